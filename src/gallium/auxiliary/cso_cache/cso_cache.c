@@ -48,14 +48,17 @@ struct cso_cache {
 static unsigned hash_key(const void *key, unsigned key_size)
 {
    unsigned *ikey = (unsigned *)key;
-   unsigned hash = 0, i;
+   unsigned hash = 2166136261u, i;
 
    assert(key_size % 4 == 0);
 
-   /* I'm sure this can be improved on:
+   /* Plain XOR folding made templates that differ by swapped fields (or
+    * by the same bit in two words) collide. Do FNV-1a a word at a time,
+    * which costs one multiply per word; cso_hash spreads the result over
+    * the table.
     */
    for (i = 0; i < key_size/4; i++)
-      hash ^= ikey[i];
+      hash = (hash ^ ikey[i]) * 16777619u;
 
    return hash;
 }
@@ -75,12 +75,29 @@ struct sampler_info
 };
 
 
+/**
+ * Number of recently used state objects per cso type which are checked
+ * before falling back to hashing the template and probing the cache.
+ */
+#define CSO_MRU_SIZE 4
+
+/**
+ * Most recently used cso_blend, cso_rasterizer, etc. of one type, most
+ * recent first. Unused entries are NULL.
+ */
+struct cso_mru
+{
+   void *entries[CSO_MRU_SIZE];
+};
+
 
 struct cso_context {
    struct pipe_context *pipe;
    struct cso_cache *cache;
    struct u_vbuf *vbuf;
 
+   struct cso_mru mru[CSO_CACHE_MAX];
+
    boolean has_geometry_shader;
    boolean has_streamout;
 
@@ -189,25 +206,83 @@ static boolean delete_vertex_elements(struct cso_context *ctx,
 }
 
 
+/**
+ * Look for a state object matching the template among the recently used
+ * ones. The template is always the first member of the cso_* structs.
+ * A hit is moved to the front.
+ */
+static INLINE void *
+cso_mru_lookup(struct cso_mru *mru, const void *templ, unsigned key_size)
+{
+   unsigned i;
+
+   for (i = 0; i < CSO_MRU_SIZE && mru->entries[i]; i++) {
+      void *cso = mru->entries[i];
+      if (memcmp(cso, templ, key_size) == 0) {
+         for (; i > 0; i--)
+            mru->entries[i] = mru->entries[i - 1];
+         mru->entries[0] = cso;
+         return cso;
+      }
+   }
+   return NULL;
+}
+
+static INLINE void
+cso_mru_add(struct cso_mru *mru, void *cso)
+{
+   unsigned i;
+
+   for (i = CSO_MRU_SIZE - 1; i > 0; i--)
+      mru->entries[i] = mru->entries[i - 1];
+   mru->entries[0] = cso;
+}
+
+static INLINE void
+cso_mru_remove(struct cso_mru *mru, void *cso)
+{
+   unsigned i, j;
+
+   for (i = 0, j = 0; i < CSO_MRU_SIZE; i++) {
+      if (mru->entries[i] != cso)
+         mru->entries[j++] = mru->entries[i];
+   }
+   for (; j < CSO_MRU_SIZE; j++)
+      mru->entries[j] = NULL;
+}
+
+
 static INLINE boolean delete_cso(struct cso_context *ctx,
                                  void *state, enum cso_cache_type type)
 {
+   boolean deleted;
+
    switch (type) {
    case CSO_BLEND:
-      return delete_blend_state(ctx, state);
+      deleted = delete_blend_state(ctx, state);
+      break;
    case CSO_SAMPLER:
-      return delete_sampler_state(ctx, state);
+      deleted = delete_sampler_state(ctx, state);
+      break;
    case CSO_DEPTH_STENCIL_ALPHA:
-      return delete_depth_stencil_state(ctx, state);
+      deleted = delete_depth_stencil_state(ctx, state);
+      break;
    case CSO_RASTERIZER:
-      return delete_rasterizer_state(ctx, state);
+      deleted = delete_rasterizer_state(ctx, state);
+      break;
    case CSO_VELEMENTS:
-      return delete_vertex_elements(ctx, state);
+      deleted = delete_vertex_elements(ctx, state);
+      break;
    default:
       assert(0);
       FREE(state);
+      return FALSE;
    }
-   return FALSE;
+
+   /* Only the pointer value is looked at, so this is fine after the free. */
+   if (deleted)
+      cso_mru_remove(&ctx->mru[type], state);
+   return deleted;
 }
 
 static INLINE void
@@ -387,17 +462,25 @@ enum pipe_error cso_set_blend(struct cso_context *ctx,
 {
    unsigned key_size, hash_key;
    struct cso_hash_iter iter;
+   struct cso_blend *cso;
    void *handle;
 
    key_size = templ->independent_blend_enable ?
       sizeof(struct pipe_blend_state) :
       (char *)&(templ->rt[1]) - (char *)templ;
+
+   cso = cso_mru_lookup(&ctx->mru[CSO_BLEND], templ, key_size);
+   if (cso) {
+      handle = cso->data;
+      goto bind;
+   }
+
    hash_key = cso_construct_key((void*)templ, key_size);
    iter = cso_find_state_template(ctx->cache, hash_key, CSO_BLEND,
                                   (void*)templ, key_size);
 
    if (cso_hash_iter_is_null(iter)) {
-      struct cso_blend *cso = MALLOC(sizeof(struct cso_blend));
+      cso = MALLOC(sizeof(struct cso_blend));
       if (!cso)
          return PIPE_ERROR_OUT_OF_MEMORY;
 
@@ -412,13 +495,15 @@ enum pipe_error cso_set_blend(struct cso_context *ctx,
          FREE(cso);
          return PIPE_ERROR_OUT_OF_MEMORY;
       }
-
-      handle = cso->data;
    }
    else {
-      handle = ((struct cso_blend *)cso_hash_iter_data(iter))->data;
+      cso = (struct cso_blend *)cso_hash_iter_data(iter);
    }
 
+   cso_mru_add(&ctx->mru[CSO_BLEND], cso);
+   handle = cso->data;
+
+bind:
    if (ctx->blend != handle) {
       ctx->blend = handle;
       ctx->pipe->bind_blend_state(ctx->pipe, handle);
@@ -448,16 +533,24 @@ cso_set_depth_stencil_alpha(struct cso_context *ctx,
                             const struct pipe_depth_stencil_alpha_state *templ)
 {
    unsigned key_size = sizeof(struct pipe_depth_stencil_alpha_state);
-   unsigned hash_key = cso_construct_key((void*)templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(ctx->cache,
-                                                       hash_key,
-                                                       CSO_DEPTH_STENCIL_ALPHA,
-                                                       (void*)templ, key_size);
+   unsigned hash_key;
+   struct cso_hash_iter iter;
+   struct cso_depth_stencil_alpha *cso;
    void *handle;
 
+   cso = cso_mru_lookup(&ctx->mru[CSO_DEPTH_STENCIL_ALPHA], templ, key_size);
+   if (cso) {
+      handle = cso->data;
+      goto bind;
+   }
+
+   hash_key = cso_construct_key((void*)templ, key_size);
+   iter = cso_find_state_template(ctx->cache, hash_key,
+                                  CSO_DEPTH_STENCIL_ALPHA,
+                                  (void*)templ, key_size);
+
    if (cso_hash_iter_is_null(iter)) {
-      struct cso_depth_stencil_alpha *cso =
-         MALLOC(sizeof(struct cso_depth_stencil_alpha));
+      cso = MALLOC(sizeof(struct cso_depth_stencil_alpha));
       if (!cso)
          return PIPE_ERROR_OUT_OF_MEMORY;
 
@@ -474,14 +567,15 @@ cso_set_depth_stencil_alpha(struct cso_context *ctx,
          FREE(cso);
          return PIPE_ERROR_OUT_OF_MEMORY;
       }
-
-      handle = cso->data;
    }
    else {
-      handle = ((struct cso_depth_stencil_alpha *)
-                cso_hash_iter_data(iter))->data;
+      cso = (struct cso_depth_stencil_alpha *)cso_hash_iter_data(iter);
    }
 
+   cso_mru_add(&ctx->mru[CSO_DEPTH_STENCIL_ALPHA], cso);
+   handle = cso->data;
+
+bind:
    if (ctx->depth_stencil != handle) {
       ctx->depth_stencil = handle;
       ctx->pipe->bind_depth_stencil_alpha_state(ctx->pipe, handle);
@@ -511,15 +605,23 @@ enum pipe_error cso_set_rasterizer(struct cso_context *ctx,
                                    const struct pipe_rasterizer_state *templ)
 {
    unsigned key_size = sizeof(struct pipe_rasterizer_state);
-   unsigned hash_key = cso_construct_key((void*)templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(ctx->cache,
-                                                       hash_key,
-                                                       CSO_RASTERIZER,
-                                                       (void*)templ, key_size);
-   void *handle = NULL;
+   unsigned hash_key;
+   struct cso_hash_iter iter;
+   struct cso_rasterizer *cso;
+   void *handle;
+
+   cso = cso_mru_lookup(&ctx->mru[CSO_RASTERIZER], templ, key_size);
+   if (cso) {
+      handle = cso->data;
+      goto bind;
+   }
+
+   hash_key = cso_construct_key((void*)templ, key_size);
+   iter = cso_find_state_template(ctx->cache, hash_key, CSO_RASTERIZER,
+                                  (void*)templ, key_size);
 
    if (cso_hash_iter_is_null(iter)) {
-      struct cso_rasterizer *cso = MALLOC(sizeof(struct cso_rasterizer));
+      cso = MALLOC(sizeof(struct cso_rasterizer));
       if (!cso)
          return PIPE_ERROR_OUT_OF_MEMORY;
 
@@ -534,13 +636,15 @@ enum pipe_error cso_set_rasterizer(struct cso_context *ctx,
          FREE(cso);
          return PIPE_ERROR_OUT_OF_MEMORY;
       }
-
-      handle = cso->data;
    }
    else {
-      handle = ((struct cso_rasterizer *)cso_hash_iter_data(iter))->data;
+      cso = (struct cso_rasterizer *)cso_hash_iter_data(iter);
    }
 
+   cso_mru_add(&ctx->mru[CSO_RASTERIZER], cso);
+   handle = cso->data;
+
+bind:
    if (ctx->rasterizer != handle) {
       ctx->rasterizer = handle;
       ctx->pipe->bind_rasterizer_state(ctx->pipe, handle);
@@ -871,6 +975,7 @@ cso_set_vertex_elements(struct cso_context *ctx,
    struct u_vbuf *vbuf = ctx->vbuf;
    unsigned key_size, hash_key;
    struct cso_hash_iter iter;
+   struct cso_velements *cso;
    void *handle;
    struct cso_velems_state velems_state;
 
@@ -888,12 +993,19 @@ cso_set_vertex_elements(struct cso_context *ctx,
    velems_state.count = count;
    memcpy(velems_state.velems, states,
           sizeof(struct pipe_vertex_element) * count);
+
+   cso = cso_mru_lookup(&ctx->mru[CSO_VELEMENTS], &velems_state, key_size);
+   if (cso) {
+      handle = cso->data;
+      goto bind;
+   }
+
    hash_key = cso_construct_key((void*)&velems_state, key_size);
    iter = cso_find_state_template(ctx->cache, hash_key, CSO_VELEMENTS,
                                   (void*)&velems_state, key_size);
 
    if (cso_hash_iter_is_null(iter)) {
-      struct cso_velements *cso = MALLOC(sizeof(struct cso_velements));
+      cso = MALLOC(sizeof(struct cso_velements));
       if (!cso)
          return PIPE_ERROR_OUT_OF_MEMORY;
 
@@ -909,13 +1021,15 @@ cso_set_vertex_elements(struct cso_context *ctx,
          FREE(cso);
          return PIPE_ERROR_OUT_OF_MEMORY;
       }
-
-      handle = cso->data;
    }
    else {
-      handle = ((struct cso_velements *)cso_hash_iter_data(iter))->data;
+      cso = (struct cso_velements *)cso_hash_iter_data(iter);
    }
 
+   cso_mru_add(&ctx->mru[CSO_VELEMENTS], cso);
+   handle = cso->data;
+
+bind:
    if (ctx->velements != handle) {
       ctx->velements = handle;
       ctx->pipe->bind_vertex_elements_state(ctx->pipe, handle);
@@ -1035,34 +1149,42 @@ single_sampler(struct cso_context *ctx,
 
    if (templ != NULL) {
       unsigned key_size = sizeof(struct pipe_sampler_state);
-      unsigned hash_key = cso_construct_key((void*)templ, key_size);
-      struct cso_hash_iter iter =
-         cso_find_state_template(ctx->cache,
-                                 hash_key, CSO_SAMPLER,
-                                 (void *) templ, key_size);
-
-      if (cso_hash_iter_is_null(iter)) {
-         struct cso_sampler *cso = MALLOC(sizeof(struct cso_sampler));
-         if (!cso)
-            return PIPE_ERROR_OUT_OF_MEMORY;
+      struct cso_sampler *cso =
+         cso_mru_lookup(&ctx->mru[CSO_SAMPLER], templ, key_size);
 
-         memcpy(&cso->state, templ, sizeof(*templ));
-         cso->data = ctx->pipe->create_sampler_state(ctx->pipe, &cso->state);
-         cso->delete_state =
-            (cso_state_callback) ctx->pipe->delete_sampler_state;
-         cso->context = ctx->pipe;
+      if (!cso) {
+         unsigned hash_key = cso_construct_key((void*)templ, key_size);
+         struct cso_hash_iter iter =
+            cso_find_state_template(ctx->cache,
+                                    hash_key, CSO_SAMPLER,
+                                    (void *) templ, key_size);
 
-         iter = cso_insert_state(ctx->cache, hash_key, CSO_SAMPLER, cso);
          if (cso_hash_iter_is_null(iter)) {
-            FREE(cso);
-            return PIPE_ERROR_OUT_OF_MEMORY;
+            cso = MALLOC(sizeof(struct cso_sampler));
+            if (!cso)
+               return PIPE_ERROR_OUT_OF_MEMORY;
+
+            memcpy(&cso->state, templ, sizeof(*templ));
+            cso->data = ctx->pipe->create_sampler_state(ctx->pipe,
+                                                        &cso->state);
+            cso->delete_state =
+               (cso_state_callback) ctx->pipe->delete_sampler_state;
+            cso->context = ctx->pipe;
+
+            iter = cso_insert_state(ctx->cache, hash_key, CSO_SAMPLER, cso);
+            if (cso_hash_iter_is_null(iter)) {
+               FREE(cso);
+               return PIPE_ERROR_OUT_OF_MEMORY;
+            }
+         }
+         else {
+            cso = (struct cso_sampler *)cso_hash_iter_data(iter);
          }
 
-         handle = cso->data;
-      }
-      else {
-         handle = ((struct cso_sampler *)cso_hash_iter_data(iter))->data;
+         cso_mru_add(&ctx->mru[CSO_SAMPLER], cso);
       }
+
+      handle = cso->data;
    }
 
    info->samplers[idx] = handle;
@@ -31,365 +31,258 @@
   */
 
 #include "util/u_debug.h"
+#include "util/u_math.h"
 #include "util/u_memory.h"
 
 #include "cso_hash.h"
 
-#define MAX(a, b) ((a > b) ? (a) : (b))
+/*
+ * Open addressing with linear probing over a power-of-two slot array.
+ * Key, value and slot state live inline in the array so a lookup touches
+ * one or two cache lines instead of chasing a malloc'ed node per entry.
+ * Erased slots become tombstones (so iterators stay valid across
+ * cso_hash_erase) and are only reclaimed when the table is rehashed.
+ */
 
 static const int MinNumBits = 4;
 
-static const unsigned char prime_deltas[] = {
-   0,  0,  1,  3,  1,  5,  3,  3,  1,  9,  7,  5,  3,  9, 25,  3,
-   1, 21,  3, 21,  7, 15,  9,  5,  3, 29, 15,  0,  0,  0,  0,  0
+enum cso_node_state {
+   CSO_NODE_EMPTY = 0,
+   CSO_NODE_FULL,
+   CSO_NODE_DELETED
 };
 
-static int primeForNumBits(int numBits)
-{
-   return (1 << numBits) + prime_deltas[numBits];
-}
-
-/*
-    Returns the smallest integer n such that
-    primeForNumBits(n) >= hint.
-*/
-static int countBits(int hint)
-{
-   int numBits = 0;
-   int bits = hint;
-
-   while (bits > 1) {
-      bits >>= 1;
-      numBits++;
-   }
-
-   if (numBits >= (int)sizeof(prime_deltas)) {
-      numBits = sizeof(prime_deltas) - 1;
-   } else if (primeForNumBits(numBits) < hint) {
-      ++numBits;
-   }
-   return numBits;
-}
-
 struct cso_node {
-   struct cso_node *next;
    unsigned key;
+   unsigned state;
    void *value;
 };
 
-struct cso_hash_data {
-   struct cso_node *fakeNext;
-   struct cso_node **buckets;
-   int size;
-   int nodeSize;
-   short userNumBits;
-   short numBits;
-   int numBuckets;
-};
-
 struct cso_hash {
-   union {
-      struct cso_hash_data *d;
-      struct cso_node      *e;
-   } data;
+   struct cso_node *nodes;
+   int size;      /* number of FULL slots */
+   int used;      /* number of FULL + DELETED slots */
+   int numBits;
+   int numSlots;
 };
 
-static void *cso_data_allocate_node(struct cso_hash_data *hash)
+
+static INLINE unsigned cso_hash_home(const struct cso_hash *hash,
+                                     unsigned key)
 {
-   return MALLOC(hash->nodeSize);
+   /* Fibonacci hashing: the keys handed to us are often poorly
+    * distributed in the low bits, so take the top bits of the product.
+    */
+   return (key * 2654435769u) >> (32 - hash->numBits);
 }
 
-static void cso_free_node(struct cso_node *node)
+static INLINE unsigned cso_hash_mask(const struct cso_hash *hash)
 {
-   FREE(node);
+   return hash->numSlots - 1;
 }
 
-static struct cso_node *
-cso_hash_create_node(struct cso_hash *hash,
-                      unsigned akey, void *avalue,
-                      struct cso_node **anextNode)
+static boolean cso_data_rehash(struct cso_hash *hash, int numBits)
 {
-   struct cso_node *node = cso_data_allocate_node(hash->data.d);
-
-   if (!node)
-      return NULL;
-
-   node->key = akey;
-   node->value = avalue;
+   struct cso_node *oldNodes = hash->nodes;
+   int oldNumSlots = hash->numSlots;
+   struct cso_node *nodes;
+   int i;
+
+   nodes = CALLOC(1 << numBits, sizeof(struct cso_node));
+   if (!nodes)
+      return FALSE;
+
+   hash->nodes = nodes;
+   hash->numBits = numBits;
+   hash->numSlots = 1 << numBits;
+   hash->used = hash->size;
+
+   for (i = 0; i < oldNumSlots; ++i) {
+      if (oldNodes[i].state == CSO_NODE_FULL) {
+         unsigned mask = cso_hash_mask(hash);
+         unsigned s = cso_hash_home(hash, oldNodes[i].key);
+         while (nodes[s].state != CSO_NODE_EMPTY)
+            s = (s + 1) & mask;
+         nodes[s] = oldNodes[i];
+      }
+   }
 
-   node->next = (struct cso_node*)(*anextNode);
-   *anextNode = node;
-   ++hash->data.d->size;
-   return node;
+   FREE(oldNodes);
+   return TRUE;
 }
 
-static void cso_data_rehash(struct cso_hash_data *hash, int hint)
+static boolean cso_data_might_grow(struct cso_hash *hash)
 {
-   if (hint < 0) {
-      hint = countBits(-hint);
-      if (hint < MinNumBits)
-         hint = MinNumBits;
-      hash->userNumBits = (short)hint;
-      while (primeForNumBits(hint) < (hash->size >> 1))
-         ++hint;
-   } else if (hint < MinNumBits) {
-      hint = MinNumBits;
-   }
+   int numBits;
 
-   if (hash->numBits != hint) {
-      struct cso_node *e = (struct cso_node *)(hash);
-      struct cso_node **oldBuckets = hash->buckets;
-      int oldNumBuckets = hash->numBuckets;
-      int  i = 0;
-
-      hash->numBits = (short)hint;
-      hash->numBuckets = primeForNumBits(hint);
-      hash->buckets = MALLOC(sizeof(struct cso_node*) * hash->numBuckets);
-      for (i = 0; i < hash->numBuckets; ++i)
-         hash->buckets[i] = e;
-
-      for (i = 0; i < oldNumBuckets; ++i) {
-         struct cso_node *firstNode = oldBuckets[i];
-         while (firstNode != e) {
-            unsigned h = firstNode->key;
-            struct cso_node *lastNode = firstNode;
-            struct cso_node *afterLastNode;
-            struct cso_node **beforeFirstNode;
-            
-            while (lastNode->next != e && lastNode->next->key == h)
-               lastNode = lastNode->next;
-
-            afterLastNode = lastNode->next;
-            beforeFirstNode = &hash->buckets[h % hash->numBuckets];
-            while (*beforeFirstNode != e)
-               beforeFirstNode = &(*beforeFirstNode)->next;
-            lastNode->next = *beforeFirstNode;
-            *beforeFirstNode = firstNode;
-            firstNode = afterLastNode;
-         }
-      }
-      FREE(oldBuckets);
-   }
+   /* Keep the load (tombstones included) under 3/4 so probe sequences
+    * stay short and there is always an empty slot to stop at.
+    */
+   if ((hash->used + 1) * 4 <= hash->numSlots * 3)
+      return TRUE;
+
+   numBits = hash->numBits ? hash->numBits : MinNumBits;
+   while ((hash->size + 1) * 2 > (1 << numBits))
+      numBits++;
+   return cso_data_rehash(hash, numBits);
 }
 
-static void cso_data_might_grow(struct cso_hash_data *hash)
+static void cso_data_has_shrunk(struct cso_hash *hash)
 {
-   if (hash->size >= hash->numBuckets)
-      cso_data_rehash(hash, hash->numBits + 1);
+   if (hash->numBits > MinNumBits &&
+       hash->size <= (hash->numSlots >> 3)) {
+      int numBits = MAX2(hash->numBits - 2, MinNumBits);
+      cso_data_rehash(hash, numBits);
+   }
 }
 
-static void cso_data_has_shrunk(struct cso_hash_data *hash)
+static struct cso_node *cso_hash_find_node(struct cso_hash *hash,
+                                           unsigned akey)
 {
-   if (hash->size <= (hash->numBuckets >> 3) &&
-       hash->numBits > hash->userNumBits) {
-      int max = MAX(hash->numBits-2, hash->userNumBits);
-      cso_data_rehash(hash,  max);
+   unsigned mask, s;
+
+   if (!hash->numSlots)
+      return NULL;
+
+   mask = cso_hash_mask(hash);
+   s = cso_hash_home(hash, akey);
+   while (hash->nodes[s].state != CSO_NODE_EMPTY) {
+      if (hash->nodes[s].state == CSO_NODE_FULL &&
+          hash->nodes[s].key == akey)
+         return &hash->nodes[s];
+      s = (s + 1) & mask;
    }
+   return NULL;
 }
 
-static struct cso_node *cso_data_first_node(struct cso_hash_data *hash)
+/* Next FULL slot after node, in slot order. */
+static struct cso_node *cso_hash_data_next(struct cso_hash *hash,
+                                           struct cso_node *node)
 {
-   struct cso_node *e = (struct cso_node *)(hash);
-   struct cso_node **bucket = hash->buckets;
-   int n = hash->numBuckets;
-   while (n--) {
-      if (*bucket != e)
-         return *bucket;
-      ++bucket;
+   struct cso_node *end = hash->nodes + hash->numSlots;
+   for (++node; node < end; ++node) {
+      if (node->state == CSO_NODE_FULL)
+         return node;
    }
-   return e;
+   return NULL;
 }
 
-static struct cso_node **cso_hash_find_node(struct cso_hash *hash, unsigned akey)
+/* Next FULL slot with the same key as node along its probe sequence. */
+static struct cso_node *cso_hash_data_next_same_key(struct cso_hash *hash,
+                                                    struct cso_node *node)
 {
-   struct cso_node **node;
-
-   if (hash->data.d->numBuckets) {
-      node = (struct cso_node **)(&hash->data.d->buckets[akey % hash->data.d->numBuckets]);
-      assert(*node == hash->data.e || (*node)->next);
-      while (*node != hash->data.e && (*node)->key != akey)
-         node = &(*node)->next;
-   } else {
-      node = (struct cso_node **)((const struct cso_node * const *)(&hash->data.e));
+   unsigned mask = cso_hash_mask(hash);
+   unsigned key = node->key;
+   unsigned s = (unsigned)(node - hash->nodes);
+
+   for (s = (s + 1) & mask; hash->nodes[s].state != CSO_NODE_EMPTY;
+        s = (s + 1) & mask) {
+      if (hash->nodes[s].state == CSO_NODE_FULL &&
+          hash->nodes[s].key == key)
+         return &hash->nodes[s];
    }
-   return node;
+   return NULL;
 }
 
 struct cso_hash_iter cso_hash_insert(struct cso_hash *hash,
                                        unsigned key, void *data)
 {
-   cso_data_might_grow(hash->data.d);
-
-   {
-      struct cso_node **nextNode = cso_hash_find_node(hash, key);
-      struct cso_node *node = cso_hash_create_node(hash, key, data, nextNode);
-      if (!node) {
-         struct cso_hash_iter null_iter = {hash, 0};
-         return null_iter;
-      }
+   struct cso_hash_iter iter = {hash, NULL, FALSE};
+   struct cso_node *node;
+   unsigned mask, s;
 
-      {
-         struct cso_hash_iter iter = {hash, node};
-         return iter;
-      }
-   }
+   if (!cso_data_might_grow(hash))
+      return iter;
+
+   /* Entries with equal keys may end up in any order along the probe
+    * sequence; reuse the first tombstone on the way if there is one.
+    */
+   mask = cso_hash_mask(hash);
+   s = cso_hash_home(hash, key);
+   while (hash->nodes[s].state == CSO_NODE_FULL)
+      s = (s + 1) & mask;
+
+   node = &hash->nodes[s];
+   if (node->state == CSO_NODE_EMPTY)
+      ++hash->used;
+   node->key = key;
+   node->value = data;
+   node->state = CSO_NODE_FULL;
+   ++hash->size;
+
+   iter.node = node;
+   iter.same_key = TRUE;
+   return iter;
 }
 
 struct cso_hash * cso_hash_create(void)
 {
-   struct cso_hash *hash = MALLOC_STRUCT(cso_hash);
+   struct cso_hash *hash = CALLOC_STRUCT(cso_hash);
    if (!hash)
       return NULL;
 
-   hash->data.d = MALLOC_STRUCT(cso_hash_data);
-   if (!hash->data.d) {
-      FREE(hash);
-      return NULL;
-   }
-
-   hash->data.d->fakeNext = 0;
-   hash->data.d->buckets = 0;
-   hash->data.d->size = 0;
-   hash->data.d->nodeSize = sizeof(struct cso_node);
-   hash->data.d->userNumBits = (short)MinNumBits;
-   hash->data.d->numBits = 0;
-   hash->data.d->numBuckets = 0;
-
+   /* The slot array is allocated on first insert. */
    return hash;
 }
 
 void cso_hash_delete(struct cso_hash *hash)
 {
-   struct cso_node *e_for_x = (struct cso_node *)(hash->data.d);
-   struct cso_node **bucket = (struct cso_node **)(hash->data.d->buckets);
-   int n = hash->data.d->numBuckets;
-   while (n--) {
-      struct cso_node *cur = *bucket++;
-      while (cur != e_for_x) {
-         struct cso_node *next = cur->next;
-         cso_free_node(cur);
-         cur = next;
-      }
-   }
-   FREE(hash->data.d->buckets);
-   FREE(hash->data.d);
+   FREE(hash->nodes);
    FREE(hash);
 }
 
 struct cso_hash_iter cso_hash_find(struct cso_hash *hash,
                                      unsigned key)
 {
-   struct cso_node **nextNode = cso_hash_find_node(hash, key);
-   struct cso_hash_iter iter = {hash, *nextNode};
+   struct cso_hash_iter iter = {hash, cso_hash_find_node(hash, key), TRUE};
    return iter;
 }
 
 unsigned cso_hash_iter_key(struct cso_hash_iter iter)
 {
-   if (!iter.node || iter.hash->data.e == iter.node)
+   if (!iter.node)
       return 0;
    return iter.node->key;
 }
 
 void * cso_hash_iter_data(struct cso_hash_iter iter)
 {
-   if (!iter.node || iter.hash->data.e == iter.node)
+   if (!iter.node)
       return 0;
    return iter.node->value;
 }
 
-static struct cso_node *cso_hash_data_next(struct cso_node *node)
+struct cso_hash_iter cso_hash_iter_next(struct cso_hash_iter iter)
 {
-   union {
-      struct cso_node *next;
-      struct cso_node *e;
-      struct cso_hash_data *d;
-   } a;
-   int start;
-   struct cso_node **bucket;
-   int n;
-
-   a.next = node->next;
-   if (!a.next) {
+   struct cso_hash_iter next = iter;
+
+   if (!iter.node) {
       debug_printf("iterating beyond the last element\n");
-      return 0;
+      return next;
    }
-   if (a.next->next)
-      return a.next;
-
-   start = (node->key % a.d->numBuckets) + 1;
-   bucket = a.d->buckets + start;
-   n = a.d->numBuckets - start;
-   while (n--) {
-      if (*bucket != a.e)
-         return *bucket;
-      ++bucket;
-   }
-   return a.e;
-}
 
-
-static struct cso_node *cso_hash_data_prev(struct cso_node *node)
-{
-   union {
-      struct cso_node *e;
-      struct cso_hash_data *d;
-   } a;
-   int start;
-   struct cso_node *sentinel;
-   struct cso_node **bucket;
-
-   a.e = node;
-   while (a.e->next)
-      a.e = a.e->next;
-
-   if (node == a.e)
-      start = a.d->numBuckets - 1;
+   if (iter.same_key)
+      next.node = cso_hash_data_next_same_key(iter.hash, iter.node);
    else
-      start = node->key % a.d->numBuckets;
-
-   sentinel = node;
-   bucket = a.d->buckets + start;
-   while (start >= 0) {
-      if (*bucket != sentinel) {
-         struct cso_node *prev = *bucket;
-         while (prev->next != sentinel)
-            prev = prev->next;
-         return prev;
-      }
-
-      sentinel = a.e;
-      --bucket;
-      --start;
-   }
-   debug_printf("iterating backward beyond first element\n");
-   return a.e;
-}
-
-struct cso_hash_iter cso_hash_iter_next(struct cso_hash_iter iter)
-{
-   struct cso_hash_iter next = {iter.hash, cso_hash_data_next(iter.node)};
+      next.node = cso_hash_data_next(iter.hash, iter.node);
    return next;
 }
 
 int cso_hash_iter_is_null(struct cso_hash_iter iter)
 {
-   if (!iter.node || iter.node == iter.hash->data.e)
-      return 1;
-   return 0;
+   return iter.node == NULL;
 }
 
 void * cso_hash_take(struct cso_hash *hash,
                       unsigned akey)
 {
-   struct cso_node **node = cso_hash_find_node(hash, akey);
-   if (*node != hash->data.e) {
-      void *t = (*node)->value;
-      struct cso_node *next = (*node)->next;
-      cso_free_node(*node);
-      *node = next;
-      --hash->data.d->size;
-      cso_data_has_shrunk(hash->data.d);
+   struct cso_node *node = cso_hash_find_node(hash, akey);
+   if (node) {
+      void *t = node->value;
+      node->state = CSO_NODE_DELETED;
+      node->value = NULL;
+      --hash->size;
+      cso_data_has_shrunk(hash);
       return t;
    }
    return 0;
@@ -397,43 +290,58 @@ void * cso_hash_take(struct cso_hash *hash,
 
 struct cso_hash_iter cso_hash_iter_prev(struct cso_hash_iter iter)
 {
-   struct cso_hash_iter prev = {iter.hash,
-                                 cso_hash_data_prev(iter.node)};
+   struct cso_hash_iter prev = {iter.hash, NULL, FALSE};
+   struct cso_node *node;
+
+   node = iter.node ? iter.node : iter.hash->nodes + iter.hash->numSlots;
+   while (node > iter.hash->nodes) {
+      --node;
+      if (node->state == CSO_NODE_FULL) {
+         prev.node = node;
+         return prev;
+      }
+   }
+   debug_printf("iterating backward beyond first element\n");
    return prev;
 }
 
 struct cso_hash_iter cso_hash_first_node(struct cso_hash *hash)
 {
-   struct cso_hash_iter iter = {hash, cso_data_first_node(hash->data.d)};
+   struct cso_hash_iter iter = {hash, NULL, FALSE};
+   if (hash->numSlots) {
+      if (hash->nodes[0].state == CSO_NODE_FULL)
+         iter.node = &hash->nodes[0];
+      else
+         iter.node = cso_hash_data_next(hash, &hash->nodes[0]);
+   }
    return iter;
 }
 
 int cso_hash_size(struct cso_hash *hash)
 {
-   return hash->data.d->size;
+   return hash->size;
 }
 
 struct cso_hash_iter cso_hash_erase(struct cso_hash *hash, struct cso_hash_iter iter)
 {
-   struct cso_hash_iter ret = iter;
-   struct cso_node *node = iter.node;
-   struct cso_node **node_ptr;
+   struct cso_hash_iter ret;
 
-   if (node == hash->data.e)
+   if (!iter.node)
       return iter;
 
-   ret = cso_hash_iter_next(ret);
-   node_ptr = (struct cso_node**)(&hash->data.d->buckets[node->key % hash->data.d->numBuckets]);
-   while (*node_ptr != node)
-      node_ptr = &(*node_ptr)->next;
-   *node_ptr = node->next;
-   cso_free_node(node);
-   --hash->data.d->size;
+   assert(iter.node->state == CSO_NODE_FULL);
+
+   /* Leave a tombstone and don't rehash, so that iteration can carry on
+    * from the returned iterator.
+    */
+   ret = cso_hash_iter_next(iter);
+   iter.node->state = CSO_NODE_DELETED;
+   iter.node->value = NULL;
+   --hash->size;
    return ret;
 }
 
 boolean cso_hash_contains(struct cso_hash *hash, unsigned key)
 {
-   struct cso_node **node = cso_hash_find_node(hash, key);
-   return (*node != hash->data.e);
+   return cso_hash_find_node(hash, key) != NULL;
 }
@@ -30,13 +30,13 @@
  * Hash table implementation.
  * 
  * This file provides a hash implementation that is capable of dealing
- * with collisions. It stores colliding entries in linked list. All
- * functions operating on the hash return an iterator. The iterator
- * itself points to the collision list. If there wasn't any collision
- * the list will have just one entry, otherwise client code should
- * iterate over the entries to find the exact entry among ones that
+ * with collisions. Entries are kept in an open-addressed table and
+ * several entries may share the same key. All functions operating on the
+ * hash return an iterator. An iterator returned by cso_hash_find or
+ * cso_hash_insert only visits the entries with that key, so client code
+ * should iterate over them to find the exact entry among ones that
  * had the same key (e.g. memcmp could be used on the data to check
- * that)
+ * that). The order of entries sharing a key is unspecified.
  * 
  * @author Zack Rusin <zackr@vmware.com>
  */
@@ -58,6 +58,7 @@ struct cso_node;
 struct cso_hash_iter {
    struct cso_hash *hash;
    struct cso_node  *node;
+   boolean same_key;  /**< only visit entries with node's key */
 };
 
 
@@ -70,9 +71,9 @@ int              cso_hash_size(struct cso_hash *hash);
 
 /**
  * Adds a data with the given key to the hash. If entry with the given
- * key is already in the hash, this current entry is instered before it
- * in the collision list.
- * Function returns iterator pointing to the inserted item in the hash.
+ * key is already in the hash, both are kept.
+ * Function returns iterator pointing to the inserted item in the hash,
+ * or a null iterator on allocation failure.
  */
 struct cso_hash_iter cso_hash_insert(struct cso_hash *hash, unsigned key,
                                      void *data);
@@ -81,7 +82,8 @@ struct cso_hash_iter cso_hash_insert(struct cso_hash *hash, unsigned key,
  * Note that the data itself is not erased and if it was a malloc'ed pointer
  * it will have to be freed after calling this function by the callee.
  * Function returns iterator pointing to the item after the removed one in
- * the hash.
+ * the hash. Erasing never moves the remaining entries, so iteration may
+ * continue from the returned iterator.
  */
 struct cso_hash_iter cso_hash_erase(struct cso_hash *hash, struct cso_hash_iter iter);
 
@@ -92,7 +94,8 @@ void  *cso_hash_take(struct cso_hash *hash, unsigned key);
 struct cso_hash_iter cso_hash_first_node(struct cso_hash *hash);
 
 /**
- * Return an iterator pointing to the first entry in the collision list.
+ * Return an iterator pointing to the first entry with the given key.
+ * Advancing it with cso_hash_iter_next only visits entries with that key.
  */
 struct cso_hash_iter cso_hash_find(struct cso_hash *hash, unsigned key);
 
@@ -112,7 +115,7 @@ struct cso_hash_iter cso_hash_iter_prev(struct cso_hash_iter iter);
 
 
 /**
- * Convenience routine to iterate over the collision list while doing a memory
+ * Convenience routine to iterate over the entries with the key while doing a memory
  * comparison to see which entry in the list is a direct copy of our template
  * and returns that entry.
  */
@@ -42,9 +42,6 @@
 #include "util/u_memory.h"
 #include "util/u_prim.h"
 
-/* fixme: move it from here */
-#define MAX_PRIMITIVES 64
-
 static INLINE int
 draw_gs_get_input_index(int semantic, int index,
                         const struct tgsi_shader_info *input_info)
@@ -79,43 +76,48 @@ tgsi_fetch_gs_outputs(struct draw_geometry_shader *shader,
                       float (**p_output)[4])
 {
    struct tgsi_exec_machine *machine = shader->machine;
-   unsigned prim_idx, j, slot;
-   unsigned current_idx = 0;
+   const unsigned *prim_counts =
+      machine->Temps[TGSI_EXEC_TEMP_PRIMITIVE_I].xyzw[TGSI_EXEC_TEMP_PRIMITIVE_C].u;
+   unsigned lane, prim_idx, j, slot;
    float (*output)[4];
 
    output = *p_output;
 
-   /* Unswizzle all output results.
+   /* Unswizzle all output results, one invocation (lane) after the
+    * other so the primitives come out in input order.
     */
 
-   for (prim_idx = 0; prim_idx < num_primitives; ++prim_idx) {
-      unsigned num_verts_per_prim = machine->Primitives[prim_idx];
-      shader->primitive_lengths[prim_idx + shader->emitted_primitives] =
-         machine->Primitives[prim_idx];
-      shader->emitted_vertices += num_verts_per_prim;
-      for (j = 0; j < num_verts_per_prim; j++, current_idx++) {
-         int idx = current_idx * shader->info.num_outputs;
+   for (lane = 0; lane < shader->fetched_prim_count; ++lane) {
+      unsigned current_idx = 0;
+
+      for (prim_idx = 0; prim_idx < prim_counts[lane]; ++prim_idx) {
+         unsigned num_verts_per_prim = machine->Primitives[lane][prim_idx];
+         shader->primitive_lengths[shader->emitted_primitives++] =
+            num_verts_per_prim;
+         shader->emitted_vertices += num_verts_per_prim;
+         for (j = 0; j < num_verts_per_prim; j++, current_idx++) {
+            int idx = current_idx * shader->info.num_outputs;
 #ifdef DEBUG_OUTPUTS
-         debug_printf("%d) Output vert:\n", idx / shader->info.num_outputs);
+            debug_printf("%d) Output vert:\n", idx / shader->info.num_outputs);
 #endif
-         for (slot = 0; slot < shader->info.num_outputs; slot++) {
-            output[slot][0] = machine->Outputs[idx + slot].xyzw[0].f[0];
-            output[slot][1] = machine->Outputs[idx + slot].xyzw[1].f[0];
-            output[slot][2] = machine->Outputs[idx + slot].xyzw[2].f[0];
-            output[slot][3] = machine->Outputs[idx + slot].xyzw[3].f[0];
+            for (slot = 0; slot < shader->info.num_outputs; slot++) {
+               output[slot][0] = machine->Outputs[idx + slot].xyzw[0].f[lane];
+               output[slot][1] = machine->Outputs[idx + slot].xyzw[1].f[lane];
+               output[slot][2] = machine->Outputs[idx + slot].xyzw[2].f[lane];
+               output[slot][3] = machine->Outputs[idx + slot].xyzw[3].f[lane];
 #ifdef DEBUG_OUTPUTS
-            debug_printf("\t%d: %f %f %f %f\n", slot,
-                         output[slot][0],
-                         output[slot][1],
-                         output[slot][2],
-                         output[slot][3]);
+               debug_printf("\t%d: %f %f %f %f\n", slot,
+                            output[slot][0],
+                            output[slot][1],
+                            output[slot][2],
+                            output[slot][3]);
 #endif
+            }
+            output = (float (*)[4])((char *)output + shader->vertex_size);
          }
-         output = (float (*)[4])((char *)output + shader->vertex_size);
       }
    }
    *p_output = output;
-   shader->emitted_primitives += num_primitives;
 }
 
 /*#define DEBUG_INPUTS 1*/
@@ -148,12 +150,8 @@ static void tgsi_fetch_gs_input(struct draw_geometry_shader *shader,
             machine->Inputs[idx].xyzw[2].u[prim_idx] = shader->in_prim_idx;
             machine->Inputs[idx].xyzw[3].u[prim_idx] = shader->in_prim_idx;
          } else {
-            vs_slot = draw_gs_get_input_index(
-               shader->info.input_semantic_name[slot],
-               shader->info.input_semantic_index[slot],
-               shader->input_info);
+            vs_slot = shader->input_map[slot];
             if (vs_slot < 0) {
-               debug_printf("VS/GS signature mismatch!\n");
                machine->Inputs[idx].xyzw[0].f[prim_idx] = 0;
                machine->Inputs[idx].xyzw[1].f[prim_idx] = 0;
                machine->Inputs[idx].xyzw[2].f[prim_idx] = 0;
@@ -206,11 +204,14 @@ static unsigned tgsi_gs_run(struct draw_geometry_shader *shader,
                       input_primitives > 2,
                       input_primitives > 3);
 
-   /* run interpreter */
+   /* run interpreter, one input primitive per lane */
    tgsi_exec_machine_run(machine);
 
    return
-      machine->Temps[TGSI_EXEC_TEMP_PRIMITIVE_I].xyzw[TGSI_EXEC_TEMP_PRIMITIVE_C].u[0];
+      machine->Temps[TGSI_EXEC_TEMP_PRIMITIVE_I].xyzw[TGSI_EXEC_TEMP_PRIMITIVE_C].u[0] +
+      machine->Temps[TGSI_EXEC_TEMP_PRIMITIVE_I].xyzw[TGSI_EXEC_TEMP_PRIMITIVE_C].u[1] +
+      machine->Temps[TGSI_EXEC_TEMP_PRIMITIVE_I].xyzw[TGSI_EXEC_TEMP_PRIMITIVE_C].u[2] +
+      machine->Temps[TGSI_EXEC_TEMP_PRIMITIVE_I].xyzw[TGSI_EXEC_TEMP_PRIMITIVE_C].u[3];
 }
 
 #ifdef HAVE_LLVM
@@ -248,12 +249,8 @@ llvm_fetch_gs_input(struct draw_geometry_shader *shader,
              * would make sense so hack around this later in gallivm.
              */
          } else {
-            vs_slot = draw_gs_get_input_index(
-               shader->info.input_semantic_name[slot],
-               shader->info.input_semantic_index[slot],
-               shader->input_info);
+            vs_slot = shader->input_map[slot];
             if (vs_slot < 0) {
-               debug_printf("VS/GS signature mismatch!\n");
                (*input_data)[i][slot][0][prim_idx] = 0;
                (*input_data)[i][slot][1][prim_idx] = 0;
                (*input_data)[i][slot][2][prim_idx] = 0;
@@ -547,10 +544,9 @@ int draw_geometry_shader_run(struct draw_geometry_shader *shader,
               u_decomposed_prims_for_vertices(shader->input_primitive,
                                               num_input_verts)),
          shader->vector_length);
-   unsigned max_out_prims =
-      u_decomposed_prims_for_vertices(shader->output_primitive,
-                                      shader->max_output_vertices)
-      * num_in_primitives;
+   /* every emitted primitive has at least one vertex */
+   unsigned max_out_prims = shader->max_output_vertices * num_in_primitives;
+   unsigned i;
    /* we allocate exactly one extra vertex per primitive to allow the GS to emit
     * overflown vertices into some area where they won't harm anyone */
    unsigned total_verts_per_buffer = shader->primitive_boundary *
@@ -591,6 +587,19 @@ int draw_geometry_shader_run(struct draw_geometry_shader *shader,
    shader->input_vertex_stride = input_stride;
    shader->input = input;
    shader->input_info = input_info;
+
+   /* Match up the GS inputs with the outputs of the previous stage once
+    * per run rather than for every fetched vertex.
+    */
+   for (i = 0; i < shader->info.num_inputs; i++) {
+      shader->input_map[i] =
+         draw_gs_get_input_index(shader->info.input_semantic_name[i],
+                                 shader->info.input_semantic_index[i],
+                                 input_info);
+      if (shader->input_map[i] < 0 &&
+          shader->info.input_semantic_name[i] != TGSI_SEMANTIC_PRIMID)
+         debug_printf("VS/GS signature mismatch!\n");
+   }
    FREE(shader->primitive_lengths);
    shader->primitive_lengths = MALLOC(max_out_prims * sizeof(unsigned));
 
@@ -599,7 +608,6 @@ int draw_geometry_shader_run(struct draw_geometry_shader *shader,
    if (shader->draw->llvm) {
       shader->gs_output = output_verts->verts;
       if (max_out_prims > shader->max_out_prims) {
-         unsigned i;
          if (shader->llvm_prim_lengths) {
             for (i = 0; i < shader->max_out_prims; ++i) {
                align_free(shader->llvm_prim_lengths[i]);
@@ -653,7 +661,6 @@ int draw_geometry_shader_run(struct draw_geometry_shader *shader,
    output_verts->count = shader->emitted_vertices;
 
    if (shader->draw->collect_statistics) {
-      unsigned i;
       for (i = 0; i < shader->emitted_primitives; ++i) {
          shader->draw->statistics.gs_primitives +=
             u_decomposed_prims_for_vertices(shader->output_primitive,
@@ -689,13 +696,6 @@ draw_gs_init( struct draw_context *draw )
       draw->gs.tgsi.machine = tgsi_exec_machine_create();
       if (!draw->gs.tgsi.machine)
          return FALSE;
-
-      draw->gs.tgsi.machine->Primitives = align_malloc(
-         MAX_PRIMITIVES * sizeof(struct tgsi_exec_vector), 16);
-      if (!draw->gs.tgsi.machine->Primitives)
-         return FALSE;
-      memset(draw->gs.tgsi.machine->Primitives, 0,
-             MAX_PRIMITIVES * sizeof(struct tgsi_exec_vector));
    }
 
    return TRUE;
@@ -704,7 +704,6 @@ draw_gs_init( struct draw_context *draw )
 void draw_gs_destroy( struct draw_context *draw )
 {
    if (draw->gs.tgsi.machine) {
-      align_free(draw->gs.tgsi.machine->Primitives);
       tgsi_exec_machine_destroy(draw->gs.tgsi.machine);
    }
 }
@@ -765,7 +764,8 @@ draw_create_geometry_shader(struct draw_context *draw,
    } else
 #endif
    {
-      gs->vector_length = 1;
+      /* the interpreter runs one invocation in each of its four lanes */
+      gs->vector_length = TGSI_QUAD_SIZE;
    }
 
    for (i = 0; i < gs->info.num_properties; ++i) {
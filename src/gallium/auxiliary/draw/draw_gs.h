@@ -87,6 +87,8 @@ struct draw_geometry_shader {
    unsigned fetched_prim_count;
    const float (*input)[4];
    const struct tgsi_shader_info *input_info;
+   /* output slot of the previous stage feeding each input, or -1 */
+   int input_map[PIPE_MAX_SHADER_INPUTS];
    unsigned vector_length;
    unsigned max_out_prims;
 
@@ -75,6 +75,7 @@ struct draw_jit_sampler
    float min_lod;
    float max_lod;
    float lod_bias;
+   float max_aniso;
    float border_color[4];
 };
 
@@ -97,6 +98,7 @@ enum {
    DRAW_JIT_SAMPLER_MIN_LOD,
    DRAW_JIT_SAMPLER_MAX_LOD,
    DRAW_JIT_SAMPLER_LOD_BIAS,
+   DRAW_JIT_SAMPLER_MAX_ANISO,
    DRAW_JIT_SAMPLER_BORDER_COLOR,
    DRAW_JIT_SAMPLER_NUM_FIELDS  /* number of fields above */
 };
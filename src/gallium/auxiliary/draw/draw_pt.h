@@ -228,6 +228,12 @@ boolean draw_pt_post_vs_run( struct pt_post_vs *pvs,
 			     struct draw_vertex_info *info,
                              const struct draw_prim_info *prim_info );
 
+boolean draw_pt_post_vs_trivial_reject( struct pt_post_vs *pvs,
+                                        const struct draw_vertex_info *vert_info,
+                                        const struct draw_prim_info *prim_info,
+                                        struct draw_prim_info *out_prim_info,
+                                        boolean *need_pipeline );
+
 void draw_pt_post_vs_prepare( struct pt_post_vs *pvs,
 			      boolean clip_xy,
 			      boolean clip_z,
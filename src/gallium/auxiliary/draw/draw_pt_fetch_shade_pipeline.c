@@ -337,19 +337,41 @@ fetch_pipeline_generic(struct draw_pt_middle_end *middle,
     * will try to access non-existent position output.
     */
    if (draw_current_shader_position_output(draw) != -1) {
+      const struct draw_prim_info *draw_prim_info = prim_info;
+      struct draw_prim_info culled_prim_info;
+      boolean need_pipeline;
 
       if (draw_pt_post_vs_run( fpme->post_vs, vert_info, prim_info ))
       {
          opt |= PT_PIPELINE;
+
+         /* Throw away the primitives which are entirely outside a clip
+          * plane here, and skip the pipeline if the others are unclipped.
+          */
+         if (draw_pt_post_vs_trivial_reject( fpme->post_vs, vert_info,
+                                             prim_info, &culled_prim_info,
+                                             &need_pipeline )) {
+            if (!need_pipeline && !(fpme->opt & PT_PIPELINE))
+               opt &= ~PT_PIPELINE;
+            draw_prim_info = &culled_prim_info;
+         }
       }
 
       /* Do we need to run the pipeline?
        */
-      if (opt & PT_PIPELINE) {
-         pipeline( fpme, vert_info, prim_info );
+      if (draw_prim_info->count == 0) {
+         /* everything was trivially rejected */
+      }
+      else if (opt & PT_PIPELINE) {
+         pipeline( fpme, vert_info, draw_prim_info );
       }
       else {
-         emit( fpme->emit, vert_info, prim_info );
+         emit( fpme->emit, vert_info, draw_prim_info );
+      }
+
+      if (draw_prim_info == &culled_prim_info) {
+         FREE((void *)culled_prim_info.elts);
+         FREE(culled_prim_info.primitive_lengths);
       }
    }
    FREE(vert_info->verts);
@@ -28,6 +28,7 @@
 #include "util/u_memory.h"
 #include "util/u_math.h"
 #include "util/u_prim.h"
+#include "util/u_sse.h"
 #include "pipe/p_context.h"
 #include "draw/draw_context.h"
 #include "draw/draw_private.h"
@@ -71,6 +72,74 @@ dot4(const float *a, const float *b)
            a[3]*b[3]);
 }
 
+/**
+ * Compute the clipmask bits of the hardwired planes, ie the four xy
+ * planes (bits 0-3, optionally pushed out to the guard band) and the two
+ * z planes (bits 4-5), without branching on each plane.  With SSE all six
+ * planes are tested with two compares and two movemasks.
+ */
+static INLINE unsigned
+hardwired_clipmask(const float *position, unsigned flags)
+{
+   unsigned enabled = 0;
+   unsigned mask;
+
+   if (flags & (DO_CLIP_XY | DO_CLIP_XY_GUARD_BAND))
+      enabled |= 0xf;
+   if (flags & (DO_CLIP_FULL_Z | DO_CLIP_HALF_Z))
+      enabled |= 0x30;
+   if (!enabled)
+      return 0;
+
+#if defined(PIPE_ARCH_SSE)
+   {
+      const float s = (flags & DO_CLIP_XY_GUARD_BAND) ? 0.5f : 1.0f;
+      /* the near plane is z + w for the full cube and z for the half cube */
+      const int near_w = (flags & DO_CLIP_FULL_Z) ? ~0 : 0;
+      const __m128 zero = _mm_setzero_ps();
+      __m128 pos = _mm_loadu_ps(position);
+      __m128 w = _mm_shuffle_ps(pos, pos, _MM_SHUFFLE(3, 3, 3, 3));
+      __m128 xxyy = _mm_shuffle_ps(pos, pos, _MM_SHUFFLE(1, 1, 0, 0));
+      __m128 zzzz = _mm_shuffle_ps(pos, pos, _MM_SHUFFLE(2, 2, 2, 2));
+      __m128 xy, z;
+
+      xy = _mm_add_ps(_mm_mul_ps(xxyy, _mm_setr_ps(-s, s, -s, s)), w);
+      z = _mm_add_ps(_mm_mul_ps(zzzz, _mm_setr_ps(1.0f, -1.0f, 0.0f, 0.0f)),
+                     _mm_and_ps(w, _mm_castsi128_ps(
+                                      _mm_setr_epi32(near_w, ~0, 0, 0))));
+
+      mask = _mm_movemask_ps(_mm_cmplt_ps(xy, zero)) |
+             (_mm_movemask_ps(_mm_cmplt_ps(z, zero)) << 4);
+   }
+#else
+   {
+      const float x = position[0], y = position[1];
+      const float z = position[2], w = position[3];
+
+      if (flags & DO_CLIP_XY_GUARD_BAND) {
+         mask = ((-0.50f * x + w < 0) << 0) |
+                (( 0.50f * x + w < 0) << 1) |
+                ((-0.50f * y + w < 0) << 2) |
+                (( 0.50f * y + w < 0) << 3);
+      }
+      else {
+         mask = ((-x + w < 0) << 0) |
+                (( x + w < 0) << 1) |
+                ((-y + w < 0) << 2) |
+                (( y + w < 0) << 3);
+      }
+
+      if (flags & DO_CLIP_FULL_Z)
+         mask |= (z + w < 0) << 4;
+      else
+         mask |= (z < 0) << 4;
+      mask |= (-z + w < 0) << 5;
+   }
+#endif
+
+   return mask & enabled;
+}
+
 #define FLAGS (0)
 #define TAG(x) x##_none
 #include "draw_cliptest_tmp.h"
@@ -124,6 +193,103 @@ boolean draw_pt_post_vs_run( struct pt_post_vs *pvs,
 }
 
 
+/**
+ * Trivially reject the primitives of a point, line or triangle list
+ * which lie entirely outside one clip plane, so they never enter the
+ * draw pipeline, using the same rules as the clip stage would.
+ *
+ * Returns FALSE if the primitives are not a candidate, in which case
+ * out_prim_info is untouched.  Otherwise out_prim_info describes the
+ * surviving primitives as an elts list into the same vertices (the caller
+ * must free its elts and primitive_lengths), and need_pipeline says
+ * whether any of them still needs clipping or edgeflag handling.
+ */
+boolean draw_pt_post_vs_trivial_reject( struct pt_post_vs *pvs,
+                                        const struct draw_vertex_info *vert_info,
+                                        const struct draw_prim_info *prim_info,
+                                        struct draw_prim_info *out_prim_info,
+                                        boolean *need_pipeline )
+{
+   struct draw_context *draw = pvs->draw;
+   const char *verts = (const char *)vert_info->verts;
+   const unsigned stride = vert_info->stride;
+   unsigned verts_per_prim, reject_mask, count, i, j, n;
+   unsigned need = 0;
+   ushort *elts;
+
+   /* Without a clip stage the clipmasks are never acted upon. */
+   if (!(draw->clip_xy || draw->clip_z || draw->clip_user))
+      return FALSE;
+
+   if (prim_info->primitive_count != 1 ||
+       vert_info->count > 0xffff + 1)
+      return FALSE;
+
+   reject_mask = ~0;
+   switch (prim_info->prim) {
+   case PIPE_PRIM_POINTS:
+      verts_per_prim = 1;
+      /* xy guard band points are only dropped for w <= 0 or inf/nan */
+      if (draw->guard_band_points_xy)
+         reject_mask = ~0xf;
+      break;
+   case PIPE_PRIM_LINES:
+      verts_per_prim = 2;
+      break;
+   case PIPE_PRIM_TRIANGLES:
+      verts_per_prim = 3;
+      break;
+   default:
+      return FALSE;
+   }
+
+   count = prim_info->primitive_lengths[0];
+   count -= count % verts_per_prim;
+
+   elts = MALLOC(MAX2(count, 1) * sizeof(ushort));
+   if (!elts)
+      return FALSE;
+   out_prim_info->primitive_lengths = MALLOC(sizeof(unsigned));
+   if (!out_prim_info->primitive_lengths) {
+      FREE(elts);
+      return FALSE;
+   }
+
+   for (i = n = 0; i < count; i += verts_per_prim) {
+      unsigned idx[3];
+      unsigned and_mask = ~0, or_mask = 0;
+
+      for (j = 0; j < verts_per_prim; j++) {
+         const struct vertex_header *v;
+
+         idx[j] = prim_info->linear ? i + j : prim_info->elts[i + j];
+         v = (const struct vertex_header *)(verts + idx[j] * stride);
+         and_mask &= v->clipmask;
+         or_mask |= v->clipmask | !v->edgeflag;
+      }
+
+      if (and_mask & reject_mask)
+         continue;
+
+      for (j = 0; j < verts_per_prim; j++)
+         elts[n++] = (ushort)idx[j];
+      need |= or_mask;
+   }
+
+   out_prim_info->linear = FALSE;
+   out_prim_info->start = 0;
+   out_prim_info->elts = elts;
+   out_prim_info->count = n;
+   out_prim_info->prim = prim_info->prim;
+   out_prim_info->flags = prim_info->flags;
+   out_prim_info->primitive_lengths[0] = n;
+   out_prim_info->primitive_count = 1;
+
+   *need_pipeline = need != 0;
+   return TRUE;
+}
+
+
 void draw_pt_post_vs_prepare( struct pt_post_vs *pvs,
 			      boolean clip_xy,
 			      boolean clip_z,
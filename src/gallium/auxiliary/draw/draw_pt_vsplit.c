@@ -29,9 +29,19 @@
 #include "draw/draw_context.h"
 #include "draw/draw_private.h"
 #include "draw/draw_pt.h"
+#include "draw/draw_vbuf.h"
 
 #define SEGMENT_SIZE 1024
-#define MAP_SIZE     256
+
+/* Independent primitives are packed into a segment until either the
+ * fetches or the draw elements run out, so allow more draw elements
+ * than fetches.
+ */
+#define DRAW_ELTS_SIZE (4 * SEGMENT_SIZE)
+
+/* Set-associative cache from fetch to draw elements */
+#define CACHE_SETS   256
+#define CACHE_WAYS   4
 
 /* The largest possible index withing an index buffer */
 #define MAX_ELT_IDX 0xffffffff
@@ -46,17 +56,20 @@ struct vsplit_frontend {
 
    unsigned max_vertices;
    ushort segment_size;
+   ushort draw_segment_size;
 
    /* buffers for splitting */
    unsigned fetch_elts[SEGMENT_SIZE];
-   ushort draw_elts[SEGMENT_SIZE];
+   ushort draw_elts[DRAW_ELTS_SIZE];
    ushort identity_draw_elts[SEGMENT_SIZE];
 
    struct {
-      /* map a fetch element to a draw element */
-      unsigned fetches[MAP_SIZE];
-      ushort draws[MAP_SIZE];
-      boolean has_max_fetch;
+      /* map a fetch element to a draw element, most recent first in
+       * each set
+       */
+      unsigned fetches[CACHE_SETS][CACHE_WAYS];
+      ushort draws[CACHE_SETS][CACHE_WAYS];
+      ubyte valid[CACHE_SETS];
 
       ushort num_fetch_elts;
       ushort num_draw_elts;
@@ -67,8 +80,7 @@ struct vsplit_frontend {
 static void
 vsplit_clear_cache(struct vsplit_frontend *vsplit)
 {
-   memset(vsplit->cache.fetches, 0xff, sizeof(vsplit->cache.fetches));
-   vsplit->cache.has_max_fetch = FALSE;
+   memset(vsplit->cache.valid, 0, sizeof(vsplit->cache.valid));
    vsplit->cache.num_fetch_elts = 0;
    vsplit->cache.num_draw_elts = 0;
 }
@@ -87,23 +99,41 @@ vsplit_flush_cache(struct vsplit_frontend *vsplit, unsigned flags)
 static INLINE void
 vsplit_add_cache(struct vsplit_frontend *vsplit, unsigned fetch, unsigned ofbias)
 {
-   unsigned hash;
-
-   hash = fetch % MAP_SIZE;
-
-   /* If the value isn't in the cache of it's an overflow due to the
-    * element bias */
-   if (vsplit->cache.fetches[hash] != fetch || ofbias) {
-      /* update cache */
-      vsplit->cache.fetches[hash] = fetch;
-      vsplit->cache.draws[hash] = vsplit->cache.num_fetch_elts;
+   const unsigned set = fetch % CACHE_SETS;
+   unsigned *fetches = vsplit->cache.fetches[set];
+   ushort *draws = vsplit->cache.draws[set];
+   unsigned valid = vsplit->cache.valid[set];
+   ushort draw;
+   unsigned i;
+
+   assert(vsplit->cache.num_draw_elts < DRAW_ELTS_SIZE);
+
+   /* An overflow due to the element bias is never a hit */
+   if (!ofbias) {
+      for (i = 0; i < valid; i++) {
+         if (fetches[i] == fetch) {
+            vsplit->draw_elts[vsplit->cache.num_draw_elts++] = draws[i];
+            return;
+         }
+      }
+   }
 
-      /* add fetch */
-      assert(vsplit->cache.num_fetch_elts < vsplit->segment_size);
-      vsplit->fetch_elts[vsplit->cache.num_fetch_elts++] = fetch;
+   /* add fetch */
+   assert(vsplit->cache.num_fetch_elts < vsplit->segment_size);
+   draw = vsplit->cache.num_fetch_elts;
+   vsplit->fetch_elts[vsplit->cache.num_fetch_elts++] = fetch;
+
+   /* update cache, evicting the oldest entry of a full set */
+   if (valid < CACHE_WAYS)
+      vsplit->cache.valid[set] = ++valid;
+   for (i = valid - 1; i > 0; i--) {
+      fetches[i] = fetches[i - 1];
+      draws[i] = draws[i - 1];
    }
+   fetches[0] = fetch;
+   draws[0] = draw;
 
-   vsplit->draw_elts[vsplit->cache.num_draw_elts++] = vsplit->cache.draws[hash];
+   vsplit->draw_elts[vsplit->cache.num_draw_elts++] = draw;
 }
 
 /**
@@ -198,16 +228,7 @@ vsplit_add_cache_uint(struct vsplit_frontend *vsplit, const uint *elts,
                       unsigned start, unsigned fetch, int elt_bias)
 {
    struct draw_context *draw = vsplit->draw;
-   unsigned raw_elem_idx = start + fetch + elt_bias;
    VSPLIT_CREATE_IDX(elts, start, fetch, elt_bias);
-
-   /* special care for DRAW_MAX_FETCH_IDX */
-   if (raw_elem_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch) {
-      unsigned hash = fetch % MAP_SIZE;
-      vsplit->cache.fetches[hash] = raw_elem_idx - 1; /* force update */
-      vsplit->cache.has_max_fetch = TRUE;
-   }
-
    vsplit_add_cache(vsplit, elt_idx, ofbias);
 }
 
@@ -263,6 +284,14 @@ static void vsplit_prepare(struct draw_pt_front_end *frontend,
    middle->prepare(middle, vsplit->prim, opt, &vsplit->max_vertices);
 
    vsplit->segment_size = MIN2(SEGMENT_SIZE, vsplit->max_vertices);
+   vsplit->draw_segment_size = MIN2(DRAW_ELTS_SIZE, vsplit->max_vertices);
+
+   /* The middle end may hand a segment's draw elements straight to the
+    * render in one draw_elements call, so keep them within its limit.
+    */
+   if (vsplit->draw->render)
+      vsplit->draw_segment_size = MIN2(vsplit->draw_segment_size,
+                                       vsplit->draw->render->max_indices);
 }
 
 
@@ -123,6 +123,49 @@ CONCAT(vsplit_primitive_, ELT_TYPE)(struct vsplit_frontend *vsplit,
                                           draw_elts, icount, 0x0);
 }
 
+/**
+ * Draw a long list of independent primitives (points, lines, triangles,
+ * quads, ...) through the cache, flushing whenever the fetch or draw
+ * elements of a segment run out rather than after a fixed number of
+ * indices. Indexed meshes usually reference each vertex several times,
+ * so this covers many more primitives per segment, and vertices on
+ * segment boundaries get shaded again less often.
+ */
+static boolean
+CONCAT(vsplit_list_, ELT_TYPE)(struct vsplit_frontend *vsplit,
+                               unsigned istart, unsigned icount)
+{
+   struct draw_context *draw = vsplit->draw;
+   const ELT_TYPE *ib = (const ELT_TYPE *) draw->pt.user.elts;
+   const int ibias = draw->pt.user.eltBias;
+   unsigned flags = DRAW_SPLIT_AFTER;
+   unsigned first, incr, i, j;
+
+   draw_pt_split_prim(vsplit->prim, &first, &incr);
+
+   /* short or connected primitives take the normal paths */
+   if (icount <= vsplit->segment_size || first != incr)
+      return FALSE;
+
+   vsplit_clear_cache(vsplit);
+
+   for (i = 0; i + incr <= icount; i += incr) {
+      if (vsplit->cache.num_fetch_elts + incr > vsplit->segment_size ||
+          vsplit->cache.num_draw_elts + incr > vsplit->draw_segment_size) {
+         vsplit_flush_cache(vsplit, flags);
+         flags |= DRAW_SPLIT_BEFORE;
+         vsplit_clear_cache(vsplit);
+      }
+
+      for (j = 0; j < incr; j++)
+         ADD_CACHE(vsplit, ib, istart, i + j, ibias);
+   }
+
+   vsplit_flush_cache(vsplit, flags & ~DRAW_SPLIT_AFTER);
+
+   return TRUE;
+}
+
 /**
  * Use the cache to prepare the fetch and draw elements, and flush.
  *
@@ -228,7 +271,8 @@ CONCAT(vsplit_segment_fan_, ELT_TYPE)(struct vsplit_frontend *vsplit,
    const unsigned max_count_fan = vsplit->segment_size;
 
 #define PRIMITIVE(istart, icount)   \
-   CONCAT(vsplit_primitive_, ELT_TYPE)(vsplit, istart, icount)
+   (CONCAT(vsplit_primitive_, ELT_TYPE)(vsplit, istart, icount) || \
+    CONCAT(vsplit_list_, ELT_TYPE)(vsplit, istart, icount))
 
 #else /* ELT_TYPE */
 
@@ -196,6 +196,17 @@ lp_sampler_static_sampler_state(struct lp_static_sampler_state *state,
    }
 
    state->normalized_coords = sampler->normalized_coords;
+
+   /*
+    * Anisotropic filtering only makes a difference when there's a mip chain
+    * to choose from (and is pointless when the lod is forced anyway).
+    */
+   if (sampler->max_anisotropy > 1 &&
+       state->min_mip_filter != PIPE_TEX_MIPFILTER_NONE &&
+       !state->min_max_lod_equal &&
+       state->normalized_coords) {
+      state->aniso = 1;
+   }
 }
 
 
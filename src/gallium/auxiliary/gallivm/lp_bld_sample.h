@@ -115,6 +115,7 @@ struct lp_static_sampler_state
    unsigned apply_min_lod:1;  /**< min_lod > 0 ? */
    unsigned apply_max_lod:1;  /**< max_lod < last_level ? */
    unsigned seamless_cube_map:1;
+   unsigned aniso:1;          /**< max_anisotropy > 1 ? */
 
    /* Hacks */
    unsigned force_nearest_s:1;
@@ -207,6 +208,11 @@ struct lp_sampler_dynamic_state
    (*lod_bias)(const struct lp_sampler_dynamic_state *state,
                struct gallivm_state *gallivm, unsigned sampler_unit);
 
+   /** Obtain texture max anisotropy (returns float) */
+   LLVMValueRef
+   (*max_aniso)(const struct lp_sampler_dynamic_state *state,
+                struct gallivm_state *gallivm, unsigned sampler_unit);
+
    /** Obtain texture border color (returns ptr to float[4]) */
    LLVMValueRef
    (*border_color)(const struct lp_sampler_dynamic_state *state,
@@ -2203,6 +2203,204 @@ lp_build_sample_general(struct lp_build_sample_context *bld,
 }
 
 
+/**
+ * Anisotropic texture sampling codegen.
+ *
+ * The pixel footprint in texture space is approximated by the two
+ * derivative vectors. Instead of choosing the lod from the major axis
+ * (which overblurs along the minor one at grazing angles) the lod is chosen
+ * from the major axis length divided by the number of probes, and that many
+ * ordinary (bi/trilinear) probes are taken and averaged along the major axis.
+ * This is the algorithm outlined in the EXT_texture_filter_anisotropic spec.
+ *
+ * The probe count is derived per quad (or per pixel with explicit
+ * derivatives) from the axis ratio, clamped to the sampler's max anisotropy.
+ * The loop only runs as many times as the most anisotropic quad in the vector
+ * requires, so isotropic quads just do a single ordinary lookup.
+ * Only used for 2D (non-cube) textures.
+ */
+static void
+lp_build_sample_aniso(struct lp_build_sample_context *bld,
+                      unsigned texture_index,
+                      unsigned sampler_index,
+                      LLVMValueRef *coords,
+                      const LLVMValueRef *offsets,
+                      const struct lp_derivatives *derivs, /* optional */
+                      LLVMValueRef lod_bias, /* optional */
+                      LLVMValueRef *colors_out)
+{
+   struct gallivm_state *gallivm = bld->gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   struct lp_build_context *coord_bld = &bld->coord_bld;
+   struct lp_build_context *int_bld = &bld->int_bld;
+   LLVMValueRef first_level, int_size, float_size, width, height;
+   LLVMValueRef dsdx, dtdx, dsdy, dtdy, ux, vx, uy, vy;
+   LLVMValueRef px2, py2, pmax2, pmin2, major_is_x;
+   LLVMValueRef axis_s, axis_t, max_aniso, ratio;
+   LLVMValueRef num_probes, num_probes_i, max_probes, rcp_probes;
+   LLVMValueRef lod, half;
+   LLVMValueRef lod_fpart = NULL, lod_positive = NULL;
+   LLVMValueRef ilevel0 = NULL, ilevel1 = NULL;
+   LLVMValueRef texels[4];
+   struct lp_build_loop_state loop_state;
+   unsigned chan, i;
+
+   assert(bld->dims == 2);
+
+   /*
+    * Derivatives of the normalized coords.
+    */
+   if (derivs) {
+      dsdx = derivs->ddx[0];
+      dtdx = derivs->ddx[1];
+      dsdy = derivs->ddy[0];
+      dtdy = derivs->ddy[1];
+   }
+   else {
+      dsdx = lp_build_ddx(coord_bld, coords[0]);
+      dtdx = lp_build_ddx(coord_bld, coords[1]);
+      dsdy = lp_build_ddy(coord_bld, coords[0]);
+      dtdy = lp_build_ddy(coord_bld, coords[1]);
+   }
+
+   /*
+    * Scale to texel space of the base level (same as lp_build_rho()).
+    */
+   first_level = bld->dynamic_state->first_level(bld->dynamic_state,
+                                                 gallivm, texture_index);
+   first_level = lp_build_broadcast_scalar(&bld->int_size_in_bld, first_level);
+   int_size = lp_build_minify(&bld->int_size_in_bld, bld->int_size,
+                              first_level, TRUE);
+   float_size = lp_build_int_to_float(&bld->float_size_in_bld, int_size);
+   width = lp_build_extract_broadcast(gallivm, bld->float_size_in_type,
+                                      coord_bld->type, float_size,
+                                      lp_build_const_int32(gallivm, 0));
+   height = lp_build_extract_broadcast(gallivm, bld->float_size_in_type,
+                                       coord_bld->type, float_size,
+                                       lp_build_const_int32(gallivm, 1));
+
+   ux = lp_build_mul(coord_bld, dsdx, width);
+   vx = lp_build_mul(coord_bld, dtdx, height);
+   uy = lp_build_mul(coord_bld, dsdy, width);
+   vy = lp_build_mul(coord_bld, dtdy, height);
+
+   /* squared lengths of the footprint axes */
+   px2 = lp_build_add(coord_bld, lp_build_mul(coord_bld, ux, ux),
+                                 lp_build_mul(coord_bld, vx, vx));
+   py2 = lp_build_add(coord_bld, lp_build_mul(coord_bld, uy, uy),
+                                 lp_build_mul(coord_bld, vy, vy));
+
+   major_is_x = lp_build_cmp(coord_bld, PIPE_FUNC_GEQUAL, px2, py2);
+   pmax2 = lp_build_select(coord_bld, major_is_x, px2, py2);
+   pmin2 = lp_build_select(coord_bld, major_is_x, py2, px2);
+   axis_s = lp_build_select(coord_bld, major_is_x, dsdx, dsdy);
+   axis_t = lp_build_select(coord_bld, major_is_x, dtdx, dtdy);
+
+   /*
+    * num_probes = clamp(ceil(pmax / pmin), 1, max_aniso)
+    * Degenerate footprints (pmin == 0) just end up using max_aniso probes.
+    */
+   max_aniso = bld->dynamic_state->max_aniso(bld->dynamic_state,
+                                             gallivm, sampler_index);
+   max_aniso = lp_build_broadcast_scalar(coord_bld, max_aniso);
+   pmin2 = lp_build_max(coord_bld, pmin2,
+                        lp_build_const_vec(gallivm, coord_bld->type, FLT_MIN));
+   ratio = lp_build_sqrt(coord_bld, lp_build_div(coord_bld, pmax2, pmin2));
+   num_probes = lp_build_ceil(coord_bld, ratio);
+   num_probes = lp_build_clamp(coord_bld, num_probes, coord_bld->one, max_aniso);
+   rcp_probes = lp_build_rcp(coord_bld, num_probes);
+
+   /*
+    * lod = log2(pmax / num_probes) = 0.5 * log2(pmax^2 / num_probes^2)
+    */
+   lod = lp_build_mul(coord_bld, pmax2, lp_build_mul(coord_bld, rcp_probes,
+                                                     rcp_probes));
+   lod = lp_build_fast_log2(coord_bld, lod);
+   half = lp_build_const_vec(gallivm, coord_bld->type, 0.5F);
+   lod = lp_build_mul(coord_bld, lod, half);
+   if (lod_bias) {
+      lod = lp_build_add(coord_bld, lod, lod_bias);
+   }
+
+   /*
+    * The rest of the lod handling (sampler bias, clamping, mip level
+    * selection, min/mag switch) is the same as for explicit lod.
+    */
+   lp_build_sample_common(bld, texture_index, sampler_index,
+                          coords, NULL, NULL, lod,
+                          &lod_positive, &lod_fpart,
+                          &ilevel0, &ilevel1);
+
+   /* number of loop iterations is the max probe count of the whole vector */
+   num_probes_i = lp_build_itrunc(coord_bld, num_probes);
+   max_probes = int_bld->one;
+   for (i = 0; i < coord_bld->type.length; i++) {
+      LLVMValueRef elem = LLVMBuildExtractElement(builder, num_probes_i,
+                                                  lp_build_const_int32(gallivm, i), "");
+      max_probes = lp_build_max(int_bld, max_probes, elem);
+   }
+
+   for (chan = 0; chan < 4; ++chan) {
+      texels[chan] = lp_build_alloca(gallivm, bld->texel_bld.vec_type, "");
+      lp_build_name(texels[chan], "sampler%u_aniso_texel_%c_var",
+                    sampler_index, "xyzw"[chan]);
+      LLVMBuildStore(builder, bld->texel_bld.zero, texels[chan]);
+   }
+
+   lp_build_loop_begin(&loop_state, gallivm, int_bld->zero);
+   {
+      LLVMValueRef probe, offset, active, weight;
+      LLVMValueRef probe_coords[5], probe_texels[4];
+
+      probe = LLVMBuildSIToFP(builder, loop_state.counter,
+                              bld->float_bld.vec_type, "");
+      probe = lp_build_broadcast_scalar(coord_bld, probe);
+
+      /*
+       * Probes are evenly spaced along the major axis, centered on the
+       * sample position, i.e. offset = (probe + 0.5) / num_probes - 0.5.
+       * Pixels needing fewer probes than others in the vector get zero
+       * weight for the excess ones (offset is clamped to stay close to the
+       * footprint, which keeps those fetches cache friendly).
+       */
+      offset = lp_build_add(coord_bld, probe, half);
+      offset = lp_build_mul(coord_bld, offset, rcp_probes);
+      offset = lp_build_sub(coord_bld, offset, half);
+      offset = lp_build_min(coord_bld, offset, half);
+      active = lp_build_cmp(coord_bld, PIPE_FUNC_LESS, probe, num_probes);
+      weight = lp_build_select(coord_bld, active, rcp_probes, coord_bld->zero);
+
+      probe_coords[0] = lp_build_add(coord_bld, coords[0],
+                                     lp_build_mul(coord_bld, offset, axis_s));
+      probe_coords[1] = lp_build_add(coord_bld, coords[1],
+                                     lp_build_mul(coord_bld, offset, axis_t));
+      probe_coords[2] = coords[2];
+      probe_coords[3] = coords[3];
+      probe_coords[4] = coords[4];
+
+      lp_build_sample_general(bld, sampler_index,
+                              probe_coords, offsets,
+                              lod_positive, lod_fpart,
+                              ilevel0, ilevel1,
+                              probe_texels);
+
+      for (chan = 0; chan < 4; ++chan) {
+         LLVMValueRef sum = LLVMBuildLoad(builder, texels[chan], "");
+         LLVMValueRef texel = lp_build_mul(coord_bld, probe_texels[chan], weight);
+         sum = lp_build_add(coord_bld, sum, texel);
+         LLVMBuildStore(builder, sum, texels[chan]);
+      }
+   }
+   lp_build_loop_end_cond(&loop_state, max_probes, NULL, LLVMIntSGE);
+
+   for (chan = 0; chan < 4; ++chan) {
+      colors_out[chan] = LLVMBuildLoad(builder, texels[chan], "");
+      lp_build_name(colors_out[chan], "sampler%u_aniso_texel_%c",
+                    sampler_index, "xyzw"[chan]);
+   }
+}
+
+
 /**
  * Texel fetch function.
  * In contrast to general sampling there is no filtering, no coord minification,
@@ -2386,6 +2584,7 @@ lp_build_sample_soa(struct gallivm_state *gallivm,
    unsigned mip_filter, min_img_filter, mag_img_filter, i;
    struct lp_build_sample_context bld;
    struct lp_static_sampler_state derived_sampler_state = *static_sampler_state;
+   boolean use_aniso;
    LLVMTypeRef i32t = LLVMInt32TypeInContext(gallivm->context);
    LLVMBuilderRef builder = gallivm->builder;
    LLVMValueRef tex_width, newcoords[5];
@@ -2455,6 +2654,18 @@ lp_build_sample_soa(struct gallivm_state *gallivm,
    }
    mip_filter = derived_sampler_state.min_mip_filter;
 
+   /*
+    * Anisotropic filtering is only done for plain 2D textures with implicit
+    * lod, and (since probes are averaged) float texels.
+    */
+   use_aniso = derived_sampler_state.aniso &&
+               !is_fetch && !explicit_lod &&
+               mip_filter != PIPE_TEX_MIPFILTER_NONE &&
+               dims == 2 &&
+               target != PIPE_TEXTURE_CUBE &&
+               target != PIPE_TEXTURE_CUBE_ARRAY &&
+               bld.texel_type.floating;
+
    if (0) {
       debug_printf("  .min_mip_filter = %u\n", derived_sampler_state.min_mip_filter);
    }
@@ -2624,6 +2835,13 @@ lp_build_sample_soa(struct gallivm_state *gallivm,
                            texel_out);
    }
 
+   else if (use_aniso) {
+      lp_build_sample_aniso(&bld, texture_index, sampler_index,
+                            newcoords, offsets,
+                            derivs, lod_bias,
+                            texel_out);
+   }
+
    else {
       LLVMValueRef lod_fpart = NULL, lod_positive = NULL;
       LLVMValueRef ilevel0 = NULL, ilevel1 = NULL;
@@ -85,6 +85,27 @@ static INLINE int pipe_thread_destroy( pipe_thread thread )
    return thrd_detach( thread );
 }
 
+/**
+ * Restrict the calling thread to run on the given cpu only.
+ * Returns FALSE if that's not supported on this platform or failed.
+ */
+static INLINE boolean pipe_thread_pin_to_cpu( unsigned cpu )
+{
+#if defined(PIPE_OS_LINUX) && !defined(PIPE_OS_ANDROID) && defined(HAVE_PTHREAD)
+   cpu_set_t set;
+
+   if (cpu >= CPU_SETSIZE)
+      return FALSE;
+
+   CPU_ZERO(&set);
+   CPU_SET(cpu, &set);
+   return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+   (void) cpu;
+   return FALSE;
+#endif
+}
+
 
 /* pipe_mutex
  */
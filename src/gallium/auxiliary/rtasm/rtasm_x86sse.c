@@ -1490,6 +1490,13 @@ void sse2_por( struct x86_function *p, struct x86_reg dst, struct x86_reg src )
    emit_modrm(p, dst, src);
 }
 
+void sse2_pand( struct x86_function *p, struct x86_reg dst, struct x86_reg src )
+{
+   DUMP_RR(dst, src);
+   emit_3ub(p, 0x66, 0x0f, 0xdb);
+   emit_modrm(p, dst, src);
+}
+
 void sse2_rcpps( struct x86_function *p,
                  struct x86_reg dst,
                  struct x86_reg src )
@@ -1508,6 +1515,69 @@ void sse2_rcpss( struct x86_function *p,
    emit_modrm( p, dst, src );
 }
 
+/***********************************************************************
+ * AVX instructions
+ */
+
+/* VEX.pp values, standing for the implied legacy prefix */
+#define VEX_PP_NONE 0
+#define VEX_PP_66   1
+#define VEX_PP_F3   2
+#define VEX_PP_F2   3
+
+/* VEX.m-mmmm values, standing for the implied leading opcode bytes */
+#define VEX_MAP_0F    1
+#define VEX_MAP_0F38  2
+#define VEX_MAP_0F3A  3
+
+/* Emit a VEX prefix.  vvvv is the extra source register, or 0 if the
+ * instruction has none.  Like emit_modrm, this doesn't support the
+ * extended x86-64 registers, so the R, X and B bits are always clear
+ * (set, as they're stored inverted).
+ */
+static void emit_vex( struct x86_function *p,
+                      unsigned map,
+                      unsigned pp,
+                      unsigned vvvv,
+                      boolean w,
+                      boolean l256 )
+{
+   unsigned char last = (((~vvvv) & 0xf) << 3) | (l256 << 2) | pp;
+
+   if (map == VEX_MAP_0F && !w) {
+      emit_2ub(p, 0xc5, 0x80 | last);
+   }
+   else {
+      emit_3ub(p, 0xc4, 0xe0 | map, (w << 7) | last);
+   }
+}
+
+/* Convert four half floats in the low 64 bits of src to floats.
+ */
+void f16c_vcvtph2ps( struct x86_function *p, struct x86_reg dst, struct x86_reg src )
+{
+   DUMP_RR(dst, src);
+   assert(dst.mod == mod_REG);
+   emit_vex(p, VEX_MAP_0F38, VEX_PP_66, 0, FALSE, FALSE);
+   emit_1ub(p, 0x13);
+   emit_modrm(p, dst, src);
+}
+
+/* Convert four floats to half floats in the low 64 bits of dst, with the
+ * rounding mode given by imm (0 for round to nearest even).
+ */
+void f16c_vcvtps2ph( struct x86_function *p, struct x86_reg dst, struct x86_reg src,
+                     unsigned char imm )
+{
+   DUMP_RRI(dst, src, imm);
+   assert(src.mod == mod_REG);
+   emit_vex(p, VEX_MAP_0F3A, VEX_PP_66, 0, FALSE, FALSE);
+   emit_1ub(p, 0x1d);
+   emit_modrm(p, src, dst);
+   emit_1ub(p, imm);
+}
+
+
 /***********************************************************************
  * x87 instructions
  */
@@ -2164,6 +2234,11 @@ static void x86_init_func_common( struct x86_function *p )
       p->caps |= X86_SSE3;
    if(util_cpu_caps.has_sse4_1)
       p->caps |= X86_SSE4_1;
+   if(util_cpu_caps.has_avx)
+      p->caps |= X86_AVX;
+   /* F16C is VEX encoded, so it also needs OS support for AVX */
+   if(util_cpu_caps.has_avx && util_cpu_caps.has_f16c)
+      p->caps |= X86_F16C;
    p->csr = p->store;
    DUMP_START();
 }
@@ -60,6 +60,7 @@
 #include "tgsi_exec.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
+#include "util/u_sse.h"
 
 
 #define DEBUG_EXECUTION 0
@@ -632,6 +633,10 @@ tgsi_check_soa_dependencies(const struct tgsi_full_instruction *inst)
 }
 
 
+static void
+decode_instructions(struct tgsi_exec_machine *mach);
+
+
 /**
  * Initialize machine state by expanding tokens to full instructions,
  * allocating temporary storage, setting up constants, etc.
@@ -670,6 +675,9 @@ tgsi_exec_machine_bind_shader(
       mach->Instructions = NULL;
       mach->NumInstructions = 0;
 
+      FREE(mach->Decoded);
+      mach->Decoded = NULL;
+
       return;
    }
 
@@ -802,6 +810,25 @@ tgsi_exec_machine_bind_shader(
    }
    tgsi_parse_free (&parse);
 
+   /* Every primitive holds at least one vertex, so an invocation can't
+    * emit more than MaxOutputVertices of them.
+    */
+   if (mach->Processor == TGSI_PROCESSOR_GEOMETRY &&
+       mach->MaxOutputVertices + 1 > mach->MaxPrimitives) {
+      unsigned max_prims = mach->MaxOutputVertices + 1;
+      unsigned *prims = MALLOC(TGSI_QUAD_SIZE * max_prims * sizeof(unsigned));
+
+      if (prims) {
+         FREE(mach->Primitives[0]);
+         for (k = 0; k < TGSI_QUAD_SIZE; k++)
+            mach->Primitives[k] = prims + k * max_prims;
+         mach->MaxPrimitives = max_prims;
+      }
+      else {
+         mach->MaxOutputVertices = mach->MaxPrimitives - 1;
+      }
+   }
+
    FREE(mach->Declarations);
    mach->Declarations = declarations;
    mach->NumDeclarations = numDeclarations;
@@ -809,6 +836,8 @@ tgsi_exec_machine_bind_shader(
    FREE(mach->Instructions);
    mach->Instructions = instructions;
    mach->NumInstructions = numInstructions;
+
+   decode_instructions(mach);
 }
 
 
@@ -833,6 +862,14 @@ tgsi_exec_machine_create( void )
    if (!mach->Inputs || !mach->Outputs)
       goto fail;
 
+   mach->Primitives[0] =
+      MALLOC(TGSI_QUAD_SIZE * TGSI_MAX_PRIMITIVES * sizeof(unsigned));
+   if (!mach->Primitives[0])
+      goto fail;
+   for (i = 1; i < TGSI_QUAD_SIZE; i++)
+      mach->Primitives[i] = mach->Primitives[0] + i * TGSI_MAX_PRIMITIVES;
+   mach->MaxPrimitives = TGSI_MAX_PRIMITIVES;
+
    /* Setup constants needed by the SSE2 executor. */
    for( i = 0; i < 4; i++ ) {
       mach->Temps[TGSI_EXEC_TEMP_00000000_I].xyzw[TGSI_EXEC_TEMP_00000000_C].u[i] = 0x00000000;
@@ -859,6 +896,7 @@ fail:
    if (mach) {
       align_free(mach->Inputs);
       align_free(mach->Outputs);
+      FREE(mach->Primitives[0]);
       align_free(mach);
    }
    return NULL;
@@ -870,10 +908,12 @@ tgsi_exec_machine_destroy(struct tgsi_exec_machine *mach)
 {
    if (mach) {
       FREE(mach->Instructions);
+      FREE(mach->Decoded);
       FREE(mach->Declarations);
 
       align_free(mach->Inputs);
       align_free(mach->Outputs);
+      FREE(mach->Primitives[0]);
 
       align_free(mach);
    }
@@ -1135,12 +1175,71 @@ fetch_src_file_channel(const struct tgsi_exec_machine *mach,
    }
 }
 
+/**
+ * Fetch a direct, one dimensional source operand.  All the lanes read
+ * the same register so whole channels are copied instead of gathering
+ * each lane through an index vector.
+ * \return FALSE if the register file has no fast path
+ */
+static boolean
+fetch_src_direct(const struct tgsi_exec_machine *mach,
+                 union tgsi_exec_channel *chan,
+                 const struct tgsi_full_src_register *reg,
+                 const uint chan_index)
+{
+   const uint swizzle = tgsi_util_get_full_src_register_swizzle(reg, chan_index);
+   const int index = reg->Register.Index;
+
+   assert(swizzle < 4);
+
+   switch (reg->Register.File) {
+   case TGSI_FILE_TEMPORARY:
+      assert(index >= 0 && index < TGSI_EXEC_NUM_TEMPS);
+      *chan = mach->Temps[index].xyzw[swizzle];
+      return TRUE;
+
+   case TGSI_FILE_INPUT:
+      assert(index >= 0);
+      *chan = mach->Inputs[index].xyzw[swizzle];
+      return TRUE;
+
+   case TGSI_FILE_IMMEDIATE:
+      assert(index >= 0 && index < (int)mach->ImmLimit);
+      chan->f[0] =
+      chan->f[1] =
+      chan->f[2] =
+      chan->f[3] = mach->Imms[index][swizzle];
+      return TRUE;
+
+   case TGSI_FILE_CONSTANT:
+      {
+         const uint *buf = (const uint *)mach->Consts[0];
+         const int pos = index * 4 + swizzle;
+         uint value = 0;
+
+         assert(buf);
+
+         /* same bounds check as fetch_src_file_channel() */
+         if (index >= 0 && pos < (int) mach->ConstsSize[0])
+            value = buf[pos];
+
+         chan->u[0] =
+         chan->u[1] =
+         chan->u[2] =
+         chan->u[3] = value;
+      }
+      return TRUE;
+
+   default:
+      return FALSE;
+   }
+}
+
 static void
-fetch_source(const struct tgsi_exec_machine *mach,
-             union tgsi_exec_channel *chan,
-             const struct tgsi_full_src_register *reg,
-             const uint chan_index,
-             enum tgsi_exec_datatype src_datatype)
+fetch_src_indexed(const struct tgsi_exec_machine *mach,
+                  union tgsi_exec_channel *chan,
+                  const struct tgsi_full_src_register *reg,
+                  const uint chan_index)
 {
    union tgsi_exec_channel index;
    union tgsi_exec_channel index2D;
@@ -1283,6 +1382,19 @@ fetch_source(const struct tgsi_exec_machine *mach,
                           &index,
                           &index2D,
                           chan);
+}
+
+static void
+fetch_source(const struct tgsi_exec_machine *mach,
+             union tgsi_exec_channel *chan,
+             const struct tgsi_full_src_register *reg,
+             const uint chan_index,
+             enum tgsi_exec_datatype src_datatype)
+{
+   if (reg->Register.Indirect || reg->Register.Dimension ||
+       !fetch_src_direct(mach, chan, reg, chan_index)) {
+      fetch_src_indexed(mach, chan, reg, chan_index);
+   }
 
    if (reg->Register.Absolute) {
       if (src_datatype == TGSI_EXEC_DATA_FLOAT) {
@@ -1301,6 +1413,54 @@ fetch_source(const struct tgsi_exec_machine *mach,
    }
 }
 
+static INLINE void
+store_dest_channel(union tgsi_exec_channel *dst,
+                   const union tgsi_exec_channel *chan,
+                   uint execmask,
+                   uint saturate)
+{
+   uint i;
+
+   switch (saturate) {
+   case TGSI_SAT_NONE:
+      if (execmask == TGSI_QUAD_MASK) {
+         *dst = *chan;
+         break;
+      }
+      for (i = 0; i < TGSI_QUAD_SIZE; i++)
+         if (execmask & (1 << i))
+            dst->i[i] = chan->i[i];
+      break;
+
+   case TGSI_SAT_ZERO_ONE:
+      for (i = 0; i < TGSI_QUAD_SIZE; i++)
+         if (execmask & (1 << i)) {
+            if (chan->f[i] < 0.0f)
+               dst->f[i] = 0.0f;
+            else if (chan->f[i] > 1.0f)
+               dst->f[i] = 1.0f;
+            else
+               dst->i[i] = chan->i[i];
+         }
+      break;
+
+   case TGSI_SAT_MINUS_PLUS_ONE:
+      for (i = 0; i < TGSI_QUAD_SIZE; i++)
+         if (execmask & (1 << i)) {
+            if (chan->f[i] < -1.0f)
+               dst->f[i] = -1.0f;
+            else if (chan->f[i] > 1.0f)
+               dst->f[i] = 1.0f;
+            else
+               dst->i[i] = chan->i[i];
+         }
+      break;
+
+   default:
+      assert( 0 );
+   }
+}
+
 static void
 store_dest(struct tgsi_exec_machine *mach,
            const union tgsi_exec_channel *chan,
@@ -1517,40 +1677,22 @@ store_dest(struct tgsi_exec_machine *mach,
       }
    }
 
-   switch (inst->Instruction.Saturate) {
-   case TGSI_SAT_NONE:
-      for (i = 0; i < TGSI_QUAD_SIZE; i++)
-         if (execmask & (1 << i))
-            dst->i[i] = chan->i[i];
-      break;
-
-   case TGSI_SAT_ZERO_ONE:
-      for (i = 0; i < TGSI_QUAD_SIZE; i++)
-         if (execmask & (1 << i)) {
-            if (chan->f[i] < 0.0f)
-               dst->f[i] = 0.0f;
-            else if (chan->f[i] > 1.0f)
-               dst->f[i] = 1.0f;
-            else
-               dst->i[i] = chan->i[i];
-         }
-      break;
+   if (reg->Register.File == TGSI_FILE_OUTPUT &&
+       mach->Processor == TGSI_PROCESSOR_GEOMETRY) {
+      /* each lane writes to the vertex it is currently emitting */
+      const unsigned *output = mach->Temps[TEMP_OUTPUT_I].xyzw[TEMP_OUTPUT_C].u;
 
-   case TGSI_SAT_MINUS_PLUS_ONE:
-      for (i = 0; i < TGSI_QUAD_SIZE; i++)
+      for (i = 0; i < TGSI_QUAD_SIZE; i++) {
          if (execmask & (1 << i)) {
-            if (chan->f[i] < -1.0f)
-               dst->f[i] = -1.0f;
-            else if (chan->f[i] > 1.0f)
-               dst->f[i] = 1.0f;
-            else
-               dst->i[i] = chan->i[i];
+            index = output[i] + reg->Register.Index;
+            store_dest_channel(&mach->Outputs[offset + index].xyzw[chan_index],
+                               chan, 1 << i, inst->Instruction.Saturate);
          }
-      break;
-
-   default:
-      assert( 0 );
+      }
+      return;
    }
+
+   store_dest_channel(dst, chan, execmask, inst->Instruction.Saturate);
 }
 
 #define FETCH(VAL,INDEX,CHAN)\
@@ -1620,33 +1762,45 @@ exec_kill(struct tgsi_exec_machine *mach,
 static void
 emit_vertex(struct tgsi_exec_machine *mach)
 {
-   /* FIXME: check for exec mask correctly
+   unsigned *output = mach->Temps[TEMP_OUTPUT_I].xyzw[TEMP_OUTPUT_C].u;
+   unsigned *prim_count = mach->Temps[TEMP_PRIMITIVE_I].xyzw[TEMP_PRIMITIVE_C].u;
    unsigned i;
-   for (i = 0; i < TGSI_QUAD_SIZE; ++i) {
-         if ((mach->ExecMask & (1 << i)))
-   */
-   if (mach->ExecMask) {
-      if (mach->Primitives[mach->Temps[TEMP_PRIMITIVE_I].xyzw[TEMP_PRIMITIVE_C].u[0]] >= mach->MaxOutputVertices)
-         return;
 
-      mach->Temps[TEMP_OUTPUT_I].xyzw[TEMP_OUTPUT_C].u[0] += mach->NumOutputs;
-      mach->Primitives[mach->Temps[TEMP_PRIMITIVE_I].xyzw[TEMP_PRIMITIVE_C].u[0]]++;
+   for (i = 0; i < TGSI_QUAD_SIZE; i++) {
+      if (!(mach->ExecMask & (1 << i)))
+         continue;
+
+      /* drop vertices beyond max_vertices */
+      if (output[i] >= mach->MaxOutputVertices * mach->NumOutputs)
+         continue;
+
+      output[i] += mach->NumOutputs;
+      mach->Primitives[i][prim_count[i]]++;
+   }
+}
+
+static void
+end_primitive(struct tgsi_exec_machine *mach, unsigned lane)
+{
+   unsigned *prim_count =
+      &mach->Temps[TEMP_PRIMITIVE_I].xyzw[TEMP_PRIMITIVE_C].u[lane];
+
+   /* an empty primitive doesn't need to be sent down */
+   if (mach->Primitives[lane][*prim_count]) {
+      ++(*prim_count);
+      debug_assert(*prim_count < mach->MaxPrimitives);
+      mach->Primitives[lane][*prim_count] = 0;
    }
 }
 
 static void
 emit_primitive(struct tgsi_exec_machine *mach)
 {
-   unsigned *prim_count = &mach->Temps[TEMP_PRIMITIVE_I].xyzw[TEMP_PRIMITIVE_C].u[0];
-   /* FIXME: check for exec mask correctly
    unsigned i;
-   for (i = 0; i < TGSI_QUAD_SIZE; ++i) {
-         if ((mach->ExecMask & (1 << i)))
-   */
-   if (mach->ExecMask) {
-      ++(*prim_count);
-      debug_assert((*prim_count * mach->NumOutputs) < mach->MaxGeometryShaderOutputs);
-      mach->Primitives[*prim_count] = 0;
+
+   for (i = 0; i < TGSI_QUAD_SIZE; i++) {
+      if (mach->ExecMask & (1 << i))
+         end_primitive(mach, i);
    }
 }
 
@@ -1654,11 +1808,11 @@ static void
 conditional_emit_primitive(struct tgsi_exec_machine *mach)
 {
    if (TGSI_PROCESSOR_GEOMETRY == mach->Processor) {
-      int emitted_verts =
-         mach->Primitives[mach->Temps[TEMP_PRIMITIVE_I].xyzw[TEMP_PRIMITIVE_C].u[0]];
-      if (emitted_verts) {
-         emit_primitive(mach);
-      }
+      unsigned i;
+
+      /* lanes which returned early still get their last primitive ended */
+      for (i = 0; i < TGSI_QUAD_SIZE; i++)
+         end_primitive(mach, i);
    }
 }
 
@@ -4606,6 +4760,606 @@ exec_instruction(
 }
 
 
+/*
+ * Pre-decoded instructions.
+ *
+ * When a shader is bound every instruction gets a handler.  Float
+ * arithmetic on direct registers is common enough in vertex and
+ * fragment shaders to get handlers that have their operands resolved
+ * up front and work on a whole quad per channel, with SSE where
+ * available.  Everything else is handed to exec_instruction().
+ *
+ * The handlers compute the same operations in the same order as the
+ * micro ops they replace, so results are bit for bit identical.
+ */
+
+#if defined(PIPE_ARCH_SSE)
+
+typedef __m128 quad_float;
+
+static INLINE quad_float
+quad_load(const float *f)
+{
+   return _mm_loadu_ps(f);
+}
+
+static INLINE void
+quad_store(float *f, quad_float q)
+{
+   _mm_storeu_ps(f, q);
+}
+
+static INLINE quad_float
+quad_splat(float f)
+{
+   return _mm_set1_ps(f);
+}
+
+static INLINE quad_float
+quad_add(quad_float a, quad_float b)
+{
+   return _mm_add_ps(a, b);
+}
+
+static INLINE quad_float
+quad_sub(quad_float a, quad_float b)
+{
+   return _mm_sub_ps(a, b);
+}
+
+static INLINE quad_float
+quad_mul(quad_float a, quad_float b)
+{
+   return _mm_mul_ps(a, b);
+}
+
+/* a < b ? a : b, like micro_min(), including for NaNs */
+static INLINE quad_float
+quad_min(quad_float a, quad_float b)
+{
+   return _mm_min_ps(a, b);
+}
+
+/* a > b ? a : b, like micro_max(), including for NaNs */
+static INLINE quad_float
+quad_max(quad_float a, quad_float b)
+{
+   return _mm_max_ps(a, b);
+}
+
+static INLINE quad_float
+quad_abs(quad_float a)
+{
+   return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+}
+
+static INLINE quad_float
+quad_neg(quad_float a)
+{
+   return _mm_xor_ps(_mm_set1_ps(-0.0f), a);
+}
+
+#else
+
+typedef union tgsi_exec_channel quad_float;
+
+static INLINE quad_float
+quad_load(const float *f)
+{
+   quad_float q;
+   memcpy(q.f, f, sizeof(q.f));
+   return q;
+}
+
+static INLINE void
+quad_store(float *f, quad_float q)
+{
+   memcpy(f, q.f, sizeof(q.f));
+}
+
+static INLINE quad_float
+quad_splat(float f)
+{
+   quad_float q;
+   q.f[0] = q.f[1] = q.f[2] = q.f[3] = f;
+   return q;
+}
+
+static INLINE quad_float
+quad_add(quad_float a, quad_float b)
+{
+   micro_add(&a, &a, &b);
+   return a;
+}
+
+static INLINE quad_float
+quad_sub(quad_float a, quad_float b)
+{
+   micro_sub(&a, &a, &b);
+   return a;
+}
+
+static INLINE quad_float
+quad_mul(quad_float a, quad_float b)
+{
+   micro_mul(&a, &a, &b);
+   return a;
+}
+
+static INLINE quad_float
+quad_min(quad_float a, quad_float b)
+{
+   micro_min(&a, &a, &b);
+   return a;
+}
+
+static INLINE quad_float
+quad_max(quad_float a, quad_float b)
+{
+   micro_max(&a, &a, &b);
+   return a;
+}
+
+static INLINE quad_float
+quad_abs(quad_float a)
+{
+   micro_abs(&a, &a);
+   return a;
+}
+
+static INLINE quad_float
+quad_neg(quad_float a)
+{
+   micro_neg(&a, &a);
+   return a;
+}
+
+#endif /* PIPE_ARCH_SSE */
+
+
+enum decoded_src_kind {
+   DECODED_SRC_VECTOR,    /**< TEMP or INPUT channel, one value per lane */
+   DECODED_SRC_SCALAR,    /**< IMM value, the same for all lanes */
+   DECODED_SRC_CONSTANT   /**< CONST[0] value, bounds checked when run */
+};
+
+struct decoded_src
+{
+   enum decoded_src_kind kind;
+   boolean absolute;
+   boolean negate;
+   const float *ptr[TGSI_NUM_CHANNELS];  /**< VECTOR and SCALAR, swizzled */
+   int pos[TGSI_NUM_CHANNELS];           /**< CONSTANT, swizzled */
+};
+
+typedef void (* decoded_func)(struct tgsi_exec_machine *mach,
+                              const struct tgsi_exec_decoded_inst *dec,
+                              int *pc);
+
+struct tgsi_exec_decoded_inst
+{
+   decoded_func func;
+   const struct tgsi_full_instruction *inst;
+
+   /* Only set up for the arithmetic handlers */
+   struct decoded_src src[3];
+   uint writemask;
+   uint saturate;
+   uint dst_file;      /**< TGSI_FILE_TEMPORARY or TGSI_FILE_OUTPUT */
+   int dst_index;
+};
+
+
+static INLINE quad_float
+fetch_decoded(const struct tgsi_exec_machine *mach,
+              const struct decoded_src *src,
+              uint chan)
+{
+   quad_float q;
+
+   switch (src->kind) {
+   case DECODED_SRC_VECTOR:
+      q = quad_load(src->ptr[chan]);
+      break;
+
+   case DECODED_SRC_SCALAR:
+      q = quad_splat(*src->ptr[chan]);
+      break;
+
+   default:
+      {
+         /* same bounds check as fetch_src_direct() */
+         const int pos = src->pos[chan];
+         union fi value;
+
+         value.ui = 0;
+         if (pos >= 0 && pos < (int) mach->ConstsSize[0])
+            value.ui = ((const uint *) mach->Consts[0])[pos];
+         q = quad_splat(value.f);
+      }
+      break;
+   }
+
+   if (src->absolute)
+      q = quad_abs(q);
+   if (src->negate)
+      q = quad_neg(q);
+
+   return q;
+}
+
+static void
+store_decoded(struct tgsi_exec_machine *mach,
+              const struct tgsi_exec_decoded_inst *dec,
+              const quad_float *dst)
+{
+   struct tgsi_exec_vector *reg;
+   uint chan;
+
+   if (dec->dst_file == TGSI_FILE_OUTPUT)
+      reg = &mach->Outputs[mach->Temps[TEMP_OUTPUT_I].xyzw[TEMP_OUTPUT_C].u[0] +
+                           dec->dst_index];
+   else
+      reg = &mach->Temps[dec->dst_index];
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      if (dec->writemask & (1 << chan)) {
+         quad_float q = dst[chan];
+
+         /* Clamp the way store_dest_channel() does: the comparisons are
+          * false for NaNs, which are passed through.
+          */
+         if (dec->saturate == TGSI_SAT_ZERO_ONE)
+            q = quad_min(quad_splat(1.0f), quad_max(quad_splat(0.0f), q));
+         else if (dec->saturate == TGSI_SAT_MINUS_PLUS_ONE)
+            q = quad_min(quad_splat(1.0f), quad_max(quad_splat(-1.0f), q));
+
+         if (mach->ExecMask == TGSI_QUAD_MASK) {
+            quad_store(reg->xyzw[chan].f, q);
+         }
+         else {
+            union tgsi_exec_channel tmp;
+
+            quad_store(tmp.f, q);
+            store_dest_channel(&reg->xyzw[chan], &tmp, mach->ExecMask,
+                               TGSI_SAT_NONE);
+         }
+      }
+   }
+}
+
+static void
+exec_decoded_generic(struct tgsi_exec_machine *mach,
+                     const struct tgsi_exec_decoded_inst *dec,
+                     int *pc)
+{
+   exec_instruction(mach, dec->inst, pc);
+}
+
+static void
+exec_decoded_mov(struct tgsi_exec_machine *mach,
+                 const struct tgsi_exec_decoded_inst *dec,
+                 int *pc)
+{
+   quad_float dst[TGSI_NUM_CHANNELS];
+   uint chan;
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      if (dec->writemask & (1 << chan))
+         dst[chan] = fetch_decoded(mach, &dec->src[0], chan);
+   }
+   store_decoded(mach, dec, dst);
+   (*pc)++;
+}
+
+static void
+exec_decoded_add(struct tgsi_exec_machine *mach,
+                 const struct tgsi_exec_decoded_inst *dec,
+                 int *pc)
+{
+   quad_float dst[TGSI_NUM_CHANNELS];
+   uint chan;
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      if (dec->writemask & (1 << chan))
+         dst[chan] = quad_add(fetch_decoded(mach, &dec->src[0], chan),
+                              fetch_decoded(mach, &dec->src[1], chan));
+   }
+   store_decoded(mach, dec, dst);
+   (*pc)++;
+}
+
+static void
+exec_decoded_sub(struct tgsi_exec_machine *mach,
+                 const struct tgsi_exec_decoded_inst *dec,
+                 int *pc)
+{
+   quad_float dst[TGSI_NUM_CHANNELS];
+   uint chan;
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      if (dec->writemask & (1 << chan))
+         dst[chan] = quad_sub(fetch_decoded(mach, &dec->src[0], chan),
+                              fetch_decoded(mach, &dec->src[1], chan));
+   }
+   store_decoded(mach, dec, dst);
+   (*pc)++;
+}
+
+static void
+exec_decoded_mul(struct tgsi_exec_machine *mach,
+                 const struct tgsi_exec_decoded_inst *dec,
+                 int *pc)
+{
+   quad_float dst[TGSI_NUM_CHANNELS];
+   uint chan;
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      if (dec->writemask & (1 << chan))
+         dst[chan] = quad_mul(fetch_decoded(mach, &dec->src[0], chan),
+                              fetch_decoded(mach, &dec->src[1], chan));
+   }
+   store_decoded(mach, dec, dst);
+   (*pc)++;
+}
+
+static void
+exec_decoded_min(struct tgsi_exec_machine *mach,
+                 const struct tgsi_exec_decoded_inst *dec,
+                 int *pc)
+{
+   quad_float dst[TGSI_NUM_CHANNELS];
+   uint chan;
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      if (dec->writemask & (1 << chan))
+         dst[chan] = quad_min(fetch_decoded(mach, &dec->src[0], chan),
+                              fetch_decoded(mach, &dec->src[1], chan));
+   }
+   store_decoded(mach, dec, dst);
+   (*pc)++;
+}
+
+static void
+exec_decoded_max(struct tgsi_exec_machine *mach,
+                 const struct tgsi_exec_decoded_inst *dec,
+                 int *pc)
+{
+   quad_float dst[TGSI_NUM_CHANNELS];
+   uint chan;
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      if (dec->writemask & (1 << chan))
+         dst[chan] = quad_max(fetch_decoded(mach, &dec->src[0], chan),
+                              fetch_decoded(mach, &dec->src[1], chan));
+   }
+   store_decoded(mach, dec, dst);
+   (*pc)++;
+}
+
+static void
+exec_decoded_mad(struct tgsi_exec_machine *mach,
+                 const struct tgsi_exec_decoded_inst *dec,
+                 int *pc)
+{
+   quad_float dst[TGSI_NUM_CHANNELS];
+   uint chan;
+
+   /* not fused, micro_mad() rounds the product */
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      if (dec->writemask & (1 << chan))
+         dst[chan] = quad_add(quad_mul(fetch_decoded(mach, &dec->src[0], chan),
+                                       fetch_decoded(mach, &dec->src[1], chan)),
+                              fetch_decoded(mach, &dec->src[2], chan));
+   }
+   store_decoded(mach, dec, dst);
+   (*pc)++;
+}
+
+static void
+exec_decoded_dp(struct tgsi_exec_machine *mach,
+                const struct tgsi_exec_decoded_inst *dec,
+                uint num_chans)
+{
+   quad_float dst[TGSI_NUM_CHANNELS];
+   quad_float sum;
+   uint chan;
+
+   sum = quad_mul(fetch_decoded(mach, &dec->src[0], TGSI_CHAN_X),
+                  fetch_decoded(mach, &dec->src[1], TGSI_CHAN_X));
+   for (chan = TGSI_CHAN_Y; chan < num_chans; chan++) {
+      sum = quad_add(quad_mul(fetch_decoded(mach, &dec->src[0], chan),
+                              fetch_decoded(mach, &dec->src[1], chan)),
+                     sum);
+   }
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++)
+      dst[chan] = sum;
+   store_decoded(mach, dec, dst);
+}
+
+static void
+exec_decoded_dp3(struct tgsi_exec_machine *mach,
+                 const struct tgsi_exec_decoded_inst *dec,
+                 int *pc)
+{
+   exec_decoded_dp(mach, dec, 3);
+   (*pc)++;
+}
+
+static void
+exec_decoded_dp4(struct tgsi_exec_machine *mach,
+                 const struct tgsi_exec_decoded_inst *dec,
+                 int *pc)
+{
+   exec_decoded_dp(mach, dec, 4);
+   (*pc)++;
+}
+
+
+/**
+ * Resolve a source operand for the arithmetic handlers.
+ * \return FALSE if it needs the general fetch_source() path
+ */
+static boolean
+decode_src(const struct tgsi_exec_machine *mach,
+           struct decoded_src *src,
+           const struct tgsi_full_src_register *reg)
+{
+   const int index = reg->Register.Index;
+   uint chan;
+
+   if (reg->Register.Indirect || reg->Register.Dimension)
+      return FALSE;
+
+   switch (reg->Register.File) {
+   case TGSI_FILE_TEMPORARY:
+      if (index < 0 || index >= TGSI_EXEC_NUM_TEMPS)
+         return FALSE;
+      src->kind = DECODED_SRC_VECTOR;
+      break;
+   case TGSI_FILE_INPUT:
+      if (index < 0 || index >= PIPE_MAX_SHADER_INPUTS)
+         return FALSE;
+      src->kind = DECODED_SRC_VECTOR;
+      break;
+   case TGSI_FILE_IMMEDIATE:
+      if (index < 0 || index >= (int) mach->ImmLimit)
+         return FALSE;
+      src->kind = DECODED_SRC_SCALAR;
+      break;
+   case TGSI_FILE_CONSTANT:
+      src->kind = DECODED_SRC_CONSTANT;
+      break;
+   default:
+      return FALSE;
+   }
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      const uint swizzle = tgsi_util_get_full_src_register_swizzle(reg, chan);
+
+      switch (reg->Register.File) {
+      case TGSI_FILE_TEMPORARY:
+         src->ptr[chan] = mach->Temps[index].xyzw[swizzle].f;
+         break;
+      case TGSI_FILE_INPUT:
+         src->ptr[chan] = mach->Inputs[index].xyzw[swizzle].f;
+         break;
+      case TGSI_FILE_IMMEDIATE:
+         src->ptr[chan] = &mach->Imms[index][swizzle];
+         break;
+      default:
+         /* negative for a negative index, see fetch_src_direct() */
+         src->pos[chan] = index * 4 + swizzle;
+         break;
+      }
+   }
+
+   src->absolute = reg->Register.Absolute;
+   src->negate = reg->Register.Negate;
+
+   return TRUE;
+}
+
+/**
+ * Pick a handler for an instruction and resolve its operands.
+ */
+static void
+decode_instruction(const struct tgsi_exec_machine *mach,
+                   struct tgsi_exec_decoded_inst *dec,
+                   const struct tgsi_full_instruction *inst)
+{
+   const struct tgsi_full_dst_register *dst = &inst->Dst[0];
+   decoded_func func;
+   uint i;
+
+   dec->func = exec_decoded_generic;
+   dec->inst = inst;
+
+   switch (inst->Instruction.Opcode) {
+   case TGSI_OPCODE_MOV:
+      func = exec_decoded_mov;
+      break;
+   case TGSI_OPCODE_ADD:
+      func = exec_decoded_add;
+      break;
+   case TGSI_OPCODE_SUB:
+      func = exec_decoded_sub;
+      break;
+   case TGSI_OPCODE_MUL:
+      func = exec_decoded_mul;
+      break;
+   case TGSI_OPCODE_MIN:
+      func = exec_decoded_min;
+      break;
+   case TGSI_OPCODE_MAX:
+      func = exec_decoded_max;
+      break;
+   case TGSI_OPCODE_MAD:
+      func = exec_decoded_mad;
+      break;
+   case TGSI_OPCODE_DP3:
+      func = exec_decoded_dp3;
+      break;
+   case TGSI_OPCODE_DP4:
+      func = exec_decoded_dp4;
+      break;
+   default:
+      return;
+   }
+
+   /* Predicates, indirect stores and the per lane output vertices of
+    * geometry shaders are left to store_dest().
+    */
+   if (inst->Instruction.Predicate ||
+       inst->Instruction.NumDstRegs != 1 ||
+       dst->Register.Indirect || dst->Register.Dimension)
+      return;
+
+   switch (dst->Register.File) {
+   case TGSI_FILE_TEMPORARY:
+      if (dst->Register.Index >= TGSI_EXEC_NUM_TEMPS)
+         return;
+      break;
+   case TGSI_FILE_OUTPUT:
+      if (mach->Processor == TGSI_PROCESSOR_GEOMETRY)
+         return;
+      break;
+   default:
+      return;
+   }
+
+   for (i = 0; i < inst->Instruction.NumSrcRegs; i++) {
+      if (i >= Elements(dec->src) ||
+          !decode_src(mach, &dec->src[i], &inst->Src[i]))
+         return;
+   }
+
+   dec->writemask = dst->Register.WriteMask;
+   dec->saturate = inst->Instruction.Saturate;
+   dec->dst_file = dst->Register.File;
+   dec->dst_index = dst->Register.Index;
+   dec->func = func;
+}
+
+static void
+decode_instructions(struct tgsi_exec_machine *mach)
+{
+   uint i;
+
+   FREE(mach->Decoded);
+   mach->Decoded = (struct tgsi_exec_decoded_inst *)
+      MALLOC(mach->NumInstructions * sizeof(struct tgsi_exec_decoded_inst));
+
+   /* tgsi_exec_machine_run() falls back to exec_instruction() */
+   if (!mach->Decoded)
+      return;
+
+   for (i = 0; i < mach->NumInstructions; i++)
+      decode_instruction(mach, &mach->Decoded[i], &mach->Instructions[i]);
+}
+
+
 /**
  * Run TGSI interpreter.
  * \return bitmask of "alive" quad components
@@ -4615,16 +5369,25 @@ tgsi_exec_machine_run( struct tgsi_exec_machine *mach )
 {
    uint i;
    int pc = 0;
-   uint default_mask = 0xf;
+   uint default_mask = TGSI_QUAD_MASK;
 
    mach->Temps[TEMP_KILMASK_I].xyzw[TEMP_KILMASK_C].u[0] = 0;
    mach->Temps[TEMP_OUTPUT_I].xyzw[TEMP_OUTPUT_C].u[0] = 0;
 
    if( mach->Processor == TGSI_PROCESSOR_GEOMETRY ) {
-      mach->Temps[TEMP_PRIMITIVE_I].xyzw[TEMP_PRIMITIVE_C].u[0] = 0;
-      mach->Primitives[0] = 0;
-      /* GS runs on a single primitive for now */
-      default_mask = 0x1;
+      /* Each lane runs the GS on one input primitive, the number of
+       * primitives comes from tgsi_set_exec_mask().
+       */
+      const int *mask = mach->Temps[TGSI_EXEC_MASK_I].xyzw[TGSI_EXEC_MASK_C].i;
+
+      default_mask = 0x0;
+      for (i = 0; i < TGSI_QUAD_SIZE; i++) {
+         if (mask[i])
+            default_mask |= 1 << i;
+         mach->Temps[TEMP_OUTPUT_I].xyzw[TEMP_OUTPUT_C].u[i] = 0;
+         mach->Temps[TEMP_PRIMITIVE_I].xyzw[TEMP_PRIMITIVE_C].u[i] = 0;
+         mach->Primitives[i][0] = 0;
+      }
    }
 
    mach->CondMask = default_mask;
@@ -4670,7 +5433,10 @@ tgsi_exec_machine_run( struct tgsi_exec_machine *mach )
 #endif
 
          assert(pc < (int) mach->NumInstructions);
-         exec_instruction(mach, mach->Instructions + pc, &pc);
+         if (mach->Decoded)
+            mach->Decoded[pc].func(mach, &mach->Decoded[pc], &pc);
+         else
+            exec_instruction(mach, mach->Instructions + pc, &pc);
 
 #if DEBUG_EXECUTION
          for (i = 0; i < TGSI_EXEC_NUM_TEMPS + TGSI_EXEC_NUM_TEMP_EXTRAS; i++) {
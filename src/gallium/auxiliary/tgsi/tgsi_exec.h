@@ -43,7 +43,12 @@ extern "C" {
 #define TGSI_CHAN_W 3
 
 #define TGSI_NUM_CHANNELS 4  /* R,G,B,A */
+
+/* The machine always executes one quad.  softpipe's quad pipeline and
+ * draw_vs_exec's four-vertex batches both depend on this width.
+ */
 #define TGSI_QUAD_SIZE    4  /* 4 pixel/quad */
+#define TGSI_QUAD_MASK    ((1 << TGSI_QUAD_SIZE) - 1)
 
 #define TGSI_FOR_EACH_CHANNEL( CHAN )\
    for (CHAN = 0; CHAN < TGSI_NUM_CHANNELS; CHAN++)
@@ -258,6 +263,10 @@ enum tgsi_break_type {
 #define TGSI_EXEC_MAX_BREAK_STACK (TGSI_EXEC_MAX_LOOP_NESTING + TGSI_EXEC_MAX_SWITCH_NESTING)
 
 
+/* Private to tgsi_exec.c */
+struct tgsi_exec_decoded_inst;
+
+
 /**
  * Run-time virtual machine state for executing TGSI shader.
  */
@@ -292,8 +301,13 @@ struct tgsi_exec_machine
    const struct tgsi_token       *Tokens;   /**< Declarations, instructions */
    unsigned                      Processor; /**< TGSI_PROCESSOR_x */
 
-   /* GEOMETRY processor only. */
-   unsigned                      *Primitives;
+   /* GEOMETRY processor only.
+    * Each of the four lanes runs its own GS invocation, with its own
+    * output vertex offset (TEMP_OUTPUT), primitive count (TEMP_PRIMITIVE)
+    * and table of vertices per emitted primitive.
+    */
+   unsigned                      *Primitives[TGSI_QUAD_SIZE];
+   unsigned                       MaxPrimitives; /**< size of each Primitives table */
    unsigned                       NumOutputs;
    unsigned                       MaxGeometryShaderOutputs;
    unsigned                       MaxOutputVertices;
@@ -350,6 +364,9 @@ struct tgsi_exec_machine
    struct tgsi_full_instruction *Instructions;
    uint NumInstructions;
 
+   /** Instructions[] decoded into handlers, one per instruction */
+   struct tgsi_exec_decoded_inst *Decoded;
+
    struct tgsi_full_declaration *Declarations;
    uint NumDeclarations;
 
@@ -260,7 +260,7 @@ emit_B8G8R8A8_UNORM( const void *attrib, void *ptr)
 static void
 emit_B10G10R10A2_UNORM( const void *attrib, void *ptr )
 {
-   float *src = (float *)ptr;
+   const float *src = (const float *)attrib;
    uint32_t value = 0;
    value |= ((uint32_t)(CLAMP(src[2], 0, 1) * 0x3ff)) & 0x3ff;
    value |= (((uint32_t)(CLAMP(src[1], 0, 1) * 0x3ff)) & 0x3ff) << 10;
@@ -269,13 +269,13 @@ emit_B10G10R10A2_UNORM( const void *attrib, void *ptr )
 #ifdef PIPE_ARCH_BIG_ENDIAN
    value = util_bswap32(value);
 #endif
-   *(uint32_t *)attrib = value;
+   *(uint32_t *)ptr = value;
 }
 
 static void
 emit_B10G10R10A2_USCALED( const void *attrib, void *ptr )
 {
-   float *src = (float *)ptr;
+   const float *src = (const float *)attrib;
    uint32_t value = 0;
    value |= ((uint32_t)CLAMP(src[2], 0, 1023)) & 0x3ff;
    value |= (((uint32_t)CLAMP(src[1], 0, 1023)) & 0x3ff) << 10;
@@ -284,13 +284,13 @@ emit_B10G10R10A2_USCALED( const void *attrib, void *ptr )
 #ifdef PIPE_ARCH_BIG_ENDIAN
    value = util_bswap32(value);
 #endif
-   *(uint32_t *)attrib = value;
+   *(uint32_t *)ptr = value;
 }
 
 static void
 emit_B10G10R10A2_SNORM( const void *attrib, void *ptr )
 {
-   float *src = (float *)ptr;
+   const float *src = (const float *)attrib;
    uint32_t value = 0;
    value |= (uint32_t)(((uint32_t)(CLAMP(src[2], -1, 1) * 0x1ff)) & 0x3ff) ;
    value |= (uint32_t)((((uint32_t)(CLAMP(src[1], -1, 1) * 0x1ff)) & 0x3ff) << 10) ;
@@ -299,13 +299,13 @@ emit_B10G10R10A2_SNORM( const void *attrib, void *ptr )
 #ifdef PIPE_ARCH_BIG_ENDIAN
    value = util_bswap32(value);
 #endif
-   *(uint32_t *)attrib = value;
+   *(uint32_t *)ptr = value;
 }
 
 static void
 emit_B10G10R10A2_SSCALED( const void *attrib, void *ptr )
 {
-   float *src = (float *)ptr;
+   const float *src = (const float *)attrib;
    uint32_t value = 0;
    value |= (uint32_t)(((uint32_t)CLAMP(src[2], -512, 511)) & 0x3ff) ;
    value |= (uint32_t)((((uint32_t)CLAMP(src[1], -512, 511)) & 0x3ff) << 10) ;
@@ -314,13 +314,13 @@ emit_B10G10R10A2_SSCALED( const void *attrib, void *ptr )
 #ifdef PIPE_ARCH_BIG_ENDIAN
    value = util_bswap32(value);
 #endif
-   *(uint32_t *)attrib = value;
+   *(uint32_t *)ptr = value;
 }
 
 static void
 emit_R10G10B10A2_UNORM( const void *attrib, void *ptr )
 {
-   float *src = (float *)ptr;
+   const float *src = (const float *)attrib;
    uint32_t value = 0;
    value |= ((uint32_t)(CLAMP(src[0], 0, 1) * 0x3ff)) & 0x3ff;
    value |= (((uint32_t)(CLAMP(src[1], 0, 1) * 0x3ff)) & 0x3ff) << 10;
@@ -329,13 +329,13 @@ emit_R10G10B10A2_UNORM( const void *attrib, void *ptr )
 #ifdef PIPE_ARCH_BIG_ENDIAN
    value = util_bswap32(value);
 #endif
-   *(uint32_t *)attrib = value;
+   *(uint32_t *)ptr = value;
 }
 
 static void
 emit_R10G10B10A2_USCALED( const void *attrib, void *ptr )
 {
-   float *src = (float *)ptr;
+   const float *src = (const float *)attrib;
    uint32_t value = 0;
    value |= ((uint32_t)CLAMP(src[0], 0, 1023)) & 0x3ff;
    value |= (((uint32_t)CLAMP(src[1], 0, 1023)) & 0x3ff) << 10;
@@ -344,13 +344,13 @@ emit_R10G10B10A2_USCALED( const void *attrib, void *ptr )
 #ifdef PIPE_ARCH_BIG_ENDIAN
    value = util_bswap32(value);
 #endif
-   *(uint32_t *)attrib = value;
+   *(uint32_t *)ptr = value;
 }
 
 static void
 emit_R10G10B10A2_SNORM( const void *attrib, void *ptr )
 {
-   float *src = (float *)ptr;
+   const float *src = (const float *)attrib;
    uint32_t value = 0;
    value |= (uint32_t)(((uint32_t)(CLAMP(src[0], -1, 1) * 0x1ff)) & 0x3ff) ;
    value |= (uint32_t)((((uint32_t)(CLAMP(src[1], -1, 1) * 0x1ff)) & 0x3ff) << 10) ;
@@ -359,13 +359,13 @@ emit_R10G10B10A2_SNORM( const void *attrib, void *ptr )
 #ifdef PIPE_ARCH_BIG_ENDIAN
    value = util_bswap32(value);
 #endif
-   *(uint32_t *)attrib = value;
+   *(uint32_t *)ptr = value;
 }
 
 static void
 emit_R10G10B10A2_SSCALED( const void *attrib, void *ptr)
 {
-   float *src = (float *)ptr;
+   const float *src = (const float *)attrib;
    uint32_t value = 0;
    value |= (uint32_t)(((uint32_t)CLAMP(src[0], -512, 511)) & 0x3ff) ;
    value |= (uint32_t)((((uint32_t)CLAMP(src[1], -512, 511)) & 0x3ff) << 10) ;
@@ -374,7 +374,7 @@ emit_R10G10B10A2_SSCALED( const void *attrib, void *ptr)
 #ifdef PIPE_ARCH_BIG_ENDIAN
    value = util_bswap32(value);
 #endif
-   *(uint32_t *)attrib = value;
+   *(uint32_t *)ptr = value;
 }
 
 static void 
@@ -64,7 +64,7 @@ struct translate_buffer_variant
 
 #define ELEMENT_BUFFER_INSTANCE_ID  1001
 
-#define NUM_CONSTS 7
+#define NUM_CONSTS 14
 
 enum
 {
@@ -74,7 +74,14 @@ enum
    CONST_INV_32767,
    CONST_INV_65535,
    CONST_INV_2147483647,
-   CONST_255
+   CONST_255,
+   CONST_2POW32,
+   CONST_1010102_MASK,
+   CONST_1010102_SCALE,
+   CONST_1010102_UNORM,
+   CONST_1010102_SNORM,
+   CONST_1010102_HALF,
+   CONST_1010102_RANGE
 };
 
 #define C(v) {(float)(v), (float)(v), (float)(v), (float)(v)}
@@ -85,11 +92,23 @@ static float consts[NUM_CONSTS][4] = {
    C(1.0 / 32767.0),
    C(1.0 / 65535.0),
    C(1.0 / 2147483647.0),
-   C(255.0)
+   C(255.0),
+   C(4294967296.0),
+   {0, 0, 0, 0},                /* integer masks, see translate_sse2_create */
+   {1.0, 1.0 / (1 << 10), 1.0 / (1 << 20), 1.0 / (1 << 30)},
+   {1.0 / 1023.0, 1.0 / (1023.0 * (1 << 10)),
+    1.0 / (1023.0 * (1 << 20)), 1.0 / (3.0 * (1 << 30))},
+   {1.0 / 511.0, 1.0 / 511.0, 1.0 / 511.0, 1.0},
+   {512.0, 512.0, 512.0, 2.0},
+   {1024.0, 1024.0, 1024.0, 4.0}
 };
 
 #undef C
 
+static const uint32_t mask_1010102[4] = {
+   0x3ff, 0x3ff << 10, 0x3ff << 20, 0x3u << 30
+};
+
 struct translate_sse
 {
    struct translate translate;
@@ -455,6 +474,81 @@ emit_memcpy(struct translate_sse *p, struct x86_reg dst, struct x86_reg src,
    }
 }
 
+/**
+ * Whether the format packs 10, 10, 10 and 2 bit channels, in that order
+ * from the lsb, with all channels of the same (non pure integer) type.
+ */
+static boolean
+is_format_1010102(const struct util_format_description *desc)
+{
+   unsigned i;
+
+   if (desc->layout != UTIL_FORMAT_LAYOUT_PLAIN ||
+       desc->block.bits != 32 ||
+       desc->nr_channels != 4)
+      return FALSE;
+
+   if (desc->channel[0].type != UTIL_FORMAT_TYPE_UNSIGNED &&
+       desc->channel[0].type != UTIL_FORMAT_TYPE_SIGNED)
+      return FALSE;
+
+   for (i = 0; i < 4; ++i) {
+      if (desc->channel[i].size != (i == 3 ? 2 : 10) ||
+          desc->channel[i].shift != i * 10 ||
+          desc->channel[i].type != desc->channel[0].type ||
+          desc->channel[i].normalized != desc->channel[0].normalized ||
+          desc->channel[i].pure_integer)
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+
+/**
+ * Load a 10_10_10_2 packed value and unpack its channels to floats,
+ * in the same lane order as the format channels.
+ */
+static void
+emit_load_1010102(struct translate_sse *p, struct x86_reg data,
+                  struct x86_reg src,
+                  const struct util_format_channel_description *channel)
+{
+   struct x86_reg tmpXMM = x86_make_reg(file_XMM, 1);
+
+   /* replicate the dword and keep each channel bits in its own lane */
+   sse2_movd(p->func, data, src);
+   sse2_pshufd(p->func, data, data, SHUF(X, X, X, X));
+   sse2_pand(p->func, data, get_const(p, CONST_1010102_MASK));
+
+   if (channel->type == UTIL_FORMAT_TYPE_UNSIGNED) {
+      /* the top channel converts as negative, add 2^32 back */
+      sse2_movdqa(p->func, tmpXMM, data);
+      sse2_psrad_imm(p->func, tmpXMM, 31);
+      sse_andps(p->func, tmpXMM, get_const(p, CONST_2POW32));
+      sse2_cvtdq2ps(p->func, data, data);
+      sse_addps(p->func, data, tmpXMM);
+      sse_mulps(p->func, data,
+                get_const(p, channel->normalized ?
+                          CONST_1010102_UNORM : CONST_1010102_SCALE));
+   }
+   else {
+      /* the top channel is already sign extended, the others get 2^n
+       * subtracted when they are 2^(n-1) or above
+       */
+      sse2_cvtdq2ps(p->func, data, data);
+      sse_mulps(p->func, data, get_const(p, CONST_1010102_SCALE));
+      sse_movaps(p->func, tmpXMM, data);
+      sse_cmpps(p->func, tmpXMM, get_const(p, CONST_1010102_HALF),
+                cc_NotLessThan);
+      sse_andps(p->func, tmpXMM, get_const(p, CONST_1010102_RANGE));
+      sse_subps(p->func, data, tmpXMM);
+      if (channel->normalized)
+         sse_mulps(p->func, data, get_const(p, CONST_1010102_SNORM));
+   }
+}
+
+
 static boolean
 translate_attr_convert(struct translate_sse *p,
                        const struct translate_element *a,
@@ -471,18 +565,28 @@ translate_attr_convert(struct translate_sse *p,
         UTIL_FORMAT_SWIZZLE_NONE, UTIL_FORMAT_SWIZZLE_NONE };
    unsigned needed_chans = 0;
    unsigned imms[2] = { 0, 0x3f800000 };
+   boolean output_float32 =
+      a->output_format == PIPE_FORMAT_R32_FLOAT ||
+      a->output_format == PIPE_FORMAT_R32G32_FLOAT ||
+      a->output_format == PIPE_FORMAT_R32G32B32_FLOAT ||
+      a->output_format == PIPE_FORMAT_R32G32B32A32_FLOAT;
+   /* 10_10_10_2 formats are only ever unpacked to floats */
+   boolean input_1010102 =
+      output_float32 &&
+      (x86_target_caps(p->func) & X86_SSE2) &&
+      is_format_1010102(input_desc);
 
    if (a->output_format == PIPE_FORMAT_NONE
        || a->input_format == PIPE_FORMAT_NONE)
       return FALSE;
 
-   if (input_desc->channel[0].size & 7)
+   if ((input_desc->channel[0].size & 7) && !input_1010102)
       return FALSE;
 
    if (input_desc->colorspace != output_desc->colorspace)
       return FALSE;
 
-   for (i = 1; i < input_desc->nr_channels; ++i) {
+   for (i = 1; i < input_desc->nr_channels && !input_1010102; ++i) {
       if (memcmp
           (&input_desc->channel[i], &input_desc->channel[0],
            sizeof(input_desc->channel[0])))
@@ -502,11 +606,7 @@ translate_attr_convert(struct translate_sse *p,
          swizzle[output_desc->swizzle[i]] = input_desc->swizzle[i];
    }
 
-   if ((x86_target_caps(p->func) & X86_SSE) &&
-       (0 || a->output_format == PIPE_FORMAT_R32_FLOAT
-        || a->output_format == PIPE_FORMAT_R32G32_FLOAT
-        || a->output_format == PIPE_FORMAT_R32G32B32_FLOAT
-        || a->output_format == PIPE_FORMAT_R32G32B32A32_FLOAT)) {
+   if ((x86_target_caps(p->func) & X86_SSE) && output_float32) {
       struct x86_reg dataXMM = x86_make_reg(file_XMM, 0);
 
       for (i = 0; i < output_desc->nr_channels; ++i) {
@@ -527,6 +627,10 @@ translate_attr_convert(struct translate_sse *p,
          case UTIL_FORMAT_TYPE_UNSIGNED:
             if (!(x86_target_caps(p->func) & X86_SSE2))
                return FALSE;
+            if (input_1010102) {
+               emit_load_1010102(p, dataXMM, src, &input_desc->channel[0]);
+               break;
+            }
             emit_load_sse2(p, dataXMM, src,
                            input_desc->channel[0].size *
                            input_desc->nr_channels >> 3);
@@ -579,6 +683,10 @@ translate_attr_convert(struct translate_sse *p,
          case UTIL_FORMAT_TYPE_SIGNED:
             if (!(x86_target_caps(p->func) & X86_SSE2))
                return FALSE;
+            if (input_1010102) {
+               emit_load_1010102(p, dataXMM, src, &input_desc->channel[0]);
+               break;
+            }
             emit_load_sse2(p, dataXMM, src,
                            input_desc->channel[0].size *
                            input_desc->nr_channels >> 3);
@@ -627,7 +735,9 @@ translate_attr_convert(struct translate_sse *p,
             break;
          case UTIL_FORMAT_TYPE_FLOAT:
             if (input_desc->channel[0].size != 32
-                && input_desc->channel[0].size != 64) {
+                && input_desc->channel[0].size != 64
+                && !(input_desc->channel[0].size == 16
+                     && (x86_target_caps(p->func) & X86_F16C))) {
                return FALSE;
             }
             if (swizzle[3] == UTIL_FORMAT_SWIZZLE_1
@@ -636,6 +746,13 @@ translate_attr_convert(struct translate_sse *p,
                needed_chans = CHANNELS_0001;
             }
             switch (input_desc->channel[0].size) {
+            case 16:
+               /* missing channels are loaded as zero */
+               emit_load_sse2(p, dataXMM, src, 2 * input_desc->nr_channels);
+               f16c_vcvtph2ps(p->func, dataXMM, dataXMM);
+               if (needed_chans == CHANNELS_0001)
+                  sse_orps(p->func, dataXMM, get_const(p, CONST_IDENTITY));
+               break;
             case 32:
                emit_load_float32(p, dataXMM, src, needed_chans,
                                  input_desc->nr_channels);
@@ -1491,6 +1608,7 @@ translate_sse2_create(const struct translate_key *key)
 
    memset(p, 0, sizeof(*p));
    memcpy(p->consts, consts, sizeof(consts));
+   memcpy(p->consts[CONST_1010102_MASK], mask_1010102, sizeof(mask_1010102));
 
    p->translate.key = *key;
    p->translate.release = translate_sse_release;
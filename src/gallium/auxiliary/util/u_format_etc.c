@@ -27,6 +27,7 @@ util_format_etc1_rgb8_unpack_rgba_float(float *dst_row, unsigned dst_stride, con
 {
    const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
    struct etc1_block block;
+   uint8_t texels[4][4][4];
    unsigned x, y, i, j;
 
    for (y = 0; y < height; y += bh) {
@@ -34,16 +35,15 @@ util_format_etc1_rgb8_unpack_rgba_float(float *dst_row, unsigned dst_stride, con
 
       for (x = 0; x < width; x+= bw) {
          etc1_parse_block(&block, src);
+         etc1_decode_block(&block, texels);
 
          for (j = 0; j < bh; j++) {
             float *dst = dst_row + (y + j) * dst_stride / sizeof(*dst_row) + x * comps;
-            uint8_t tmp[3];
 
             for (i = 0; i < bw; i++) {
-               etc1_fetch_texel(&block, i, j, tmp);
-               dst[0] = ubyte_to_float(tmp[0]);
-               dst[1] = ubyte_to_float(tmp[1]);
-               dst[2] = ubyte_to_float(tmp[2]);
+               dst[0] = ubyte_to_float(texels[j][i][0]);
+               dst[1] = ubyte_to_float(texels[j][i][1]);
+               dst[2] = ubyte_to_float(texels[j][i][2]);
                dst[3] = 1.0f;
                dst += comps;
             }
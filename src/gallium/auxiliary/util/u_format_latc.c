@@ -64,14 +64,14 @@ util_format_latc1_unorm_unpack_rgba_float(float *dst_row, unsigned dst_stride, c
    for(y = 0; y < height; y += 4) {
       const uint8_t *src = src_row;
       for(x = 0; x < width; x += 4) {
+         uint8_t tmp_r[16];
+         util_format_unsigned_decode_rgtc_block(src, tmp_r);
          for(j = 0; j < 4; ++j) {
             for(i = 0; i < 4; ++i) {
                float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*4;
-               uint8_t tmp_r;
-               util_format_unsigned_fetch_texel_rgtc(0, src, i, j, &tmp_r, 1);
                dst[0] =
                dst[1] =
-               dst[2] = ubyte_to_float(tmp_r);
+               dst[2] = ubyte_to_float(tmp_r[j * 4 + i]);
                dst[3] = 1.0;
             }
          }
@@ -132,14 +132,14 @@ util_format_latc1_snorm_unpack_rgba_float(float *dst_row, unsigned dst_stride, c
    for(y = 0; y < height; y += 4) {
       const int8_t *src = (int8_t *)src_row;
       for(x = 0; x < width; x += 4) {
+         int8_t tmp_r[16];
+         util_format_signed_decode_rgtc_block(src, tmp_r);
          for(j = 0; j < 4; ++j) {
             for(i = 0; i < 4; ++i) {
                float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*4;
-               int8_t tmp_r;
-               util_format_signed_fetch_texel_rgtc(0, src, i, j, &tmp_r, 1);
                dst[0] =
                dst[1] =
-               dst[2] = byte_to_float_tex(tmp_r);
+               dst[2] = byte_to_float_tex(tmp_r[j * 4 + i]);
                dst[3] = 1.0;
             }
          }
@@ -198,16 +198,16 @@ util_format_latc2_unorm_unpack_rgba_float(float *dst_row, unsigned dst_stride, c
    for(y = 0; y < height; y += 4) {
       const uint8_t *src = src_row;
       for(x = 0; x < width; x += 4) {
+         uint8_t tmp_r[16], tmp_g[16];
+         util_format_unsigned_decode_rgtc_block(src, tmp_r);
+         util_format_unsigned_decode_rgtc_block(src + 8, tmp_g);
          for(j = 0; j < 4; ++j) {
             for(i = 0; i < 4; ++i) {
                float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*4;
-               uint8_t tmp_r, tmp_g;
-               util_format_unsigned_fetch_texel_rgtc(0, src, i, j, &tmp_r, 2);
-               util_format_unsigned_fetch_texel_rgtc(0, src + 8, i, j, &tmp_g, 2);
                dst[0] =
                dst[1] =
-               dst[2] = ubyte_to_float(tmp_r);
-               dst[3] = ubyte_to_float(tmp_g);
+               dst[2] = ubyte_to_float(tmp_r[j * 4 + i]);
+               dst[3] = ubyte_to_float(tmp_g[j * 4 + i]);
             }
          }
          src += block_size;
@@ -257,16 +257,16 @@ util_format_latc2_snorm_unpack_rgba_float(float *dst_row, unsigned dst_stride, c
    for(y = 0; y < height; y += 4) {
       const int8_t *src = (int8_t *)src_row;
       for(x = 0; x < width; x += 4) {
+         int8_t tmp_r[16], tmp_g[16];
+         util_format_signed_decode_rgtc_block(src, tmp_r);
+         util_format_signed_decode_rgtc_block(src + 8, tmp_g);
          for(j = 0; j < 4; ++j) {
             for(i = 0; i < 4; ++i) {
                float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*4;
-               int8_t tmp_r, tmp_g;
-               util_format_signed_fetch_texel_rgtc(0, src, i, j, &tmp_r, 2);
-               util_format_signed_fetch_texel_rgtc(0, src + 8, i, j, &tmp_g, 2);
                dst[0] =
                dst[1] =
-               dst[2] = byte_to_float_tex(tmp_r);
-               dst[3] = byte_to_float_tex(tmp_g);
+               dst[2] = byte_to_float_tex(tmp_r[j * 4 + i]);
+               dst[3] = byte_to_float_tex(tmp_g[j * 4 + i]);
             }
          }
          src += block_size;
@@ -47,10 +47,12 @@ util_format_rgtc1_unorm_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride
    for(y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
       for(x = 0; x < width; x += bw) {
+         uint8_t tmp_r[16];
+         util_format_unsigned_decode_rgtc_block(src, tmp_r);
          for(j = 0; j < bh; ++j) {
             for(i = 0; i < bw; ++i) {
                uint8_t *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*comps;
-	       util_format_unsigned_fetch_texel_rgtc(0, src, i, j, dst, 1);
+	       dst[0] = tmp_r[j * 4 + i];
 	       dst[1] = 0;
 	       dst[2] = 0;
 	       dst[3] = 255;
@@ -93,12 +95,12 @@ util_format_rgtc1_unorm_unpack_rgba_float(float *dst_row, unsigned dst_stride, c
    for(y = 0; y < height; y += 4) {
       const uint8_t *src = src_row;
       for(x = 0; x < width; x += 4) {
+         uint8_t tmp_r[16];
+         util_format_unsigned_decode_rgtc_block(src, tmp_r);
          for(j = 0; j < 4; ++j) {
             for(i = 0; i < 4; ++i) {
                float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*4;
-               uint8_t tmp_r;
-               util_format_unsigned_fetch_texel_rgtc(0, src, i, j, &tmp_r, 1);
-               dst[0] = ubyte_to_float(tmp_r);
+               dst[0] = ubyte_to_float(tmp_r[j * 4 + i]);
                dst[1] = 0.0;
                dst[2] = 0.0;
                dst[3] = 1.0;
@@ -191,12 +193,12 @@ util_format_rgtc1_snorm_unpack_rgba_float(float *dst_row, unsigned dst_stride, c
    for(y = 0; y < height; y += 4) {
       const int8_t *src = (int8_t *)src_row;
       for(x = 0; x < width; x += 4) {
+         int8_t tmp_r[16];
+         util_format_signed_decode_rgtc_block(src, tmp_r);
          for(j = 0; j < 4; ++j) {
             for(i = 0; i < 4; ++i) {
                float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*4;
-               int8_t tmp_r;
-               util_format_signed_fetch_texel_rgtc(0, src, i, j, &tmp_r, 1);
-               dst[0] = byte_to_float_tex(tmp_r);
+               dst[0] = byte_to_float_tex(tmp_r[j * 4 + i]);
                dst[1] = 0.0;
                dst[2] = 0.0;
                dst[3] = 1.0;
@@ -239,11 +241,14 @@ util_format_rgtc2_unorm_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride
    for(y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
       for(x = 0; x < width; x += bw) {
+         uint8_t tmp_r[16], tmp_g[16];
+         util_format_unsigned_decode_rgtc_block(src, tmp_r);
+         util_format_unsigned_decode_rgtc_block(src + 8, tmp_g);
          for(j = 0; j < bh; ++j) {
             for(i = 0; i < bw; ++i) {
                uint8_t *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*comps;
-	       util_format_unsigned_fetch_texel_rgtc(0, src, i, j, dst, 2);
-	       util_format_unsigned_fetch_texel_rgtc(0, src + 8, i, j, dst + 1, 2);
+	       dst[0] = tmp_r[j * 4 + i];
+	       dst[1] = tmp_g[j * 4 + i];
 	       dst[2] = 0;
 	       dst[3] = 255;
 	    }
@@ -318,14 +323,14 @@ util_format_rgtc2_unorm_unpack_rgba_float(float *dst_row, unsigned dst_stride, c
    for(y = 0; y < height; y += 4) {
       const uint8_t *src = src_row;
       for(x = 0; x < width; x += 4) {
+         uint8_t tmp_r[16], tmp_g[16];
+         util_format_unsigned_decode_rgtc_block(src, tmp_r);
+         util_format_unsigned_decode_rgtc_block(src + 8, tmp_g);
          for(j = 0; j < 4; ++j) {
             for(i = 0; i < 4; ++i) {
                float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*4;
-               uint8_t tmp_r, tmp_g;
-               util_format_unsigned_fetch_texel_rgtc(0, src, i, j, &tmp_r, 2);
-               util_format_unsigned_fetch_texel_rgtc(0, src + 8, i, j, &tmp_g, 2);
-               dst[0] = ubyte_to_float(tmp_r);
-               dst[1] = ubyte_to_float(tmp_g);
+               dst[0] = ubyte_to_float(tmp_r[j * 4 + i]);
+               dst[1] = ubyte_to_float(tmp_g[j * 4 + i]);
                dst[2] = 0.0;
                dst[3] = 1.0;
             }
@@ -375,14 +380,14 @@ util_format_rgtc2_snorm_unpack_rgba_float(float *dst_row, unsigned dst_stride, c
    for(y = 0; y < height; y += 4) {
       const int8_t *src = (int8_t *)src_row;
       for(x = 0; x < width; x += 4) {
+         int8_t tmp_r[16], tmp_g[16];
+         util_format_signed_decode_rgtc_block(src, tmp_r);
+         util_format_signed_decode_rgtc_block(src + 8, tmp_g);
          for(j = 0; j < 4; ++j) {
             for(i = 0; i < 4; ++i) {
                float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*4;
-               int8_t tmp_r, tmp_g;
-               util_format_signed_fetch_texel_rgtc(0, src, i, j, &tmp_r, 2);
-               util_format_signed_fetch_texel_rgtc(0, src + 8, i, j, &tmp_g, 2);
-               dst[0] = byte_to_float_tex(tmp_r);
-               dst[1] = byte_to_float_tex(tmp_g);
+               dst[0] = byte_to_float_tex(tmp_r[j * 4 + i]);
+               dst[1] = byte_to_float_tex(tmp_g[j * 4 + i]);
                dst[2] = 0.0;
                dst[3] = 1.0;
             }
@@ -67,7 +67,9 @@
  * 2) User buffer uploading (u_vbuf_upload_buffers)
  *
  * Only the [min_index, max_index] range is uploaded (just like Translate)
- * with a single memcpy.
+ * with a single memcpy. Buffers whose ranges overlap in memory (interleaved
+ * client arrays) share one upload, and buffers which are not fetched by
+ * the driver after unrolling or translation are not uploaded at all.
  *
  * This method works best for non-indexed draw operations or indexed draw
  * operations where the [min_index, max_index] range is not being way bigger
@@ -908,7 +910,7 @@ void u_vbuf_set_index_buffer(struct u_vbuf *mgr,
 }
 
 static enum pipe_error
-u_vbuf_upload_buffers(struct u_vbuf *mgr,
+u_vbuf_upload_buffers(struct u_vbuf *mgr, uint32_t vb_mask,
                       int start_vertex, unsigned num_vertices,
                       int start_instance, unsigned num_instances)
 {
@@ -934,7 +936,8 @@ u_vbuf_upload_buffers(struct u_vbuf *mgr,
          continue;
       }
 
-      if (!vb->user_buffer) {
+      /* Skip buffers which are read directly or completely translated. */
+      if (!vb->user_buffer || !(vb_mask & (1 << index))) {
          continue;
       }
 
@@ -971,28 +974,71 @@ u_vbuf_upload_buffers(struct u_vbuf *mgr,
       buffer_mask |= index_bit;
    }
 
-   /* Upload buffers. */
+   /* Upload buffers.  Client arrays which overlap in memory, typically
+    * interleaved arrays bound as separate buffers, are uploaded once and
+    * share the copy.
+    */
    while (buffer_mask) {
-      unsigned start, end;
-      struct pipe_vertex_buffer *real_vb;
-      const uint8_t *ptr;
+      const uint8_t *start, *end;
+      struct pipe_resource *buffer = NULL;
+      uint32_t group_mask, mask;
+      unsigned offset, min_offset = 0;
       enum pipe_error err;
+      boolean grown;
 
       i = u_bit_scan(&buffer_mask);
-
-      start = start_offset[i];
-      end = end_offset[i];
+      group_mask = 1 << i;
+      start = (const uint8_t*)mgr->vertex_buffer[i].user_buffer +
+              start_offset[i];
+      end = (const uint8_t*)mgr->vertex_buffer[i].user_buffer + end_offset[i];
       assert(start < end);
 
-      real_vb = &mgr->real_vertex_buffer[i];
-      ptr = mgr->vertex_buffer[i].user_buffer;
+      do {
+         grown = FALSE;
+         mask = buffer_mask;
+         while (mask) {
+            unsigned j = u_bit_scan(&mask);
+            const uint8_t *ptr = mgr->vertex_buffer[j].user_buffer;
+
+            if (ptr + start_offset[j] < end && ptr + end_offset[j] > start) {
+               start = MIN2(start, ptr + start_offset[j]);
+               end = MAX2(end, ptr + end_offset[j]);
+               group_mask |= 1 << j;
+               buffer_mask &= ~(1 << j);
+               grown = TRUE;
+            }
+         }
+      } while (grown);
+
+      /* Each real buffer_offset is "offset" moved by the distance between
+       * the uploaded range and that buffer's data.  Keep them positive. */
+      mask = group_mask;
+      while (mask) {
+         const struct pipe_vertex_buffer *vb =
+            &mgr->vertex_buffer[u_bit_scan(&mask)];
+         const uint8_t *base = (const uint8_t*)vb->user_buffer +
+                               vb->buffer_offset;
+
+         if (start > base)
+            min_offset = MAX2(min_offset, (unsigned)(start - base));
+      }
 
-      err = u_upload_data(mgr->uploader, start, end - start, ptr + start,
-                          &real_vb->buffer_offset, &real_vb->buffer);
+      err = u_upload_data(mgr->uploader, min_offset, end - start, start,
+                          &offset, &buffer);
       if (err != PIPE_OK)
          return err;
 
-      real_vb->buffer_offset -= start;
+      while (group_mask) {
+         unsigned j = u_bit_scan(&group_mask);
+         const struct pipe_vertex_buffer *vb = &mgr->vertex_buffer[j];
+         struct pipe_vertex_buffer *real_vb = &mgr->real_vertex_buffer[j];
+         const uint8_t *base = (const uint8_t*)vb->user_buffer +
+                               vb->buffer_offset;
+
+         pipe_resource_reference(&real_vb->buffer, buffer);
+         real_vb->buffer_offset = offset + (base - start);
+      }
+      pipe_resource_reference(&buffer, NULL);
    }
 
    return PIPE_OK;
@@ -1257,7 +1303,7 @@ void u_vbuf_draw_vbo(struct u_vbuf *mgr, const struct pipe_draw_info *info)
 
    /* Upload user buffers. */
    if (user_vb_mask) {
-      if (u_vbuf_upload_buffers(mgr, start_vertex, num_vertices,
+      if (u_vbuf_upload_buffers(mgr, user_vb_mask, start_vertex, num_vertices,
                                 new_info.start_instance,
                                 new_info.instance_count) != PIPE_OK) {
          debug_warn_once("u_vbuf_upload_buffers() failed");
@@ -41,6 +41,7 @@
 #include "lp_setup.h"
 #include "lp_state_fs.h"
 #include "lp_state_setup.h"
+#include "lp_query.h"
 
 
 struct llvmpipe_vbuf_render;
@@ -149,6 +150,9 @@ struct llvmpipe_context {
    struct lp_setup_variant_list_item setup_variants_list;
    unsigned nr_setup_variants;
 
+   /** Counters reported by the driver specific queries */
+   struct llvmpipe_counters counters;
+
    /** Conditional query object and mode */
    struct pipe_query *render_cond_query;
    uint render_cond_mode;
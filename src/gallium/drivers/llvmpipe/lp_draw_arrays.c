@@ -35,6 +35,7 @@
 #include "pipe/p_context.h"
 #include "util/u_draw.h"
 #include "util/u_prim.h"
+#include "os/os_time.h"
 
 #include "lp_context.h"
 #include "lp_state.h"
@@ -57,6 +58,8 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
    struct draw_context *draw = lp->draw;
    const void *mapped_indices = NULL;
    unsigned i;
+   int64_t t0, t1;
+   uint64_t rast_time;
 
    if (!llvmpipe_check_render_cond(lp))
       return;
@@ -66,9 +69,15 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
       return;
    }
 
+   t0 = os_time_get();
+
    if (lp->dirty)
       llvmpipe_update_derived( lp );
 
+   t1 = os_time_get();
+   lp->counters.setup_time += t1 - t0;
+   rast_time = lp->counters.rast_time;
+
    /*
     * Map vertex buffers
     */
@@ -159,6 +168,12 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
     * internally when this condition is seen?)
     */
    draw_flush(draw);
+
+   /* Don't count scenes rasterized because they ran out of space as
+    * binning time.
+    */
+   lp->counters.binning_time += os_time_get() - t1 -
+                                (lp->counters.rast_time - rast_time);
 }
 
 
@@ -121,7 +121,8 @@ lp_jit_create_types(struct lp_fragment_shader_variant *lp)
       LLVMTypeRef elem_types[LP_JIT_SAMPLER_NUM_FIELDS];
       elem_types[LP_JIT_SAMPLER_MIN_LOD] =
       elem_types[LP_JIT_SAMPLER_MAX_LOD] =
-      elem_types[LP_JIT_SAMPLER_LOD_BIAS] = LLVMFloatTypeInContext(lc);
+      elem_types[LP_JIT_SAMPLER_LOD_BIAS] =
+      elem_types[LP_JIT_SAMPLER_MAX_ANISO] = LLVMFloatTypeInContext(lc);
       elem_types[LP_JIT_SAMPLER_BORDER_COLOR] =
          LLVMArrayType(LLVMFloatTypeInContext(lc), 4);
 
@@ -137,6 +138,9 @@ lp_jit_create_types(struct lp_fragment_shader_variant *lp)
       LP_CHECK_MEMBER_OFFSET(struct lp_jit_sampler, lod_bias,
                              gallivm->target, sampler_type,
                              LP_JIT_SAMPLER_LOD_BIAS);
+      LP_CHECK_MEMBER_OFFSET(struct lp_jit_sampler, max_aniso,
+                             gallivm->target, sampler_type,
+                             LP_JIT_SAMPLER_MAX_ANISO);
       LP_CHECK_MEMBER_OFFSET(struct lp_jit_sampler, border_color,
                              gallivm->target, sampler_type,
                              LP_JIT_SAMPLER_BORDER_COLOR);
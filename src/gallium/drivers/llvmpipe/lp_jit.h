@@ -66,6 +66,7 @@ struct lp_jit_sampler
    float min_lod;
    float max_lod;
    float lod_bias;
+   float max_aniso;
    float border_color[4];
 };
 
@@ -95,6 +96,7 @@ enum {
    LP_JIT_SAMPLER_MIN_LOD,
    LP_JIT_SAMPLER_MAX_LOD,
    LP_JIT_SAMPLER_LOD_BIAS,
+   LP_JIT_SAMPLER_MAX_ANISO,
    LP_JIT_SAMPLER_BORDER_COLOR,
    LP_JIT_SAMPLER_NUM_FIELDS  /* number of fields above */
 };
@@ -63,6 +63,18 @@
 
 #define LP_MAX_THREADS 16
 
+/**
+ * Limits for choosing cpus to pin rasterizer threads to.
+ */
+#define LP_MAX_PIN_CPUS 256
+#define LP_MAX_NUMA_NODES 64
+
+/**
+ * Max rectangles a display target's damage is presented as; beyond that
+ * their bounding box is presented instead.
+ */
+#define LP_MAX_DAMAGE_RECTS 64
+
 
 /**
  * Max bytes per scene.  This may be replaced by a runtime parameter.
@@ -48,6 +48,50 @@ static struct llvmpipe_query *llvmpipe_query( struct pipe_query *p )
    return (struct llvmpipe_query *)p;
 }
 
+
+static INLINE boolean
+is_driver_query(unsigned type)
+{
+   return type >= PIPE_QUERY_DRIVER_SPECIFIC && type < LP_QUERY_LAST;
+}
+
+
+/**
+ * Current value of the counter behind a driver specific query.
+ */
+static uint64_t
+get_driver_query_value(const struct llvmpipe_context *llvmpipe,
+                       unsigned type)
+{
+   const struct llvmpipe_counters *counters = &llvmpipe->counters;
+
+   switch (type) {
+   case LP_QUERY_SETUP_TIME:
+      return counters->setup_time;
+   case LP_QUERY_BINNING_TIME:
+      return counters->binning_time;
+   case LP_QUERY_RAST_TIME:
+      return counters->rast_time;
+   case LP_QUERY_RAST_IDLE_TIME:
+      return counters->rast_idle_time;
+   case LP_QUERY_COMPILE_TIME:
+      return counters->compile_time;
+   case LP_QUERY_COMPILES:
+      return counters->num_compiles;
+   case LP_QUERY_SCENE_MEMORY:
+      return counters->scene_memory;
+   case LP_QUERY_SCENES:
+      return counters->num_scenes;
+   case LP_QUERY_TILES_SHADED:
+      return counters->tiles_shaded;
+   case LP_QUERY_BINS_STOLEN:
+      return counters->bins_stolen;
+   default:
+      assert(type >= LP_QUERY_RAST_THREAD_TIME && type < LP_QUERY_LAST);
+      return counters->rast_thread_time[type - LP_QUERY_RAST_THREAD_TIME];
+   }
+}
+
 static struct pipe_query *
 llvmpipe_create_query(struct pipe_context *pipe, 
                       unsigned type,
@@ -55,7 +99,7 @@ llvmpipe_create_query(struct pipe_context *pipe,
 {
    struct llvmpipe_query *pq;
 
-   assert(type < PIPE_QUERY_TYPES);
+   assert(type < PIPE_QUERY_TYPES || is_driver_query(type));
 
    pq = CALLOC_STRUCT( llvmpipe_query );
 
@@ -176,6 +220,10 @@ llvmpipe_get_query_result(struct pipe_context *pipe,
    }
       break;
    default:
+      if (is_driver_query(pq->type)) {
+         *result = pq->end[0] - pq->start[0];
+         break;
+      }
       assert(0);
       break;
    }
@@ -201,6 +249,16 @@ llvmpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
 
    memset(pq->start, 0, sizeof(pq->start));
    memset(pq->end, 0, sizeof(pq->end));
+
+   /* Driver specific queries just sample the context's counters, and need
+    * neither a scene nor a fence.  Work still being binned is accounted
+    * when its scene gets rasterized.
+    */
+   if (is_driver_query(pq->type)) {
+      pq->start[0] = get_driver_query_value(llvmpipe, pq->type);
+      return;
+   }
+
    lp_setup_begin_query(llvmpipe->setup, pq);
 
    switch (pq->type) {
@@ -244,6 +302,11 @@ llvmpipe_end_query(struct pipe_context *pipe, struct pipe_query *q)
    struct llvmpipe_context *llvmpipe = llvmpipe_context( pipe );
    struct llvmpipe_query *pq = llvmpipe_query(q);
 
+   if (is_driver_query(pq->type)) {
+      pq->end[0] = get_driver_query_value(llvmpipe, pq->type);
+      return;
+   }
+
    lp_setup_end_query(llvmpipe->setup, pq);
 
    switch (pq->type) {
@@ -319,6 +382,46 @@ llvmpipe_check_render_cond(struct llvmpipe_context *lp)
       return TRUE;
 }
 
+int
+llvmpipe_get_driver_query_info(struct pipe_screen *_screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info)
+{
+   static const struct pipe_driver_query_info queries[] = {
+      {"setup-time", LP_QUERY_SETUP_TIME, 0, FALSE},
+      {"binning-time", LP_QUERY_BINNING_TIME, 0, FALSE},
+      {"rast-time", LP_QUERY_RAST_TIME, 0, FALSE},
+      {"rast-idle-time", LP_QUERY_RAST_IDLE_TIME, 0, FALSE},
+      {"shader-compile-time", LP_QUERY_COMPILE_TIME, 0, FALSE},
+      {"shader-compiles", LP_QUERY_COMPILES, 0, FALSE},
+      {"scene-memory", LP_QUERY_SCENE_MEMORY, 0, TRUE},
+      {"scenes", LP_QUERY_SCENES, 0, FALSE},
+      {"tiles-shaded", LP_QUERY_TILES_SHADED, 0, FALSE},
+      {"bins-stolen", LP_QUERY_BINS_STOLEN, 0, FALSE},
+   };
+   struct llvmpipe_screen *screen = llvmpipe_screen(_screen);
+   unsigned num_threads = MAX2(1, screen->num_threads);
+
+   if (!info)
+      return Elements(queries) + num_threads;
+
+   if (index < Elements(queries)) {
+      *info = queries[index];
+      return 1;
+   }
+
+   index -= Elements(queries);
+   if (index >= num_threads)
+      return 0;
+
+   info->name = screen->rast_thread_query_names[index];
+   info->query_type = LP_QUERY_RAST_THREAD_TIME + index;
+   info->max_value = 0;
+   info->uses_byte_units = FALSE;
+   return 1;
+}
+
+
 void llvmpipe_init_query_funcs(struct llvmpipe_context *llvmpipe )
 {
    llvmpipe->pipe.create_query = llvmpipe_create_query;
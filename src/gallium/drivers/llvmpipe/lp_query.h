@@ -35,10 +35,51 @@
 
 #include <limits.h>
 #include "os/os_thread.h"
+#include "pipe/p_defines.h"
 #include "lp_limits.h"
 
 
 struct llvmpipe_context;
+struct pipe_screen;
+struct pipe_driver_query_info;
+
+
+/**
+ * Driver specific queries, reporting the llvmpipe_counters below.
+ * Times are in microseconds.
+ */
+#define LP_QUERY_SETUP_TIME          (PIPE_QUERY_DRIVER_SPECIFIC + 0)
+#define LP_QUERY_BINNING_TIME        (PIPE_QUERY_DRIVER_SPECIFIC + 1)
+#define LP_QUERY_RAST_TIME           (PIPE_QUERY_DRIVER_SPECIFIC + 2)
+#define LP_QUERY_RAST_IDLE_TIME      (PIPE_QUERY_DRIVER_SPECIFIC + 3)
+#define LP_QUERY_COMPILE_TIME        (PIPE_QUERY_DRIVER_SPECIFIC + 4)
+#define LP_QUERY_COMPILES            (PIPE_QUERY_DRIVER_SPECIFIC + 5)
+#define LP_QUERY_SCENE_MEMORY        (PIPE_QUERY_DRIVER_SPECIFIC + 6)
+#define LP_QUERY_SCENES              (PIPE_QUERY_DRIVER_SPECIFIC + 7)
+#define LP_QUERY_TILES_SHADED        (PIPE_QUERY_DRIVER_SPECIFIC + 8)
+#define LP_QUERY_BINS_STOLEN         (PIPE_QUERY_DRIVER_SPECIFIC + 9)
+/** Per rasterizer thread busy time, LP_MAX_THREADS consecutive queries */
+#define LP_QUERY_RAST_THREAD_TIME    (PIPE_QUERY_DRIVER_SPECIFIC + 10)
+#define LP_QUERY_LAST                (LP_QUERY_RAST_THREAD_TIME + LP_MAX_THREADS)
+
+
+/**
+ * Always-on, per context counters.  These are cheap enough to be
+ * accumulated in release builds, unlike the lp_perf ones.
+ */
+struct llvmpipe_counters {
+   uint64_t setup_time;       /**< state validation, incl. shader lookup */
+   uint64_t binning_time;     /**< vertex processing, setup and binning */
+   uint64_t rast_time;        /**< wall time rasterizing scenes */
+   uint64_t rast_idle_time;   /**< sum of the threads' end of scene waits */
+   uint64_t rast_thread_time[LP_MAX_THREADS];
+   uint64_t compile_time;     /**< fragment and setup shader compiles */
+   uint64_t num_compiles;
+   uint64_t scene_memory;     /**< bytes of scene data rasterized */
+   uint64_t num_scenes;
+   uint64_t tiles_shaded;     /**< non-empty bins rasterized */
+   uint64_t bins_stolen;
+};
 
 
 struct llvmpipe_query {
@@ -57,4 +98,9 @@ extern void llvmpipe_init_query_funcs(struct llvmpipe_context * );
 
 extern boolean llvmpipe_check_render_cond(struct llvmpipe_context *);
 
+extern int
+llvmpipe_get_driver_query_info(struct pipe_screen *screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info);
+
 #endif /* LP_QUERY_H */
@@ -28,12 +28,18 @@
 #include <limits.h>
 #include "util/u_memory.h"
 #include "util/u_math.h"
+#include "util/u_string.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_rect.h"
 #include "util/u_surface.h"
 #include "util/u_pack_color.h"
 
 #include "os/os_time.h"
 
+#if defined(PIPE_OS_LINUX)
+#include <unistd.h>
+#endif
+
 #include "lp_scene_queue.h"
 #include "lp_context.h"
 #include "lp_debug.h"
@@ -67,7 +73,7 @@ lp_rast_begin( struct lp_rasterizer *rast,
    LP_DBG(DEBUG_RAST, "%s\n", __FUNCTION__);
 
    lp_scene_begin_rasterization( scene );
-   lp_scene_bin_iter_begin( scene );
+   lp_scene_bin_iter_begin( scene, MAX2(rast->num_threads, 1) );
 }
 
 
@@ -656,12 +662,21 @@ rasterize_scene(struct lp_rasterizer_task *task,
       {
          struct cmd_bin *bin;
          int i, j;
+         boolean stolen;
+         int64_t start = os_time_get();
 
          assert(scene);
-         while ((bin = lp_scene_bin_iter_next(scene, &i, &j))) {
-            if (!is_empty_bin( bin ))
+         while ((bin = lp_scene_bin_iter_next(scene, task->thread_index,
+                                              &i, &j, &stolen))) {
+            if (!is_empty_bin( bin )) {
                rasterize_bin(task, bin, i, j);
+               task->stats.num_bins++;
+               if (stolen)
+                  task->stats.num_stolen++;
+            }
          }
+
+         task->stats.busy_time += os_time_get() - start;
       }
    }
 
@@ -735,6 +750,20 @@ lp_rast_finish( struct lp_rasterizer *rast )
 }
 
 
+/**
+ * Return the accumulated statistics of a rasterizer thread.
+ * Only meaningful between scenes, i.e. after lp_rast_finish().
+ */
+void
+lp_rast_get_thread_stats( const struct lp_rasterizer *rast,
+                          unsigned thread,
+                          struct lp_rast_thread_stats *stats )
+{
+   assert(thread < MAX2(rast->num_threads, 1));
+   *stats = rast->tasks[thread].stats;
+}
+
+
 /**
  * This is the thread's main entrypoint.
  * It's a simple loop:
@@ -754,6 +783,12 @@ static PIPE_THREAD_ROUTINE( thread_function, init_data )
     */
    util_fpstate_set_denorms_to_zero(fpstate);
 
+   if (rast->pin_threads) {
+      if (!pipe_thread_pin_to_cpu(task->cpu))
+         debug_printf("llvmpipe: failed to pin thread %u to cpu %u\n",
+                      task->thread_index, task->cpu);
+   }
+
    while (1) {
       /* wait for work */
       if (debug)
@@ -785,7 +820,11 @@ static PIPE_THREAD_ROUTINE( thread_function, init_data )
                       rast->curr_scene);
       
       /* wait for all threads to finish with this scene */
-      pipe_barrier_wait( &rast->barrier );
+      {
+         int64_t start = os_time_get();
+         pipe_barrier_wait( &rast->barrier );
+         task->stats.idle_time += os_time_get() - start;
+      }
 
       /* XXX: shouldn't be necessary:
        */
@@ -804,6 +843,83 @@ static PIPE_THREAD_ROUTINE( thread_function, init_data )
 }
 
 
+/**
+ * Return the NUMA node of the given cpu, or 0 if unknown.
+ */
+static unsigned
+cpu_numa_node(unsigned cpu)
+{
+#if defined(PIPE_OS_LINUX)
+   char path[64];
+   unsigned node;
+
+   for (node = 0; node < LP_MAX_NUMA_NODES; node++) {
+      util_snprintf(path, sizeof path,
+                    "/sys/devices/system/node/node%u/cpu%u", node, cpu);
+      if (access(path, F_OK) == 0)
+         return node;
+   }
+#endif
+   return 0;
+}
+
+
+/**
+ * Choose the cpu each rasterizer thread gets pinned to.
+ *
+ * Threads are spread over the NUMA nodes in blocks, so that threads with
+ * adjacent indices share a node. Since adjacent threads also get adjacent
+ * screen regions (see lp_scene_bin_iter_begin()), and framebuffer pages are
+ * placed by first touch, this keeps most tile loads/stores node-local.
+ */
+static void
+assign_thread_cpus(struct lp_rasterizer *rast)
+{
+   unsigned nr_cpus = MIN2(MAX2(util_cpu_caps.nr_cpus, 1), LP_MAX_PIN_CPUS);
+   unsigned char cpu_node[LP_MAX_PIN_CPUS];
+   boolean cpu_used[LP_MAX_PIN_CPUS];
+   unsigned nodes[LP_MAX_NUMA_NODES];
+   unsigned num_nodes = 0;
+   unsigned cpu, i, j;
+
+   for (cpu = 0; cpu < nr_cpus; cpu++) {
+      cpu_node[cpu] = cpu_numa_node(cpu);
+      cpu_used[cpu] = FALSE;
+      for (j = 0; j < num_nodes; j++) {
+         if (nodes[j] == cpu_node[cpu])
+            break;
+      }
+      if (j == num_nodes)
+         nodes[num_nodes++] = cpu_node[cpu];
+   }
+
+   for (i = 0; i < rast->num_threads; i++) {
+      unsigned node = nodes[i * num_nodes / rast->num_threads];
+
+      /* first unused cpu on that node, any unused cpu, or just wrap around */
+      for (cpu = 0; cpu < nr_cpus; cpu++) {
+         if (!cpu_used[cpu] && cpu_node[cpu] == node)
+            break;
+      }
+      if (cpu == nr_cpus) {
+         for (cpu = 0; cpu < nr_cpus; cpu++) {
+            if (!cpu_used[cpu])
+               break;
+         }
+      }
+      if (cpu == nr_cpus) {
+         cpu = i % nr_cpus;
+      }
+
+      cpu_used[cpu] = TRUE;
+      rast->tasks[i].cpu = cpu;
+
+      LP_DBG(DEBUG_RAST, "thread %u -> cpu %u (node %u)\n",
+             i, cpu, cpu_node[cpu]);
+   }
+}
+
+
 /**
  * Initialize semaphores and spawn the threads.
  */
@@ -827,9 +943,10 @@ create_rast_threads(struct lp_rasterizer *rast)
  * Create new lp_rasterizer.  If num_threads is zero, don't create any
  * new threads, do rendering synchronously.
  * \param num_threads  number of rasterizer threads to create
+ * \param pin_threads  pin the threads to (NUMA node ordered) cpus
  */
 struct lp_rasterizer *
-lp_rast_create( unsigned num_threads )
+lp_rast_create( unsigned num_threads, boolean pin_threads )
 {
    struct lp_rasterizer *rast;
    unsigned i;
@@ -854,6 +971,11 @@ lp_rast_create( unsigned num_threads )
 
    rast->no_rast = debug_get_bool_option("LP_NO_RAST", FALSE);
 
+   rast->pin_threads = pin_threads;
+   if (pin_threads) {
+      assign_thread_cpus(rast);
+   }
+
    create_rast_threads(rast);
 
    /* for synchronizing rasterization threads */
@@ -876,6 +998,21 @@ void lp_rast_destroy( struct lp_rasterizer *rast )
 {
    unsigned i;
 
+   if (LP_DEBUG & DEBUG_COUNTERS) {
+      for (i = 0; i < MAX2(rast->num_threads, 1); i++) {
+         const struct lp_rasterizer_task *task = &rast->tasks[i];
+         int64_t total = task->stats.busy_time + task->stats.idle_time;
+         debug_printf("llvmpipe: thread %u: busy %.3f sec, idle %.3f sec "
+                      "(%3.0f%%), %u bins, %u stolen\n",
+                      i,
+                      task->stats.busy_time / 1000000.0,
+                      task->stats.idle_time / 1000000.0,
+                      total ? 100.0 * task->stats.idle_time / total : 0.0,
+                      task->stats.num_bins,
+                      task->stats.num_stolen);
+      }
+   }
+
    /* Set exit_flag and signal each thread's work_ready semaphore.
     * Each thread will be woken up, notice that the exit_flag is set and
     * break out of its main loop.  The thread will then exit.
@@ -150,8 +150,19 @@ struct lp_rast_clear_rb {
 
 
 
+/**
+ * Per-thread rasterization statistics (times in microseconds).
+ */
+struct lp_rast_thread_stats {
+   int64_t busy_time;      /**< spent rasterizing bins */
+   int64_t idle_time;      /**< spent waiting for the other threads */
+   unsigned num_bins;      /**< non-empty bins rasterized */
+   unsigned num_stolen;    /**< bins taken from other threads' queues */
+};
+
+
 struct lp_rasterizer *
-lp_rast_create( unsigned num_threads );
+lp_rast_create( unsigned num_threads, boolean pin_threads );
 
 void
 lp_rast_destroy( struct lp_rasterizer * );
@@ -163,6 +174,11 @@ lp_rast_queue_scene( struct lp_rasterizer *rast,
 void
 lp_rast_finish( struct lp_rasterizer *rast );
 
+void
+lp_rast_get_thread_stats( const struct lp_rasterizer *rast,
+                          unsigned thread,
+                          struct lp_rast_thread_stats *stats );
+
 
 union lp_rast_cmd_arg {
    const struct lp_rast_shader_inputs *shade_tile;
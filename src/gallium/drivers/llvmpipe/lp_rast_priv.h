@@ -97,11 +97,17 @@ struct lp_rasterizer_task
    /** "my" index */
    unsigned thread_index;
 
+   /** cpu this thread is pinned to (if lp_rasterizer::pin_threads) */
+   unsigned cpu;
+
    /** Non-interpolated passthru state and occlude counter for visible pixels */
    struct lp_jit_thread_data thread_data;
    uint64_t ps_invocations;
    uint8_t ps_inv_multiplier;
 
+   /** Load balancing statistics */
+   struct lp_rast_thread_stats stats;
+
    pipe_semaphore work_ready;
    pipe_semaphore work_done;
 };
@@ -128,6 +134,7 @@ struct lp_rasterizer
 
    unsigned num_threads;
    pipe_thread threads[LP_MAX_THREADS];
+   boolean pin_threads;
 
    /** For synchronizing the rasterization threads */
    pipe_barrier barrier;
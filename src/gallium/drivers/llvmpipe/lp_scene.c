@@ -34,6 +34,8 @@
 #include "lp_scene.h"
 #include "lp_fence.h"
 #include "lp_debug.h"
+#include "lp_screen.h"
+#include "lp_texture.h"
 
 
 #define RESOURCE_REF_SZ 32
@@ -54,6 +56,8 @@ struct lp_scene *
 lp_scene_create( struct pipe_context *pipe )
 {
    struct lp_scene *scene = CALLOC_STRUCT(lp_scene);
+   unsigned i;
+
    if (!scene)
       return NULL;
 
@@ -62,7 +66,9 @@ lp_scene_create( struct pipe_context *pipe )
    scene->data.head =
       CALLOC_STRUCT(data_block);
 
-   pipe_mutex_init(scene->mutex);
+   for (i = 0; i < Elements(scene->bin_queues); i++) {
+      pipe_mutex_init(scene->bin_queues[i].mutex);
+   }
 
 #ifdef DEBUG
    /* Do some scene limit sanity checks here */
@@ -89,8 +95,12 @@ lp_scene_create( struct pipe_context *pipe )
 void
 lp_scene_destroy(struct lp_scene *scene)
 {
+   unsigned i;
+
    lp_fence_reference(&scene->fence, NULL);
-   pipe_mutex_destroy(scene->mutex);
+   for (i = 0; i < Elements(scene->bin_queues); i++) {
+      pipe_mutex_destroy(scene->bin_queues[i].mutex);
+   }
    assert(scene->data.head->next == NULL);
    FREE(scene->data.head);
    FREE(scene);
@@ -446,61 +456,126 @@ lp_scene_is_resource_referenced(const struct lp_scene *scene,
 
 
 
-/** advance curr_x,y to the next bin */
-static boolean
-next_bin(struct lp_scene *scene)
+/**
+ * Compute the order in which bins are handed out: square blocks of
+ * BIN_BLOCK_SIZE tiles in raster order, and raster order within each block.
+ * Splitting this order into contiguous ranges gives each thread a
+ * spatially coherent region of the framebuffer.
+ */
+static void
+compute_bin_order(struct lp_scene *scene)
 {
-   scene->curr_x++;
-   if (scene->curr_x >= scene->tiles_x) {
-      scene->curr_x = 0;
-      scene->curr_y++;
-   }
-   if (scene->curr_y >= scene->tiles_y) {
-      /* no more bins */
-      return FALSE;
+   unsigned bx, by, x, y;
+   unsigned n = 0;
+
+   for (by = 0; by < scene->tiles_y; by += BIN_BLOCK_SIZE) {
+      for (bx = 0; bx < scene->tiles_x; bx += BIN_BLOCK_SIZE) {
+         unsigned x_end = MIN2(bx + BIN_BLOCK_SIZE, scene->tiles_x);
+         unsigned y_end = MIN2(by + BIN_BLOCK_SIZE, scene->tiles_y);
+         for (y = by; y < y_end; y++) {
+            for (x = bx; x < x_end; x++) {
+               scene->bin_order[n++] = x | (y << 16);
+            }
+         }
+      }
    }
-   return TRUE;
+
+   assert(n == lp_scene_get_num_bins(scene));
 }
 
 
+/**
+ * Prepare for iterating over the scene's bins with the given number of
+ * queues (one per rasterizer thread).
+ * Each queue gets an equally sized contiguous range of the bin order.
+ */
 void
-lp_scene_bin_iter_begin( struct lp_scene *scene )
+lp_scene_bin_iter_begin( struct lp_scene *scene, unsigned num_queues )
 {
-   scene->curr_x = scene->curr_y = -1;
+   unsigned num_bins = lp_scene_get_num_bins(scene);
+   unsigned i;
+
+   assert(num_queues >= 1 && num_queues <= Elements(scene->bin_queues));
+
+   if (scene->bin_order_tiles_x != scene->tiles_x ||
+       scene->bin_order_tiles_y != scene->tiles_y) {
+      compute_bin_order(scene);
+      scene->bin_order_tiles_x = scene->tiles_x;
+      scene->bin_order_tiles_y = scene->tiles_y;
+   }
+
+   scene->num_bin_queues = num_queues;
+   for (i = 0; i < num_queues; i++) {
+      scene->bin_queues[i].head = num_bins * i / num_queues;
+      scene->bin_queues[i].tail = num_bins * (i + 1) / num_queues;
+   }
+}
+
+
+/**
+ * Take the bin at the head (owner) or tail (thief) of a queue.
+ * Returns FALSE if the queue is empty.
+ */
+static boolean
+bin_queue_pop(struct bin_queue *queue, boolean from_tail, unsigned *index)
+{
+   boolean ret = FALSE;
+
+   pipe_mutex_lock(queue->mutex);
+   if (queue->head < queue->tail) {
+      *index = from_tail ? --queue->tail : queue->head++;
+      ret = TRUE;
+   }
+   pipe_mutex_unlock(queue->mutex);
+
+   return ret;
 }
 
 
 /**
- * Return pointer to next bin to be rendered.
- * The lp_scene::curr_x and ::curr_y fields will be advanced.
+ * Return pointer to next bin to be rendered by the thread owning the
+ * given queue.
  * Multiple rendering threads will call this function to get a chunk
- * of work (a bin) to work on.
+ * of work (a bin) to work on. Once a thread's own queue is exhausted it
+ * steals from the end of the other threads' queues, starting with its
+ * neighbours, so the regions which are left over are split up without
+ * disturbing the owners' locality much.
+ * \param stolen  optionally returns whether the bin came from another queue
  */
 struct cmd_bin *
-lp_scene_bin_iter_next( struct lp_scene *scene , int *x, int *y)
+lp_scene_bin_iter_next( struct lp_scene *scene, unsigned queue,
+                        int *x, int *y, boolean *stolen )
 {
-   struct cmd_bin *bin = NULL;
+   unsigned num_queues = scene->num_bin_queues;
+   unsigned index, i;
+   unsigned order;
 
-   pipe_mutex_lock(scene->mutex);
+   assert(queue < num_queues);
 
-   if (scene->curr_x < 0) {
-      /* first bin */
-      scene->curr_x = 0;
-      scene->curr_y = 0;
+   if (bin_queue_pop(&scene->bin_queues[queue], FALSE, &index)) {
+      if (stolen)
+         *stolen = FALSE;
    }
-   else if (!next_bin(scene)) {
-      /* no more bins left */
-      goto end;
+   else {
+      for (i = 1; i < num_queues; i++) {
+         if (bin_queue_pop(&scene->bin_queues[(queue + i) % num_queues],
+                           TRUE, &index))
+            break;
+      }
+      if (i == num_queues) {
+         /* no more bins left */
+         return NULL;
+      }
+      if (stolen)
+         *stolen = TRUE;
    }
 
-   bin = lp_scene_get_bin(scene, scene->curr_x, scene->curr_y);
-   *x = scene->curr_x;
-   *y = scene->curr_y;
+   order = scene->bin_order[index];
+   *x = order & 0xffff;
+   *y = order >> 16;
 
-end:
-   /*printf("return bin %p at %d, %d\n", (void *) bin, *bin_x, *bin_y);*/
-   pipe_mutex_unlock(scene->mutex);
-   return bin;
+   /*printf("return bin %d, %d\n", *x, *y);*/
+   return lp_scene_get_bin(scene, *x, *y);
 }
 
 
@@ -559,3 +634,69 @@ void lp_scene_end_binning( struct lp_scene *scene )
          lp_debug_bins( scene );
    }
 }
+
+
+/**
+ * Whether any command in the bin may write the color buffers.
+ */
+static boolean
+bin_writes_color(const struct cmd_bin *bin)
+{
+   const struct cmd_block *block;
+   unsigned i;
+
+   for (block = bin->head; block; block = block->next) {
+      for (i = 0; i < block->count; i++) {
+         switch (block->cmd[i]) {
+         case LP_RAST_OP_CLEAR_ZSTENCIL:
+         case LP_RAST_OP_BEGIN_QUERY:
+         case LP_RAST_OP_END_QUERY:
+         case LP_RAST_OP_SET_STATE:
+            break;
+         default:
+            return TRUE;
+         }
+      }
+   }
+
+   return FALSE;
+}
+
+
+/**
+ * Add the tiles written by the scene to the damage of the color buffers
+ * which are display targets.
+ */
+void
+lp_scene_update_damage( struct lp_scene *scene )
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(scene->pipe->screen);
+   struct llvmpipe_resource *targets[PIPE_MAX_COLOR_BUFS];
+   unsigned num_targets = 0;
+   unsigned i, x, y;
+
+   if (scene->discard)
+      return;
+
+   for (i = 0; i < scene->fb.nr_cbufs; i++) {
+      struct pipe_surface *cbuf = scene->fb.cbufs[i];
+      if (cbuf && llvmpipe_resource(cbuf->texture)->damage) {
+         targets[num_targets++] = llvmpipe_resource(cbuf->texture);
+      }
+   }
+
+   if (!num_targets)
+      return;
+
+   pipe_mutex_lock(screen->damage_mutex);
+   for (y = 0; y < scene->tiles_y; y++) {
+      for (x = 0; x < scene->tiles_x; x++) {
+         if (bin_writes_color(lp_scene_get_bin(scene, x, y))) {
+            for (i = 0; i < num_targets; i++) {
+               llvmpipe_resource_damage_tile(targets[i], x, y);
+            }
+         }
+      }
+   }
+   pipe_mutex_unlock(screen->damage_mutex);
+}
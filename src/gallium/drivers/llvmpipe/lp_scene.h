@@ -38,6 +38,7 @@
 #include "os/os_thread.h"
 #include "lp_rast.h"
 #include "lp_debug.h"
+#include "lp_limits.h"
 
 struct lp_scene_queue;
 struct lp_rast_state;
@@ -58,6 +59,11 @@ struct lp_rast_state;
  */
 #define DATA_BLOCK_SIZE (64 * 1024)
 
+/* Bins are handed out to the rasterizer threads in square blocks of
+ * this many tiles per side, for locality.
+ */
+#define BIN_BLOCK_SIZE 4
+
 /* Scene temporary storage is clamped to this size:
  */
 #define LP_SCENE_MAX_SIZE (9*1024*1024)
@@ -117,6 +123,17 @@ struct data_block_list {
 
 struct resource_ref;
 
+/**
+ * A contiguous range of the scene's bin order owned by one rasterizer
+ * thread. The owner takes bins from the head, other threads which ran out
+ * of work steal from the tail.
+ */
+struct bin_queue {
+   pipe_mutex mutex;
+   unsigned head;
+   unsigned tail;
+};
+
 /**
  * All bins and bin data are contained here.
  * Per-bin data goes into the 'tile' bins.
@@ -172,8 +189,17 @@ struct lp_scene {
     */
    unsigned tiles_x, tiles_y;
 
-   int curr_x, curr_y;  /**< for iterating over bins */
-   pipe_mutex mutex;
+   /** Per-thread queues of bins for iterating over bins */
+   struct bin_queue bin_queues[LP_MAX_THREADS];
+   unsigned num_bin_queues;
+
+   /**
+    * Order in which the bins are distributed to the queues, as (x | y << 16).
+    * Only depends on the tile counts (which are remembered here too), so
+    * each thread keeps getting the same screen region from scene to scene.
+    */
+   unsigned bin_order[TILES_X * TILES_Y];
+   unsigned bin_order_tiles_x, bin_order_tiles_y;
 
    struct cmd_bin tile[TILES_X][TILES_Y];
    struct data_block_list data;
@@ -378,10 +404,11 @@ lp_scene_get_num_bins( const struct lp_scene *scene )
 
 
 void
-lp_scene_bin_iter_begin( struct lp_scene *scene );
+lp_scene_bin_iter_begin( struct lp_scene *scene, unsigned num_queues );
 
 struct cmd_bin *
-lp_scene_bin_iter_next( struct lp_scene *scene, int *x, int *y );
+lp_scene_bin_iter_next( struct lp_scene *scene, unsigned queue,
+                        int *x, int *y, boolean *stolen );
 
 
 
@@ -395,6 +422,9 @@ lp_scene_begin_binning( struct lp_scene *scene,
 void
 lp_scene_end_binning( struct lp_scene *scene );
 
+void
+lp_scene_update_damage( struct lp_scene *scene );
+
 
 /* Begin/end rasterization of a scene
  */
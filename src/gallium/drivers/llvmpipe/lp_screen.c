@@ -32,6 +32,7 @@
 #include "util/u_format.h"
 #include "util/u_string.h"
 #include "util/u_format_s3tc.h"
+#include "util/u_box.h"
 #include "pipe/p_defines.h"
 #include "pipe/p_screen.h"
 #include "draw/draw_context.h"
@@ -45,6 +46,7 @@
 #include "lp_screen.h"
 #include "lp_context.h"
 #include "lp_debug.h"
+#include "lp_query.h"
 #include "lp_public.h"
 #include "lp_limits.h"
 #include "lp_rast.h"
@@ -331,7 +333,7 @@ llvmpipe_get_paramf(struct pipe_screen *screen, enum pipe_capf param)
    case PIPE_CAPF_MAX_POINT_WIDTH_AA:
       return 255.0; /* arbitrary */
    case PIPE_CAPF_MAX_TEXTURE_ANISOTROPY:
-      return 16.0; /* not actually signficant at this time */
+      return 16.0;
    case PIPE_CAPF_MAX_TEXTURE_LOD_BIAS:
       return 16.0; /* arbitrary */
    case PIPE_CAPF_GUARD_BAND_LEFT:
@@ -465,10 +467,102 @@ llvmpipe_flush_frontbuffer(struct pipe_screen *_screen,
    struct llvmpipe_screen *screen = llvmpipe_screen(_screen);
    struct sw_winsys *winsys = screen->winsys;
    struct llvmpipe_resource *texture = llvmpipe_resource(resource);
+   struct pipe_box rects[LP_MAX_DAMAGE_RECTS];
+   unsigned num_rects;
+   boolean full;
 
    assert(texture->dt);
-   if (texture->dt)
+   if (!texture->dt)
+      return;
+
+   /* Explicit sub-boxes are presented as is, and leave the damage alone.
+    * They change the drawable behind the tracking's back, though.
+    */
+   if (sub_box || !screen->present_damage || !texture->damage) {
+      pipe_mutex_lock(screen->damage_mutex);
+      if (screen->last_present_drawable == context_private) {
+         if (screen->last_present_resource != resource)
+            screen->last_present_resource = NULL;
+         screen->prev_present_resource = NULL;
+      }
+      pipe_mutex_unlock(screen->damage_mutex);
       winsys->displaytarget_display(winsys, texture->dt, context_private, sub_box);
+      return;
+   }
+
+   /* The damage is only relative to what the drawable shows if this
+    * resource was the last one presented to it.  Double buffering
+    * alternates between two resources: the drawable then shows the other
+    * one, which differs from this resource's previous present by what
+    * the other one presented last, so add that to the damage.
+    */
+   pipe_mutex_lock(screen->damage_mutex);
+   full = TRUE;
+   if (screen->last_present_drawable == context_private) {
+      if (screen->last_present_resource == resource) {
+         full = FALSE;
+      }
+      else if (screen->prev_present_resource == resource &&
+               screen->last_present_width == resource->width0 &&
+               screen->last_present_height == resource->height0) {
+         unsigned i;
+         for (i = 0; i < screen->last_present_num_rects; i++)
+            llvmpipe_resource_damage_locked(resource,
+                                            &screen->last_present_rects[i]);
+         full = FALSE;
+      }
+   }
+   num_rects = llvmpipe_resource_take_damage(texture, rects, Elements(rects));
+
+   if (full) {
+      u_box_2d(0, 0, resource->width0, resource->height0, &rects[0]);
+      num_rects = 1;
+   }
+   else if (num_rects > 1 && !winsys->displaytarget_display_rects) {
+      struct pipe_box bbox = rects[0];
+      unsigned i;
+      for (i = 1; i < num_rects; i++) {
+         int x1 = MAX2(bbox.x + bbox.width, rects[i].x + rects[i].width);
+         int y1 = MAX2(bbox.y + bbox.height, rects[i].y + rects[i].height);
+         bbox.x = MIN2(bbox.x, rects[i].x);
+         bbox.y = MIN2(bbox.y, rects[i].y);
+         bbox.width = x1 - bbox.x;
+         bbox.height = y1 - bbox.y;
+      }
+      rects[0] = bbox;
+      num_rects = 1;
+   }
+
+   /* Only a strict alternation keeps the other resource's contents one
+    * present behind.
+    */
+   if (screen->last_present_drawable == context_private &&
+       screen->last_present_resource != resource)
+      screen->prev_present_resource = screen->last_present_resource;
+   else
+      screen->prev_present_resource = NULL;
+   screen->last_present_resource = resource;
+   screen->last_present_drawable = context_private;
+   screen->last_present_width = resource->width0;
+   screen->last_present_height = resource->height0;
+   memcpy(screen->last_present_rects, rects, num_rects * sizeof rects[0]);
+   screen->last_present_num_rects = num_rects;
+   pipe_mutex_unlock(screen->damage_mutex);
+
+   if (full) {
+      winsys->displaytarget_display(winsys, texture->dt, context_private, NULL);
+   }
+   else if (num_rects == 0) {
+      /* nothing changed */
+   }
+   else if (winsys->displaytarget_display_rects) {
+      winsys->displaytarget_display_rects(winsys, texture->dt, context_private,
+                                          rects, num_rects);
+   }
+   else {
+      winsys->displaytarget_display(winsys, texture->dt, context_private,
+                                    &rects[0]);
+   }
 }
 
 static void
@@ -486,6 +580,7 @@ llvmpipe_destroy_screen( struct pipe_screen *_screen )
       winsys->destroy(winsys);
 
    pipe_mutex_destroy(screen->rast_mutex);
+   pipe_mutex_destroy(screen->damage_mutex);
 
    FREE(screen);
 }
@@ -548,6 +643,7 @@ struct pipe_screen *
 llvmpipe_create_screen(struct sw_winsys *winsys)
 {
    struct llvmpipe_screen *screen;
+   unsigned i;
 
    util_cpu_detect();
 
@@ -585,6 +681,7 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->base.fence_finish = llvmpipe_fence_finish;
 
    screen->base.get_timestamp = llvmpipe_get_timestamp;
+   screen->base.get_driver_query_info = llvmpipe_get_driver_query_info;
 
    llvmpipe_init_screen_resource_funcs(&screen->base);
 
@@ -597,13 +694,23 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->num_threads = debug_get_num_option("LP_NUM_THREADS", screen->num_threads);
    screen->num_threads = MIN2(screen->num_threads, LP_MAX_THREADS);
 
-   screen->rast = lp_rast_create(screen->num_threads);
+   screen->pin_threads = debug_get_bool_option("LP_PIN_THREADS", FALSE);
+   screen->present_damage = debug_get_bool_option("LP_PRESENT_DAMAGE", TRUE);
+
+   for (i = 0; i < LP_MAX_THREADS; i++) {
+      util_snprintf(screen->rast_thread_query_names[i],
+                    sizeof screen->rast_thread_query_names[i],
+                    "rast-thread-%u-time", i);
+   }
+
+   screen->rast = lp_rast_create(screen->num_threads, screen->pin_threads);
    if (!screen->rast) {
       lp_jit_screen_cleanup(screen);
       FREE(screen);
       return NULL;
    }
    pipe_mutex_init(screen->rast_mutex);
+   pipe_mutex_init(screen->damage_mutex);
 
    util_format_s3tc_init();
 
@@ -36,8 +36,10 @@
 
 #include "pipe/p_screen.h"
 #include "pipe/p_defines.h"
+#include "pipe/p_state.h"
 #include "os/os_thread.h"
 #include "gallivm/lp_bld.h"
+#include "lp_limits.h"
 
 
 struct sw_winsys;
@@ -51,12 +53,39 @@ struct llvmpipe_screen
 
    unsigned num_threads;
 
+   /** Pin rasterizer threads to cpus and place framebuffers by first touch */
+   boolean pin_threads;
+
    /* Increments whenever textures are modified.  Contexts can track this.
     */
    unsigned timestamp;
 
    struct lp_rasterizer *rast;
    pipe_mutex rast_mutex;
+
+   /** Only present the damaged parts of display targets */
+   boolean present_damage;
+
+   /**
+    * Protects the display targets' damage, and the resource/drawable pair
+    * last presented, whose damage is relative to the drawable's contents.
+    * The resources are only compared, never dereferenced.
+    *
+    * prev_present_resource is the resource presented to the same drawable
+    * before last_present_resource, and last_present_rects what the latter
+    * changed on top of it, so that double buffering can present the union
+    * of the two.
+    */
+   pipe_mutex damage_mutex;
+   const struct pipe_resource *last_present_resource;
+   const void *last_present_drawable;
+   unsigned last_present_width, last_present_height;
+   const struct pipe_resource *prev_present_resource;
+   struct pipe_box last_present_rects[LP_MAX_DAMAGE_RECTS];
+   unsigned last_present_num_rects;
+
+   /** Names of the per thread LP_QUERY_RAST_THREAD_TIME queries */
+   char rast_thread_query_names[LP_MAX_THREADS][24];
 };
 
 
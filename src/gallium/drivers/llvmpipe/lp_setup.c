@@ -152,21 +152,50 @@ lp_setup_rasterize_scene( struct lp_setup_context *setup )
 {
    struct lp_scene *scene = setup->scene;
    struct llvmpipe_screen *screen = llvmpipe_screen(scene->pipe->screen);
+   struct llvmpipe_counters *counters =
+      &llvmpipe_context(scene->pipe)->counters;
+   struct lp_rast_thread_stats before[LP_MAX_THREADS];
+   unsigned num_threads = MAX2(1, screen->num_threads);
+   unsigned i;
+   int64_t t0;
 
    scene->num_active_queries = setup->active_binned_queries;
    memcpy(scene->active_queries, setup->active_queries,
           scene->num_active_queries * sizeof(scene->active_queries[0]));
 
    lp_scene_end_binning(scene);
+   lp_scene_update_damage(scene);
 
    lp_fence_reference(&setup->last_fence, scene->fence);
 
    if (setup->last_fence)
       setup->last_fence->issued = TRUE;
 
+   counters->scene_memory += scene->scene_size;
+   counters->num_scenes++;
+
    pipe_mutex_lock(screen->rast_mutex);
+
+   /* The rasterizer is shared by all contexts, so attribute to this one
+    * only what changed while rasterizing its scene.
+    */
+   for (i = 0; i < num_threads; i++)
+      lp_rast_get_thread_stats(screen->rast, i, &before[i]);
+
+   t0 = os_time_get();
    lp_rast_queue_scene(screen->rast, scene);
    lp_rast_finish(screen->rast);
+   counters->rast_time += os_time_get() - t0;
+
+   for (i = 0; i < num_threads; i++) {
+      struct lp_rast_thread_stats after;
+      lp_rast_get_thread_stats(screen->rast, i, &after);
+      counters->rast_thread_time[i] += after.busy_time - before[i].busy_time;
+      counters->rast_idle_time += after.idle_time - before[i].idle_time;
+      counters->tiles_shaded += after.num_bins - before[i].num_bins;
+      counters->bins_stolen += after.num_stolen - before[i].num_stolen;
+   }
+
    pipe_mutex_unlock(screen->rast_mutex);
 
    lp_scene_end_rasterization(setup->scene);
@@ -934,6 +963,7 @@ lp_setup_set_fragment_sampler_state(struct lp_setup_context *setup,
          jit_sam->min_lod = sampler->min_lod;
          jit_sam->max_lod = sampler->max_lod;
          jit_sam->lod_bias = sampler->lod_bias;
+         jit_sam->max_aniso = sampler->max_anisotropy;
          COPY_4V(jit_sam->border_color, sampler->border_color.f);
       }
    }
@@ -27,6 +27,7 @@
 
 #include "util/u_rect.h"
 #include "util/u_surface.h"
+#include "util/u_box.h"
 #include "lp_context.h"
 #include "lp_flush.h"
 #include "lp_limits.h"
@@ -112,8 +113,12 @@ lp_resource_copy(struct pipe_context *pipe,
 
    if (src_tex->dt)
       llvmpipe_resource_unmap(src, 0, 0);
-   if (dst_tex->dt)
+   if (dst_tex->dt) {
+      struct pipe_box dst_box;
+      u_box_2d(dstx, dsty, width, height, &dst_box);
+      llvmpipe_resource_damage(dst, &dst_box);
       llvmpipe_resource_unmap(dst, 0, 0);
+   }
 
 }
 
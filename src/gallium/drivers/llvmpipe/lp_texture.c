@@ -42,6 +42,7 @@
 #include "util/u_memory.h"
 #include "util/u_simple_list.h"
 #include "util/u_transfer.h"
+#include "util/u_box.h"
 
 #include "lp_context.h"
 #include "lp_flush.h"
@@ -53,6 +54,10 @@
 
 #include "state_tracker/sw_winsys.h"
 
+#if defined(PIPE_OS_UNIX)
+#include "os/os_mman.h"
+#endif
+
 
 #ifdef DEBUG
 static struct llvmpipe_resource resource_list;
@@ -60,6 +65,28 @@ static struct llvmpipe_resource resource_list;
 static unsigned id_counter = 0;
 
 
+/**
+ * Allocate zeroed memory whose pages only get backed (and hence placed on
+ * a NUMA node) when first accessed. The OS zero-fills anonymous mappings on
+ * demand, so unlike align_malloc + memset the allocating thread doesn't
+ * touch the pages; for render targets they end up local to the pinned
+ * rasterizer thread which first renders to them.
+ * Returns NULL if not supported.
+ */
+static void *
+alloc_first_touch(uint64_t size)
+{
+#if defined(PIPE_OS_UNIX)
+   void *ptr = os_mmap(NULL, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   return ptr == MAP_FAILED ? NULL : ptr;
+#else
+   (void) size;
+   return NULL;
+#endif
+}
+
+
 /**
  * Conventional allocation path for non-display textures:
  * Compute strides and allocate data (unless asked not to).
@@ -164,12 +191,22 @@ llvmpipe_texture_layout(struct llvmpipe_screen *screen,
    }
 
    if (allocate) {
-      lpr->tex_data = align_malloc(total_size, mip_align);
-      if (!lpr->tex_data) {
-         return FALSE;
+      lpr->total_alloc_size = total_size;
+
+      if (screen->pin_threads &&
+          (pt->bind & (PIPE_BIND_RENDER_TARGET | PIPE_BIND_DEPTH_STENCIL))) {
+         lpr->tex_data = alloc_first_touch(total_size);
+         lpr->first_touch = lpr->tex_data != NULL;
       }
-      else {
-         memset(lpr->tex_data, 0, total_size);
+
+      if (!lpr->tex_data) {
+         lpr->tex_data = align_malloc(total_size, mip_align);
+         if (!lpr->tex_data) {
+            return FALSE;
+         }
+         else {
+            memset(lpr->tex_data, 0, total_size);
+         }
       }
    }
 
@@ -195,6 +232,28 @@ llvmpipe_can_create_resource(struct pipe_screen *screen,
 }
 
 
+/**
+ * Allocate the damage tracking of a display target, with all of it
+ * initially damaged.
+ */
+static boolean
+llvmpipe_displaytarget_init_damage(struct llvmpipe_resource *lpr)
+{
+   unsigned num_tiles;
+
+   lpr->damage_tiles_x = align(MAX2(1, lpr->base.width0), TILE_SIZE) / TILE_SIZE;
+   lpr->damage_tiles_y = align(MAX2(1, lpr->base.height0), TILE_SIZE) / TILE_SIZE;
+   num_tiles = lpr->damage_tiles_x * lpr->damage_tiles_y;
+
+   lpr->damage = MALLOC((num_tiles + 31) / 32 * sizeof lpr->damage[0]);
+   if (!lpr->damage)
+      return FALSE;
+
+   memset(lpr->damage, 0xff, (num_tiles + 31) / 32 * sizeof lpr->damage[0]);
+   return TRUE;
+}
+
+
 static boolean
 llvmpipe_displaytarget_layout(struct llvmpipe_screen *screen,
                               struct llvmpipe_resource *lpr)
@@ -217,6 +276,12 @@ llvmpipe_displaytarget_layout(struct llvmpipe_screen *screen,
    if (lpr->dt == NULL)
       return FALSE;
 
+   if (!llvmpipe_displaytarget_init_damage(lpr)) {
+      winsys->displaytarget_destroy(winsys, lpr->dt);
+      lpr->dt = NULL;
+      return FALSE;
+   }
+
    {
       void *map = winsys->displaytarget_map(winsys, lpr->dt,
                                             PIPE_TRANSFER_WRITE);
@@ -310,11 +375,25 @@ llvmpipe_resource_destroy(struct pipe_screen *pscreen,
       /* display target */
       struct sw_winsys *winsys = screen->winsys;
       winsys->displaytarget_destroy(winsys, lpr->dt);
+
+      pipe_mutex_lock(screen->damage_mutex);
+      if (screen->last_present_resource == pt)
+         screen->last_present_resource = NULL;
+      if (screen->prev_present_resource == pt)
+         screen->prev_present_resource = NULL;
+      pipe_mutex_unlock(screen->damage_mutex);
+
+      FREE(lpr->damage);
    }
    else if (llvmpipe_resource_is_texture(pt)) {
       /* free linear image data */
       if (lpr->tex_data) {
-         align_free(lpr->tex_data);
+#if defined(PIPE_OS_UNIX)
+         if (lpr->first_touch)
+            os_munmap(lpr->tex_data, lpr->total_alloc_size);
+         else
+#endif
+            align_free(lpr->tex_data);
          lpr->tex_data = NULL;
       }
    }
@@ -456,6 +535,11 @@ llvmpipe_resource_from_handle(struct pipe_screen *screen,
       goto no_dt;
    }
 
+   if (!llvmpipe_displaytarget_init_damage(lpr)) {
+      winsys->displaytarget_destroy(winsys, lpr->dt);
+      goto no_dt;
+   }
+
    lpr->id = id_counter++;
 
 #ifdef DEBUG
@@ -592,6 +676,8 @@ llvmpipe_transfer_map( struct pipe_context *pipe,
       /* Do something to notify sharing contexts of a texture change.
        */
       screen->timestamp++;
+
+      llvmpipe_resource_damage(resource, box);
    }
 
    map +=
@@ -672,6 +758,144 @@ llvmpipe_get_format_alignment( enum pipe_format format )
 }
 
 
+/**
+ * Mark the tiles of a display target overlapped by the box as damaged.
+ * The caller must hold llvmpipe_screen::damage_mutex.
+ */
+void
+llvmpipe_resource_damage_locked(struct pipe_resource *resource,
+                                const struct pipe_box *box)
+{
+   struct llvmpipe_resource *lpr = llvmpipe_resource(resource);
+   int x0, y0, x1, y1;
+   unsigned tx, ty;
+
+   if (!lpr->damage)
+      return;
+
+   x0 = MAX2(box->x, 0);
+   y0 = MAX2(box->y, 0);
+   x1 = MIN2(box->x + box->width, (int) resource->width0);
+   y1 = MIN2(box->y + box->height, (int) resource->height0);
+   if (x0 >= x1 || y0 >= y1)
+      return;
+
+   for (ty = y0 / TILE_SIZE; ty <= (y1 - 1) / TILE_SIZE; ty++) {
+      for (tx = x0 / TILE_SIZE; tx <= (x1 - 1) / TILE_SIZE; tx++) {
+         llvmpipe_resource_damage_tile(lpr, tx, ty);
+      }
+   }
+}
+
+
+/**
+ * Mark the tiles of a display target overlapped by the box as damaged.
+ */
+void
+llvmpipe_resource_damage(struct pipe_resource *resource,
+                         const struct pipe_box *box)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(resource->screen);
+
+   if (!llvmpipe_resource(resource)->damage)
+      return;
+
+   pipe_mutex_lock(screen->damage_mutex);
+   llvmpipe_resource_damage_locked(resource, box);
+   pipe_mutex_unlock(screen->damage_mutex);
+}
+
+
+static INLINE boolean
+tile_is_damaged(const struct llvmpipe_resource *lpr, unsigned tx, unsigned ty)
+{
+   unsigned i = ty * lpr->damage_tiles_x + tx;
+   return (lpr->damage[i / 32] >> (i % 32)) & 1;
+}
+
+
+/**
+ * Convert the damage of a display target into at most max_rects
+ * rectangles, and clear it.  Runs of damaged tiles in a tile row become
+ * rectangles, which are merged with the ones of the previous row when
+ * they span the same columns.  If there are more than max_rects, the
+ * bounding box of the damage is returned instead.
+ *
+ * The caller must hold llvmpipe_screen::damage_mutex.
+ *
+ * \return number of rectangles, 0 if nothing was damaged
+ */
+unsigned
+llvmpipe_resource_take_damage(struct llvmpipe_resource *lpr,
+                              struct pipe_box *rects,
+                              unsigned max_rects)
+{
+   const int width = lpr->base.width0;
+   const int height = lpr->base.height0;
+   unsigned num_rects = 0;
+   boolean overflow = FALSE;
+   int minx = width, miny = height, maxx = 0, maxy = 0;
+   unsigned tx, ty, i;
+
+   assert(lpr->damage);
+   assert(max_rects > 0);
+
+   for (ty = 0; ty < lpr->damage_tiles_y; ty++) {
+      const int y = ty * TILE_SIZE;
+      const int h = MIN2(TILE_SIZE, height - y);
+
+      tx = 0;
+      while (tx < lpr->damage_tiles_x) {
+         int x, w;
+
+         if (!tile_is_damaged(lpr, tx, ty)) {
+            tx++;
+            continue;
+         }
+
+         x = tx * TILE_SIZE;
+         while (tx < lpr->damage_tiles_x && tile_is_damaged(lpr, tx, ty))
+            tx++;
+         w = MIN2((int) tx * TILE_SIZE, width) - x;
+
+         minx = MIN2(minx, x);
+         miny = MIN2(miny, y);
+         maxx = MAX2(maxx, x + w);
+         maxy = MAX2(maxy, y + h);
+
+         if (overflow)
+            continue;
+
+         for (i = 0; i < num_rects; i++) {
+            if (rects[i].x == x && rects[i].width == w &&
+                rects[i].y + rects[i].height == y) {
+               rects[i].height += h;
+               break;
+            }
+         }
+
+         if (i == num_rects) {
+            if (num_rects == max_rects)
+               overflow = TRUE;
+            else
+               u_box_2d(x, y, w, h, &rects[num_rects++]);
+         }
+      }
+   }
+
+   if (overflow) {
+      u_box_2d(minx, miny, maxx - minx, maxy - miny, &rects[0]);
+      num_rects = 1;
+   }
+
+   memset(lpr->damage, 0,
+          (lpr->damage_tiles_x * lpr->damage_tiles_y + 31) / 32 *
+          sizeof lpr->damage[0]);
+
+   return num_rects;
+}
+
+
 /**
  * Create buffer which wraps user-space data.
  */
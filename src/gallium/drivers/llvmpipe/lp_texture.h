@@ -80,6 +80,18 @@ struct llvmpipe_resource
     */
    void *tex_data;
 
+   /** tex_data is an anonymous mapping placed by first touch */
+   boolean first_touch;
+
+   /**
+    * Tiles written since the display target was last presented, one bit
+    * per TILE_SIZE x TILE_SIZE tile in row major order.  NULL for other
+    * resources.  Protected by llvmpipe_screen::damage_mutex.
+    */
+   uint32_t *damage;
+   unsigned damage_tiles_x;
+   unsigned damage_tiles_y;
+
    /**
     * Data for non-texture resources.
     */
@@ -127,6 +139,17 @@ llvmpipe_transfer(struct pipe_transfer *pt)
 }
 
 
+static INLINE void
+llvmpipe_resource_damage_tile(struct llvmpipe_resource *lpr,
+                              unsigned tx, unsigned ty)
+{
+   unsigned i = ty * lpr->damage_tiles_x + tx;
+   assert(tx < lpr->damage_tiles_x);
+   assert(ty < lpr->damage_tiles_y);
+   lpr->damage[i / 32] |= 1u << (i % 32);
+}
+
+
 void llvmpipe_init_screen_resource_funcs(struct pipe_screen *screen);
 void llvmpipe_init_context_resource_funcs(struct pipe_context *pipe);
 
@@ -236,4 +259,20 @@ llvmpipe_is_resource_referenced( struct pipe_context *pipe,
 unsigned
 llvmpipe_get_format_alignment(enum pipe_format format);
 
+
+void
+llvmpipe_resource_damage(struct pipe_resource *resource,
+                         const struct pipe_box *box);
+
+void
+llvmpipe_resource_damage_locked(struct pipe_resource *resource,
+                                const struct pipe_box *box);
+
+
+unsigned
+llvmpipe_resource_take_damage(struct llvmpipe_resource *lpr,
+                              struct pipe_box *rects,
+                              unsigned max_rects);
+
+
 #endif /* LP_TEXTURE_H */
@@ -0,0 +1,681 @@
+/*
+ * Copyright 2014 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tile binner: spreads quad processing over several threads.
+ * See sp_bin.h for an overview.
+ */
+
+#include "os/os_thread.h"
+#include "pipe/p_defines.h"
+#include "tgsi/tgsi_exec.h"
+#include "util/u_dynarray.h"
+#include "util/u_format.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+
+#include "sp_bin.h"
+#include "sp_context.h"
+#include "sp_fs.h"
+#include "sp_limits.h"
+#include "sp_quad.h"
+#include "sp_quad_pipe.h"
+#include "sp_state.h"
+#include "sp_tex_sample.h"
+#include "sp_tex_tile_cache.h"
+#include "sp_texture.h"
+#include "sp_tile_cache.h"
+
+
+/** Max quads per binned run (setup emits at most 8 at a time) */
+#define BIN_MAX_QUADS 16
+
+/**
+ * Below this many binned runs the workers' pipelines are run in turn on
+ * the calling thread, as waking the threads would cost more than it saves.
+ */
+#define BIN_MIN_THREADED_RUNS 64
+
+
+/**
+ * A run of quads from one primitive, all within one tile.
+ */
+struct bin_run
+{
+   unsigned coef;      /**< byte offset of the coefs in sp_binner::coefs */
+   unsigned nr;
+   struct quad_header_input input[BIN_MAX_QUADS];
+   ubyte mask[BIN_MAX_QUADS];
+};
+
+
+struct bin_worker
+{
+   struct sp_binner *binner;
+   unsigned index;
+
+   /** quad runs queued for this worker's tiles (struct bin_run) */
+   struct util_dynarray runs;
+
+   /** stages, shader machine and tile caches used by this worker */
+   struct quad_pipeline quad;
+   uint64_t occlusion_count;
+   uint64_t ps_invocations;
+
+   /** surfaces the tile caches are bound to, referenced */
+   struct pipe_surface *cbufs[PIPE_MAX_COLOR_BUFS];
+   struct pipe_surface *zsbuf;
+
+   /** fragment shader sampler, a copy of the context's one using tex_cache */
+   struct sp_tgsi_sampler sampler;
+
+   /** what the pipeline and shader machine were last prepared with */
+   unsigned quad_timestamp;
+   const struct sp_fragment_shader_variant *fs_variant;
+   struct tgsi_sampler *fs_sampler;
+   struct softpipe_tex_tile_cache *tex_cache[PIPE_MAX_SHADER_SAMPLER_VIEWS];
+
+   /** quads the runs are unpacked into */
+   struct quad_header quads[BIN_MAX_QUADS];
+   struct quad_header *quad_ptrs[BIN_MAX_QUADS];
+
+   pipe_thread thread;
+   pipe_semaphore work_ready;
+   pipe_semaphore work_done;
+};
+
+
+struct sp_binner
+{
+   struct softpipe_context *softpipe;
+
+   unsigned num_workers;
+   unsigned num_runs;
+
+   /**
+    * Coefficients of the binned primitives.  Each primitive stores
+    * posCoef followed by its fragment shader input coefs.
+    */
+   struct util_dynarray coefs;
+   unsigned coef;   /**< offset of the current primitive's coefs */
+
+   /** render every tile on the first worker (see sp_bin_set_framebuffer) */
+   boolean serial;
+
+   boolean exit_flag;
+
+   struct bin_worker workers[SP_MAX_THREADS];
+};
+
+
+/**
+ * Which worker renders tile (x, y) (in units of tiles).
+ * Neighbouring tiles go to different workers to balance the load.
+ */
+static INLINE unsigned
+tile_owner(const struct sp_binner *bin, unsigned x, unsigned y)
+{
+   if (bin->serial)
+      return 0;
+
+   return (x + y) % bin->num_workers;
+}
+
+
+static boolean
+worker_owns_tile(const void *data, unsigned x, unsigned y)
+{
+   const struct bin_worker *w = (const struct bin_worker *) data;
+
+   return tile_owner(w->binner, x, y) == w->index;
+}
+
+
+/**
+ * Point the worker's tile caches at the current framebuffer surfaces.
+ * Their old contents were flushed when the framebuffer changed.
+ */
+static void
+bind_surfaces(struct bin_worker *w)
+{
+   const struct pipe_framebuffer_state *fb = &w->binner->softpipe->framebuffer;
+   unsigned i;
+
+   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++) {
+      struct pipe_surface *cb = i < fb->nr_cbufs ? fb->cbufs[i] : NULL;
+
+      if (w->cbufs[i] != cb) {
+         pipe_surface_reference(&w->cbufs[i], cb);
+         sp_tile_cache_set_surface(w->quad.cbuf_cache[i], cb);
+      }
+   }
+
+   if (w->zsbuf != fb->zsbuf) {
+      pipe_surface_reference(&w->zsbuf, fb->zsbuf);
+      sp_tile_cache_set_surface(w->quad.zsbuf_cache, fb->zsbuf);
+   }
+}
+
+
+/**
+ * Point the worker's copy of the fragment sampler at its own texture
+ * tile caches.
+ * \return FALSE if a texture cache couldn't be allocated
+ */
+static boolean
+bind_samplers(struct bin_worker *w)
+{
+   struct softpipe_context *sp = w->binner->softpipe;
+   unsigned i;
+
+   w->sampler = *sp->tgsi.sampler[PIPE_SHADER_FRAGMENT];
+
+   for (i = 0; i < sp->num_sampler_views[PIPE_SHADER_FRAGMENT]; i++) {
+      struct softpipe_tex_tile_cache *tc = w->tex_cache[i];
+
+      if (!tc) {
+         tc = w->tex_cache[i] = sp_create_tex_tile_cache(&sp->pipe);
+         if (!tc)
+            return FALSE;
+      }
+
+      sp_tex_tile_cache_set_sampler_view(tc,
+                           sp->sampler_views[PIPE_SHADER_FRAGMENT][i]);
+
+      if (tc->texture) {
+         struct softpipe_resource *spt = softpipe_resource(tc->texture);
+         if (spt->timestamp != tc->timestamp) {
+            sp_tex_tile_cache_validate_texture(tc);
+            tc->timestamp = spt->timestamp;
+         }
+      }
+
+      w->sampler.sp_sview[i].cache = tc;
+   }
+
+   return TRUE;
+}
+
+
+/**
+ * Get the worker's pipeline ready to render with the current state.
+ * The shader is only rebound and the stages only relinked when the
+ * context did so since the worker's last batch.
+ * \return FALSE if the worker must use the context's sampler (and hence
+ *         must not run concurrently)
+ */
+static boolean
+prepare_worker(struct bin_worker *w)
+{
+   struct softpipe_context *sp = w->binner->softpipe;
+   struct tgsi_sampler *sampler = &w->sampler.base;
+   boolean new_fs;
+   boolean ok;
+
+   bind_surfaces(w);
+   w->quad.round_colors = !w->binner->serial;
+
+   ok = bind_samplers(w);
+   if (!ok)
+      sampler = &sp->tgsi.sampler[PIPE_SHADER_FRAGMENT]->base;
+
+   new_fs = w->fs_variant != sp->fs_variant;
+   if (new_fs || w->fs_sampler != sampler) {
+      sp->fs_variant->prepare(sp->fs_variant, w->quad.fs_machine, sampler);
+      w->fs_variant = sp->fs_variant;
+      w->fs_sampler = sampler;
+   }
+
+   if (new_fs || w->quad_timestamp != sp->quad_timestamp) {
+      sp_build_quad_pipeline(sp, &w->quad);
+      w->quad_timestamp = sp->quad_timestamp;
+   }
+
+   w->quad.first->begin(w->quad.first);
+
+   return ok;
+}
+
+
+/**
+ * Render the quad runs queued on a worker, in order.
+ */
+static void
+run_worker(struct bin_worker *w)
+{
+   const struct sp_binner *bin = w->binner;
+   struct quad_stage *first = w->quad.first;
+   const struct bin_run *run = util_dynarray_begin(&w->runs);
+   const struct bin_run *end = util_dynarray_end(&w->runs);
+
+   for (; run < end; run++) {
+      const struct tgsi_interp_coef *coef = (const struct tgsi_interp_coef *)
+         ((const char *) bin->coefs.data + run->coef);
+      unsigned i;
+
+      for (i = 0; i < run->nr; i++) {
+         struct quad_header *quad = &w->quads[i];
+
+         quad->input = run->input[i];
+         quad->inout.mask = run->mask[i];
+         quad->posCoef = &coef[0];
+         quad->coef = &coef[1];
+         w->quad_ptrs[i] = quad;
+      }
+
+      first->run(first, w->quad_ptrs, run->nr);
+   }
+}
+
+
+static PIPE_THREAD_ROUTINE( bin_thread_function, init_data )
+{
+   struct bin_worker *w = (struct bin_worker *) init_data;
+
+   while (1) {
+      pipe_semaphore_wait(&w->work_ready);
+
+      if (w->binner->exit_flag)
+         break;
+
+      run_worker(w);
+
+      pipe_semaphore_signal(&w->work_done);
+   }
+
+   return 0;
+}
+
+
+/**
+ * Save the coefficients of the primitive whose quads are about to be
+ * binned.
+ */
+void
+sp_bin_coefs(struct sp_binner *bin,
+             const struct tgsi_interp_coef *coef,
+             const struct tgsi_interp_coef *posCoef,
+             unsigned num_inputs)
+{
+   struct tgsi_interp_coef *dst;
+
+   bin->coef = bin->coefs.size;
+
+   dst = util_dynarray_grow(&bin->coefs,
+                            (1 + num_inputs) * sizeof(*dst));
+   dst[0] = *posCoef;
+   memcpy(&dst[1], coef, num_inputs * sizeof(*dst));
+}
+
+
+/**
+ * Queue a run of quads on the worker owning their tile.
+ */
+void
+sp_bin_quads(struct sp_binner *bin, struct quad_header *quads[], unsigned nr)
+{
+   const unsigned tx = quads[0]->input.x0 / TILE_SIZE;
+   const unsigned ty = quads[0]->input.y0 / TILE_SIZE;
+   struct bin_worker *w = &bin->workers[tile_owner(bin, tx, ty)];
+   struct bin_run *run;
+   unsigned i;
+
+   assert(nr <= BIN_MAX_QUADS);
+   assert(bin->coefs.size > bin->coef);
+
+   run = util_dynarray_grow(&w->runs, sizeof(*run));
+   run->coef = bin->coef;
+   run->nr = nr;
+
+   for (i = 0; i < nr; i++) {
+      assert(quads[i]->input.x0 / TILE_SIZE == tx);
+      assert(quads[i]->input.y0 / TILE_SIZE == ty);
+      run->input[i] = quads[i]->input;
+      run->mask[i] = quads[i]->inout.mask;
+   }
+
+   bin->num_runs++;
+}
+
+
+/**
+ * Render everything binned so far and wait for the workers to finish.
+ * Called by the vbuf backend at the end of each primitive batch, while
+ * the context state is still the one the quads were set up with.
+ */
+void
+sp_bin_render(struct sp_binner *bin)
+{
+   struct softpipe_context *sp = bin->softpipe;
+   boolean threaded = bin->num_runs >= BIN_MIN_THREADED_RUNS;
+   unsigned i;
+
+   if (!bin->num_runs)
+      return;
+
+   for (i = 0; i < bin->num_workers; i++) {
+      struct bin_worker *w = &bin->workers[i];
+
+      if (w->runs.size && !prepare_worker(w))
+         threaded = FALSE;
+   }
+
+   if (threaded) {
+      for (i = 1; i < bin->num_workers; i++) {
+         if (bin->workers[i].runs.size)
+            pipe_semaphore_signal(&bin->workers[i].work_ready);
+      }
+
+      /* the calling thread takes the first worker's tiles */
+      run_worker(&bin->workers[0]);
+
+      for (i = 1; i < bin->num_workers; i++) {
+         if (bin->workers[i].runs.size)
+            pipe_semaphore_wait(&bin->workers[i].work_done);
+      }
+   }
+   else {
+      for (i = 0; i < bin->num_workers; i++)
+         run_worker(&bin->workers[i]);
+   }
+
+   for (i = 0; i < bin->num_workers; i++) {
+      struct bin_worker *w = &bin->workers[i];
+
+      sp->occlusion_count += w->occlusion_count;
+      sp->pipeline_statistics.ps_invocations += w->ps_invocations;
+      w->occlusion_count = 0;
+      w->ps_invocations = 0;
+
+      w->runs.size = 0;
+   }
+
+   bin->coefs.size = 0;
+   bin->num_runs = 0;
+}
+
+
+/**
+ * Clear the given buffers (PIPE_CLEAR_COLOR or PIPE_CLEAR_DEPTHSTENCIL).
+ * Each worker's cache records the clear for the tiles it owns only, so
+ * every tile is written back exactly once.
+ */
+void
+sp_bin_clear(struct sp_binner *bin, unsigned buffers,
+             const union pipe_color_union *color, uint64_t clear_val)
+{
+   const struct pipe_framebuffer_state *fb = &bin->softpipe->framebuffer;
+   union pipe_color_union cbuf_color[PIPE_MAX_COLOR_BUFS];
+   unsigned i, j;
+
+   /* Cleared tiles are materialized from the float clear color, so round
+    * it like the colors the workers' blend stages write.
+    */
+   for (j = 0; j < fb->nr_cbufs; j++) {
+      cbuf_color[j] = *color;
+
+      if (fb->cbufs[j] && !bin->serial &&
+          !sp_tile_cache_format_is_exact(fb->cbufs[j]->format)) {
+         const struct util_format_description *desc =
+            util_format_description(fb->cbufs[j]->format);
+         uint8_t packed[16];
+
+         desc->pack_rgba_float(packed, 0, color->f, 0, 1, 1);
+         desc->unpack_rgba_float(cbuf_color[j].f, 0, packed, 0, 1, 1);
+      }
+   }
+
+   for (i = 0; i < bin->num_workers; i++) {
+      struct bin_worker *w = &bin->workers[i];
+
+      bind_surfaces(w);
+
+      if (buffers & PIPE_CLEAR_COLOR) {
+         for (j = 0; j < fb->nr_cbufs; j++) {
+            sp_tile_cache_clear(w->quad.cbuf_cache[j], &cbuf_color[j], 0);
+            sp_tile_cache_keep_clear(w->quad.cbuf_cache[j],
+                                     worker_owns_tile, w);
+         }
+      }
+
+      if (buffers & PIPE_CLEAR_DEPTHSTENCIL) {
+         sp_tile_cache_clear(w->quad.zsbuf_cache, color, clear_val);
+         sp_tile_cache_keep_clear(w->quad.zsbuf_cache,
+                                  worker_owns_tile, w);
+      }
+   }
+}
+
+
+/**
+ * Write back the workers' color and/or depth tile caches.
+ * \param buffers  mask of PIPE_CLEAR_COLORn and PIPE_CLEAR_DEPTHSTENCIL
+ */
+void
+sp_bin_flush_tile_caches(struct sp_binner *bin, unsigned buffers)
+{
+   unsigned i, j;
+
+   for (i = 0; i < bin->num_workers; i++) {
+      struct bin_worker *w = &bin->workers[i];
+
+      for (j = 0; j < PIPE_MAX_COLOR_BUFS; j++) {
+         if (buffers & (PIPE_CLEAR_COLOR0 << j))
+            sp_flush_tile_cache(w->quad.cbuf_cache[j]);
+      }
+
+      if (buffers & PIPE_CLEAR_DEPTHSTENCIL)
+         sp_flush_tile_cache(w->quad.zsbuf_cache);
+   }
+}
+
+
+/**
+ * Whether binned rendering to a color buffer of the given format must be
+ * serialized.  The workers round the colors they write to the format so
+ * that their output doesn't depend on when each cache evicts a tile.
+ * u_format can't round-trip 32-bit normalized channels through float, so
+ * for those the rounding never settles.  Instead the first worker renders
+ * every tile in submission order, which is what the context's own cache
+ * would do.
+ */
+static boolean
+format_needs_serial(enum pipe_format format)
+{
+   const struct util_format_description *desc = util_format_description(format);
+   unsigned i;
+
+   for (i = 0; i < desc->nr_channels; i++) {
+      if (desc->channel[i].normalized && desc->channel[i].size == 32)
+         return TRUE;
+   }
+
+   return FALSE;
+}
+
+
+/**
+ * Called before the framebuffer state changes to 'fb'.
+ */
+void
+sp_bin_set_framebuffer(struct sp_binner *bin,
+                       const struct pipe_framebuffer_state *fb)
+{
+   boolean serial = FALSE;
+   unsigned i;
+
+   for (i = 0; i < fb->nr_cbufs; i++) {
+      if (fb->cbufs[i] && format_needs_serial(fb->cbufs[i]->format))
+         serial = TRUE;
+   }
+
+   /* pending clears were split between the workers by tile ownership */
+   if (serial != bin->serial) {
+      sp_bin_flush_tile_caches(bin, PIPE_CLEAR_COLOR | PIPE_CLEAR_DEPTHSTENCIL);
+      bin->serial = serial;
+   }
+}
+
+
+/**
+ * Unbind a fragment shader variant which is about to be deleted from the
+ * workers' shader machines.
+ */
+void
+sp_bin_unbind_fs_variant(struct sp_binner *bin,
+                         const struct sp_fragment_shader_variant *var)
+{
+   unsigned i;
+
+   for (i = 0; i < bin->num_workers; i++) {
+      struct bin_worker *w = &bin->workers[i];
+
+      if (w->fs_variant == var) {
+         tgsi_exec_machine_bind_shader(w->quad.fs_machine, NULL, NULL);
+         w->fs_variant = NULL;
+      }
+   }
+}
+
+
+void
+sp_bin_flush_texture_caches(struct sp_binner *bin)
+{
+   unsigned i, j;
+
+   for (i = 0; i < bin->num_workers; i++) {
+      for (j = 0; j < PIPE_MAX_SHADER_SAMPLER_VIEWS; j++) {
+         if (bin->workers[i].tex_cache[j])
+            sp_flush_tex_tile_cache(bin->workers[i].tex_cache[j]);
+      }
+   }
+}
+
+
+/**
+ * Create a binner with num_threads workers.  The calling thread acts as
+ * the first worker, so num_threads - 1 threads are started.
+ */
+struct sp_binner *
+sp_create_binner(struct softpipe_context *softpipe, unsigned num_threads)
+{
+   struct sp_binner *bin = CALLOC_STRUCT(sp_binner);
+   unsigned i, j;
+
+   if (!bin)
+      return NULL;
+
+   assert(num_threads > 1 && num_threads <= SP_MAX_THREADS);
+
+   bin->softpipe = softpipe;
+   util_dynarray_init(&bin->coefs);
+
+   for (i = 0; i < num_threads; i++) {
+      struct bin_worker *w = &bin->workers[i];
+
+      w->binner = bin;
+      w->index = i;
+      util_dynarray_init(&w->runs);
+      pipe_semaphore_init(&w->work_ready, 0);
+      pipe_semaphore_init(&w->work_done, 0);
+      /* count the workers as we go so destruction cleans up partial ones */
+      bin->num_workers = i + 1;
+
+      if (!sp_init_quad_pipeline(softpipe, &w->quad))
+         goto fail;
+
+      w->quad.fs_machine = tgsi_exec_machine_create();
+      if (!w->quad.fs_machine)
+         goto fail;
+
+      for (j = 0; j < PIPE_MAX_COLOR_BUFS; j++) {
+         w->quad.cbuf_cache[j] = sp_create_tile_cache(&softpipe->pipe);
+         if (!w->quad.cbuf_cache[j])
+            goto fail;
+      }
+      w->quad.zsbuf_cache = sp_create_tile_cache(&softpipe->pipe);
+      if (!w->quad.zsbuf_cache)
+         goto fail;
+
+      w->quad.occlusion_count = &w->occlusion_count;
+      w->quad.ps_invocations = &w->ps_invocations;
+
+      if (i > 0) {
+         w->thread = pipe_thread_create(bin_thread_function, w);
+         if (!w->thread)
+            goto fail;
+      }
+   }
+
+   return bin;
+
+fail:
+   sp_destroy_binner(bin);
+   return NULL;
+}
+
+
+void
+sp_destroy_binner(struct sp_binner *bin)
+{
+   unsigned i, j;
+
+   /* tell the threads to exit and wait for them */
+   bin->exit_flag = TRUE;
+   for (i = 1; i < bin->num_workers; i++) {
+      if (bin->workers[i].thread) {
+         pipe_semaphore_signal(&bin->workers[i].work_ready);
+         pipe_thread_wait(bin->workers[i].thread);
+      }
+   }
+
+   for (i = 0; i < bin->num_workers; i++) {
+      struct bin_worker *w = &bin->workers[i];
+
+      sp_destroy_quad_pipeline(&w->quad);
+
+      if (w->quad.fs_machine)
+         tgsi_exec_machine_destroy(w->quad.fs_machine);
+
+      for (j = 0; j < PIPE_MAX_COLOR_BUFS; j++) {
+         sp_destroy_tile_cache(w->quad.cbuf_cache[j]);
+         pipe_surface_reference(&w->cbufs[j], NULL);
+      }
+      sp_destroy_tile_cache(w->quad.zsbuf_cache);
+      pipe_surface_reference(&w->zsbuf, NULL);
+
+      for (j = 0; j < PIPE_MAX_SHADER_SAMPLER_VIEWS; j++) {
+         if (w->tex_cache[j]) {
+            /* drop the texture reference */
+            sp_tex_tile_cache_set_sampler_view(w->tex_cache[j], NULL);
+            sp_destroy_tex_tile_cache(w->tex_cache[j]);
+         }
+      }
+
+      util_dynarray_fini(&w->runs);
+      pipe_semaphore_destroy(&w->work_ready);
+      pipe_semaphore_destroy(&w->work_done);
+   }
+
+   util_dynarray_fini(&bin->coefs);
+   FREE(bin);
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2014 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tile binner for threaded fragment processing.
+ *
+ * The screen is divided into cache tiles (TILE_SIZE x TILE_SIZE) and each
+ * tile is owned by one worker.  Setup hands the binner runs of quads which
+ * never straddle a tile; they're queued on the owner of their tile and
+ * rendered when the vbuf backend has finished a batch of primitives.
+ * Every worker has its own quad pipeline, color/depth tile caches and
+ * texture tile caches, so the workers never touch the same memory and a
+ * tile sees its quads in submission order.
+ */
+
+#ifndef SP_BIN_H
+#define SP_BIN_H
+
+#include "pipe/p_compiler.h"
+
+
+struct softpipe_context;
+struct quad_header;
+struct tgsi_interp_coef;
+union pipe_color_union;
+struct sp_binner;
+struct sp_fragment_shader_variant;
+struct pipe_framebuffer_state;
+
+
+struct sp_binner *
+sp_create_binner(struct softpipe_context *softpipe, unsigned num_threads);
+
+void
+sp_destroy_binner(struct sp_binner *bin);
+
+void
+sp_bin_coefs(struct sp_binner *bin,
+             const struct tgsi_interp_coef *coef,
+             const struct tgsi_interp_coef *posCoef,
+             unsigned num_inputs);
+
+void
+sp_bin_quads(struct sp_binner *bin, struct quad_header *quads[], unsigned nr);
+
+void
+sp_bin_render(struct sp_binner *bin);
+
+void
+sp_bin_clear(struct sp_binner *bin, unsigned buffers,
+             const union pipe_color_union *color, uint64_t clear_val);
+
+void
+sp_bin_flush_tile_caches(struct sp_binner *bin, unsigned buffers);
+
+void
+sp_bin_flush_texture_caches(struct sp_binner *bin);
+
+void
+sp_bin_set_framebuffer(struct sp_binner *bin,
+                       const struct pipe_framebuffer_state *fb);
+
+void
+sp_bin_unbind_fs_variant(struct sp_binner *bin,
+                         const struct sp_fragment_shader_variant *var);
+
+
+#endif /* SP_BIN_H */
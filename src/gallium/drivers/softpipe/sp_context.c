@@ -38,6 +38,7 @@
 #include "util/u_pstipple.h"
 #include "util/u_inlines.h"
 #include "tgsi/tgsi_exec.h"
+#include "sp_bin.h"
 #include "sp_clear.h"
 #include "sp_context.h"
 #include "sp_flush.h"
@@ -73,17 +74,10 @@ softpipe_destroy( struct pipe_context *pipe )
    if (softpipe->draw)
       draw_destroy( softpipe->draw );
 
-   if (softpipe->quad.shade)
-      softpipe->quad.shade->destroy( softpipe->quad.shade );
+   if (softpipe->binner)
+      sp_destroy_binner(softpipe->binner);
 
-   if (softpipe->quad.depth_test)
-      softpipe->quad.depth_test->destroy( softpipe->quad.depth_test );
-
-   if (softpipe->quad.blend)
-      softpipe->quad.blend->destroy( softpipe->quad.blend );
-
-   if (softpipe->quad.pstipple)
-      softpipe->quad.pstipple->destroy( softpipe->quad.pstipple );
+   sp_destroy_quad_pipeline(&softpipe->quad);
 
    for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++) {
       sp_destroy_tile_cache(softpipe->cbuf_cache[i]);
@@ -192,6 +186,7 @@ softpipe_create_context( struct pipe_screen *screen,
    struct softpipe_screen *sp_screen = softpipe_screen(screen);
    struct softpipe_context *softpipe = CALLOC_STRUCT(softpipe_context);
    uint i, sh;
+   long num_threads;
 
    util_init_math();
 
@@ -246,10 +241,25 @@ softpipe_create_context( struct pipe_screen *screen,
    softpipe->fs_machine = tgsi_exec_machine_create();
 
    /* setup quad rendering stages */
-   softpipe->quad.shade = sp_quad_shade_stage(softpipe);
-   softpipe->quad.depth_test = sp_quad_depth_test_stage(softpipe);
-   softpipe->quad.blend = sp_quad_blend_stage(softpipe);
-   softpipe->quad.pstipple = sp_quad_polygon_stipple_stage(softpipe);
+   if (!sp_init_quad_pipeline(softpipe, &softpipe->quad))
+      goto fail;
+
+   softpipe->quad.fs_machine = softpipe->fs_machine;
+   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++)
+      softpipe->quad.cbuf_cache[i] = softpipe->cbuf_cache[i];
+   softpipe->quad.zsbuf_cache = softpipe->zsbuf_cache;
+   softpipe->quad.occlusion_count = &softpipe->occlusion_count;
+   softpipe->quad.ps_invocations =
+      &softpipe->pipeline_statistics.ps_invocations;
+
+   /* optionally spread fragment processing over several threads */
+   num_threads = debug_get_num_option("SOFTPIPE_NUM_THREADS", 0);
+   if (num_threads > 1) {
+      softpipe->binner = sp_create_binner(softpipe,
+                                          MIN2(num_threads, SP_MAX_THREADS));
+      if (!softpipe->binner)
+         goto fail;
+   }
 
 
    /*
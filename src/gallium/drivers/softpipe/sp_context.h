@@ -55,6 +55,7 @@ struct sp_fragment_shader;
 struct sp_vertex_shader;
 struct sp_velems_state;
 struct sp_so_state;
+struct sp_binner;
 
 struct softpipe_context {
    struct pipe_context pipe;  /**< base class */
@@ -157,13 +158,11 @@ struct softpipe_context {
    } pstipple;
 
    /** Software quad rendering pipeline */
-   struct {
-      struct quad_stage *shade;
-      struct quad_stage *depth_test;
-      struct quad_stage *blend;
-      struct quad_stage *pstipple;
-      struct quad_stage *first; /**< points to one of the above stages */
-   } quad;
+   struct quad_pipeline quad;
+   unsigned quad_timestamp;  /**< bumped whenever 'quad' is rebuilt */
+
+   /** Tile binner for threaded rendering, NULL if disabled */
+   struct sp_binner *binner;
 
    /** TGSI exec things */
    struct {
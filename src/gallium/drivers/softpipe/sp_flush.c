@@ -34,6 +34,7 @@
 #include "pipe/p_screen.h"
 #include "draw/draw_context.h"
 #include "sp_flush.h"
+#include "sp_bin.h"
 #include "sp_context.h"
 #include "sp_state.h"
 #include "sp_tile_cache.h"
@@ -60,6 +61,9 @@ softpipe_flush( struct pipe_context *pipe,
             sp_flush_tex_tile_cache(softpipe->tex_cache[sh][i]);
          }
       }
+
+      if (softpipe->binner)
+         sp_bin_flush_texture_caches(softpipe->binner);
    }
 
    /* If this is a swapbuffers, just flush color buffers.
@@ -74,6 +78,10 @@ softpipe_flush( struct pipe_context *pipe,
    if (softpipe->zsbuf_cache)
       sp_flush_tile_cache(softpipe->zsbuf_cache);
 
+   if (softpipe->binner)
+      sp_bin_flush_tile_caches(softpipe->binner,
+                               PIPE_CLEAR_COLOR | PIPE_CLEAR_DEPTHSTENCIL);
+
    softpipe->dirty_render_cache = FALSE;
 
    /* Enable to dump BMPs of the color/depth buffers each frame */
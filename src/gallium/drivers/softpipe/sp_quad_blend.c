@@ -59,6 +59,8 @@ struct blend_quad_stage
    boolean clamp[PIPE_MAX_COLOR_BUFS];  /**< clamp colors to [0,1]? */
    enum format base_format[PIPE_MAX_COLOR_BUFS];
    enum util_format_type format_type[PIPE_MAX_COLOR_BUFS];
+   /** format to round written colors to, or NULL if it is exact */
+   const struct util_format_description *round[PIPE_MAX_COLOR_BUFS];
 };
 
 
@@ -914,6 +916,37 @@ rebase_colors(enum format base_format, float (*quadColor)[4])
    }
 }
 
+/**
+ * Round the quad colors to what the color buffer can hold.  The tile
+ * cache stores floats, but a tile that is evicted and fetched again only
+ * holds what the surface format kept.  The binner's workers each evict at
+ * their own pace, so their pipelines round every write to make blending
+ * read back the same values whether or not the tile stayed cached.
+ */
+static void
+round_colors(const struct util_format_description *desc,
+             float (*quadColor)[4])
+{
+   float rgba[TGSI_QUAD_SIZE][4];
+   uint8_t packed[TGSI_QUAD_SIZE * 16];
+   unsigned i, j;
+
+   for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+      for (i = 0; i < 4; i++) {
+         rgba[j][i] = quadColor[i][j];
+      }
+   }
+
+   desc->pack_rgba_float(packed, 0, &rgba[0][0], 0, TGSI_QUAD_SIZE, 1);
+   desc->unpack_rgba_float(&rgba[0][0], 0, packed, 0, TGSI_QUAD_SIZE, 1);
+
+   for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+      for (i = 0; i < 4; i++) {
+         quadColor[i][j] = rgba[j][i];
+      }
+   }
+}
+
 static void
 blend_fallback(struct quad_stage *qs, 
                struct quad_header *quads[],
@@ -933,7 +966,7 @@ blend_fallback(struct quad_stage *qs,
          const uint blend_buf = blend->independent_blend_enable ? cbuf : 0;
          float dest[4][TGSI_QUAD_SIZE];
          struct softpipe_cached_tile *tile
-            = sp_get_cached_tile(softpipe->cbuf_cache[cbuf],
+            = sp_get_cached_tile(qs->pipeline->cbuf_cache[cbuf],
                                  quads[0]->input.x0, 
                                  quads[0]->input.y0, quads[0]->input.layer);
          const boolean clamp = bqs->clamp[cbuf];
@@ -1006,6 +1039,9 @@ blend_fallback(struct quad_stage *qs,
             if (blend->rt[blend_buf].colormask != 0xf)
                colormask_quad( blend->rt[cbuf].colormask, quadColor, dest);
 
+            if (bqs->round[cbuf])
+               round_colors(bqs->round[cbuf], quadColor);
+
             /* Output color values
              */
             for (j = 0; j < TGSI_QUAD_SIZE; j++) {
@@ -1036,7 +1072,7 @@ blend_single_add_src_alpha_inv_src_alpha(struct quad_stage *qs,
    uint i, j, q;
 
    struct softpipe_cached_tile *tile
-      = sp_get_cached_tile(qs->softpipe->cbuf_cache[0],
+      = sp_get_cached_tile(qs->pipeline->cbuf_cache[0],
                            quads[0]->input.x0, 
                            quads[0]->input.y0, quads[0]->input.layer);
 
@@ -1088,6 +1124,9 @@ blend_single_add_src_alpha_inv_src_alpha(struct quad_stage *qs,
 
       rebase_colors(bqs->base_format[0], quadColor);
 
+      if (bqs->round[0])
+         round_colors(bqs->round[0], quadColor);
+
       for (j = 0; j < TGSI_QUAD_SIZE; j++) {
          if (quad->inout.mask & (1 << j)) {
             int x = itx + (j & 1);
@@ -1110,7 +1149,7 @@ blend_single_add_one_one(struct quad_stage *qs,
    uint i, j, q;
 
    struct softpipe_cached_tile *tile
-      = sp_get_cached_tile(qs->softpipe->cbuf_cache[0],
+      = sp_get_cached_tile(qs->pipeline->cbuf_cache[0],
                            quads[0]->input.x0, 
                            quads[0]->input.y0, quads[0]->input.layer);
 
@@ -1150,6 +1189,9 @@ blend_single_add_one_one(struct quad_stage *qs,
 
       rebase_colors(bqs->base_format[0], quadColor);
 
+      if (bqs->round[0])
+         round_colors(bqs->round[0], quadColor);
+
       for (j = 0; j < TGSI_QUAD_SIZE; j++) {
          if (quad->inout.mask & (1 << j)) {
             int x = itx + (j & 1);
@@ -1178,7 +1220,7 @@ single_output_color(struct quad_stage *qs,
    uint i, j, q;
 
    struct softpipe_cached_tile *tile
-      = sp_get_cached_tile(qs->softpipe->cbuf_cache[0],
+      = sp_get_cached_tile(qs->pipeline->cbuf_cache[0],
                            quads[0]->input.x0, 
                            quads[0]->input.y0, quads[0]->input.layer);
 
@@ -1193,6 +1235,9 @@ single_output_color(struct quad_stage *qs,
 
       rebase_colors(bqs->base_format[0], quadColor);
 
+      if (bqs->round[0])
+         round_colors(bqs->round[0], quadColor);
+
       for (j = 0; j < TGSI_QUAD_SIZE; j++) {
          if (quad->inout.mask & (1 << j)) {
             int x = itx + (j & 1);
@@ -1277,6 +1322,12 @@ choose_blend_quad(struct quad_stage *qs,
             bqs->base_format[i] = RGB;
          else
             bqs->base_format[i] = RGBA;
+
+         if (qs->pipeline->round_colors &&
+             !sp_tile_cache_format_is_exact(format))
+            bqs->round[i] = desc;
+         else
+            bqs->round[i] = NULL;
       }
    }
 
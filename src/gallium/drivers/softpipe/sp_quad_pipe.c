@@ -32,15 +32,56 @@
 
 
 static void
-insert_stage_at_head(struct softpipe_context *sp, struct quad_stage *quad)
+insert_stage_at_head(struct quad_pipeline *qp, struct quad_stage *quad)
 {
-   quad->next = sp->quad.first;
-   sp->quad.first = quad;
+   quad->next = qp->first;
+   qp->first = quad;
+}
+
+
+/**
+ * Create the stages of a quad pipeline.  The caller fills in the machine,
+ * tile caches and counters the stages will use.
+ */
+boolean
+sp_init_quad_pipeline(struct softpipe_context *sp, struct quad_pipeline *qp)
+{
+   qp->shade = sp_quad_shade_stage(sp);
+   qp->depth_test = sp_quad_depth_test_stage(sp);
+   qp->blend = sp_quad_blend_stage(sp);
+   qp->pstipple = sp_quad_polygon_stipple_stage(sp);
+
+   if (!qp->shade || !qp->depth_test || !qp->blend || !qp->pstipple)
+      return FALSE;
+
+   qp->shade->pipeline = qp;
+   qp->depth_test->pipeline = qp;
+   qp->blend->pipeline = qp;
+   qp->pstipple->pipeline = qp;
+
+   return TRUE;
+}
+
+
+void
+sp_destroy_quad_pipeline(struct quad_pipeline *qp)
+{
+   if (qp->shade)
+      qp->shade->destroy( qp->shade );
+
+   if (qp->depth_test)
+      qp->depth_test->destroy( qp->depth_test );
+
+   if (qp->blend)
+      qp->blend->destroy( qp->blend );
+
+   if (qp->pstipple)
+      qp->pstipple->destroy( qp->pstipple );
 }
 
 
 void
-sp_build_quad_pipeline(struct softpipe_context *sp)
+sp_build_quad_pipeline(struct softpipe_context *sp, struct quad_pipeline *qp)
 {
    boolean early_depth_test =
       sp->depth_stencil->depth.enabled &&
@@ -50,20 +91,19 @@ sp_build_quad_pipeline(struct softpipe_context *sp)
       !sp->fs_variant->info.writes_z &&
       !sp->fs_variant->info.writes_stencil;
 
-   sp->quad.first = sp->quad.blend;
+   qp->first = qp->blend;
 
    if (early_depth_test) {
-      insert_stage_at_head( sp, sp->quad.shade );
-      insert_stage_at_head( sp, sp->quad.depth_test );
+      insert_stage_at_head( qp, qp->shade );
+      insert_stage_at_head( qp, qp->depth_test );
    }
    else {
-      insert_stage_at_head( sp, sp->quad.depth_test );
-      insert_stage_at_head( sp, sp->quad.shade );
+      insert_stage_at_head( qp, qp->depth_test );
+      insert_stage_at_head( qp, qp->shade );
    }
 
 #if !DO_PSTIPPLE_IN_DRAW_MODULE && !DO_PSTIPPLE_IN_HELPER_MODULE
    if (sp->rasterizer->poly_stipple_enable)
-      insert_stage_at_head( sp, sp->quad.pstipple );
+      insert_stage_at_head( qp, qp->pstipple );
 #endif
 }
-
@@ -31,9 +31,14 @@
 #ifndef SP_QUAD_PIPE_H
 #define SP_QUAD_PIPE_H
 
+#include "pipe/p_state.h"
+
 
 struct softpipe_context;
+struct softpipe_tile_cache;
+struct tgsi_exec_machine;
 struct quad_header;
+struct quad_pipeline;
 
 
 /**
@@ -43,6 +48,7 @@ struct quad_header;
  */
 struct quad_stage {
    struct softpipe_context *softpipe;
+   struct quad_pipeline *pipeline;  /**< the pipeline this stage belongs to */
 
    struct quad_stage *next;
 
@@ -55,6 +61,30 @@ struct quad_stage {
 };
 
 
+/**
+ * A set of quad stages plus the shader machine, tile caches and counters
+ * they write to.  The context has one; with threaded rendering every
+ * binner worker (see sp_bin.c) has another.
+ */
+struct quad_pipeline {
+   struct quad_stage *shade;
+   struct quad_stage *depth_test;
+   struct quad_stage *blend;
+   struct quad_stage *pstipple;
+   struct quad_stage *first; /**< points to one of the above stages */
+
+   struct tgsi_exec_machine *fs_machine;
+   struct softpipe_tile_cache *cbuf_cache[PIPE_MAX_COLOR_BUFS];
+   struct softpipe_tile_cache *zsbuf_cache;
+
+   uint64_t *occlusion_count;
+   uint64_t *ps_invocations;
+
+   /** round written colors to the color buffer format (binned rendering) */
+   boolean round_colors;
+};
+
+
 struct quad_stage *sp_quad_polygon_stipple_stage( struct softpipe_context *softpipe );
 struct quad_stage *sp_quad_earlyz_stage( struct softpipe_context *softpipe );
 struct quad_stage *sp_quad_shade_stage( struct softpipe_context *softpipe );
@@ -67,6 +97,10 @@ struct quad_stage *sp_quad_blend_stage( struct softpipe_context *softpipe );
 struct quad_stage *sp_quad_colormask_stage( struct softpipe_context *softpipe );
 struct quad_stage *sp_quad_output_stage( struct softpipe_context *softpipe );
 
-void sp_build_quad_pipeline(struct softpipe_context *sp);
+boolean sp_init_quad_pipeline(struct softpipe_context *sp,
+                              struct quad_pipeline *qp);
+void sp_destroy_quad_pipeline(struct quad_pipeline *qp);
+void sp_build_quad_pipeline(struct softpipe_context *sp,
+                            struct quad_pipeline *qp);
 
 #endif /* SP_QUAD_PIPE_H */
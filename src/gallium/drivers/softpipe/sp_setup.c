@@ -32,6 +32,7 @@
  * \author  Brian Paul
  */
 
+#include "sp_bin.h"
 #include "sp_context.h"
 #include "sp_quad.h"
 #include "sp_quad_pipe.h"
@@ -100,6 +101,7 @@ struct setup_context {
 
    struct tgsi_interp_coef coef[PIPE_MAX_SHADER_INPUTS];
    struct tgsi_interp_coef posCoef;  /* For Z, W */
+   boolean coef_binned;  /**< coefs already copied to the binner? */
 
    struct {
       int left[2];   /**< [0] = row0, [1] = row1 */
@@ -153,6 +155,30 @@ quad_clip(struct setup_context *setup, struct quad_header *quad)
 }
 
 
+/**
+ * Pass a run of quads to the quad pipeline, or to the binner when
+ * fragment processing is threaded.
+ */
+static INLINE void
+emit_quads(struct setup_context *setup,
+           struct quad_header *quads[], unsigned nr)
+{
+   struct softpipe_context *sp = setup->softpipe;
+
+   if (sp->binner) {
+      if (!setup->coef_binned) {
+         sp_bin_coefs(sp->binner, setup->coef, &setup->posCoef,
+                      sp->fs_variant->info.num_inputs);
+         setup->coef_binned = TRUE;
+      }
+      sp_bin_quads(sp->binner, quads, nr);
+   }
+   else {
+      sp->quad.first->run( sp->quad.first, quads, nr );
+   }
+}
+
+
 /**
  * Emit a quad (pass to next stage) with clipping.
  */
@@ -162,13 +188,11 @@ clip_emit_quad(struct setup_context *setup, struct quad_header *quad)
    quad_clip( setup, quad );
 
    if (quad->inout.mask) {
-      struct softpipe_context *sp = setup->softpipe;
-
 #if DEBUG_FRAGS
       setup->numFragsEmitted += util_bitcount(quad->inout.mask);
 #endif
 
-      sp->quad.first->run( sp->quad.first, &quad, 1 );
+      emit_quads( setup, &quad, 1 );
    }
 }
 
@@ -203,7 +227,6 @@ flush_spans(struct setup_context *setup)
    const int xleft1 = setup->span.left[1];
    const int xright0 = setup->span.right[0];
    const int xright1 = setup->span.right[1];
-   struct quad_stage *pipe = setup->softpipe->quad.first;
 
    const int minleft = block_x(MIN2(xleft0, xleft1));
    const int maxright = MAX2(xright0, xright1);
@@ -248,7 +271,7 @@ flush_spans(struct setup_context *setup)
             lx += 2;
          } while (mask0 | mask1);
 
-         pipe->run( pipe, setup->quad_ptrs, q );
+         emit_quads( setup, setup->quad_ptrs, q );
       }
    }
 
@@ -598,6 +621,8 @@ setup_tri_coefficients(struct setup_context *setup)
    uint fragSlot;
    float v[3];
 
+   setup->coef_binned = FALSE;
+
    /* z and w are done by linear interpolation:
     */
    v[0] = setup->vmin[0][2];
@@ -958,6 +983,8 @@ setup_line_coefficients(struct setup_context *setup,
    float area;
    float v[2];
 
+   setup->coef_binned = FALSE;
+
    /* use setup->vmin, vmax to point to vertices */
    if (softpipe->rasterizer->flatshade_first)
       setup->vprovoke = v0;
@@ -1252,6 +1279,7 @@ sp_setup_point(struct setup_context *setup,
     * probably should be ruled out on that basis.
     */
    setup->vprovoke = v0;
+   setup->coef_binned = FALSE;
 
    /* setup Z, W */
    const_coeff(setup, &setup->posCoef, 0, 2);
@@ -1444,6 +1472,7 @@ sp_setup_prepare(struct setup_context *setup)
    }
 
    setup->max_layer = max_layer;
+   setup->coef_binned = FALSE;
 
    sp->quad.first->begin( sp->quad.first );
 
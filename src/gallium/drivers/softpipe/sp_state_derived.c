@@ -402,8 +402,10 @@ softpipe_update_derived(struct softpipe_context *softpipe, unsigned prim)
    if (softpipe->dirty & (SP_NEW_BLEND |
                           SP_NEW_DEPTH_STENCIL_ALPHA |
                           SP_NEW_FRAMEBUFFER |
-                          SP_NEW_FS))
-      sp_build_quad_pipeline(softpipe);
+                          SP_NEW_FS)) {
+      sp_build_quad_pipeline(softpipe, &softpipe->quad);
+      softpipe->quad_timestamp++;
+   }
 
    softpipe->dirty = 0;
 }
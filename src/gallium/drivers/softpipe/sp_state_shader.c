@@ -25,6 +25,7 @@
  * 
  **************************************************************************/
 
+#include "sp_bin.h"
 #include "sp_context.h"
 #include "sp_state.h"
 #include "sp_fs.h"
@@ -192,6 +193,9 @@ softpipe_delete_fs_state(struct pipe_context *pipe, void *fs)
       draw_delete_fragment_shader(softpipe->draw, var->draw_shader);
 #endif
 
+      if (softpipe->binner)
+         sp_bin_unbind_fs_variant(softpipe->binner, var);
+
       var->delete(var, softpipe->fs_machine);
    }
 
@@ -28,6 +28,7 @@
 /* Authors:  Keith Whitwell <keithw@vmware.com>
  */
 
+#include "sp_bin.h"
 #include "sp_context.h"
 #include "sp_state.h"
 #include "sp_tile_cache.h"
@@ -53,6 +54,9 @@ softpipe_set_framebuffer_state(struct pipe_context *pipe,
 
    draw_flush(sp->draw);
 
+   if (sp->binner)
+      sp_bin_set_framebuffer(sp->binner, fb);
+
    for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++) {
       struct pipe_surface *cb = i < fb->nr_cbufs ? fb->cbufs[i] : NULL;
 
@@ -60,6 +64,8 @@ softpipe_set_framebuffer_state(struct pipe_context *pipe,
       if (sp->framebuffer.cbufs[i] != cb) {
          /* flush old */
          sp_flush_tile_cache(sp->cbuf_cache[i]);
+         if (sp->binner)
+            sp_bin_flush_tile_caches(sp->binner, PIPE_CLEAR_COLOR0 << i);
 
          /* assign new */
          pipe_surface_reference(&sp->framebuffer.cbufs[i], cb);
@@ -75,6 +81,8 @@ softpipe_set_framebuffer_state(struct pipe_context *pipe,
    if (sp->framebuffer.zsbuf != fb->zsbuf) {
       /* flush old */
       sp_flush_tile_cache(sp->zsbuf_cache);
+      if (sp->binner)
+         sp_bin_flush_tile_caches(sp->binner, PIPE_CLEAR_DEPTHSTENCIL);
 
       /* assign new */
       pipe_surface_reference(&sp->framebuffer.zsbuf, fb->zsbuf);
@@ -626,6 +626,63 @@ sp_find_cached_tile(struct softpipe_tile_cache *tc,
 
 
 
+/**
+ * Forget the pending clear of every tile for which owns_tile() returns
+ * FALSE.  This is used to split a clear between several caches of the
+ * same surface which each render a disjoint set of tiles.
+ */
+void
+sp_tile_cache_keep_clear(struct softpipe_tile_cache *tc,
+                         boolean (*owns_tile)(const void *data,
+                                              unsigned x, unsigned y),
+                         const void *data)
+{
+   int layer;
+   uint x, y;
+
+   for (layer = 0; layer < tc->num_maps; layer++) {
+      const uint w = tc->transfer[layer]->box.width;
+      const uint h = tc->transfer[layer]->box.height;
+
+      for (y = 0; y < h; y += TILE_SIZE) {
+         for (x = 0; x < w; x += TILE_SIZE) {
+            if (!owns_tile(data, x / TILE_SIZE, y / TILE_SIZE)) {
+               clear_clear_flag(tc->clear_flags, tile_address(x, y, layer),
+                                tc->clear_flags_size);
+            }
+         }
+      }
+   }
+}
+
+
+/**
+ * Return TRUE if the cached float colors of a color surface in the given
+ * format survive being written back and fetched again.  Otherwise what
+ * blending reads back depends on whether the tile was evicted meanwhile.
+ */
+boolean
+sp_tile_cache_format_is_exact(enum pipe_format format)
+{
+   const struct util_format_description *desc = util_format_description(format);
+   unsigned i;
+
+   if (util_format_is_pure_integer(format))
+      return TRUE;
+
+   if (desc->nr_channels != 4)
+      return FALSE;
+
+   for (i = 0; i < 4; i++) {
+      if (desc->channel[i].type != UTIL_FORMAT_TYPE_FLOAT ||
+          desc->channel[i].size != 32)
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+
 /**
  * When a whole surface is being cleared to a value we can avoid
  * fetching tiles above.
@@ -123,6 +123,15 @@ sp_tile_cache_clear(struct softpipe_tile_cache *tc,
                     const union pipe_color_union *color,
                     uint64_t clearValue);
 
+extern void
+sp_tile_cache_keep_clear(struct softpipe_tile_cache *tc,
+                         boolean (*owns_tile)(const void *data,
+                                              unsigned x, unsigned y),
+                         const void *data);
+
+extern boolean
+sp_tile_cache_format_is_exact(enum pipe_format format);
+
 extern struct softpipe_cached_tile *
 sp_find_cached_tile(struct softpipe_tile_cache *tc, 
                     union tile_address addr );
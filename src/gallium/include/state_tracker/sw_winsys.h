@@ -132,6 +132,20 @@ struct sw_winsys
                              void *context_private,
                              struct pipe_box *box );
 
+   /**
+    * Like displaytarget_display, but only update the given rectangles of
+    * the drawable, e.g. the parts of the display target that changed
+    * since it was last displayed.
+    *
+    * Optional, may be NULL.
+    */
+   void
+   (*displaytarget_display_rects)( struct sw_winsys *ws,
+                                   struct sw_displaytarget *dt,
+                                   void *context_private,
+                                   const struct pipe_box *rects,
+                                   unsigned num_rects );
+
    void 
    (*displaytarget_destroy)( struct sw_winsys *ws, 
                              struct sw_displaytarget *dt );
@@ -360,6 +360,10 @@ drisw_init_screen(__DRIscreen * sPriv)
    sPriv->driverPrivate = (void *)screen;
    sPriv->extensions = drisw_screen_extensions;
 
+   /* putImage2 is only available since version 2 of the loader */
+   drisw_lf.put_image2 = sPriv->swrast_loader->base.version >= 2 ?
+                         drisw_put_image2 : NULL;
+
    pscreen = drisw_create_screen(&drisw_lf);
    /* dri_init_screen_helper checks pscreen for us */
 
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2014 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+ * Test case for cso_hash, and a micro-benchmark of state changes going
+ * through cso_context.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "cso_cache/cso_context.h"
+#include "cso_cache/cso_hash.h"
+#include "os/os_time.h"
+#include "util/u_memory.h"
+#include "softpipe/sp_public.h"
+#include "sw/null/null_sw_winsys.h"
+
+
+#define NUM_VALUES 5000
+#define NUM_KEYS 700
+
+#define NUM_STATES 64
+#define NUM_ITERATIONS 200000
+
+
+static int
+test_hash(void)
+{
+   struct cso_hash *hash = cso_hash_create();
+   struct cso_hash_iter iter;
+   static unsigned values[NUM_VALUES];
+   static unsigned seen[NUM_VALUES];
+   unsigned i, count, erased;
+
+   for (i = 0; i < NUM_VALUES; i++) {
+      values[i] = i;
+      iter = cso_hash_insert(hash, i % NUM_KEYS, &values[i]);
+      if (cso_hash_iter_data(iter) != &values[i])
+         return 1;
+   }
+   if (cso_hash_size(hash) != NUM_VALUES)
+      return 1;
+
+   /* Iterators from find must visit exactly the entries with that key. */
+   memset(seen, 0, sizeof seen);
+   for (i = 0; i < NUM_KEYS; i++) {
+      count = 0;
+      iter = cso_hash_find(hash, i);
+      while (!cso_hash_iter_is_null(iter)) {
+         unsigned *v = (unsigned *)cso_hash_iter_data(iter);
+         if (cso_hash_iter_key(iter) != i || *v % NUM_KEYS != i)
+            return 1;
+         seen[*v]++;
+         count++;
+         iter = cso_hash_iter_next(iter);
+      }
+      if (count != (NUM_VALUES - i + NUM_KEYS - 1) / NUM_KEYS)
+         return 1;
+   }
+   for (i = 0; i < NUM_VALUES; i++) {
+      if (seen[i] != 1)
+         return 1;
+   }
+
+   if (!cso_hash_iter_is_null(cso_hash_find(hash, NUM_KEYS)))
+      return 1;
+
+   /* Erase odd values while walking the whole table. */
+   erased = 0;
+   count = 0;
+   iter = cso_hash_first_node(hash);
+   while (!cso_hash_iter_is_null(iter)) {
+      unsigned *v = (unsigned *)cso_hash_iter_data(iter);
+      count++;
+      if (*v & 1) {
+         iter = cso_hash_erase(hash, iter);
+         erased++;
+      }
+      else
+         iter = cso_hash_iter_next(iter);
+   }
+   if (count != NUM_VALUES || cso_hash_size(hash) != NUM_VALUES - erased)
+      return 1;
+
+   /* Take everything else out, letting the table shrink. */
+   for (i = 0; i < NUM_VALUES; i += 2) {
+      unsigned *v = (unsigned *)cso_hash_take(hash, i % NUM_KEYS);
+      if (!v || *v % NUM_KEYS != i % NUM_KEYS || (*v & 1))
+         return 1;
+   }
+   if (cso_hash_size(hash) != 0 ||
+       !cso_hash_iter_is_null(cso_hash_first_node(hash)) ||
+       cso_hash_contains(hash, 0))
+      return 1;
+
+   cso_hash_delete(hash);
+   return 0;
+}
+
+
+static void
+bench_states(struct cso_context *cso, const char *name, unsigned window)
+{
+   static struct pipe_blend_state blend[NUM_STATES];
+   static struct pipe_depth_stencil_alpha_state dsa[NUM_STATES];
+   static struct pipe_rasterizer_state rast[NUM_STATES];
+   static struct pipe_sampler_state samp[NUM_STATES];
+   const struct pipe_sampler_state *samplers[2];
+   unsigned seed = 1;
+   int64_t start, end;
+   unsigned i;
+
+   memset(blend, 0, sizeof blend);
+   memset(dsa, 0, sizeof dsa);
+   memset(rast, 0, sizeof rast);
+   memset(samp, 0, sizeof samp);
+
+   for (i = 0; i < NUM_STATES; i++) {
+      blend[i].rt[0].blend_enable = i & 1;
+      blend[i].rt[0].rgb_src_factor = i >> 1;
+      blend[i].rt[0].colormask = 0xf;
+      dsa[i].depth.enabled = 1;
+      dsa[i].depth.func = i & 7;
+      dsa[i].depth.writemask = (i >> 3) & 1;
+      dsa[i].alpha.ref_value = i / 64.0f;
+      rast[i].cull_face = i & 3;
+      rast[i].line_width = 1.0f + (i >> 2);
+      rast[i].point_size = 1.0f;
+      samp[i].min_img_filter = i & 1;
+      samp[i].wrap_s = (i >> 1) & 3;
+      samp[i].lod_bias = (float)(i >> 3);
+   }
+
+   start = os_time_get();
+   for (i = 0; i < NUM_ITERATIONS; i++) {
+      unsigned s;
+
+      seed = seed * 1103515245 + 12345;
+      s = (seed >> 16) % window;
+
+      cso_set_blend(cso, &blend[s]);
+      cso_set_depth_stencil_alpha(cso, &dsa[s]);
+      cso_set_rasterizer(cso, &rast[s]);
+      samplers[0] = &samp[s];
+      samplers[1] = &samp[(s + 1) % window];
+      cso_set_samplers(cso, PIPE_SHADER_FRAGMENT, 2, samplers);
+   }
+   end = os_time_get();
+
+   printf("%s: %u states, %.1f ns per state set\n", name, window,
+          (double)(end - start) * 1000.0 / (NUM_ITERATIONS * 5));
+}
+
+
+int main(int argc, char **argv)
+{
+   struct pipe_screen *screen;
+   struct pipe_context *pipe;
+   struct cso_context *cso;
+
+   if (test_hash()) {
+      printf("cso_hash: FAIL\n");
+      return 1;
+   }
+   printf("cso_hash: PASS\n");
+
+   screen = softpipe_create_screen(null_sw_create());
+   if (!screen)
+      return 0;
+   pipe = screen->context_create(screen, NULL);
+   cso = cso_create_context(pipe);
+
+   /* Few states cycling (typical meta ops / ping-ponging between two
+    * materials) and many states (hash lookups).
+    */
+   bench_states(cso, "cso_context", 2);
+   bench_states(cso, "cso_context", 4);
+   bench_states(cso, "cso_context", NUM_STATES);
+
+   cso_release_all(cso);
+   cso_destroy_context(cso);
+   pipe->destroy(pipe);
+   screen->destroy(screen);
+
+   return 0;
+}
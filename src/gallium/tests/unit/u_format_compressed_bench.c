@@ -0,0 +1,144 @@
+/*
+ * Copyright 2014 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+ * Measure how fast compressed formats are decoded to RGBA8 and float, i.e.
+ * the path taken when a driver has to decompress textures on upload.
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "os/os_time.h"
+#include "util/u_format.h"
+#include "util/u_format_s3tc.h"
+#include "util/u_math.h"
+
+
+#define WIDTH 1024
+#define HEIGHT 1024
+#define ITERATIONS 8
+
+
+static boolean
+is_benchmarked(const struct util_format_description *format_desc)
+{
+   switch (format_desc->layout) {
+   case UTIL_FORMAT_LAYOUT_S3TC:
+      return util_format_s3tc_enabled;
+   case UTIL_FORMAT_LAYOUT_RGTC:
+   case UTIL_FORMAT_LAYOUT_ETC:
+      return TRUE;
+   default:
+      /* BPTC has no gallium decoder yet */
+      return FALSE;
+   }
+}
+
+
+/**
+ * Returns the number of texels decoded per second, in millions.
+ */
+static double
+bench_unpack(const struct util_format_description *format_desc,
+             const uint8_t *src, unsigned src_stride,
+             void *dst, boolean to_float)
+{
+   int64_t start, end;
+   unsigned i;
+
+   start = os_time_get();
+
+   for (i = 0; i < ITERATIONS; ++i) {
+      if (to_float)
+         format_desc->unpack_rgba_float(dst, WIDTH * 4 * sizeof(float),
+                                        src, src_stride, WIDTH, HEIGHT);
+      else
+         format_desc->unpack_rgba_8unorm(dst, WIDTH * 4,
+                                         src, src_stride, WIDTH, HEIGHT);
+   }
+
+   end = os_time_get();
+
+   return (double) WIDTH * HEIGHT * ITERATIONS / MAX2(end - start, 1);
+}
+
+
+int main(int argc, char **argv)
+{
+   enum pipe_format format;
+   uint8_t *src;
+   void *dst;
+   unsigned i;
+
+   util_format_s3tc_init();
+
+   /* Enough for the largest (16 byte) blocks */
+   src = malloc(WIDTH * HEIGHT);
+   dst = malloc(WIDTH * HEIGHT * 4 * sizeof(float));
+   if (!src || !dst)
+      return 1;
+
+   /* Random blocks exercise all the block modes */
+   for (i = 0; i < WIDTH * HEIGHT; ++i)
+      src[i] = rand();
+
+   printf("%-32s %12s %12s\n", "format", "8unorm Mt/s", "float Mt/s");
+
+   for (format = 1; format < PIPE_FORMAT_COUNT; ++format) {
+      const struct util_format_description *format_desc;
+      unsigned src_stride;
+
+      format_desc = util_format_description(format);
+      if (!format_desc || !is_benchmarked(format_desc))
+         continue;
+
+      src_stride = WIDTH / format_desc->block.width *
+                   format_desc->block.bits / 8;
+
+      printf("%-32s", format_desc->short_name);
+
+      /* The 8unorm unpacks aren't implemented for the signed formats */
+      if (format_desc->unpack_rgba_8unorm &&
+          !strstr(format_desc->name, "SNORM"))
+         printf(" %12.1f",
+                bench_unpack(format_desc, src, src_stride, dst, FALSE));
+      else
+         printf(" %12s", "-");
+
+      if (format_desc->unpack_rgba_float)
+         printf(" %12.1f",
+                bench_unpack(format_desc, src, src_stride, dst, TRUE));
+      else
+         printf(" %12s", "-");
+
+      printf("\n");
+   }
+
+   free(src);
+   free(dst);
+
+   return 0;
+}
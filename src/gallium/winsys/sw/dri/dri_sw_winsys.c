@@ -183,7 +183,7 @@ dri_sw_displaytarget_display(struct sw_winsys *ws,
 
    height = dri_sw_dt->height;
 
-   if (box) {
+   if (box && dri_sw_ws->lf->put_image2) {
        void *data;
        data = dri_sw_dt->data + (dri_sw_dt->stride * box->y) + box->x * blsize;
        dri_sw_ws->lf->put_image2(dri_drawable, data,
@@ -193,6 +193,28 @@ dri_sw_displaytarget_display(struct sw_winsys *ws,
    }
 }
 
+static void
+dri_sw_displaytarget_display_rects(struct sw_winsys *ws,
+                                   struct sw_displaytarget *dt,
+                                   void *context_private,
+                                   const struct pipe_box *rects,
+                                   unsigned num_rects)
+{
+   struct dri_sw_winsys *dri_sw_ws = dri_sw_winsys(ws);
+   struct dri_sw_displaytarget *dri_sw_dt = dri_sw_displaytarget(dt);
+   struct dri_drawable *dri_drawable = (struct dri_drawable *)context_private;
+   unsigned blsize = util_format_get_blocksize(dri_sw_dt->format);
+   unsigned i;
+
+   for (i = 0; i < num_rects; i++) {
+      const struct pipe_box *box = &rects[i];
+      void *data = dri_sw_dt->data + (dri_sw_dt->stride * box->y) + box->x * blsize;
+      dri_sw_ws->lf->put_image2(dri_drawable, data,
+                                box->x, box->y, box->width, box->height,
+                                dri_sw_dt->stride);
+   }
+}
+
 static void
 dri_destroy_sw_winsys(struct sw_winsys *winsys)
 {
@@ -224,6 +246,8 @@ dri_create_sw_winsys(struct drisw_loader_funcs *lf)
    ws->base.displaytarget_unmap = dri_sw_displaytarget_unmap;
 
    ws->base.displaytarget_display = dri_sw_displaytarget_display;
+   if (lf->put_image2)
+      ws->base.displaytarget_display_rects = dri_sw_displaytarget_display_rects;
 
    return &ws->base;
 }
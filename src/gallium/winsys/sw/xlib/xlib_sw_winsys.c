@@ -38,6 +38,7 @@
 #include "util/u_format.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
+#include "util/u_box.h"
 
 #include "state_tracker/xlibsw_api.h"
 #include "xlib_sw_winsys.h"
@@ -294,13 +295,17 @@ xlib_displaytarget_destroy(struct sw_winsys *ws,
  */
 static void
 xlib_sw_display(struct xlib_drawable *xlib_drawable,
-                struct sw_displaytarget *dt)
+                struct sw_displaytarget *dt,
+                const struct pipe_box *rects,
+                unsigned num_rects)
 {
    static boolean no_swap = 0;
    static boolean firsttime = 1;
    struct xlib_displaytarget *xlib_dt = xlib_displaytarget(dt);
    Display *display = xlib_dt->display;
    XImage *ximage;
+   struct pipe_box full;
+   unsigned i;
 
    if (firsttime) {
       no_swap = getenv("SP_NO_RAST") != NULL;
@@ -322,6 +327,15 @@ xlib_sw_display(struct xlib_drawable *xlib_drawable,
       }
 
       xlib_dt->drawable = xlib_drawable->drawable;
+
+      /* whatever the drawable shows is unrelated to this display target */
+      rects = NULL;
+   }
+
+   if (!rects) {
+      u_box_2d(0, 0, xlib_dt->width, xlib_dt->height, &full);
+      rects = &full;
+      num_rects = 1;
    }
 
    if (xlib_dt->tempImage == NULL) {
@@ -344,8 +358,11 @@ xlib_sw_display(struct xlib_drawable *xlib_drawable,
       ximage->data = xlib_dt->data;
 
       /* _debug_printf("XSHM\n"); */
-      XShmPutImage(xlib_dt->display, xlib_drawable->drawable, xlib_dt->gc,
-                   ximage, 0, 0, 0, 0, xlib_dt->width, xlib_dt->height, False);
+      for (i = 0; i < num_rects; i++) {
+         XShmPutImage(xlib_dt->display, xlib_drawable->drawable, xlib_dt->gc,
+                      ximage, rects[i].x, rects[i].y, rects[i].x, rects[i].y,
+                      rects[i].width, rects[i].height, False);
+      }
    }
    else {
       /* display image in Window */
@@ -362,8 +379,11 @@ xlib_sw_display(struct xlib_drawable *xlib_drawable,
       ximage->bytes_per_line = xlib_dt->stride;
 
       /* _debug_printf("XPUT\n"); */
-      XPutImage(xlib_dt->display, xlib_drawable->drawable, xlib_dt->gc,
-                ximage, 0, 0, 0, 0, xlib_dt->width, xlib_dt->height);
+      for (i = 0; i < num_rects; i++) {
+         XPutImage(xlib_dt->display, xlib_drawable->drawable, xlib_dt->gc,
+                   ximage, rects[i].x, rects[i].y, rects[i].x, rects[i].y,
+                   rects[i].width, rects[i].height);
+      }
    }
 
    XFlush(xlib_dt->display);
@@ -381,7 +401,22 @@ xlib_displaytarget_display(struct sw_winsys *ws,
                            struct pipe_box *box)
 {
    struct xlib_drawable *xlib_drawable = (struct xlib_drawable *)context_private;
-   xlib_sw_display(xlib_drawable, dt);
+   xlib_sw_display(xlib_drawable, dt, box, box ? 1 : 0);
+}
+
+
+/**
+ * Display/copy only the given rectangles of the surface.
+ */
+static void
+xlib_displaytarget_display_rects(struct sw_winsys *ws,
+                                 struct sw_displaytarget *dt,
+                                 void *context_private,
+                                 const struct pipe_box *rects,
+                                 unsigned num_rects)
+{
+   struct xlib_drawable *xlib_drawable = (struct xlib_drawable *)context_private;
+   xlib_sw_display(xlib_drawable, dt, rects, num_rects);
 }
 
 
@@ -482,6 +517,7 @@ xlib_create_sw_winsys(Display *display)
    ws->base.displaytarget_destroy = xlib_displaytarget_destroy;
 
    ws->base.displaytarget_display = xlib_displaytarget_display;
+   ws->base.displaytarget_display_rects = xlib_displaytarget_display_rects;
 
    return &ws->base;
 }
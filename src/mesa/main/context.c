@@ -123,6 +123,7 @@
 #include "stencil.h"
 #include "texcompress_s3tc.h"
 #include "texstate.h"
+#include "threadpool.h"
 #include "transformfeedback.h"
 #include "mtypes.h"
 #include "varray.h"
@@ -1151,6 +1152,8 @@ _mesa_initialize_context(struct gl_context *ctx,
 
    ctx->FirstTimeCurrent = GL_TRUE;
 
+   _mesa_threadpool_reference();
+
    return GL_TRUE;
 
 fail:
@@ -1275,6 +1278,8 @@ _mesa_free_context_data( struct gl_context *ctx )
 
    free(ctx->VersionString);
 
+   _mesa_threadpool_release();
+
    /* unbind the context if it's currently bound */
    if (ctx == _mesa_get_current_context()) {
       _mesa_make_current(NULL, NULL, NULL);
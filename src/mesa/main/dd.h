@@ -788,6 +788,12 @@ struct dd_function_table {
 
 #define FLUSH_STORED_VERTICES 0x1
 #define FLUSH_UPDATE_CURRENT  0x2
+/**
+ * Only passed to FlushVertices(), never set in NeedFlush: the stored
+ * vertices are being flushed only because the modelview matrix is about to
+ * change.  The T&L engine may keep them if it can account for the change.
+ */
+#define FLUSH_MODELVIEW       0x4
    /**
     * Set by the driver-supplied T&L engine whenever vertices are buffered
     * between glBegin()/glEnd() objects or __struct gl_contextRec::Current
@@ -35,6 +35,7 @@
 #include "dispatch.h"
 #include "hash.h"
 #include "mtypes.h"
+#include "threadpool.h"
 #include "version.h"
 #include "util/hash_table.h"
 
@@ -1359,6 +1360,9 @@ _mesa_error( struct gl_context *ctx, GLenum error, const char *fmtString, ... )
     */
    static GLuint error_msg_id = 0;
 
+   if (_mesa_threadpool_defer_error())
+      return;
+
    debug_get_id(&error_msg_id);
 
    do_output = should_output(ctx, error, fmtString);
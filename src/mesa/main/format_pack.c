@@ -36,6 +36,7 @@
  */
 
 
+#include "c11/threads.h"
 #include "colormac.h"
 #include "format_pack.h"
 #include "macros.h"
@@ -1953,405 +1954,425 @@ pack_float_X8R8G8B8_SRGB(const GLfloat src[4], void *dst)
    *d = PACK_COLOR_8888(b, g, r, 255);
 }
 
+static gl_pack_ubyte_rgba_func pack_ubyte_rgba_table[MESA_FORMAT_COUNT];
+
+
+static void
+init_pack_ubyte_rgba_table(void)
+{
+   gl_pack_ubyte_rgba_func *table = pack_ubyte_rgba_table;
+
+   table[MESA_FORMAT_NONE] = NULL;
+
+   table[MESA_FORMAT_A8B8G8R8_UNORM] = pack_ubyte_A8B8G8R8_UNORM;
+   table[MESA_FORMAT_R8G8B8A8_UNORM] = pack_ubyte_R8G8B8A8_UNORM;
+   table[MESA_FORMAT_B8G8R8A8_UNORM] = pack_ubyte_B8G8R8A8_UNORM;
+   table[MESA_FORMAT_A8R8G8B8_UNORM] = pack_ubyte_A8R8G8B8_UNORM;
+   table[MESA_FORMAT_X8B8G8R8_UNORM] = pack_ubyte_A8B8G8R8_UNORM; /* reused */
+   table[MESA_FORMAT_R8G8B8X8_UNORM] = pack_ubyte_R8G8B8A8_UNORM; /* reused */
+   table[MESA_FORMAT_B8G8R8X8_UNORM] = pack_ubyte_B8G8R8X8_UNORM;
+   table[MESA_FORMAT_X8R8G8B8_UNORM] = pack_ubyte_X8R8G8B8_UNORM;
+   table[MESA_FORMAT_BGR_UNORM8] = pack_ubyte_BGR_UNORM8;
+   table[MESA_FORMAT_RGB_UNORM8] = pack_ubyte_RGB_UNORM8;
+   table[MESA_FORMAT_B5G6R5_UNORM] = pack_ubyte_B5G6R5_UNORM;
+   table[MESA_FORMAT_R5G6B5_UNORM] = pack_ubyte_R5G6B5_UNORM;
+   table[MESA_FORMAT_B4G4R4A4_UNORM] = pack_ubyte_B4G4R4A4_UNORM;
+   table[MESA_FORMAT_A4R4G4B4_UNORM] = pack_ubyte_A4R4G4B4_UNORM;
+   table[MESA_FORMAT_A1B5G5R5_UNORM] = pack_ubyte_A1B5G5R5_UNORM;
+   table[MESA_FORMAT_B5G5R5A1_UNORM] = pack_ubyte_B5G5R5A1_UNORM;
+   table[MESA_FORMAT_A1R5G5B5_UNORM] = pack_ubyte_A1R5G5B5_UNORM;
+   table[MESA_FORMAT_L4A4_UNORM] = pack_ubyte_L4A4_UNORM;
+   table[MESA_FORMAT_L8A8_UNORM] = pack_ubyte_L8A8_UNORM;
+   table[MESA_FORMAT_A8L8_UNORM] = pack_ubyte_A8L8_UNORM;
+   table[MESA_FORMAT_L16A16_UNORM] = pack_ubyte_L16A16_UNORM;
+   table[MESA_FORMAT_A16L16_UNORM] = pack_ubyte_A16L16_UNORM;
+   table[MESA_FORMAT_B2G3R3_UNORM] = pack_ubyte_B2G3R3_UNORM;
+   table[MESA_FORMAT_A_UNORM8] = pack_ubyte_A_UNORM8;
+   table[MESA_FORMAT_A_UNORM16] = pack_ubyte_A_UNORM16;
+   table[MESA_FORMAT_L_UNORM8] = pack_ubyte_L_UNORM8;
+   table[MESA_FORMAT_L_UNORM16] = pack_ubyte_L_UNORM16;
+   table[MESA_FORMAT_I_UNORM8] = pack_ubyte_L_UNORM8; /* reuse pack_ubyte_L_UNORM8 */
+   table[MESA_FORMAT_I_UNORM16] = pack_ubyte_L_UNORM16; /* reuse pack_ubyte_L_UNORM16 */
+   table[MESA_FORMAT_YCBCR] = pack_ubyte_YCBCR;
+   table[MESA_FORMAT_YCBCR_REV] = pack_ubyte_YCBCR_REV;
+   table[MESA_FORMAT_R_UNORM8] = pack_ubyte_R_UNORM8;
+   table[MESA_FORMAT_R8G8_UNORM] = pack_ubyte_R8G8_UNORM;
+   table[MESA_FORMAT_G8R8_UNORM] = pack_ubyte_G8R8_UNORM;
+   table[MESA_FORMAT_R_UNORM16] = pack_ubyte_R_UNORM16;
+   table[MESA_FORMAT_R16G16_UNORM] = pack_ubyte_R16G16_UNORM;
+   table[MESA_FORMAT_G16R16_UNORM] = pack_ubyte_G16R16_UNORM;
+   table[MESA_FORMAT_B10G10R10A2_UNORM] = pack_ubyte_B10G10R10A2_UNORM;
+   table[MESA_FORMAT_R10G10B10A2_UINT] = pack_ubyte_R10G10B10A2_UINT;
+
+   /* should never convert RGBA to these formats */
+   table[MESA_FORMAT_S8_UINT_Z24_UNORM] = NULL;
+   table[MESA_FORMAT_Z24_UNORM_S8_UINT] = NULL;
+   table[MESA_FORMAT_Z_UNORM16] = NULL;
+   table[MESA_FORMAT_Z24_UNORM_X8_UINT] = NULL;
+   table[MESA_FORMAT_X8_UINT_Z24_UNORM] = NULL;
+   table[MESA_FORMAT_Z_UNORM32] = NULL;
+   table[MESA_FORMAT_S_UINT8] = NULL;
+
+   /* sRGB */
+   table[MESA_FORMAT_BGR_SRGB8] = pack_ubyte_BGR_SRGB8;
+   table[MESA_FORMAT_A8B8G8R8_SRGB] = pack_ubyte_A8B8G8R8_SRGB;
+   table[MESA_FORMAT_B8G8R8A8_SRGB] = pack_ubyte_B8G8R8A8_SRGB;
+   table[MESA_FORMAT_A8R8G8B8_SRGB] = pack_ubyte_A8R8G8B8_SRGB;
+   table[MESA_FORMAT_R8G8B8A8_SRGB] = pack_ubyte_R8G8B8A8_SRGB;
+   table[MESA_FORMAT_L_SRGB8] = pack_ubyte_L_SRGB8;
+   table[MESA_FORMAT_L8A8_SRGB] = pack_ubyte_L8A8_SRGB;
+   table[MESA_FORMAT_A8L8_SRGB] = pack_ubyte_A8L8_SRGB;
+   /* n/a */
+   table[MESA_FORMAT_SRGB_DXT1] = NULL; /* pack_ubyte_SRGB_DXT1; */
+   table[MESA_FORMAT_SRGBA_DXT1] = NULL; /* pack_ubyte_SRGBA_DXT1; */
+   table[MESA_FORMAT_SRGBA_DXT3] = NULL; /* pack_ubyte_SRGBA_DXT3; */
+   table[MESA_FORMAT_SRGBA_DXT5] = NULL; /* pack_ubyte_SRGBA_DXT5; */
+
+   table[MESA_FORMAT_RGB_FXT1] = NULL; /* pack_ubyte_RGB_FXT1; */
+   table[MESA_FORMAT_RGBA_FXT1] = NULL; /* pack_ubyte_RGBA_FXT1; */
+   table[MESA_FORMAT_RGB_DXT1] = NULL; /* pack_ubyte_RGB_DXT1; */
+   table[MESA_FORMAT_RGBA_DXT1] = NULL; /* pack_ubyte_RGBA_DXT1; */
+   table[MESA_FORMAT_RGBA_DXT3] = NULL; /* pack_ubyte_RGBA_DXT3; */
+   table[MESA_FORMAT_RGBA_DXT5] = NULL; /* pack_ubyte_RGBA_DXT5; */
+
+   table[MESA_FORMAT_RGBA_FLOAT32] = pack_ubyte_RGBA_FLOAT32;
+   table[MESA_FORMAT_RGBA_FLOAT16] = pack_ubyte_RGBA_FLOAT16;
+   table[MESA_FORMAT_RGB_FLOAT32] = pack_ubyte_RGB_FLOAT32;
+   table[MESA_FORMAT_RGB_FLOAT16] = pack_ubyte_RGB_FLOAT16;
+   table[MESA_FORMAT_A_FLOAT32] = pack_ubyte_A_FLOAT32;
+   table[MESA_FORMAT_A_FLOAT16] = pack_ubyte_A_FLOAT16;
+   table[MESA_FORMAT_L_FLOAT32] = pack_ubyte_L_FLOAT32;
+   table[MESA_FORMAT_L_FLOAT16] = pack_ubyte_L_FLOAT16;
+   table[MESA_FORMAT_LA_FLOAT32] = pack_ubyte_LA_FLOAT32;
+   table[MESA_FORMAT_LA_FLOAT16] = pack_ubyte_LA_FLOAT16;
+   table[MESA_FORMAT_I_FLOAT32] = pack_ubyte_L_FLOAT32;
+   table[MESA_FORMAT_I_FLOAT16] = pack_ubyte_L_FLOAT16;
+   table[MESA_FORMAT_R_FLOAT32] = pack_ubyte_L_FLOAT32;
+   table[MESA_FORMAT_R_FLOAT16] = pack_ubyte_L_FLOAT16;
+   table[MESA_FORMAT_RG_FLOAT32] = pack_ubyte_RG_FLOAT32;
+   table[MESA_FORMAT_RG_FLOAT16] = pack_ubyte_RG_FLOAT16;
+
+   /* n/a */
+   table[MESA_FORMAT_RGBA_SINT8] = NULL; /* pack_ubyte_RGBA_INT8 */
+   table[MESA_FORMAT_RGBA_SINT16] = NULL; /* pack_ubyte_RGBA_INT16 */
+   table[MESA_FORMAT_RGBA_SINT32] = NULL; /* pack_ubyte_RGBA_INT32 */
+   table[MESA_FORMAT_RGBA_UINT8] = NULL; /* pack_ubyte_RGBA_UINT8 */
+   table[MESA_FORMAT_RGBA_UINT16] = NULL; /* pack_ubyte_RGBA_UINT16 */
+   table[MESA_FORMAT_RGBA_UINT32] = NULL; /* pack_ubyte_RGBA_UINT32 */
+
+   table[MESA_FORMAT_RGBA_UNORM16] = pack_ubyte_RGBA_16;
+
+   /* n/a */
+   table[MESA_FORMAT_R_SNORM8] = NULL;
+   table[MESA_FORMAT_R8G8_SNORM] = NULL;
+   table[MESA_FORMAT_X8B8G8R8_SNORM] = NULL;
+   table[MESA_FORMAT_A8B8G8R8_SNORM] = NULL;
+   table[MESA_FORMAT_R8G8B8A8_SNORM] = NULL;
+   table[MESA_FORMAT_R_SNORM16] = NULL;
+   table[MESA_FORMAT_R16G16_SNORM] = NULL;
+   table[MESA_FORMAT_RGB_SNORM16] = NULL;
+   table[MESA_FORMAT_RGBA_SNORM16] = NULL;
+   table[MESA_FORMAT_A_SNORM8] = NULL;
+   table[MESA_FORMAT_L_SNORM8] = NULL;
+   table[MESA_FORMAT_L8A8_SNORM] = NULL;
+   table[MESA_FORMAT_A8L8_SNORM] = NULL;
+   table[MESA_FORMAT_I_SNORM8] = NULL;
+   table[MESA_FORMAT_A_SNORM16] = NULL;
+   table[MESA_FORMAT_L_SNORM16] = NULL;
+   table[MESA_FORMAT_LA_SNORM16] = NULL;
+   table[MESA_FORMAT_I_SNORM16] = NULL;
+
+
+   table[MESA_FORMAT_RGBA_UNORM16] = pack_ubyte_RGBA_16;
+
+   table[MESA_FORMAT_R9G9B9E5_FLOAT] = pack_ubyte_R9G9B9E5_FLOAT;
+   table[MESA_FORMAT_R11G11B10_FLOAT] = pack_ubyte_R11G11B10_FLOAT;
+
+   table[MESA_FORMAT_B4G4R4X4_UNORM] = pack_ubyte_XRGB4444_UNORM;
+   table[MESA_FORMAT_B5G5R5X1_UNORM] = pack_ubyte_XRGB1555_UNORM;
+   table[MESA_FORMAT_R8G8B8X8_SNORM] = NULL;
+   table[MESA_FORMAT_R8G8B8X8_SRGB] = NULL;
+   table[MESA_FORMAT_X8B8G8R8_SRGB] = NULL;
+   table[MESA_FORMAT_RGBX_UINT8] = NULL;
+   table[MESA_FORMAT_RGBX_SINT8] = NULL;
+   table[MESA_FORMAT_B10G10R10X2_UNORM] = pack_ubyte_B10G10R10X2_UNORM;
+   table[MESA_FORMAT_RGBX_UNORM16] = pack_ubyte_RGBX_UNORM16;
+   table[MESA_FORMAT_RGBX_SNORM16] = NULL;
+   table[MESA_FORMAT_RGBX_FLOAT16] = NULL;
+   table[MESA_FORMAT_RGBX_UINT16] = NULL;
+   table[MESA_FORMAT_RGBX_SINT16] = NULL;
+   table[MESA_FORMAT_RGBX_FLOAT32] = NULL;
+   table[MESA_FORMAT_RGBX_UINT32] = NULL;
+   table[MESA_FORMAT_RGBX_SINT32] = NULL;
+
+   table[MESA_FORMAT_R10G10B10A2_UNORM] = pack_ubyte_R10G10B10A2_UNORM;
+
+   table[MESA_FORMAT_B8G8R8X8_SRGB] = NULL;
+   table[MESA_FORMAT_X8R8G8B8_SRGB] = NULL;
+}
+
+
 /**
  * Return a function that can pack a GLubyte rgba[4] color.
  */
 gl_pack_ubyte_rgba_func
 _mesa_get_pack_ubyte_rgba_function(mesa_format format)
 {
-   static gl_pack_ubyte_rgba_func table[MESA_FORMAT_COUNT];
-   static GLboolean initialized = GL_FALSE;
-
-   if (!initialized) {
-      memset(table, 0, sizeof(table));
-
-      table[MESA_FORMAT_NONE] = NULL;
-
-      table[MESA_FORMAT_A8B8G8R8_UNORM] = pack_ubyte_A8B8G8R8_UNORM;
-      table[MESA_FORMAT_R8G8B8A8_UNORM] = pack_ubyte_R8G8B8A8_UNORM;
-      table[MESA_FORMAT_B8G8R8A8_UNORM] = pack_ubyte_B8G8R8A8_UNORM;
-      table[MESA_FORMAT_A8R8G8B8_UNORM] = pack_ubyte_A8R8G8B8_UNORM;
-      table[MESA_FORMAT_X8B8G8R8_UNORM] = pack_ubyte_A8B8G8R8_UNORM; /* reused */
-      table[MESA_FORMAT_R8G8B8X8_UNORM] = pack_ubyte_R8G8B8A8_UNORM; /* reused */
-      table[MESA_FORMAT_B8G8R8X8_UNORM] = pack_ubyte_B8G8R8X8_UNORM;
-      table[MESA_FORMAT_X8R8G8B8_UNORM] = pack_ubyte_X8R8G8B8_UNORM;
-      table[MESA_FORMAT_BGR_UNORM8] = pack_ubyte_BGR_UNORM8;
-      table[MESA_FORMAT_RGB_UNORM8] = pack_ubyte_RGB_UNORM8;
-      table[MESA_FORMAT_B5G6R5_UNORM] = pack_ubyte_B5G6R5_UNORM;
-      table[MESA_FORMAT_R5G6B5_UNORM] = pack_ubyte_R5G6B5_UNORM;
-      table[MESA_FORMAT_B4G4R4A4_UNORM] = pack_ubyte_B4G4R4A4_UNORM;
-      table[MESA_FORMAT_A4R4G4B4_UNORM] = pack_ubyte_A4R4G4B4_UNORM;
-      table[MESA_FORMAT_A1B5G5R5_UNORM] = pack_ubyte_A1B5G5R5_UNORM;
-      table[MESA_FORMAT_B5G5R5A1_UNORM] = pack_ubyte_B5G5R5A1_UNORM;
-      table[MESA_FORMAT_A1R5G5B5_UNORM] = pack_ubyte_A1R5G5B5_UNORM;
-      table[MESA_FORMAT_L4A4_UNORM] = pack_ubyte_L4A4_UNORM;
-      table[MESA_FORMAT_L8A8_UNORM] = pack_ubyte_L8A8_UNORM;
-      table[MESA_FORMAT_A8L8_UNORM] = pack_ubyte_A8L8_UNORM;
-      table[MESA_FORMAT_L16A16_UNORM] = pack_ubyte_L16A16_UNORM;
-      table[MESA_FORMAT_A16L16_UNORM] = pack_ubyte_A16L16_UNORM;
-      table[MESA_FORMAT_B2G3R3_UNORM] = pack_ubyte_B2G3R3_UNORM;
-      table[MESA_FORMAT_A_UNORM8] = pack_ubyte_A_UNORM8;
-      table[MESA_FORMAT_A_UNORM16] = pack_ubyte_A_UNORM16;
-      table[MESA_FORMAT_L_UNORM8] = pack_ubyte_L_UNORM8;
-      table[MESA_FORMAT_L_UNORM16] = pack_ubyte_L_UNORM16;
-      table[MESA_FORMAT_I_UNORM8] = pack_ubyte_L_UNORM8; /* reuse pack_ubyte_L_UNORM8 */
-      table[MESA_FORMAT_I_UNORM16] = pack_ubyte_L_UNORM16; /* reuse pack_ubyte_L_UNORM16 */
-      table[MESA_FORMAT_YCBCR] = pack_ubyte_YCBCR;
-      table[MESA_FORMAT_YCBCR_REV] = pack_ubyte_YCBCR_REV;
-      table[MESA_FORMAT_R_UNORM8] = pack_ubyte_R_UNORM8;
-      table[MESA_FORMAT_R8G8_UNORM] = pack_ubyte_R8G8_UNORM;
-      table[MESA_FORMAT_G8R8_UNORM] = pack_ubyte_G8R8_UNORM;
-      table[MESA_FORMAT_R_UNORM16] = pack_ubyte_R_UNORM16;
-      table[MESA_FORMAT_R16G16_UNORM] = pack_ubyte_R16G16_UNORM;
-      table[MESA_FORMAT_G16R16_UNORM] = pack_ubyte_G16R16_UNORM;
-      table[MESA_FORMAT_B10G10R10A2_UNORM] = pack_ubyte_B10G10R10A2_UNORM;
-      table[MESA_FORMAT_R10G10B10A2_UINT] = pack_ubyte_R10G10B10A2_UINT;
-
-      /* should never convert RGBA to these formats */
-      table[MESA_FORMAT_S8_UINT_Z24_UNORM] = NULL;
-      table[MESA_FORMAT_Z24_UNORM_S8_UINT] = NULL;
-      table[MESA_FORMAT_Z_UNORM16] = NULL;
-      table[MESA_FORMAT_Z24_UNORM_X8_UINT] = NULL;
-      table[MESA_FORMAT_X8_UINT_Z24_UNORM] = NULL;
-      table[MESA_FORMAT_Z_UNORM32] = NULL;
-      table[MESA_FORMAT_S_UINT8] = NULL;
-
-      /* sRGB */
-      table[MESA_FORMAT_BGR_SRGB8] = pack_ubyte_BGR_SRGB8;
-      table[MESA_FORMAT_A8B8G8R8_SRGB] = pack_ubyte_A8B8G8R8_SRGB;
-      table[MESA_FORMAT_B8G8R8A8_SRGB] = pack_ubyte_B8G8R8A8_SRGB;
-      table[MESA_FORMAT_A8R8G8B8_SRGB] = pack_ubyte_A8R8G8B8_SRGB;
-      table[MESA_FORMAT_R8G8B8A8_SRGB] = pack_ubyte_R8G8B8A8_SRGB;
-      table[MESA_FORMAT_L_SRGB8] = pack_ubyte_L_SRGB8;
-      table[MESA_FORMAT_L8A8_SRGB] = pack_ubyte_L8A8_SRGB;
-      table[MESA_FORMAT_A8L8_SRGB] = pack_ubyte_A8L8_SRGB;
-      /* n/a */
-      table[MESA_FORMAT_SRGB_DXT1] = NULL; /* pack_ubyte_SRGB_DXT1; */
-      table[MESA_FORMAT_SRGBA_DXT1] = NULL; /* pack_ubyte_SRGBA_DXT1; */
-      table[MESA_FORMAT_SRGBA_DXT3] = NULL; /* pack_ubyte_SRGBA_DXT3; */
-      table[MESA_FORMAT_SRGBA_DXT5] = NULL; /* pack_ubyte_SRGBA_DXT5; */
-
-      table[MESA_FORMAT_RGB_FXT1] = NULL; /* pack_ubyte_RGB_FXT1; */
-      table[MESA_FORMAT_RGBA_FXT1] = NULL; /* pack_ubyte_RGBA_FXT1; */
-      table[MESA_FORMAT_RGB_DXT1] = NULL; /* pack_ubyte_RGB_DXT1; */
-      table[MESA_FORMAT_RGBA_DXT1] = NULL; /* pack_ubyte_RGBA_DXT1; */
-      table[MESA_FORMAT_RGBA_DXT3] = NULL; /* pack_ubyte_RGBA_DXT3; */
-      table[MESA_FORMAT_RGBA_DXT5] = NULL; /* pack_ubyte_RGBA_DXT5; */
-
-      table[MESA_FORMAT_RGBA_FLOAT32] = pack_ubyte_RGBA_FLOAT32;
-      table[MESA_FORMAT_RGBA_FLOAT16] = pack_ubyte_RGBA_FLOAT16;
-      table[MESA_FORMAT_RGB_FLOAT32] = pack_ubyte_RGB_FLOAT32;
-      table[MESA_FORMAT_RGB_FLOAT16] = pack_ubyte_RGB_FLOAT16;
-      table[MESA_FORMAT_A_FLOAT32] = pack_ubyte_A_FLOAT32;
-      table[MESA_FORMAT_A_FLOAT16] = pack_ubyte_A_FLOAT16;
-      table[MESA_FORMAT_L_FLOAT32] = pack_ubyte_L_FLOAT32;
-      table[MESA_FORMAT_L_FLOAT16] = pack_ubyte_L_FLOAT16;
-      table[MESA_FORMAT_LA_FLOAT32] = pack_ubyte_LA_FLOAT32;
-      table[MESA_FORMAT_LA_FLOAT16] = pack_ubyte_LA_FLOAT16;
-      table[MESA_FORMAT_I_FLOAT32] = pack_ubyte_L_FLOAT32;
-      table[MESA_FORMAT_I_FLOAT16] = pack_ubyte_L_FLOAT16;
-      table[MESA_FORMAT_R_FLOAT32] = pack_ubyte_L_FLOAT32;
-      table[MESA_FORMAT_R_FLOAT16] = pack_ubyte_L_FLOAT16;
-      table[MESA_FORMAT_RG_FLOAT32] = pack_ubyte_RG_FLOAT32;
-      table[MESA_FORMAT_RG_FLOAT16] = pack_ubyte_RG_FLOAT16;
-
-      /* n/a */
-      table[MESA_FORMAT_RGBA_SINT8] = NULL; /* pack_ubyte_RGBA_INT8 */
-      table[MESA_FORMAT_RGBA_SINT16] = NULL; /* pack_ubyte_RGBA_INT16 */
-      table[MESA_FORMAT_RGBA_SINT32] = NULL; /* pack_ubyte_RGBA_INT32 */
-      table[MESA_FORMAT_RGBA_UINT8] = NULL; /* pack_ubyte_RGBA_UINT8 */
-      table[MESA_FORMAT_RGBA_UINT16] = NULL; /* pack_ubyte_RGBA_UINT16 */
-      table[MESA_FORMAT_RGBA_UINT32] = NULL; /* pack_ubyte_RGBA_UINT32 */
-
-      table[MESA_FORMAT_RGBA_UNORM16] = pack_ubyte_RGBA_16;
-
-      /* n/a */
-      table[MESA_FORMAT_R_SNORM8] = NULL;
-      table[MESA_FORMAT_R8G8_SNORM] = NULL;
-      table[MESA_FORMAT_X8B8G8R8_SNORM] = NULL;
-      table[MESA_FORMAT_A8B8G8R8_SNORM] = NULL;
-      table[MESA_FORMAT_R8G8B8A8_SNORM] = NULL;
-      table[MESA_FORMAT_R_SNORM16] = NULL;
-      table[MESA_FORMAT_R16G16_SNORM] = NULL;
-      table[MESA_FORMAT_RGB_SNORM16] = NULL;
-      table[MESA_FORMAT_RGBA_SNORM16] = NULL;
-      table[MESA_FORMAT_A_SNORM8] = NULL;
-      table[MESA_FORMAT_L_SNORM8] = NULL;
-      table[MESA_FORMAT_L8A8_SNORM] = NULL;
-      table[MESA_FORMAT_A8L8_SNORM] = NULL;
-      table[MESA_FORMAT_I_SNORM8] = NULL;
-      table[MESA_FORMAT_A_SNORM16] = NULL;
-      table[MESA_FORMAT_L_SNORM16] = NULL;
-      table[MESA_FORMAT_LA_SNORM16] = NULL;
-      table[MESA_FORMAT_I_SNORM16] = NULL;
-
-
-      table[MESA_FORMAT_RGBA_UNORM16] = pack_ubyte_RGBA_16;
-
-      table[MESA_FORMAT_R9G9B9E5_FLOAT] = pack_ubyte_R9G9B9E5_FLOAT;
-      table[MESA_FORMAT_R11G11B10_FLOAT] = pack_ubyte_R11G11B10_FLOAT;
-
-      table[MESA_FORMAT_B4G4R4X4_UNORM] = pack_ubyte_XRGB4444_UNORM;
-      table[MESA_FORMAT_B5G5R5X1_UNORM] = pack_ubyte_XRGB1555_UNORM;
-      table[MESA_FORMAT_R8G8B8X8_SNORM] = NULL;
-      table[MESA_FORMAT_R8G8B8X8_SRGB] = NULL;
-      table[MESA_FORMAT_X8B8G8R8_SRGB] = NULL;
-      table[MESA_FORMAT_RGBX_UINT8] = NULL;
-      table[MESA_FORMAT_RGBX_SINT8] = NULL;
-      table[MESA_FORMAT_B10G10R10X2_UNORM] = pack_ubyte_B10G10R10X2_UNORM;
-      table[MESA_FORMAT_RGBX_UNORM16] = pack_ubyte_RGBX_UNORM16;
-      table[MESA_FORMAT_RGBX_SNORM16] = NULL;
-      table[MESA_FORMAT_RGBX_FLOAT16] = NULL;
-      table[MESA_FORMAT_RGBX_UINT16] = NULL;
-      table[MESA_FORMAT_RGBX_SINT16] = NULL;
-      table[MESA_FORMAT_RGBX_FLOAT32] = NULL;
-      table[MESA_FORMAT_RGBX_UINT32] = NULL;
-      table[MESA_FORMAT_RGBX_SINT32] = NULL;
-
-      table[MESA_FORMAT_R10G10B10A2_UNORM] = pack_ubyte_R10G10B10A2_UNORM;
-
-      table[MESA_FORMAT_B8G8R8X8_SRGB] = NULL;
-      table[MESA_FORMAT_X8R8G8B8_SRGB] = NULL;
-
-      initialized = GL_TRUE;
-   }
-
-   return table[format];
+   static once_flag flag = ONCE_FLAG_INIT;
+
+   call_once(&flag, init_pack_ubyte_rgba_table);
+
+   return pack_ubyte_rgba_table[format];
+}
+
+
+
+static gl_pack_float_rgba_func pack_float_rgba_table[MESA_FORMAT_COUNT];
+
+
+static void
+init_pack_float_rgba_table(void)
+{
+   gl_pack_float_rgba_func *table = pack_float_rgba_table;
+
+   table[MESA_FORMAT_NONE] = NULL;
+
+   table[MESA_FORMAT_A8B8G8R8_UNORM] = pack_float_A8B8G8R8_UNORM;
+   table[MESA_FORMAT_R8G8B8A8_UNORM] = pack_float_R8G8B8A8_UNORM;
+   table[MESA_FORMAT_B8G8R8A8_UNORM] = pack_float_B8G8R8A8_UNORM;
+   table[MESA_FORMAT_A8R8G8B8_UNORM] = pack_float_A8R8G8B8_UNORM;
+   table[MESA_FORMAT_X8B8G8R8_UNORM] = pack_float_A8B8G8R8_UNORM; /* reused */
+   table[MESA_FORMAT_R8G8B8X8_UNORM] = pack_float_R8G8B8A8_UNORM; /* reused */
+   table[MESA_FORMAT_B8G8R8X8_UNORM] = pack_float_B8G8R8X8_UNORM;
+   table[MESA_FORMAT_X8R8G8B8_UNORM] = pack_float_X8R8G8B8_UNORM;
+   table[MESA_FORMAT_BGR_UNORM8] = pack_float_BGR_UNORM8;
+   table[MESA_FORMAT_RGB_UNORM8] = pack_float_RGB_UNORM8;
+   table[MESA_FORMAT_B5G6R5_UNORM] = pack_float_B5G6R5_UNORM;
+   table[MESA_FORMAT_R5G6B5_UNORM] = pack_float_R5G6B5_UNORM;
+   table[MESA_FORMAT_B4G4R4A4_UNORM] = pack_float_B4G4R4A4_UNORM;
+   table[MESA_FORMAT_A4R4G4B4_UNORM] = pack_float_A4R4G4B4_UNORM;
+   table[MESA_FORMAT_A1B5G5R5_UNORM] = pack_float_A1B5G5R5_UNORM;
+   table[MESA_FORMAT_B5G5R5A1_UNORM] = pack_float_B5G5R5A1_UNORM;
+   table[MESA_FORMAT_A1R5G5B5_UNORM] = pack_float_A1R5G5B5_UNORM;
+
+   table[MESA_FORMAT_L4A4_UNORM] = pack_float_L4A4_UNORM;
+   table[MESA_FORMAT_L8A8_UNORM] = pack_float_L8A8_UNORM;
+   table[MESA_FORMAT_A8L8_UNORM] = pack_float_A8L8_UNORM;
+   table[MESA_FORMAT_L16A16_UNORM] = pack_float_L16A16_UNORM;
+   table[MESA_FORMAT_A16L16_UNORM] = pack_float_A16L16_UNORM;
+   table[MESA_FORMAT_B2G3R3_UNORM] = pack_float_B2G3R3_UNORM;
+   table[MESA_FORMAT_A_UNORM8] = pack_float_A_UNORM8;
+   table[MESA_FORMAT_A_UNORM16] = pack_float_A_UNORM16;
+   table[MESA_FORMAT_L_UNORM8] = pack_float_L_UNORM8;
+   table[MESA_FORMAT_L_UNORM16] = pack_float_L_UNORM16;
+   table[MESA_FORMAT_I_UNORM8] = pack_float_L_UNORM8; /* reuse pack_float_L_UNORM8 */
+   table[MESA_FORMAT_I_UNORM16] = pack_float_L_UNORM16; /* reuse pack_float_L_UNORM16 */
+   table[MESA_FORMAT_YCBCR] = pack_float_YCBCR;
+   table[MESA_FORMAT_YCBCR_REV] = pack_float_YCBCR_REV;
+   table[MESA_FORMAT_R_UNORM8] = pack_float_R_UNORM8;
+   table[MESA_FORMAT_R8G8_UNORM] = pack_float_R8G8_UNORM;
+   table[MESA_FORMAT_G8R8_UNORM] = pack_float_G8R8_UNORM;
+   table[MESA_FORMAT_R_UNORM16] = pack_float_R_UNORM16;
+   table[MESA_FORMAT_R16G16_UNORM] = pack_float_R16G16_UNORM;
+   table[MESA_FORMAT_G16R16_UNORM] = pack_float_G16R16_UNORM;
+   table[MESA_FORMAT_B10G10R10A2_UNORM] = pack_float_B10G10R10A2_UNORM;
+   table[MESA_FORMAT_R10G10B10A2_UINT] = pack_float_R10G10B10A2_UINT;
+
+   /* should never convert RGBA to these formats */
+   table[MESA_FORMAT_S8_UINT_Z24_UNORM] = NULL;
+   table[MESA_FORMAT_Z24_UNORM_S8_UINT] = NULL;
+   table[MESA_FORMAT_Z_UNORM16] = NULL;
+   table[MESA_FORMAT_Z24_UNORM_X8_UINT] = NULL;
+   table[MESA_FORMAT_X8_UINT_Z24_UNORM] = NULL;
+   table[MESA_FORMAT_Z_UNORM32] = NULL;
+   table[MESA_FORMAT_S_UINT8] = NULL;
+
+   table[MESA_FORMAT_BGR_SRGB8] = pack_float_BGR_SRGB8;
+   table[MESA_FORMAT_A8B8G8R8_SRGB] = pack_float_A8B8G8R8_SRGB;
+   table[MESA_FORMAT_B8G8R8A8_SRGB] = pack_float_B8G8R8A8_SRGB;
+   table[MESA_FORMAT_A8R8G8B8_SRGB] = pack_float_A8R8G8B8_SRGB;
+   table[MESA_FORMAT_R8G8B8A8_SRGB] = pack_float_R8G8B8A8_SRGB;
+   table[MESA_FORMAT_L_SRGB8] = pack_float_L_SRGB8;
+   table[MESA_FORMAT_L8A8_SRGB] = pack_float_L8A8_SRGB;
+   table[MESA_FORMAT_A8L8_SRGB] = pack_float_A8L8_SRGB;
+
+   /* n/a */
+   table[MESA_FORMAT_SRGB_DXT1] = NULL;
+   table[MESA_FORMAT_SRGBA_DXT1] = NULL;
+   table[MESA_FORMAT_SRGBA_DXT3] = NULL;
+   table[MESA_FORMAT_SRGBA_DXT5] = NULL;
+
+   table[MESA_FORMAT_RGB_FXT1] = NULL;
+   table[MESA_FORMAT_RGBA_FXT1] = NULL;
+   table[MESA_FORMAT_RGB_DXT1] = NULL;
+   table[MESA_FORMAT_RGBA_DXT1] = NULL;
+   table[MESA_FORMAT_RGBA_DXT3] = NULL;
+   table[MESA_FORMAT_RGBA_DXT5] = NULL;
+
+   table[MESA_FORMAT_RGBA_FLOAT32] = pack_float_RGBA_FLOAT32;
+   table[MESA_FORMAT_RGBA_FLOAT16] = pack_float_RGBA_FLOAT16;
+   table[MESA_FORMAT_RGB_FLOAT32] = pack_float_RGB_FLOAT32;
+   table[MESA_FORMAT_RGB_FLOAT16] = pack_float_RGB_FLOAT16;
+   table[MESA_FORMAT_A_FLOAT32] = pack_float_A_FLOAT32;
+   table[MESA_FORMAT_A_FLOAT16] = pack_float_A_FLOAT16;
+   table[MESA_FORMAT_L_FLOAT32] = pack_float_L_FLOAT32;
+   table[MESA_FORMAT_L_FLOAT16] = pack_float_L_FLOAT16;
+   table[MESA_FORMAT_LA_FLOAT32] = pack_float_LA_FLOAT32;
+   table[MESA_FORMAT_LA_FLOAT16] = pack_float_LA_FLOAT16;
+
+   table[MESA_FORMAT_I_FLOAT32] = pack_float_L_FLOAT32;
+   table[MESA_FORMAT_I_FLOAT16] = pack_float_L_FLOAT16;
+   table[MESA_FORMAT_R_FLOAT32] = pack_float_L_FLOAT32;
+   table[MESA_FORMAT_R_FLOAT16] = pack_float_L_FLOAT16;
+   table[MESA_FORMAT_RG_FLOAT32] = pack_float_RG_FLOAT32;
+   table[MESA_FORMAT_RG_FLOAT16] = pack_float_RG_FLOAT16;
+
+   /* n/a */
+   table[MESA_FORMAT_RGBA_SINT8] = NULL;
+   table[MESA_FORMAT_RGBA_SINT16] = NULL;
+   table[MESA_FORMAT_RGBA_SINT32] = NULL;
+   table[MESA_FORMAT_RGBA_UINT8] = NULL;
+   table[MESA_FORMAT_RGBA_UINT16] = NULL;
+   table[MESA_FORMAT_RGBA_UINT32] = NULL;
+
+   table[MESA_FORMAT_RGBA_UNORM16] = pack_float_RGBA_16;
+
+   table[MESA_FORMAT_R_SNORM8] = pack_float_R_SNORM8;
+   table[MESA_FORMAT_R8G8_SNORM] = pack_float_R8G8_SNORM;
+   table[MESA_FORMAT_X8B8G8R8_SNORM] = pack_float_X8B8G8R8_SNORM;
+   table[MESA_FORMAT_A8B8G8R8_SNORM] = pack_float_A8B8G8R8_SNORM;
+   table[MESA_FORMAT_R8G8B8A8_SNORM] = pack_float_R8G8B8A8_SNORM;
+   table[MESA_FORMAT_R_SNORM16] = pack_float_R_SNORM16;
+   table[MESA_FORMAT_R16G16_SNORM] = pack_float_R16G16_SNORM;
+   table[MESA_FORMAT_RGB_SNORM16] = pack_float_RGB_SNORM16;
+   table[MESA_FORMAT_RGBA_SNORM16] = pack_float_RGBA_SNORM16;
+   table[MESA_FORMAT_A_SNORM8] = pack_float_A_SNORM8;
+   table[MESA_FORMAT_L_SNORM8] = pack_float_L_SNORM8;
+   table[MESA_FORMAT_L8A8_SNORM] = pack_float_L8A8_SNORM;
+   table[MESA_FORMAT_A8L8_SNORM] = pack_float_A8L8_SNORM;
+   table[MESA_FORMAT_I_SNORM8] = pack_float_L_SNORM8; /* reused */
+   table[MESA_FORMAT_A_SNORM16] = pack_float_A_SNORM16;
+   table[MESA_FORMAT_L_SNORM16] = pack_float_L_SNORM16;
+   table[MESA_FORMAT_LA_SNORM16] = pack_float_LA_SNORM16;
+   table[MESA_FORMAT_I_SNORM16] = pack_float_L_SNORM16; /* reused */
+
+   table[MESA_FORMAT_R9G9B9E5_FLOAT] = pack_float_R9G9B9E5_FLOAT;
+   table[MESA_FORMAT_R11G11B10_FLOAT] = pack_float_R11G11B10_FLOAT;
+
+   table[MESA_FORMAT_B4G4R4X4_UNORM] = pack_float_XRGB4444_UNORM;
+   table[MESA_FORMAT_B5G5R5X1_UNORM] = pack_float_XRGB1555_UNORM;
+   table[MESA_FORMAT_R8G8B8X8_SNORM] = pack_float_XBGR8888_SNORM;
+   table[MESA_FORMAT_R8G8B8X8_SRGB] = pack_float_R8G8B8X8_SRGB;
+   table[MESA_FORMAT_X8B8G8R8_SRGB] = pack_float_X8B8G8R8_SRGB;
+   table[MESA_FORMAT_RGBX_UINT8] = NULL;
+   table[MESA_FORMAT_RGBX_SINT8] = NULL;
+   table[MESA_FORMAT_B10G10R10X2_UNORM] = pack_float_B10G10R10X2_UNORM;
+   table[MESA_FORMAT_RGBX_UNORM16] = pack_float_RGBX_UNORM16;
+   table[MESA_FORMAT_RGBX_SNORM16] = pack_float_RGBX_SNORM16;
+   table[MESA_FORMAT_RGBX_FLOAT16] = pack_float_XBGR16161616_FLOAT;
+   table[MESA_FORMAT_RGBX_UINT16] = NULL;
+   table[MESA_FORMAT_RGBX_SINT16] = NULL;
+   table[MESA_FORMAT_RGBX_FLOAT32] = pack_float_RGBX_FLOAT32;
+   table[MESA_FORMAT_RGBX_UINT32] = NULL;
+   table[MESA_FORMAT_RGBX_SINT32] = NULL;
+
+   table[MESA_FORMAT_R10G10B10A2_UNORM] = pack_float_R10G10B10A2_UNORM;
+
+   table[MESA_FORMAT_G8R8_SNORM] = pack_float_G8R8_SNORM;
+   table[MESA_FORMAT_G16R16_SNORM] = pack_float_G16R16_SNORM;
+
+   table[MESA_FORMAT_B8G8R8X8_SRGB] = pack_float_B8G8R8X8_SRGB;
+   table[MESA_FORMAT_X8R8G8B8_SRGB] = pack_float_X8R8G8B8_SRGB;
 }
 
 
-
 /**
  * Return a function that can pack a GLfloat rgba[4] color.
  */
 gl_pack_float_rgba_func
 _mesa_get_pack_float_rgba_function(mesa_format format)
 {
-   static gl_pack_float_rgba_func table[MESA_FORMAT_COUNT];
-   static GLboolean initialized = GL_FALSE;
-
-   if (!initialized) {
-      memset(table, 0, sizeof(table));
-
-      table[MESA_FORMAT_NONE] = NULL;
-
-      table[MESA_FORMAT_A8B8G8R8_UNORM] = pack_float_A8B8G8R8_UNORM;
-      table[MESA_FORMAT_R8G8B8A8_UNORM] = pack_float_R8G8B8A8_UNORM;
-      table[MESA_FORMAT_B8G8R8A8_UNORM] = pack_float_B8G8R8A8_UNORM;
-      table[MESA_FORMAT_A8R8G8B8_UNORM] = pack_float_A8R8G8B8_UNORM;
-      table[MESA_FORMAT_X8B8G8R8_UNORM] = pack_float_A8B8G8R8_UNORM; /* reused */
-      table[MESA_FORMAT_R8G8B8X8_UNORM] = pack_float_R8G8B8A8_UNORM; /* reused */
-      table[MESA_FORMAT_B8G8R8X8_UNORM] = pack_float_B8G8R8X8_UNORM;
-      table[MESA_FORMAT_X8R8G8B8_UNORM] = pack_float_X8R8G8B8_UNORM;
-      table[MESA_FORMAT_BGR_UNORM8] = pack_float_BGR_UNORM8;
-      table[MESA_FORMAT_RGB_UNORM8] = pack_float_RGB_UNORM8;
-      table[MESA_FORMAT_B5G6R5_UNORM] = pack_float_B5G6R5_UNORM;
-      table[MESA_FORMAT_R5G6B5_UNORM] = pack_float_R5G6B5_UNORM;
-      table[MESA_FORMAT_B4G4R4A4_UNORM] = pack_float_B4G4R4A4_UNORM;
-      table[MESA_FORMAT_A4R4G4B4_UNORM] = pack_float_A4R4G4B4_UNORM;
-      table[MESA_FORMAT_A1B5G5R5_UNORM] = pack_float_A1B5G5R5_UNORM;
-      table[MESA_FORMAT_B5G5R5A1_UNORM] = pack_float_B5G5R5A1_UNORM;
-      table[MESA_FORMAT_A1R5G5B5_UNORM] = pack_float_A1R5G5B5_UNORM;
-
-      table[MESA_FORMAT_L4A4_UNORM] = pack_float_L4A4_UNORM;
-      table[MESA_FORMAT_L8A8_UNORM] = pack_float_L8A8_UNORM;
-      table[MESA_FORMAT_A8L8_UNORM] = pack_float_A8L8_UNORM;
-      table[MESA_FORMAT_L16A16_UNORM] = pack_float_L16A16_UNORM;
-      table[MESA_FORMAT_A16L16_UNORM] = pack_float_A16L16_UNORM;
-      table[MESA_FORMAT_B2G3R3_UNORM] = pack_float_B2G3R3_UNORM;
-      table[MESA_FORMAT_A_UNORM8] = pack_float_A_UNORM8;
-      table[MESA_FORMAT_A_UNORM16] = pack_float_A_UNORM16;
-      table[MESA_FORMAT_L_UNORM8] = pack_float_L_UNORM8;
-      table[MESA_FORMAT_L_UNORM16] = pack_float_L_UNORM16;
-      table[MESA_FORMAT_I_UNORM8] = pack_float_L_UNORM8; /* reuse pack_float_L_UNORM8 */
-      table[MESA_FORMAT_I_UNORM16] = pack_float_L_UNORM16; /* reuse pack_float_L_UNORM16 */
-      table[MESA_FORMAT_YCBCR] = pack_float_YCBCR;
-      table[MESA_FORMAT_YCBCR_REV] = pack_float_YCBCR_REV;
-      table[MESA_FORMAT_R_UNORM8] = pack_float_R_UNORM8;
-      table[MESA_FORMAT_R8G8_UNORM] = pack_float_R8G8_UNORM;
-      table[MESA_FORMAT_G8R8_UNORM] = pack_float_G8R8_UNORM;
-      table[MESA_FORMAT_R_UNORM16] = pack_float_R_UNORM16;
-      table[MESA_FORMAT_R16G16_UNORM] = pack_float_R16G16_UNORM;
-      table[MESA_FORMAT_G16R16_UNORM] = pack_float_G16R16_UNORM;
-      table[MESA_FORMAT_B10G10R10A2_UNORM] = pack_float_B10G10R10A2_UNORM;
-      table[MESA_FORMAT_R10G10B10A2_UINT] = pack_float_R10G10B10A2_UINT;
-
-      /* should never convert RGBA to these formats */
-      table[MESA_FORMAT_S8_UINT_Z24_UNORM] = NULL;
-      table[MESA_FORMAT_Z24_UNORM_S8_UINT] = NULL;
-      table[MESA_FORMAT_Z_UNORM16] = NULL;
-      table[MESA_FORMAT_Z24_UNORM_X8_UINT] = NULL;
-      table[MESA_FORMAT_X8_UINT_Z24_UNORM] = NULL;
-      table[MESA_FORMAT_Z_UNORM32] = NULL;
-      table[MESA_FORMAT_S_UINT8] = NULL;
-
-      table[MESA_FORMAT_BGR_SRGB8] = pack_float_BGR_SRGB8;
-      table[MESA_FORMAT_A8B8G8R8_SRGB] = pack_float_A8B8G8R8_SRGB;
-      table[MESA_FORMAT_B8G8R8A8_SRGB] = pack_float_B8G8R8A8_SRGB;
-      table[MESA_FORMAT_A8R8G8B8_SRGB] = pack_float_A8R8G8B8_SRGB;
-      table[MESA_FORMAT_R8G8B8A8_SRGB] = pack_float_R8G8B8A8_SRGB;
-      table[MESA_FORMAT_L_SRGB8] = pack_float_L_SRGB8;
-      table[MESA_FORMAT_L8A8_SRGB] = pack_float_L8A8_SRGB;
-      table[MESA_FORMAT_A8L8_SRGB] = pack_float_A8L8_SRGB;
-
-      /* n/a */
-      table[MESA_FORMAT_SRGB_DXT1] = NULL;
-      table[MESA_FORMAT_SRGBA_DXT1] = NULL;
-      table[MESA_FORMAT_SRGBA_DXT3] = NULL;
-      table[MESA_FORMAT_SRGBA_DXT5] = NULL;
-
-      table[MESA_FORMAT_RGB_FXT1] = NULL;
-      table[MESA_FORMAT_RGBA_FXT1] = NULL;
-      table[MESA_FORMAT_RGB_DXT1] = NULL;
-      table[MESA_FORMAT_RGBA_DXT1] = NULL;
-      table[MESA_FORMAT_RGBA_DXT3] = NULL;
-      table[MESA_FORMAT_RGBA_DXT5] = NULL;
-
-      table[MESA_FORMAT_RGBA_FLOAT32] = pack_float_RGBA_FLOAT32;
-      table[MESA_FORMAT_RGBA_FLOAT16] = pack_float_RGBA_FLOAT16;
-      table[MESA_FORMAT_RGB_FLOAT32] = pack_float_RGB_FLOAT32;
-      table[MESA_FORMAT_RGB_FLOAT16] = pack_float_RGB_FLOAT16;
-      table[MESA_FORMAT_A_FLOAT32] = pack_float_A_FLOAT32;
-      table[MESA_FORMAT_A_FLOAT16] = pack_float_A_FLOAT16;
-      table[MESA_FORMAT_L_FLOAT32] = pack_float_L_FLOAT32;
-      table[MESA_FORMAT_L_FLOAT16] = pack_float_L_FLOAT16;
-      table[MESA_FORMAT_LA_FLOAT32] = pack_float_LA_FLOAT32;
-      table[MESA_FORMAT_LA_FLOAT16] = pack_float_LA_FLOAT16;
-
-      table[MESA_FORMAT_I_FLOAT32] = pack_float_L_FLOAT32;
-      table[MESA_FORMAT_I_FLOAT16] = pack_float_L_FLOAT16;
-      table[MESA_FORMAT_R_FLOAT32] = pack_float_L_FLOAT32;
-      table[MESA_FORMAT_R_FLOAT16] = pack_float_L_FLOAT16;
-      table[MESA_FORMAT_RG_FLOAT32] = pack_float_RG_FLOAT32;
-      table[MESA_FORMAT_RG_FLOAT16] = pack_float_RG_FLOAT16;
-
-      /* n/a */
-      table[MESA_FORMAT_RGBA_SINT8] = NULL;
-      table[MESA_FORMAT_RGBA_SINT16] = NULL;
-      table[MESA_FORMAT_RGBA_SINT32] = NULL;
-      table[MESA_FORMAT_RGBA_UINT8] = NULL;
-      table[MESA_FORMAT_RGBA_UINT16] = NULL;
-      table[MESA_FORMAT_RGBA_UINT32] = NULL;
-
-      table[MESA_FORMAT_RGBA_UNORM16] = pack_float_RGBA_16;
-
-      table[MESA_FORMAT_R_SNORM8] = pack_float_R_SNORM8;
-      table[MESA_FORMAT_R8G8_SNORM] = pack_float_R8G8_SNORM;
-      table[MESA_FORMAT_X8B8G8R8_SNORM] = pack_float_X8B8G8R8_SNORM;
-      table[MESA_FORMAT_A8B8G8R8_SNORM] = pack_float_A8B8G8R8_SNORM;
-      table[MESA_FORMAT_R8G8B8A8_SNORM] = pack_float_R8G8B8A8_SNORM;
-      table[MESA_FORMAT_R_SNORM16] = pack_float_R_SNORM16;
-      table[MESA_FORMAT_R16G16_SNORM] = pack_float_R16G16_SNORM;
-      table[MESA_FORMAT_RGB_SNORM16] = pack_float_RGB_SNORM16;
-      table[MESA_FORMAT_RGBA_SNORM16] = pack_float_RGBA_SNORM16;
-      table[MESA_FORMAT_A_SNORM8] = pack_float_A_SNORM8;
-      table[MESA_FORMAT_L_SNORM8] = pack_float_L_SNORM8;
-      table[MESA_FORMAT_L8A8_SNORM] = pack_float_L8A8_SNORM;
-      table[MESA_FORMAT_A8L8_SNORM] = pack_float_A8L8_SNORM;
-      table[MESA_FORMAT_I_SNORM8] = pack_float_L_SNORM8; /* reused */
-      table[MESA_FORMAT_A_SNORM16] = pack_float_A_SNORM16;
-      table[MESA_FORMAT_L_SNORM16] = pack_float_L_SNORM16;
-      table[MESA_FORMAT_LA_SNORM16] = pack_float_LA_SNORM16;
-      table[MESA_FORMAT_I_SNORM16] = pack_float_L_SNORM16; /* reused */
-
-      table[MESA_FORMAT_R9G9B9E5_FLOAT] = pack_float_R9G9B9E5_FLOAT;
-      table[MESA_FORMAT_R11G11B10_FLOAT] = pack_float_R11G11B10_FLOAT;
-
-      table[MESA_FORMAT_B4G4R4X4_UNORM] = pack_float_XRGB4444_UNORM;
-      table[MESA_FORMAT_B5G5R5X1_UNORM] = pack_float_XRGB1555_UNORM;
-      table[MESA_FORMAT_R8G8B8X8_SNORM] = pack_float_XBGR8888_SNORM;
-      table[MESA_FORMAT_R8G8B8X8_SRGB] = pack_float_R8G8B8X8_SRGB;
-      table[MESA_FORMAT_X8B8G8R8_SRGB] = pack_float_X8B8G8R8_SRGB;
-      table[MESA_FORMAT_RGBX_UINT8] = NULL;
-      table[MESA_FORMAT_RGBX_SINT8] = NULL;
-      table[MESA_FORMAT_B10G10R10X2_UNORM] = pack_float_B10G10R10X2_UNORM;
-      table[MESA_FORMAT_RGBX_UNORM16] = pack_float_RGBX_UNORM16;
-      table[MESA_FORMAT_RGBX_SNORM16] = pack_float_RGBX_SNORM16;
-      table[MESA_FORMAT_RGBX_FLOAT16] = pack_float_XBGR16161616_FLOAT;
-      table[MESA_FORMAT_RGBX_UINT16] = NULL;
-      table[MESA_FORMAT_RGBX_SINT16] = NULL;
-      table[MESA_FORMAT_RGBX_FLOAT32] = pack_float_RGBX_FLOAT32;
-      table[MESA_FORMAT_RGBX_UINT32] = NULL;
-      table[MESA_FORMAT_RGBX_SINT32] = NULL;
-
-      table[MESA_FORMAT_R10G10B10A2_UNORM] = pack_float_R10G10B10A2_UNORM;
-
-      table[MESA_FORMAT_G8R8_SNORM] = pack_float_G8R8_SNORM;
-      table[MESA_FORMAT_G16R16_SNORM] = pack_float_G16R16_SNORM;
-
-      table[MESA_FORMAT_B8G8R8X8_SRGB] = pack_float_B8G8R8X8_SRGB;
-      table[MESA_FORMAT_X8R8G8B8_SRGB] = pack_float_X8R8G8B8_SRGB;
-
-      initialized = GL_TRUE;
-   }
+   static once_flag flag = ONCE_FLAG_INIT;
 
-   return table[format];
+   call_once(&flag, init_pack_float_rgba_table);
+
+   return pack_float_rgba_table[format];
 }
 
 
 
+static pack_float_rgba_row_func pack_float_rgba_row_table[MESA_FORMAT_COUNT];
+
+
+static void
+init_pack_float_rgba_row_table(void)
+{
+   pack_float_rgba_row_func *table = pack_float_rgba_row_table;
+
+   /* We don't need a special row packing function for each format.
+    * There's a generic fallback which uses a per-pixel packing function.
+    */
+   table[MESA_FORMAT_A8B8G8R8_UNORM] = pack_row_float_A8B8G8R8_UNORM;
+   table[MESA_FORMAT_R8G8B8A8_UNORM] = pack_row_float_R8G8B8A8_UNORM;
+   table[MESA_FORMAT_B8G8R8A8_UNORM] = pack_row_float_B8G8R8A8_UNORM;
+   table[MESA_FORMAT_A8R8G8B8_UNORM] = pack_row_float_A8R8G8B8_UNORM;
+   table[MESA_FORMAT_X8B8G8R8_UNORM] = pack_row_float_A8B8G8R8_UNORM; /* reused */
+   table[MESA_FORMAT_R8G8B8X8_UNORM] = pack_row_float_R8G8B8A8_UNORM; /* reused */
+   table[MESA_FORMAT_B8G8R8X8_UNORM] = pack_row_float_B8G8R8X8_UNORM;
+   table[MESA_FORMAT_X8R8G8B8_UNORM] = pack_row_float_X8R8G8B8_UNORM;
+   table[MESA_FORMAT_BGR_UNORM8] = pack_row_float_BGR_UNORM8;
+   table[MESA_FORMAT_RGB_UNORM8] = pack_row_float_RGB_UNORM8;
+   table[MESA_FORMAT_B5G6R5_UNORM] = pack_row_float_B5G6R5_UNORM;
+   table[MESA_FORMAT_R5G6B5_UNORM] = pack_row_float_R5G6B5_UNORM;
+}
+
+
 static pack_float_rgba_row_func
 get_pack_float_rgba_row_function(mesa_format format)
 {
-   static pack_float_rgba_row_func table[MESA_FORMAT_COUNT];
-   static GLboolean initialized = GL_FALSE;
+   static once_flag flag = ONCE_FLAG_INIT;
 
-   if (!initialized) {
-      /* We don't need a special row packing function for each format.
-       * There's a generic fallback which uses a per-pixel packing function.
-       */
-      memset(table, 0, sizeof(table));
-
-      table[MESA_FORMAT_A8B8G8R8_UNORM] = pack_row_float_A8B8G8R8_UNORM;
-      table[MESA_FORMAT_R8G8B8A8_UNORM] = pack_row_float_R8G8B8A8_UNORM;
-      table[MESA_FORMAT_B8G8R8A8_UNORM] = pack_row_float_B8G8R8A8_UNORM;
-      table[MESA_FORMAT_A8R8G8B8_UNORM] = pack_row_float_A8R8G8B8_UNORM;
-      table[MESA_FORMAT_X8B8G8R8_UNORM] = pack_row_float_A8B8G8R8_UNORM; /* reused */
-      table[MESA_FORMAT_R8G8B8X8_UNORM] = pack_row_float_R8G8B8A8_UNORM; /* reused */
-      table[MESA_FORMAT_B8G8R8X8_UNORM] = pack_row_float_B8G8R8X8_UNORM;
-      table[MESA_FORMAT_X8R8G8B8_UNORM] = pack_row_float_X8R8G8B8_UNORM;
-      table[MESA_FORMAT_BGR_UNORM8] = pack_row_float_BGR_UNORM8;
-      table[MESA_FORMAT_RGB_UNORM8] = pack_row_float_RGB_UNORM8;
-      table[MESA_FORMAT_B5G6R5_UNORM] = pack_row_float_B5G6R5_UNORM;
-      table[MESA_FORMAT_R5G6B5_UNORM] = pack_row_float_R5G6B5_UNORM;
-
-      initialized = GL_TRUE;
-   }
+   call_once(&flag, init_pack_float_rgba_row_table);
 
-   return table[format];
+   return pack_float_rgba_row_table[format];
 }
 
 
 
+static pack_ubyte_rgba_row_func pack_ubyte_rgba_row_table[MESA_FORMAT_COUNT];
+
+
+static void
+init_pack_ubyte_rgba_row_table(void)
+{
+   pack_ubyte_rgba_row_func *table = pack_ubyte_rgba_row_table;
+
+   /* We don't need a special row packing function for each format.
+    * There's a generic fallback which uses a per-pixel packing function.
+    */
+   table[MESA_FORMAT_A8B8G8R8_UNORM] = pack_row_ubyte_A8B8G8R8_UNORM;
+   table[MESA_FORMAT_R8G8B8A8_UNORM] = pack_row_ubyte_R8G8B8A8_UNORM;
+   table[MESA_FORMAT_B8G8R8A8_UNORM] = pack_row_ubyte_B8G8R8A8_UNORM;
+   table[MESA_FORMAT_A8R8G8B8_UNORM] = pack_row_ubyte_A8R8G8B8_UNORM;
+   table[MESA_FORMAT_X8B8G8R8_UNORM] = pack_row_ubyte_A8B8G8R8_UNORM; /* reused */
+   table[MESA_FORMAT_R8G8B8X8_UNORM] = pack_row_ubyte_R8G8B8A8_UNORM; /* reused */
+   table[MESA_FORMAT_B8G8R8X8_UNORM] = pack_row_ubyte_B8G8R8X8_UNORM;
+   table[MESA_FORMAT_X8R8G8B8_UNORM] = pack_row_ubyte_X8R8G8B8_UNORM;
+   table[MESA_FORMAT_BGR_UNORM8] = pack_row_ubyte_BGR_UNORM8;
+   table[MESA_FORMAT_RGB_UNORM8] = pack_row_ubyte_RGB_UNORM8;
+   table[MESA_FORMAT_B5G6R5_UNORM] = pack_row_ubyte_B5G6R5_UNORM;
+   table[MESA_FORMAT_R5G6B5_UNORM] = pack_row_ubyte_R5G6B5_UNORM;
+}
+
+
 static pack_ubyte_rgba_row_func
 get_pack_ubyte_rgba_row_function(mesa_format format)
 {
-   static pack_ubyte_rgba_row_func table[MESA_FORMAT_COUNT];
-   static GLboolean initialized = GL_FALSE;
+   static once_flag flag = ONCE_FLAG_INIT;
 
-   if (!initialized) {
-      /* We don't need a special row packing function for each format.
-       * There's a generic fallback which uses a per-pixel packing function.
-       */
-      memset(table, 0, sizeof(table));
-
-      table[MESA_FORMAT_A8B8G8R8_UNORM] = pack_row_ubyte_A8B8G8R8_UNORM;
-      table[MESA_FORMAT_R8G8B8A8_UNORM] = pack_row_ubyte_R8G8B8A8_UNORM;
-      table[MESA_FORMAT_B8G8R8A8_UNORM] = pack_row_ubyte_B8G8R8A8_UNORM;
-      table[MESA_FORMAT_A8R8G8B8_UNORM] = pack_row_ubyte_A8R8G8B8_UNORM;
-      table[MESA_FORMAT_X8B8G8R8_UNORM] = pack_row_ubyte_A8B8G8R8_UNORM; /* reused */
-      table[MESA_FORMAT_R8G8B8X8_UNORM] = pack_row_ubyte_R8G8B8A8_UNORM; /* reused */
-      table[MESA_FORMAT_B8G8R8X8_UNORM] = pack_row_ubyte_B8G8R8X8_UNORM;
-      table[MESA_FORMAT_X8R8G8B8_UNORM] = pack_row_ubyte_X8R8G8B8_UNORM;
-      table[MESA_FORMAT_BGR_UNORM8] = pack_row_ubyte_BGR_UNORM8;
-      table[MESA_FORMAT_RGB_UNORM8] = pack_row_ubyte_RGB_UNORM8;
-      table[MESA_FORMAT_B5G6R5_UNORM] = pack_row_ubyte_B5G6R5_UNORM;
-      table[MESA_FORMAT_R5G6B5_UNORM] = pack_row_ubyte_R5G6B5_UNORM;
-
-      initialized = GL_TRUE;
-   }
+   call_once(&flag, init_pack_ubyte_rgba_row_table);
 
-   return table[format];
+   return pack_ubyte_rgba_row_table[format];
 }
 
 
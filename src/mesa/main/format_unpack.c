@@ -23,6 +23,7 @@
  */
 
 
+#include "c11/threads.h"
 #include "colormac.h"
 #include "format_unpack.h"
 #include "macros.h"
@@ -2365,239 +2366,246 @@ unpack_X8R8G8B8_SRGB(const void *src, GLfloat dst[][4], GLuint n)
    }
 }
 
+static unpack_rgba_func unpack_rgba_table[MESA_FORMAT_COUNT];
+
+
+static void
+init_unpack_rgba_table(void)
+{
+   unpack_rgba_func *table = unpack_rgba_table;
+
+   table[MESA_FORMAT_NONE] = NULL;
+
+   table[MESA_FORMAT_A8B8G8R8_UNORM] = unpack_A8B8G8R8_UNORM;
+   table[MESA_FORMAT_R8G8B8A8_UNORM] = unpack_R8G8B8A8_UNORM;
+   table[MESA_FORMAT_B8G8R8A8_UNORM] = unpack_B8G8R8A8_UNORM;
+   table[MESA_FORMAT_A8R8G8B8_UNORM] = unpack_A8R8G8B8_UNORM;
+   table[MESA_FORMAT_X8B8G8R8_UNORM] = unpack_RGBX8888;
+   table[MESA_FORMAT_R8G8B8X8_UNORM] = unpack_RGBX8888_REV;
+   table[MESA_FORMAT_B8G8R8X8_UNORM] = unpack_B8G8R8X8_UNORM;
+   table[MESA_FORMAT_X8R8G8B8_UNORM] = unpack_X8R8G8B8_UNORM;
+   table[MESA_FORMAT_BGR_UNORM8] = unpack_BGR_UNORM8;
+   table[MESA_FORMAT_RGB_UNORM8] = unpack_RGB_UNORM8;
+   table[MESA_FORMAT_B5G6R5_UNORM] = unpack_B5G6R5_UNORM;
+   table[MESA_FORMAT_R5G6B5_UNORM] = unpack_R5G6B5_UNORM;
+   table[MESA_FORMAT_B4G4R4A4_UNORM] = unpack_B4G4R4A4_UNORM;
+   table[MESA_FORMAT_A4R4G4B4_UNORM] = unpack_A4R4G4B4_UNORM;
+   table[MESA_FORMAT_A1B5G5R5_UNORM] = unpack_A1B5G5R5_UNORM;
+   table[MESA_FORMAT_B5G5R5A1_UNORM] = unpack_B5G5R5A1_UNORM;
+   table[MESA_FORMAT_A1R5G5B5_UNORM] = unpack_A1R5G5B5_UNORM;
+   table[MESA_FORMAT_L4A4_UNORM] = unpack_L4A4_UNORM;
+   table[MESA_FORMAT_L8A8_UNORM] = unpack_L8A8_UNORM;
+   table[MESA_FORMAT_A8L8_UNORM] = unpack_A8L8_UNORM;
+   table[MESA_FORMAT_L16A16_UNORM] = unpack_L16A16_UNORM;
+   table[MESA_FORMAT_A16L16_UNORM] = unpack_A16L16_UNORM;
+   table[MESA_FORMAT_B2G3R3_UNORM] = unpack_B2G3R3_UNORM;
+   table[MESA_FORMAT_A_UNORM8] = unpack_A_UNORM8;
+   table[MESA_FORMAT_A_UNORM16] = unpack_A_UNORM16;
+   table[MESA_FORMAT_L_UNORM8] = unpack_L_UNORM8;
+   table[MESA_FORMAT_L_UNORM16] = unpack_L_UNORM16;
+   table[MESA_FORMAT_I_UNORM8] = unpack_I_UNORM8;
+   table[MESA_FORMAT_I_UNORM16] = unpack_I_UNORM16;
+   table[MESA_FORMAT_YCBCR] = unpack_YCBCR;
+   table[MESA_FORMAT_YCBCR_REV] = unpack_YCBCR_REV;
+   table[MESA_FORMAT_R_UNORM8] = unpack_R_UNORM8;
+   table[MESA_FORMAT_R8G8_UNORM] = unpack_R8G8_UNORM;
+   table[MESA_FORMAT_G8R8_UNORM] = unpack_G8R8_UNORM;
+   table[MESA_FORMAT_R_UNORM16] = unpack_R_UNORM16;
+   table[MESA_FORMAT_R16G16_UNORM] = unpack_R16G16_UNORM;
+   table[MESA_FORMAT_G16R16_UNORM] = unpack_G16R16_UNORM;
+   table[MESA_FORMAT_B10G10R10A2_UNORM] = unpack_B10G10R10A2_UNORM;
+   table[MESA_FORMAT_B10G10R10A2_UINT] = unpack_B10G10R10A2_UINT;
+   table[MESA_FORMAT_R10G10B10A2_UINT] = unpack_R10G10B10A2_UINT;
+   table[MESA_FORMAT_S8_UINT_Z24_UNORM] = unpack_S8_UINT_Z24_UNORM;
+   table[MESA_FORMAT_Z24_UNORM_S8_UINT] = unpack_Z24_UNORM_S8_UINT;
+   table[MESA_FORMAT_Z_UNORM16] = unpack_Z_UNORM16;
+   table[MESA_FORMAT_Z24_UNORM_X8_UINT] = unpack_Z24_UNORM_X8_UINT;
+   table[MESA_FORMAT_X8_UINT_Z24_UNORM] = unpack_X8_UINT_Z24_UNORM;
+   table[MESA_FORMAT_Z_UNORM32] = unpack_Z_UNORM32;
+   table[MESA_FORMAT_S_UINT8] = unpack_S8;
+   table[MESA_FORMAT_BGR_SRGB8] = unpack_BGR_SRGB8;
+   table[MESA_FORMAT_A8B8G8R8_SRGB] = unpack_A8B8G8R8_SRGB;
+   table[MESA_FORMAT_B8G8R8A8_SRGB] = unpack_B8G8R8A8_SRGB;
+   table[MESA_FORMAT_A8R8G8B8_SRGB] = unpack_A8R8G8B8_SRGB;
+   table[MESA_FORMAT_R8G8B8A8_SRGB] = unpack_R8G8B8A8_SRGB;
+   table[MESA_FORMAT_L_SRGB8] = unpack_L_SRGB8;
+   table[MESA_FORMAT_L8A8_SRGB] = unpack_L8A8_SRGB;
+   table[MESA_FORMAT_A8L8_SRGB] = unpack_A8L8_SRGB;
+   table[MESA_FORMAT_SRGB_DXT1] = unpack_SRGB_DXT1;
+   table[MESA_FORMAT_SRGBA_DXT1] = unpack_SRGBA_DXT1;
+   table[MESA_FORMAT_SRGBA_DXT3] = unpack_SRGBA_DXT3;
+   table[MESA_FORMAT_SRGBA_DXT5] = unpack_SRGBA_DXT5;
+
+   table[MESA_FORMAT_RGB_FXT1] = unpack_RGB_FXT1;
+   table[MESA_FORMAT_RGBA_FXT1] = unpack_RGBA_FXT1;
+   table[MESA_FORMAT_RGB_DXT1] = unpack_RGB_DXT1;
+   table[MESA_FORMAT_RGBA_DXT1] = unpack_RGBA_DXT1;
+   table[MESA_FORMAT_RGBA_DXT3] = unpack_RGBA_DXT3;
+   table[MESA_FORMAT_RGBA_DXT5] = unpack_RGBA_DXT5;
+
+   table[MESA_FORMAT_RGBA_FLOAT32] = unpack_RGBA_FLOAT32;
+   table[MESA_FORMAT_RGBA_FLOAT16] = unpack_RGBA_FLOAT16;
+   table[MESA_FORMAT_RGB_FLOAT32] = unpack_RGB_FLOAT32;
+   table[MESA_FORMAT_RGB_FLOAT16] = unpack_RGB_FLOAT16;
+   table[MESA_FORMAT_A_FLOAT32] = unpack_A_FLOAT32;
+   table[MESA_FORMAT_A_FLOAT16] = unpack_A_FLOAT16;
+   table[MESA_FORMAT_L_FLOAT32] = unpack_L_FLOAT32;
+   table[MESA_FORMAT_L_FLOAT16] = unpack_L_FLOAT16;
+   table[MESA_FORMAT_LA_FLOAT32] = unpack_LA_FLOAT32;
+   table[MESA_FORMAT_LA_FLOAT16] = unpack_LA_FLOAT16;
+   table[MESA_FORMAT_I_FLOAT32] = unpack_I_FLOAT32;
+   table[MESA_FORMAT_I_FLOAT16] = unpack_I_FLOAT16;
+   table[MESA_FORMAT_R_FLOAT32] = unpack_R_FLOAT32;
+   table[MESA_FORMAT_R_FLOAT16] = unpack_R_FLOAT16;
+   table[MESA_FORMAT_RG_FLOAT32] = unpack_RG_FLOAT32;
+   table[MESA_FORMAT_RG_FLOAT16] = unpack_RG_FLOAT16;
+
+   table[MESA_FORMAT_A_UINT8] = unpack_ALPHA_UINT8;
+   table[MESA_FORMAT_A_UINT16] = unpack_ALPHA_UINT16;
+   table[MESA_FORMAT_A_UINT32] = unpack_ALPHA_UINT32;
+   table[MESA_FORMAT_A_SINT8] = unpack_ALPHA_INT8;
+   table[MESA_FORMAT_A_SINT16] = unpack_ALPHA_INT16;
+   table[MESA_FORMAT_A_SINT32] = unpack_ALPHA_INT32;
+
+   table[MESA_FORMAT_I_UINT8] = unpack_INTENSITY_UINT8;
+   table[MESA_FORMAT_I_UINT16] = unpack_INTENSITY_UINT16;
+   table[MESA_FORMAT_I_UINT32] = unpack_INTENSITY_UINT32;
+   table[MESA_FORMAT_I_SINT8] = unpack_INTENSITY_INT8;
+   table[MESA_FORMAT_I_SINT16] = unpack_INTENSITY_INT16;
+   table[MESA_FORMAT_I_SINT32] = unpack_INTENSITY_INT32;
+
+   table[MESA_FORMAT_L_UINT8] = unpack_LUMINANCE_UINT8;
+   table[MESA_FORMAT_L_UINT16] = unpack_LUMINANCE_UINT16;
+   table[MESA_FORMAT_L_UINT32] = unpack_LUMINANCE_UINT32;
+   table[MESA_FORMAT_L_SINT8] = unpack_LUMINANCE_INT8;
+   table[MESA_FORMAT_L_SINT16] = unpack_LUMINANCE_INT16;
+   table[MESA_FORMAT_L_SINT32] = unpack_LUMINANCE_INT32;
+
+   table[MESA_FORMAT_LA_UINT8] = unpack_LUMINANCE_ALPHA_UINT8;
+   table[MESA_FORMAT_LA_UINT16] = unpack_LUMINANCE_ALPHA_UINT16;
+   table[MESA_FORMAT_LA_UINT32] = unpack_LUMINANCE_ALPHA_UINT32;
+   table[MESA_FORMAT_LA_SINT8] = unpack_LUMINANCE_ALPHA_INT8;
+   table[MESA_FORMAT_LA_SINT16] = unpack_LUMINANCE_ALPHA_INT16;
+   table[MESA_FORMAT_LA_SINT32] = unpack_LUMINANCE_ALPHA_INT32;
+
+   table[MESA_FORMAT_R_SINT8] = unpack_R_INT8;
+   table[MESA_FORMAT_RG_SINT8] = unpack_RG_INT8;
+   table[MESA_FORMAT_RGB_SINT8] = unpack_RGB_INT8;
+   table[MESA_FORMAT_RGBA_SINT8] = unpack_RGBA_INT8;
+   table[MESA_FORMAT_R_SINT16] = unpack_R_INT16;
+   table[MESA_FORMAT_RG_SINT16] = unpack_RG_INT16;
+   table[MESA_FORMAT_RGB_SINT16] = unpack_RGB_INT16;
+   table[MESA_FORMAT_RGBA_SINT16] = unpack_RGBA_INT16;
+   table[MESA_FORMAT_R_SINT32] = unpack_R_INT32;
+   table[MESA_FORMAT_RG_SINT32] = unpack_RG_INT32;
+   table[MESA_FORMAT_RGB_SINT32] = unpack_RGB_INT32;
+   table[MESA_FORMAT_RGBA_SINT32] = unpack_RGBA_INT32;
+   table[MESA_FORMAT_R_UINT8] = unpack_R_UINT8;
+   table[MESA_FORMAT_RG_UINT8] = unpack_RG_UINT8;
+   table[MESA_FORMAT_RGB_UINT8] = unpack_RGB_UINT8;
+   table[MESA_FORMAT_RGBA_UINT8] = unpack_RGBA_UINT8;
+   table[MESA_FORMAT_R_UINT16] = unpack_R_UINT16;
+   table[MESA_FORMAT_RG_UINT16] = unpack_RG_UINT16;
+   table[MESA_FORMAT_RGB_UINT16] = unpack_RGB_UINT16;
+   table[MESA_FORMAT_RGBA_UINT16] = unpack_RGBA_UINT16;
+   table[MESA_FORMAT_R_UINT32] = unpack_R_UINT32;
+   table[MESA_FORMAT_RG_UINT32] = unpack_RG_UINT32;
+   table[MESA_FORMAT_RGB_UINT32] = unpack_RGB_UINT32;
+   table[MESA_FORMAT_RGBA_UINT32] = unpack_RGBA_UINT32;
+
+   table[MESA_FORMAT_R_SNORM8] = unpack_R_SNORM8;
+   table[MESA_FORMAT_R8G8_SNORM] = unpack_R8G8_SNORM;
+   table[MESA_FORMAT_X8B8G8R8_SNORM] = unpack_X8B8G8R8_SNORM;
+   table[MESA_FORMAT_A8B8G8R8_SNORM] = unpack_A8B8G8R8_SNORM;
+   table[MESA_FORMAT_R8G8B8A8_SNORM] = unpack_R8G8B8A8_SNORM;
+   table[MESA_FORMAT_R_SNORM16] = unpack_R_SNORM16;
+   table[MESA_FORMAT_R16G16_SNORM] = unpack_R16G16_SNORM;
+   table[MESA_FORMAT_RGB_SNORM16] = unpack_RGB_SNORM16;
+   table[MESA_FORMAT_RGBA_SNORM16] = unpack_RGBA_SNORM16;
+   table[MESA_FORMAT_RGBA_UNORM16] = unpack_RGBA_16;
+
+   table[MESA_FORMAT_R_RGTC1_UNORM] = unpack_RED_RGTC1;
+   table[MESA_FORMAT_R_RGTC1_SNORM] = unpack_SIGNED_RED_RGTC1;
+   table[MESA_FORMAT_RG_RGTC2_UNORM] = unpack_RG_RGTC2;
+   table[MESA_FORMAT_RG_RGTC2_SNORM] = unpack_SIGNED_RG_RGTC2;
+
+   table[MESA_FORMAT_L_LATC1_UNORM] = unpack_L_LATC1;
+   table[MESA_FORMAT_L_LATC1_SNORM] = unpack_SIGNED_L_LATC1;
+   table[MESA_FORMAT_LA_LATC2_UNORM] = unpack_LA_LATC2;
+   table[MESA_FORMAT_LA_LATC2_SNORM] = unpack_SIGNED_LA_LATC2;
+
+   table[MESA_FORMAT_ETC1_RGB8] = unpack_ETC1_RGB8;
+   table[MESA_FORMAT_ETC2_RGB8] = unpack_ETC2_RGB8;
+   table[MESA_FORMAT_ETC2_SRGB8] = unpack_ETC2_SRGB8;
+   table[MESA_FORMAT_ETC2_RGBA8_EAC] = unpack_ETC2_RGBA8_EAC;
+   table[MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC] = unpack_ETC2_SRGB8_ALPHA8_EAC;
+   table[MESA_FORMAT_ETC2_R11_EAC] = unpack_ETC2_R11_EAC;
+   table[MESA_FORMAT_ETC2_RG11_EAC] = unpack_ETC2_RG11_EAC;
+   table[MESA_FORMAT_ETC2_SIGNED_R11_EAC] = unpack_ETC2_SIGNED_R11_EAC;
+   table[MESA_FORMAT_ETC2_SIGNED_RG11_EAC] = unpack_ETC2_SIGNED_RG11_EAC;
+   table[MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1] =
+      unpack_ETC2_RGB8_PUNCHTHROUGH_ALPHA1;
+   table[MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1] =
+      unpack_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1;
+   table[MESA_FORMAT_A_SNORM8] = unpack_A_SNORM8;
+   table[MESA_FORMAT_L_SNORM8] = unpack_L_SNORM8;
+   table[MESA_FORMAT_L8A8_SNORM] = unpack_L8A8_SNORM;
+   table[MESA_FORMAT_A8L8_SNORM] = unpack_A8L8_SNORM;
+   table[MESA_FORMAT_I_SNORM8] = unpack_I_SNORM8;
+   table[MESA_FORMAT_A_SNORM16] = unpack_A_SNORM16;
+   table[MESA_FORMAT_L_SNORM16] = unpack_L_SNORM16;
+   table[MESA_FORMAT_LA_SNORM16] = unpack_LA_SNORM16;
+   table[MESA_FORMAT_I_SNORM16] = unpack_I_SNORM16;
+
+   table[MESA_FORMAT_R9G9B9E5_FLOAT] = unpack_R9G9B9E5_FLOAT;
+   table[MESA_FORMAT_R11G11B10_FLOAT] = unpack_R11G11B10_FLOAT;
+
+   table[MESA_FORMAT_Z_FLOAT32] = unpack_Z_FLOAT32;
+   table[MESA_FORMAT_Z32_FLOAT_S8X24_UINT] = unpack_Z32_FLOAT_S8X24_UINT;
+
+   table[MESA_FORMAT_B4G4R4X4_UNORM] = unpack_XRGB4444_UNORM;
+   table[MESA_FORMAT_B5G5R5X1_UNORM] = unpack_XRGB1555_UNORM;
+   table[MESA_FORMAT_R8G8B8X8_SNORM] = unpack_R8G8B8X8_SNORM;
+   table[MESA_FORMAT_R8G8B8X8_SRGB] = unpack_R8G8B8X8_SRGB;
+   table[MESA_FORMAT_X8B8G8R8_SRGB] = unpack_X8B8G8R8_SRGB;
+   table[MESA_FORMAT_RGBX_UINT8] = unpack_XBGR8888_UINT;
+   table[MESA_FORMAT_RGBX_SINT8] = unpack_XBGR8888_SINT;
+   table[MESA_FORMAT_B10G10R10X2_UNORM] = unpack_B10G10R10X2_UNORM;
+   table[MESA_FORMAT_RGBX_UNORM16] = unpack_RGBX_UNORM16;
+   table[MESA_FORMAT_RGBX_SNORM16] = unpack_RGBX_SNORM16;
+   table[MESA_FORMAT_RGBX_FLOAT16] = unpack_XBGR16161616_FLOAT;
+   table[MESA_FORMAT_RGBX_UINT16] = unpack_XBGR16161616_UINT;
+   table[MESA_FORMAT_RGBX_SINT16] = unpack_XBGR16161616_SINT;
+   table[MESA_FORMAT_RGBX_FLOAT32] = unpack_RGBX_FLOAT32;
+   table[MESA_FORMAT_RGBX_UINT32] = unpack_XBGR32323232_UINT;
+   table[MESA_FORMAT_RGBX_SINT32] = unpack_XBGR32323232_SINT;
+
+   table[MESA_FORMAT_R10G10B10A2_UNORM] = unpack_R10G10B10A2_UNORM;
+
+   table[MESA_FORMAT_G8R8_SNORM] = unpack_G8R8_SNORM;
+   table[MESA_FORMAT_G16R16_SNORM] = unpack_G16R16_SNORM;
+
+   table[MESA_FORMAT_B8G8R8X8_SRGB] = unpack_B8G8R8X8_SRGB;
+   table[MESA_FORMAT_X8R8G8B8_SRGB] = unpack_X8R8G8B8_SRGB;
+}
+
+
 /**
  * Return the unpacker function for the given format.
  */
 static unpack_rgba_func
 get_unpack_rgba_function(mesa_format format)
 {
-   static unpack_rgba_func table[MESA_FORMAT_COUNT];
-   static GLboolean initialized = GL_FALSE;
-
-   if (!initialized) {
-      table[MESA_FORMAT_NONE] = NULL;
-
-      table[MESA_FORMAT_A8B8G8R8_UNORM] = unpack_A8B8G8R8_UNORM;
-      table[MESA_FORMAT_R8G8B8A8_UNORM] = unpack_R8G8B8A8_UNORM;
-      table[MESA_FORMAT_B8G8R8A8_UNORM] = unpack_B8G8R8A8_UNORM;
-      table[MESA_FORMAT_A8R8G8B8_UNORM] = unpack_A8R8G8B8_UNORM;
-      table[MESA_FORMAT_X8B8G8R8_UNORM] = unpack_RGBX8888;
-      table[MESA_FORMAT_R8G8B8X8_UNORM] = unpack_RGBX8888_REV;
-      table[MESA_FORMAT_B8G8R8X8_UNORM] = unpack_B8G8R8X8_UNORM;
-      table[MESA_FORMAT_X8R8G8B8_UNORM] = unpack_X8R8G8B8_UNORM;
-      table[MESA_FORMAT_BGR_UNORM8] = unpack_BGR_UNORM8;
-      table[MESA_FORMAT_RGB_UNORM8] = unpack_RGB_UNORM8;
-      table[MESA_FORMAT_B5G6R5_UNORM] = unpack_B5G6R5_UNORM;
-      table[MESA_FORMAT_R5G6B5_UNORM] = unpack_R5G6B5_UNORM;
-      table[MESA_FORMAT_B4G4R4A4_UNORM] = unpack_B4G4R4A4_UNORM;
-      table[MESA_FORMAT_A4R4G4B4_UNORM] = unpack_A4R4G4B4_UNORM;
-      table[MESA_FORMAT_A1B5G5R5_UNORM] = unpack_A1B5G5R5_UNORM;
-      table[MESA_FORMAT_B5G5R5A1_UNORM] = unpack_B5G5R5A1_UNORM;
-      table[MESA_FORMAT_A1R5G5B5_UNORM] = unpack_A1R5G5B5_UNORM;
-      table[MESA_FORMAT_L4A4_UNORM] = unpack_L4A4_UNORM;
-      table[MESA_FORMAT_L8A8_UNORM] = unpack_L8A8_UNORM;
-      table[MESA_FORMAT_A8L8_UNORM] = unpack_A8L8_UNORM;
-      table[MESA_FORMAT_L16A16_UNORM] = unpack_L16A16_UNORM;
-      table[MESA_FORMAT_A16L16_UNORM] = unpack_A16L16_UNORM;
-      table[MESA_FORMAT_B2G3R3_UNORM] = unpack_B2G3R3_UNORM;
-      table[MESA_FORMAT_A_UNORM8] = unpack_A_UNORM8;
-      table[MESA_FORMAT_A_UNORM16] = unpack_A_UNORM16;
-      table[MESA_FORMAT_L_UNORM8] = unpack_L_UNORM8;
-      table[MESA_FORMAT_L_UNORM16] = unpack_L_UNORM16;
-      table[MESA_FORMAT_I_UNORM8] = unpack_I_UNORM8;
-      table[MESA_FORMAT_I_UNORM16] = unpack_I_UNORM16;
-      table[MESA_FORMAT_YCBCR] = unpack_YCBCR;
-      table[MESA_FORMAT_YCBCR_REV] = unpack_YCBCR_REV;
-      table[MESA_FORMAT_R_UNORM8] = unpack_R_UNORM8;
-      table[MESA_FORMAT_R8G8_UNORM] = unpack_R8G8_UNORM;
-      table[MESA_FORMAT_G8R8_UNORM] = unpack_G8R8_UNORM;
-      table[MESA_FORMAT_R_UNORM16] = unpack_R_UNORM16;
-      table[MESA_FORMAT_R16G16_UNORM] = unpack_R16G16_UNORM;
-      table[MESA_FORMAT_G16R16_UNORM] = unpack_G16R16_UNORM;
-      table[MESA_FORMAT_B10G10R10A2_UNORM] = unpack_B10G10R10A2_UNORM;
-      table[MESA_FORMAT_B10G10R10A2_UINT] = unpack_B10G10R10A2_UINT;
-      table[MESA_FORMAT_R10G10B10A2_UINT] = unpack_R10G10B10A2_UINT;
-      table[MESA_FORMAT_S8_UINT_Z24_UNORM] = unpack_S8_UINT_Z24_UNORM;
-      table[MESA_FORMAT_Z24_UNORM_S8_UINT] = unpack_Z24_UNORM_S8_UINT;
-      table[MESA_FORMAT_Z_UNORM16] = unpack_Z_UNORM16;
-      table[MESA_FORMAT_Z24_UNORM_X8_UINT] = unpack_Z24_UNORM_X8_UINT;
-      table[MESA_FORMAT_X8_UINT_Z24_UNORM] = unpack_X8_UINT_Z24_UNORM;
-      table[MESA_FORMAT_Z_UNORM32] = unpack_Z_UNORM32;
-      table[MESA_FORMAT_S_UINT8] = unpack_S8;
-      table[MESA_FORMAT_BGR_SRGB8] = unpack_BGR_SRGB8;
-      table[MESA_FORMAT_A8B8G8R8_SRGB] = unpack_A8B8G8R8_SRGB;
-      table[MESA_FORMAT_B8G8R8A8_SRGB] = unpack_B8G8R8A8_SRGB;
-      table[MESA_FORMAT_A8R8G8B8_SRGB] = unpack_A8R8G8B8_SRGB;
-      table[MESA_FORMAT_R8G8B8A8_SRGB] = unpack_R8G8B8A8_SRGB;
-      table[MESA_FORMAT_L_SRGB8] = unpack_L_SRGB8;
-      table[MESA_FORMAT_L8A8_SRGB] = unpack_L8A8_SRGB;
-      table[MESA_FORMAT_A8L8_SRGB] = unpack_A8L8_SRGB;
-      table[MESA_FORMAT_SRGB_DXT1] = unpack_SRGB_DXT1;
-      table[MESA_FORMAT_SRGBA_DXT1] = unpack_SRGBA_DXT1;
-      table[MESA_FORMAT_SRGBA_DXT3] = unpack_SRGBA_DXT3;
-      table[MESA_FORMAT_SRGBA_DXT5] = unpack_SRGBA_DXT5;
-
-      table[MESA_FORMAT_RGB_FXT1] = unpack_RGB_FXT1;
-      table[MESA_FORMAT_RGBA_FXT1] = unpack_RGBA_FXT1;
-      table[MESA_FORMAT_RGB_DXT1] = unpack_RGB_DXT1;
-      table[MESA_FORMAT_RGBA_DXT1] = unpack_RGBA_DXT1;
-      table[MESA_FORMAT_RGBA_DXT3] = unpack_RGBA_DXT3;
-      table[MESA_FORMAT_RGBA_DXT5] = unpack_RGBA_DXT5;
-
-      table[MESA_FORMAT_RGBA_FLOAT32] = unpack_RGBA_FLOAT32;
-      table[MESA_FORMAT_RGBA_FLOAT16] = unpack_RGBA_FLOAT16;
-      table[MESA_FORMAT_RGB_FLOAT32] = unpack_RGB_FLOAT32;
-      table[MESA_FORMAT_RGB_FLOAT16] = unpack_RGB_FLOAT16;
-      table[MESA_FORMAT_A_FLOAT32] = unpack_A_FLOAT32;
-      table[MESA_FORMAT_A_FLOAT16] = unpack_A_FLOAT16;
-      table[MESA_FORMAT_L_FLOAT32] = unpack_L_FLOAT32;
-      table[MESA_FORMAT_L_FLOAT16] = unpack_L_FLOAT16;
-      table[MESA_FORMAT_LA_FLOAT32] = unpack_LA_FLOAT32;
-      table[MESA_FORMAT_LA_FLOAT16] = unpack_LA_FLOAT16;
-      table[MESA_FORMAT_I_FLOAT32] = unpack_I_FLOAT32;
-      table[MESA_FORMAT_I_FLOAT16] = unpack_I_FLOAT16;
-      table[MESA_FORMAT_R_FLOAT32] = unpack_R_FLOAT32;
-      table[MESA_FORMAT_R_FLOAT16] = unpack_R_FLOAT16;
-      table[MESA_FORMAT_RG_FLOAT32] = unpack_RG_FLOAT32;
-      table[MESA_FORMAT_RG_FLOAT16] = unpack_RG_FLOAT16;
-
-      table[MESA_FORMAT_A_UINT8] = unpack_ALPHA_UINT8;
-      table[MESA_FORMAT_A_UINT16] = unpack_ALPHA_UINT16;
-      table[MESA_FORMAT_A_UINT32] = unpack_ALPHA_UINT32;
-      table[MESA_FORMAT_A_SINT8] = unpack_ALPHA_INT8;
-      table[MESA_FORMAT_A_SINT16] = unpack_ALPHA_INT16;
-      table[MESA_FORMAT_A_SINT32] = unpack_ALPHA_INT32;
-
-      table[MESA_FORMAT_I_UINT8] = unpack_INTENSITY_UINT8;
-      table[MESA_FORMAT_I_UINT16] = unpack_INTENSITY_UINT16;
-      table[MESA_FORMAT_I_UINT32] = unpack_INTENSITY_UINT32;
-      table[MESA_FORMAT_I_SINT8] = unpack_INTENSITY_INT8;
-      table[MESA_FORMAT_I_SINT16] = unpack_INTENSITY_INT16;
-      table[MESA_FORMAT_I_SINT32] = unpack_INTENSITY_INT32;
-
-      table[MESA_FORMAT_L_UINT8] = unpack_LUMINANCE_UINT8;
-      table[MESA_FORMAT_L_UINT16] = unpack_LUMINANCE_UINT16;
-      table[MESA_FORMAT_L_UINT32] = unpack_LUMINANCE_UINT32;
-      table[MESA_FORMAT_L_SINT8] = unpack_LUMINANCE_INT8;
-      table[MESA_FORMAT_L_SINT16] = unpack_LUMINANCE_INT16;
-      table[MESA_FORMAT_L_SINT32] = unpack_LUMINANCE_INT32;
-
-      table[MESA_FORMAT_LA_UINT8] = unpack_LUMINANCE_ALPHA_UINT8;
-      table[MESA_FORMAT_LA_UINT16] = unpack_LUMINANCE_ALPHA_UINT16;
-      table[MESA_FORMAT_LA_UINT32] = unpack_LUMINANCE_ALPHA_UINT32;
-      table[MESA_FORMAT_LA_SINT8] = unpack_LUMINANCE_ALPHA_INT8;
-      table[MESA_FORMAT_LA_SINT16] = unpack_LUMINANCE_ALPHA_INT16;
-      table[MESA_FORMAT_LA_SINT32] = unpack_LUMINANCE_ALPHA_INT32;
-
-      table[MESA_FORMAT_R_SINT8] = unpack_R_INT8;
-      table[MESA_FORMAT_RG_SINT8] = unpack_RG_INT8;
-      table[MESA_FORMAT_RGB_SINT8] = unpack_RGB_INT8;
-      table[MESA_FORMAT_RGBA_SINT8] = unpack_RGBA_INT8;
-      table[MESA_FORMAT_R_SINT16] = unpack_R_INT16;
-      table[MESA_FORMAT_RG_SINT16] = unpack_RG_INT16;
-      table[MESA_FORMAT_RGB_SINT16] = unpack_RGB_INT16;
-      table[MESA_FORMAT_RGBA_SINT16] = unpack_RGBA_INT16;
-      table[MESA_FORMAT_R_SINT32] = unpack_R_INT32;
-      table[MESA_FORMAT_RG_SINT32] = unpack_RG_INT32;
-      table[MESA_FORMAT_RGB_SINT32] = unpack_RGB_INT32;
-      table[MESA_FORMAT_RGBA_SINT32] = unpack_RGBA_INT32;
-      table[MESA_FORMAT_R_UINT8] = unpack_R_UINT8;
-      table[MESA_FORMAT_RG_UINT8] = unpack_RG_UINT8;
-      table[MESA_FORMAT_RGB_UINT8] = unpack_RGB_UINT8;
-      table[MESA_FORMAT_RGBA_UINT8] = unpack_RGBA_UINT8;
-      table[MESA_FORMAT_R_UINT16] = unpack_R_UINT16;
-      table[MESA_FORMAT_RG_UINT16] = unpack_RG_UINT16;
-      table[MESA_FORMAT_RGB_UINT16] = unpack_RGB_UINT16;
-      table[MESA_FORMAT_RGBA_UINT16] = unpack_RGBA_UINT16;
-      table[MESA_FORMAT_R_UINT32] = unpack_R_UINT32;
-      table[MESA_FORMAT_RG_UINT32] = unpack_RG_UINT32;
-      table[MESA_FORMAT_RGB_UINT32] = unpack_RGB_UINT32;
-      table[MESA_FORMAT_RGBA_UINT32] = unpack_RGBA_UINT32;
-
-      table[MESA_FORMAT_R_SNORM8] = unpack_R_SNORM8;
-      table[MESA_FORMAT_R8G8_SNORM] = unpack_R8G8_SNORM;
-      table[MESA_FORMAT_X8B8G8R8_SNORM] = unpack_X8B8G8R8_SNORM;
-      table[MESA_FORMAT_A8B8G8R8_SNORM] = unpack_A8B8G8R8_SNORM;
-      table[MESA_FORMAT_R8G8B8A8_SNORM] = unpack_R8G8B8A8_SNORM;
-      table[MESA_FORMAT_R_SNORM16] = unpack_R_SNORM16;
-      table[MESA_FORMAT_R16G16_SNORM] = unpack_R16G16_SNORM;
-      table[MESA_FORMAT_RGB_SNORM16] = unpack_RGB_SNORM16;
-      table[MESA_FORMAT_RGBA_SNORM16] = unpack_RGBA_SNORM16;
-      table[MESA_FORMAT_RGBA_UNORM16] = unpack_RGBA_16;
-
-      table[MESA_FORMAT_R_RGTC1_UNORM] = unpack_RED_RGTC1;
-      table[MESA_FORMAT_R_RGTC1_SNORM] = unpack_SIGNED_RED_RGTC1;
-      table[MESA_FORMAT_RG_RGTC2_UNORM] = unpack_RG_RGTC2;
-      table[MESA_FORMAT_RG_RGTC2_SNORM] = unpack_SIGNED_RG_RGTC2;
-
-      table[MESA_FORMAT_L_LATC1_UNORM] = unpack_L_LATC1;
-      table[MESA_FORMAT_L_LATC1_SNORM] = unpack_SIGNED_L_LATC1;
-      table[MESA_FORMAT_LA_LATC2_UNORM] = unpack_LA_LATC2;
-      table[MESA_FORMAT_LA_LATC2_SNORM] = unpack_SIGNED_LA_LATC2;
-
-      table[MESA_FORMAT_ETC1_RGB8] = unpack_ETC1_RGB8;
-      table[MESA_FORMAT_ETC2_RGB8] = unpack_ETC2_RGB8;
-      table[MESA_FORMAT_ETC2_SRGB8] = unpack_ETC2_SRGB8;
-      table[MESA_FORMAT_ETC2_RGBA8_EAC] = unpack_ETC2_RGBA8_EAC;
-      table[MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC] = unpack_ETC2_SRGB8_ALPHA8_EAC;
-      table[MESA_FORMAT_ETC2_R11_EAC] = unpack_ETC2_R11_EAC;
-      table[MESA_FORMAT_ETC2_RG11_EAC] = unpack_ETC2_RG11_EAC;
-      table[MESA_FORMAT_ETC2_SIGNED_R11_EAC] = unpack_ETC2_SIGNED_R11_EAC;
-      table[MESA_FORMAT_ETC2_SIGNED_RG11_EAC] = unpack_ETC2_SIGNED_RG11_EAC;
-      table[MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1] =
-         unpack_ETC2_RGB8_PUNCHTHROUGH_ALPHA1;
-      table[MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1] =
-         unpack_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1;
-      table[MESA_FORMAT_A_SNORM8] = unpack_A_SNORM8;
-      table[MESA_FORMAT_L_SNORM8] = unpack_L_SNORM8;
-      table[MESA_FORMAT_L8A8_SNORM] = unpack_L8A8_SNORM;
-      table[MESA_FORMAT_A8L8_SNORM] = unpack_A8L8_SNORM;
-      table[MESA_FORMAT_I_SNORM8] = unpack_I_SNORM8;
-      table[MESA_FORMAT_A_SNORM16] = unpack_A_SNORM16;
-      table[MESA_FORMAT_L_SNORM16] = unpack_L_SNORM16;
-      table[MESA_FORMAT_LA_SNORM16] = unpack_LA_SNORM16;
-      table[MESA_FORMAT_I_SNORM16] = unpack_I_SNORM16;
-
-      table[MESA_FORMAT_R9G9B9E5_FLOAT] = unpack_R9G9B9E5_FLOAT;
-      table[MESA_FORMAT_R11G11B10_FLOAT] = unpack_R11G11B10_FLOAT;
-
-      table[MESA_FORMAT_Z_FLOAT32] = unpack_Z_FLOAT32;
-      table[MESA_FORMAT_Z32_FLOAT_S8X24_UINT] = unpack_Z32_FLOAT_S8X24_UINT;
-
-      table[MESA_FORMAT_B4G4R4X4_UNORM] = unpack_XRGB4444_UNORM;
-      table[MESA_FORMAT_B5G5R5X1_UNORM] = unpack_XRGB1555_UNORM;
-      table[MESA_FORMAT_R8G8B8X8_SNORM] = unpack_R8G8B8X8_SNORM;
-      table[MESA_FORMAT_R8G8B8X8_SRGB] = unpack_R8G8B8X8_SRGB;
-      table[MESA_FORMAT_X8B8G8R8_SRGB] = unpack_X8B8G8R8_SRGB;
-      table[MESA_FORMAT_RGBX_UINT8] = unpack_XBGR8888_UINT;
-      table[MESA_FORMAT_RGBX_SINT8] = unpack_XBGR8888_SINT;
-      table[MESA_FORMAT_B10G10R10X2_UNORM] = unpack_B10G10R10X2_UNORM;
-      table[MESA_FORMAT_RGBX_UNORM16] = unpack_RGBX_UNORM16;
-      table[MESA_FORMAT_RGBX_SNORM16] = unpack_RGBX_SNORM16;
-      table[MESA_FORMAT_RGBX_FLOAT16] = unpack_XBGR16161616_FLOAT;
-      table[MESA_FORMAT_RGBX_UINT16] = unpack_XBGR16161616_UINT;
-      table[MESA_FORMAT_RGBX_SINT16] = unpack_XBGR16161616_SINT;
-      table[MESA_FORMAT_RGBX_FLOAT32] = unpack_RGBX_FLOAT32;
-      table[MESA_FORMAT_RGBX_UINT32] = unpack_XBGR32323232_UINT;
-      table[MESA_FORMAT_RGBX_SINT32] = unpack_XBGR32323232_SINT;
-
-      table[MESA_FORMAT_R10G10B10A2_UNORM] = unpack_R10G10B10A2_UNORM;
-
-      table[MESA_FORMAT_G8R8_SNORM] = unpack_G8R8_SNORM;
-      table[MESA_FORMAT_G16R16_SNORM] = unpack_G16R16_SNORM;
-
-      table[MESA_FORMAT_B8G8R8X8_SRGB] = unpack_B8G8R8X8_SRGB;
-      table[MESA_FORMAT_X8R8G8B8_SRGB] = unpack_X8R8G8B8_SRGB;
-
-      initialized = GL_TRUE;
-   }
-
-   if (table[format] == NULL) {
+   static once_flag flag = ONCE_FLAG_INIT;
+
+   call_once(&flag, init_unpack_rgba_table);
+
+   if (unpack_rgba_table[format] == NULL) {
       _mesa_problem(NULL, "unsupported unpack for format %s",
                     _mesa_get_format_name(format));
    }
 
-   return table[format];
+   return unpack_rgba_table[format];
 }
 
 
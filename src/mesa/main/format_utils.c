@@ -25,6 +25,10 @@
 #include "format_utils.h"
 #include "glformats.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 static const uint8_t map_identity[7] = { 0, 1, 2, 3, 4, 5, 6 };
 static const uint8_t map_3210[7] = { 3, 2, 1, 0, 4, 5, 6 };
 static const uint8_t map_1032[7] = { 1, 0, 3, 2, 4, 5, 6 };
@@ -290,6 +294,121 @@ swizzle_convert_try_memcpy(void *dst, GLenum dst_type, int num_dst_channels,
    return true;
 }
 
+/**
+ * Attempts to perform the given swizzle-and-convert operation on whole
+ * 32-bit texels
+ *
+ * Swizzling four 8-bit channels into four 8-bit channels of the same type
+ * (RGBA <-> BGRA and friends, or RGBX -> RGBA) is by far the most common
+ * operation for texture uploads and ReadPixels.  Each destination channel
+ * is then just a shifted and masked copy of a source channel, so the
+ * conversion can be done with a handful of shifts per texel, four texels
+ * at a time with SSE2.
+ *
+ * The arguments are exactly the same as for _mesa_swizzle_and_convert
+ *
+ * \return  true if it successfully performed the swizzle-and-convert
+ *          operation, false otherwise
+ */
+static bool
+swizzle_convert_try_rgba8(void *dst, GLenum dst_type, int num_dst_channels,
+                          const void *src, GLenum src_type, int num_src_channels,
+                          const uint8_t swizzle[4], bool normalized, int count)
+{
+   const bool little_endian = _mesa_little_endian();
+   const uint8_t *typed_src = src;
+   uint8_t *typed_dst = dst;
+   uint32_t one, fill = 0, mask[4];
+   int rshift[4], lshift[4];
+   int i, s;
+
+   if (src_type != dst_type || num_src_channels != 4 || num_dst_channels != 4)
+      return false;
+
+   switch (dst_type) {
+   case GL_UNSIGNED_BYTE:
+      one = normalized ? UINT8_MAX : 1;
+      break;
+   case GL_BYTE:
+      one = normalized ? INT8_MAX : 1;
+      break;
+   default:
+      return false;
+   }
+
+   /* dst channel i = ((src >> rshift[i]) << lshift[i]) & mask[i], where
+    * at most one of the two shifts is non-zero.
+    */
+   for (i = 0; i < 4; ++i) {
+      const int dst_shift = little_endian ? 8 * i : 24 - 8 * i;
+
+      rshift[i] = 0;
+      lshift[i] = 0;
+      mask[i] = 0;
+
+      if (swizzle[i] < 4) {
+         const int src_shift =
+            little_endian ? 8 * swizzle[i] : 24 - 8 * swizzle[i];
+         if (src_shift > dst_shift)
+            rshift[i] = src_shift - dst_shift;
+         else
+            lshift[i] = dst_shift - src_shift;
+         mask[i] = 0xffu << dst_shift;
+      } else if (swizzle[i] == MESA_FORMAT_SWIZZLE_ONE) {
+         fill |= one << dst_shift;
+      }
+   }
+
+   s = 0;
+
+#ifdef __SSE2__
+   {
+      const __m128i vfill = _mm_set1_epi32(fill);
+      const __m128i vmask0 = _mm_set1_epi32(mask[0]);
+      const __m128i vmask1 = _mm_set1_epi32(mask[1]);
+      const __m128i vmask2 = _mm_set1_epi32(mask[2]);
+      const __m128i vmask3 = _mm_set1_epi32(mask[3]);
+      const __m128i vr0 = _mm_cvtsi32_si128(rshift[0]);
+      const __m128i vr1 = _mm_cvtsi32_si128(rshift[1]);
+      const __m128i vr2 = _mm_cvtsi32_si128(rshift[2]);
+      const __m128i vr3 = _mm_cvtsi32_si128(rshift[3]);
+      const __m128i vl0 = _mm_cvtsi32_si128(lshift[0]);
+      const __m128i vl1 = _mm_cvtsi32_si128(lshift[1]);
+      const __m128i vl2 = _mm_cvtsi32_si128(lshift[2]);
+      const __m128i vl3 = _mm_cvtsi32_si128(lshift[3]);
+
+      for (; s + 4 <= count; s += 4) {
+         const __m128i t =
+            _mm_loadu_si128((const __m128i *) (typed_src + s * 4));
+         __m128i c0, c1, c2, c3;
+
+         c0 = _mm_and_si128(_mm_sll_epi32(_mm_srl_epi32(t, vr0), vl0), vmask0);
+         c1 = _mm_and_si128(_mm_sll_epi32(_mm_srl_epi32(t, vr1), vl1), vmask1);
+         c2 = _mm_and_si128(_mm_sll_epi32(_mm_srl_epi32(t, vr2), vl2), vmask2);
+         c3 = _mm_and_si128(_mm_sll_epi32(_mm_srl_epi32(t, vr3), vl3), vmask3);
+
+         _mm_storeu_si128((__m128i *) (typed_dst + s * 4),
+                          _mm_or_si128(_mm_or_si128(vfill, c0),
+                                       _mm_or_si128(_mm_or_si128(c1, c2), c3)));
+      }
+   }
+#endif
+
+   for (; s < count; ++s) {
+      uint32_t t;
+
+      memcpy(&t, typed_src + s * 4, 4);
+      t = fill |
+          (((t >> rshift[0]) << lshift[0]) & mask[0]) |
+          (((t >> rshift[1]) << lshift[1]) & mask[1]) |
+          (((t >> rshift[2]) << lshift[2]) & mask[2]) |
+          (((t >> rshift[3]) << lshift[3]) & mask[3]);
+      memcpy(typed_dst + s * 4, &t, 4);
+   }
+
+   return true;
+}
+
 /**
  * Represents a single instance of the standard swizzle-and-convert loop
  *
@@ -1010,6 +1129,11 @@ _mesa_swizzle_and_convert(void *void_dst, GLenum dst_type, int num_dst_channels,
                                   swizzle, normalized, count))
       return;
 
+   if (swizzle_convert_try_rgba8(void_dst, dst_type, num_dst_channels,
+                                 void_src, src_type, num_src_channels,
+                                 swizzle, normalized, count))
+      return;
+
    switch (dst_type) {
    case GL_FLOAT:
       convert_float(void_dst, num_dst_channels, void_src, src_type,
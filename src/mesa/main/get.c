@@ -666,13 +666,6 @@ find_custom_value(struct gl_context *ctx, const struct value_desc *d, union valu
       v->value_int = 1 << (*p - 1);
       break;
 
-   case GL_SCISSOR_BOX:
-      v->value_int_4[0] = ctx->Scissor.ScissorArray[0].X;
-      v->value_int_4[1] = ctx->Scissor.ScissorArray[0].Y;
-      v->value_int_4[2] = ctx->Scissor.ScissorArray[0].Width;
-      v->value_int_4[3] = ctx->Scissor.ScissorArray[0].Height;
-      break;
-
    case GL_SCISSOR_TEST:
       v->value_bool = ctx->Scissor.EnableFlags & 1;
       break;
@@ -690,18 +683,6 @@ find_custom_value(struct gl_context *ctx, const struct value_desc *d, union valu
 	 v->value_enum = GL_COMPILE;
       break;
 
-   case GL_VIEWPORT:
-      v->value_float_4[0] = ctx->ViewportArray[0].X;
-      v->value_float_4[1] = ctx->ViewportArray[0].Y;
-      v->value_float_4[2] = ctx->ViewportArray[0].Width;
-      v->value_float_4[3] = ctx->ViewportArray[0].Height;
-      break;
-
-   case GL_DEPTH_RANGE:
-      v->value_double_2[0] = ctx->ViewportArray[0].Near;
-      v->value_double_2[1] = ctx->ViewportArray[0].Far;
-      break;
-
    case GL_ACTIVE_STENCIL_FACE_EXT:
       v->value_enum = ctx->Stencil.ActiveFace ? GL_BACK : GL_FRONT;
       break;
@@ -1182,7 +1163,7 @@ static const struct value_desc *
 find_value(const char *func, GLenum pname, void **p, union value *v)
 {
    GET_CURRENT_CONTEXT(ctx);
-   struct gl_texture_unit *unit;
+   void *bases[LOC_CUSTOM];
    int mask, hash;
    const struct value_desc *d;
    int api;
@@ -1221,31 +1202,25 @@ find_value(const char *func, GLenum pname, void **p, union value *v)
    if (unlikely(d->extra && !check_extra(ctx, func, d)))
       return &error_value;
 
-   switch (d->location) {
-   case LOC_BUFFER:
-      *p = ((char *) ctx->DrawBuffer + d->offset);
-      return d;
-   case LOC_CONTEXT:
-      *p = ((char *) ctx + d->offset);
-      return d;
-   case LOC_ARRAY:
-      *p = ((char *) ctx->Array.VAO + d->offset);
-      return d;
-   case LOC_TEXUNIT:
-      unit = &ctx->Texture.Unit[ctx->Texture.CurrentUnit];
-      *p = ((char *) unit + d->offset);
-      return d;
-   case LOC_CUSTOM:
+   if (d->location == LOC_CUSTOM) {
       find_custom_value(ctx, d, v);
       *p = v;
       return d;
-   default:
-      assert(0);
-      break;
    }
 
-   /* silence warning */
-   return &error_value;
+   /* Everything else is at an offset from one of these.  Looking the base
+    * up rather than switching on the location saves a jump that's hard to
+    * predict when the pnames being queried vary.
+    */
+   bases[LOC_BUFFER] = ctx->DrawBuffer;
+   bases[LOC_CONTEXT] = ctx;
+   bases[LOC_ARRAY] = ctx->Array.VAO;
+   bases[LOC_TEXUNIT] = &ctx->Texture.Unit[ctx->Texture.CurrentUnit];
+
+   assert(d->location < LOC_CUSTOM);
+   *p = (char *) bases[d->location] + d->offset;
+
+   return d;
 }
 
 static const int transpose[] = {
@@ -1255,456 +1230,214 @@ static const int transpose[] = {
    3, 7, 11, 15
 };
 
-void GLAPIENTRY
-_mesa_GetBooleanv(GLenum pname, GLboolean *params)
+/**
+ * Converts the value find_value() found to the type a glGet*v() function
+ * returns.  Each of those has a table of these indexed by enum value_type,
+ * so that a query is a hash lookup followed by one indirect call instead
+ * of a walk through a switch over all of the value types.
+ */
+typedef void (*get_value_func)(const struct value_desc *d, const void *p,
+                               const union value *v, void *params);
+
+static void
+get_invalid(const struct value_desc *d, const void *p,
+            const union value *v, void *params)
 {
-   const struct value_desc *d;
-   union value v;
-   GLmatrix *m;
-   int shift, i;
-   void *p;
+   /* find_value() already raised the error */
+}
 
-   d = find_value("glGetBooleanv", pname, &p, &v);
-   switch (d->type) {
-   case TYPE_INVALID:
-      break;
-   case TYPE_CONST:
-      params[0] = INT_TO_BOOLEAN(d->offset);
-      break;
+/**
+ * Define a get_value_func converting n values of src_type.
+ */
+#define GET_VALUES(name, src_type, dst_type, n, CONVERT)                \
+static void                                                             \
+name(const struct value_desc *d, const void *p,                         \
+     const union value *v, void *params)                                \
+{                                                                       \
+   const src_type *src = (const src_type *) p;                          \
+   dst_type *dst = (dst_type *) params;                                 \
+   int i;                                                               \
+                                                                        \
+   for (i = 0; i < n; i++)                                              \
+      dst[i] = CONVERT(src[i]);                                         \
+}
 
-   case TYPE_FLOAT_4:
-   case TYPE_FLOATN_4:
-      params[3] = FLOAT_TO_BOOLEAN(((GLfloat *) p)[3]);
-   case TYPE_FLOAT_3:
-   case TYPE_FLOATN_3:
-      params[2] = FLOAT_TO_BOOLEAN(((GLfloat *) p)[2]);
-   case TYPE_FLOAT_2:
-   case TYPE_FLOATN_2:
-      params[1] = FLOAT_TO_BOOLEAN(((GLfloat *) p)[1]);
-   case TYPE_FLOAT:
-   case TYPE_FLOATN:
-      params[0] = FLOAT_TO_BOOLEAN(((GLfloat *) p)[0]);
-      break;
+/**
+ * Define the get_value_funcs for each value type returned as dst_type,
+ * and the get_<suffix>_funcs[] table of them.  Matrices are converted
+ * like normalized floats, and the bit types like booleans.
+ */
+#define GET_VALUE_FUNCS(suffix, dst_type, FROM_INT, FROM_INT64,         \
+                        FROM_FLOAT, FROM_FLOATN, FROM_DOUBLEN,          \
+                        FROM_BOOLEAN)                                   \
+GET_VALUES(get_int_##suffix, GLint, dst_type, 1, FROM_INT)              \
+GET_VALUES(get_int_2_##suffix, GLint, dst_type, 2, FROM_INT)            \
+GET_VALUES(get_int_3_##suffix, GLint, dst_type, 3, FROM_INT)            \
+GET_VALUES(get_int_4_##suffix, GLint, dst_type, 4, FROM_INT)            \
+GET_VALUES(get_int64_##suffix, GLint64, dst_type, 1, FROM_INT64)        \
+GET_VALUES(get_boolean_##suffix, GLboolean, dst_type, 1, FROM_BOOLEAN)  \
+GET_VALUES(get_float_##suffix, GLfloat, dst_type, 1, FROM_FLOAT)        \
+GET_VALUES(get_float_2_##suffix, GLfloat, dst_type, 2, FROM_FLOAT)      \
+GET_VALUES(get_float_3_##suffix, GLfloat, dst_type, 3, FROM_FLOAT)      \
+GET_VALUES(get_float_4_##suffix, GLfloat, dst_type, 4, FROM_FLOAT)      \
+GET_VALUES(get_floatn_##suffix, GLfloat, dst_type, 1, FROM_FLOATN)      \
+GET_VALUES(get_floatn_2_##suffix, GLfloat, dst_type, 2, FROM_FLOATN)    \
+GET_VALUES(get_floatn_3_##suffix, GLfloat, dst_type, 3, FROM_FLOATN)    \
+GET_VALUES(get_floatn_4_##suffix, GLfloat, dst_type, 4, FROM_FLOATN)    \
+GET_VALUES(get_doublen_##suffix, GLdouble, dst_type, 1, FROM_DOUBLEN)   \
+GET_VALUES(get_doublen_2_##suffix, GLdouble, dst_type, 2, FROM_DOUBLEN) \
+                                                                        \
+static void                                                             \
+get_int_n_##suffix(const struct value_desc *d, const void *p,           \
+                   const union value *v, void *params)                  \
+{                                                                       \
+   dst_type *dst = (dst_type *) params;                                 \
+   int i;                                                               \
+                                                                        \
+   for (i = 0; i < v->value_int_n.n; i++)                               \
+      dst[i] = FROM_INT(v->value_int_n.ints[i]);                        \
+}                                                                       \
+                                                                        \
+static void                                                             \
+get_bit_##suffix(const struct value_desc *d, const void *p,             \
+                 const union value *v, void *params)                    \
+{                                                                       \
+   const int shift = d->type - TYPE_BIT_0;                              \
+                                                                        \
+   *(dst_type *) params = FROM_BOOLEAN((*(GLbitfield *) p >> shift) & 1); \
+}                                                                       \
+                                                                        \
+static void                                                             \
+get_matrix_##suffix(const struct value_desc *d, const void *p,          \
+                    const union value *v, void *params)                 \
+{                                                                       \
+   const GLmatrix *m = *(GLmatrix **) p;                                \
+   dst_type *dst = (dst_type *) params;                                 \
+   int i;                                                               \
+                                                                        \
+   for (i = 0; i < 16; i++)                                             \
+      dst[i] = FROM_FLOATN(m->m[i]);                                    \
+}                                                                       \
+                                                                        \
+static void                                                             \
+get_matrix_t_##suffix(const struct value_desc *d, const void *p,        \
+                      const union value *v, void *params)               \
+{                                                                       \
+   const GLmatrix *m = *(GLmatrix **) p;                                \
+   dst_type *dst = (dst_type *) params;                                 \
+   int i;                                                               \
+                                                                        \
+   for (i = 0; i < 16; i++)                                             \
+      dst[i] = FROM_FLOATN(m->m[transpose[i]]);                         \
+}                                                                       \
+                                                                        \
+static void                                                             \
+get_const_##suffix(const struct value_desc *d, const void *p,           \
+                   const union value *v, void *params)                  \
+{                                                                       \
+   *(dst_type *) params = FROM_INT(d->offset);                          \
+}                                                                       \
+                                                                        \
+/* In the order of enum value_type */                                   \
+static const get_value_func get_##suffix##_funcs[] = {                  \
+   get_invalid,                                                         \
+   get_int_##suffix,                                                    \
+   get_int_2_##suffix,                                                  \
+   get_int_3_##suffix,                                                  \
+   get_int_4_##suffix,                                                  \
+   get_int_n_##suffix,                                                  \
+   get_int64_##suffix,                                                  \
+   get_int_##suffix,            /* TYPE_ENUM */                         \
+   get_int_2_##suffix,          /* TYPE_ENUM_2 */                       \
+   get_boolean_##suffix,                                                \
+   get_bit_##suffix,                                                    \
+   get_bit_##suffix,                                                    \
+   get_bit_##suffix,                                                    \
+   get_bit_##suffix,                                                    \
+   get_bit_##suffix,                                                    \
+   get_bit_##suffix,                                                    \
+   get_bit_##suffix,                                                    \
+   get_bit_##suffix,                                                    \
+   get_float_##suffix,                                                  \
+   get_float_2_##suffix,                                                \
+   get_float_3_##suffix,                                                \
+   get_float_4_##suffix,                                                \
+   get_floatn_##suffix,                                                 \
+   get_floatn_2_##suffix,                                               \
+   get_floatn_3_##suffix,                                               \
+   get_floatn_4_##suffix,                                               \
+   get_doublen_##suffix,                                                \
+   get_doublen_2_##suffix,                                              \
+   get_matrix_##suffix,                                                 \
+   get_matrix_t_##suffix,                                               \
+   get_const_##suffix                                                   \
+}
 
-   case TYPE_DOUBLEN_2:
-      params[1] = FLOAT_TO_BOOLEAN(((GLdouble *) p)[1]);
-   case TYPE_DOUBLEN:
-      params[0] = FLOAT_TO_BOOLEAN(((GLdouble *) p)[0]);
-      break;
+GET_VALUE_FUNCS(as_boolean, GLboolean, INT_TO_BOOLEAN, INT64_TO_BOOLEAN,
+                FLOAT_TO_BOOLEAN, FLOAT_TO_BOOLEAN, FLOAT_TO_BOOLEAN,
+                (GLboolean));
 
-   case TYPE_INT_4:
-      params[3] = INT_TO_BOOLEAN(((GLint *) p)[3]);
-   case TYPE_INT_3:
-      params[2] = INT_TO_BOOLEAN(((GLint *) p)[2]);
-   case TYPE_INT_2:
-   case TYPE_ENUM_2:
-      params[1] = INT_TO_BOOLEAN(((GLint *) p)[1]);
-   case TYPE_INT:
-   case TYPE_ENUM:
-      params[0] = INT_TO_BOOLEAN(((GLint *) p)[0]);
-      break;
+GET_VALUE_FUNCS(as_float, GLfloat, (GLfloat), (GLfloat),
+                (GLfloat), (GLfloat), (GLfloat),
+                BOOLEAN_TO_FLOAT);
 
-   case TYPE_INT_N:
-      for (i = 0; i < v.value_int_n.n; i++)
-	 params[i] = INT_TO_BOOLEAN(v.value_int_n.ints[i]);
-      break;
+GET_VALUE_FUNCS(as_int, GLint, (GLint), INT64_TO_INT,
+                IROUND, FLOAT_TO_INT, FLOAT_TO_INT,
+                BOOLEAN_TO_INT);
 
-   case TYPE_INT64:
-      params[0] = INT64_TO_BOOLEAN(((GLint64 *) p)[0]);
-      break;
+GET_VALUE_FUNCS(as_int64, GLint64, (GLint64), (GLint64),
+                IROUND64, FLOAT_TO_INT64, FLOAT_TO_INT64,
+                BOOLEAN_TO_INT64);
 
-   case TYPE_BOOLEAN:
-      params[0] = ((GLboolean*) p)[0];
-      break;		
+GET_VALUE_FUNCS(as_double, GLdouble, (GLdouble), (GLdouble),
+                (GLdouble), (GLdouble), (GLdouble),
+                (GLdouble));
 
-   case TYPE_MATRIX:
-      m = *(GLmatrix **) p;
-      for (i = 0; i < 16; i++)
-	 params[i] = FLOAT_TO_BOOLEAN(m->m[i]);
-      break;
+GET_VALUE_FUNCS(as_fixed, GLfixed, INT_TO_FIXED, (GLfixed),
+                FLOAT_TO_FIXED, FLOAT_TO_FIXED, FLOAT_TO_FIXED,
+                BOOLEAN_TO_FIXED);
 
-   case TYPE_MATRIX_T:
-      m = *(GLmatrix **) p;
-      for (i = 0; i < 16; i++)
-	 params[i] = FLOAT_TO_BOOLEAN(m->m[transpose[i]]);
-      break;
+#define GET_VALUE(func, pname, params, funcs)                           \
+   do {                                                                 \
+      const struct value_desc *d;                                       \
+      union value v;                                                    \
+      void *p;                                                          \
+                                                                        \
+      d = find_value(func, pname, &p, &v);                              \
+      funcs[d->type](d, p, &v, params);                                 \
+   } while (0)
 
-   case TYPE_BIT_0:
-   case TYPE_BIT_1:
-   case TYPE_BIT_2:
-   case TYPE_BIT_3:
-   case TYPE_BIT_4:
-   case TYPE_BIT_5:
-   case TYPE_BIT_6:
-   case TYPE_BIT_7:
-      shift = d->type - TYPE_BIT_0;
-      params[0] = (*(GLbitfield *) p >> shift) & 1;
-      break;
-   }
+void GLAPIENTRY
+_mesa_GetBooleanv(GLenum pname, GLboolean *params)
+{
+   /* All of the tables come from GET_VALUE_FUNCS */
+   STATIC_ASSERT(Elements(get_as_boolean_funcs) == TYPE_CONST + 1);
+
+   GET_VALUE("glGetBooleanv", pname, params, get_as_boolean_funcs);
 }
 
 void GLAPIENTRY
 _mesa_GetFloatv(GLenum pname, GLfloat *params)
 {
-   const struct value_desc *d;
-   union value v;
-   GLmatrix *m;
-   int shift, i;
-   void *p;
-
-   d = find_value("glGetFloatv", pname, &p, &v);
-   switch (d->type) {
-   case TYPE_INVALID:
-      break;
-   case TYPE_CONST:
-      params[0] = (GLfloat) d->offset;
-      break;
-
-   case TYPE_FLOAT_4:
-   case TYPE_FLOATN_4:
-      params[3] = ((GLfloat *) p)[3];
-   case TYPE_FLOAT_3:
-   case TYPE_FLOATN_3:
-      params[2] = ((GLfloat *) p)[2];
-   case TYPE_FLOAT_2:
-   case TYPE_FLOATN_2:
-      params[1] = ((GLfloat *) p)[1];
-   case TYPE_FLOAT:
-   case TYPE_FLOATN:
-      params[0] = ((GLfloat *) p)[0];
-      break;
-
-   case TYPE_DOUBLEN_2:
-      params[1] = (GLfloat) (((GLdouble *) p)[1]);
-   case TYPE_DOUBLEN:
-      params[0] = (GLfloat) (((GLdouble *) p)[0]);
-      break;
-
-   case TYPE_INT_4:
-      params[3] = (GLfloat) (((GLint *) p)[3]);
-   case TYPE_INT_3:
-      params[2] = (GLfloat) (((GLint *) p)[2]);
-   case TYPE_INT_2:
-   case TYPE_ENUM_2:
-      params[1] = (GLfloat) (((GLint *) p)[1]);
-   case TYPE_INT:
-   case TYPE_ENUM:
-      params[0] = (GLfloat) (((GLint *) p)[0]);
-      break;
-
-   case TYPE_INT_N:
-      for (i = 0; i < v.value_int_n.n; i++)
-	 params[i] = INT_TO_FLOAT(v.value_int_n.ints[i]);
-      break;
-
-   case TYPE_INT64:
-      params[0] = (GLfloat) (((GLint64 *) p)[0]);
-      break;
-
-   case TYPE_BOOLEAN:
-      params[0] = BOOLEAN_TO_FLOAT(*(GLboolean*) p);
-      break;		
-
-   case TYPE_MATRIX:
-      m = *(GLmatrix **) p;
-      for (i = 0; i < 16; i++)
-	 params[i] = m->m[i];
-      break;
-
-   case TYPE_MATRIX_T:
-      m = *(GLmatrix **) p;
-      for (i = 0; i < 16; i++)
-	 params[i] = m->m[transpose[i]];
-      break;
-
-   case TYPE_BIT_0:
-   case TYPE_BIT_1:
-   case TYPE_BIT_2:
-   case TYPE_BIT_3:
-   case TYPE_BIT_4:
-   case TYPE_BIT_5:
-   case TYPE_BIT_6:
-   case TYPE_BIT_7:
-      shift = d->type - TYPE_BIT_0;
-      params[0] = BOOLEAN_TO_FLOAT((*(GLbitfield *) p >> shift) & 1);
-      break;
-   }
+   GET_VALUE("glGetFloatv", pname, params, get_as_float_funcs);
 }
 
 void GLAPIENTRY
 _mesa_GetIntegerv(GLenum pname, GLint *params)
 {
-   const struct value_desc *d;
-   union value v;
-   GLmatrix *m;
-   int shift, i;
-   void *p;
-
-   d = find_value("glGetIntegerv", pname, &p, &v);
-   switch (d->type) {
-   case TYPE_INVALID:
-      break;
-   case TYPE_CONST:
-      params[0] = d->offset;
-      break;
-
-   case TYPE_FLOAT_4:
-      params[3] = IROUND(((GLfloat *) p)[3]);
-   case TYPE_FLOAT_3:
-      params[2] = IROUND(((GLfloat *) p)[2]);
-   case TYPE_FLOAT_2:
-      params[1] = IROUND(((GLfloat *) p)[1]);
-   case TYPE_FLOAT:
-      params[0] = IROUND(((GLfloat *) p)[0]);
-      break;
-
-   case TYPE_FLOATN_4:
-      params[3] = FLOAT_TO_INT(((GLfloat *) p)[3]);
-   case TYPE_FLOATN_3:
-      params[2] = FLOAT_TO_INT(((GLfloat *) p)[2]);
-   case TYPE_FLOATN_2:
-      params[1] = FLOAT_TO_INT(((GLfloat *) p)[1]);
-   case TYPE_FLOATN:
-      params[0] = FLOAT_TO_INT(((GLfloat *) p)[0]);
-      break;
-
-   case TYPE_DOUBLEN_2:
-      params[1] = FLOAT_TO_INT(((GLdouble *) p)[1]);
-   case TYPE_DOUBLEN:
-      params[0] = FLOAT_TO_INT(((GLdouble *) p)[0]);
-      break;
-
-   case TYPE_INT_4:
-      params[3] = ((GLint *) p)[3];
-   case TYPE_INT_3:
-      params[2] = ((GLint *) p)[2];
-   case TYPE_INT_2:
-   case TYPE_ENUM_2:
-      params[1] = ((GLint *) p)[1];
-   case TYPE_INT:
-   case TYPE_ENUM:
-      params[0] = ((GLint *) p)[0];
-      break;
-
-   case TYPE_INT_N:
-      for (i = 0; i < v.value_int_n.n; i++)
-	 params[i] = v.value_int_n.ints[i];
-      break;
-
-   case TYPE_INT64:
-      params[0] = INT64_TO_INT(((GLint64 *) p)[0]);
-      break;
-
-   case TYPE_BOOLEAN:
-      params[0] = BOOLEAN_TO_INT(*(GLboolean*) p);
-      break;		
-
-   case TYPE_MATRIX:
-      m = *(GLmatrix **) p;
-      for (i = 0; i < 16; i++)
-	 params[i] = FLOAT_TO_INT(m->m[i]);
-      break;
-
-   case TYPE_MATRIX_T:
-      m = *(GLmatrix **) p;
-      for (i = 0; i < 16; i++)
-	 params[i] = FLOAT_TO_INT(m->m[transpose[i]]);
-      break;
-
-   case TYPE_BIT_0:
-   case TYPE_BIT_1:
-   case TYPE_BIT_2:
-   case TYPE_BIT_3:
-   case TYPE_BIT_4:
-   case TYPE_BIT_5:
-   case TYPE_BIT_6:
-   case TYPE_BIT_7:
-      shift = d->type - TYPE_BIT_0;
-      params[0] = (*(GLbitfield *) p >> shift) & 1;
-      break;
-   }
+   GET_VALUE("glGetIntegerv", pname, params, get_as_int_funcs);
 }
 
 void GLAPIENTRY
 _mesa_GetInteger64v(GLenum pname, GLint64 *params)
 {
-   const struct value_desc *d;
-   union value v;
-   GLmatrix *m;
-   int shift, i;
-   void *p;
-
-   d = find_value("glGetInteger64v", pname, &p, &v);
-   switch (d->type) {
-   case TYPE_INVALID:
-      break;
-   case TYPE_CONST:
-      params[0] = d->offset;
-      break;
-
-   case TYPE_FLOAT_4:
-      params[3] = IROUND64(((GLfloat *) p)[3]);
-   case TYPE_FLOAT_3:
-      params[2] = IROUND64(((GLfloat *) p)[2]);
-   case TYPE_FLOAT_2:
-      params[1] = IROUND64(((GLfloat *) p)[1]);
-   case TYPE_FLOAT:
-      params[0] = IROUND64(((GLfloat *) p)[0]);
-      break;
-
-   case TYPE_FLOATN_4:
-      params[3] = FLOAT_TO_INT64(((GLfloat *) p)[3]);
-   case TYPE_FLOATN_3:
-      params[2] = FLOAT_TO_INT64(((GLfloat *) p)[2]);
-   case TYPE_FLOATN_2:
-      params[1] = FLOAT_TO_INT64(((GLfloat *) p)[1]);
-   case TYPE_FLOATN:
-      params[0] = FLOAT_TO_INT64(((GLfloat *) p)[0]);
-      break;
-
-   case TYPE_DOUBLEN_2:
-      params[1] = FLOAT_TO_INT64(((GLdouble *) p)[1]);
-   case TYPE_DOUBLEN:
-      params[0] = FLOAT_TO_INT64(((GLdouble *) p)[0]);
-      break;
-
-   case TYPE_INT_4:
-      params[3] = ((GLint *) p)[3];
-   case TYPE_INT_3:
-      params[2] = ((GLint *) p)[2];
-   case TYPE_INT_2:
-   case TYPE_ENUM_2:
-      params[1] = ((GLint *) p)[1];
-   case TYPE_INT:
-   case TYPE_ENUM:
-      params[0] = ((GLint *) p)[0];
-      break;
-
-   case TYPE_INT_N:
-      for (i = 0; i < v.value_int_n.n; i++)
-	 params[i] = INT_TO_BOOLEAN(v.value_int_n.ints[i]);
-      break;
-
-   case TYPE_INT64:
-      params[0] = ((GLint64 *) p)[0];
-      break;
-
-   case TYPE_BOOLEAN:
-      params[0] = ((GLboolean*) p)[0];
-      break;		
-
-   case TYPE_MATRIX:
-      m = *(GLmatrix **) p;
-      for (i = 0; i < 16; i++)
-	 params[i] = FLOAT_TO_INT64(m->m[i]);
-      break;
-
-   case TYPE_MATRIX_T:
-      m = *(GLmatrix **) p;
-      for (i = 0; i < 16; i++)
-	 params[i] = FLOAT_TO_INT64(m->m[transpose[i]]);
-      break;
-
-   case TYPE_BIT_0:
-   case TYPE_BIT_1:
-   case TYPE_BIT_2:
-   case TYPE_BIT_3:
-   case TYPE_BIT_4:
-   case TYPE_BIT_5:
-   case TYPE_BIT_6:
-   case TYPE_BIT_7:
-      shift = d->type - TYPE_BIT_0;
-      params[0] = (*(GLbitfield *) p >> shift) & 1;
-      break;
-   }
+   GET_VALUE("glGetInteger64v", pname, params, get_as_int64_funcs);
 }
 
 void GLAPIENTRY
 _mesa_GetDoublev(GLenum pname, GLdouble *params)
 {
-   const struct value_desc *d;
-   union value v;
-   GLmatrix *m;
-   int shift, i;
-   void *p;
-
-   d = find_value("glGetDoublev", pname, &p, &v);
-   switch (d->type) {
-   case TYPE_INVALID:
-      break;
-   case TYPE_CONST:
-      params[0] = d->offset;
-      break;
-
-   case TYPE_FLOAT_4:
-   case TYPE_FLOATN_4:
-      params[3] = ((GLfloat *) p)[3];
-   case TYPE_FLOAT_3:
-   case TYPE_FLOATN_3:
-      params[2] = ((GLfloat *) p)[2];
-   case TYPE_FLOAT_2:
-   case TYPE_FLOATN_2:
-      params[1] = ((GLfloat *) p)[1];
-   case TYPE_FLOAT:
-   case TYPE_FLOATN:
-      params[0] = ((GLfloat *) p)[0];
-      break;
-
-   case TYPE_DOUBLEN_2:
-      params[1] = ((GLdouble *) p)[1];
-   case TYPE_DOUBLEN:
-      params[0] = ((GLdouble *) p)[0];
-      break;
-
-   case TYPE_INT_4:
-      params[3] = ((GLint *) p)[3];
-   case TYPE_INT_3:
-      params[2] = ((GLint *) p)[2];
-   case TYPE_INT_2:
-   case TYPE_ENUM_2:
-      params[1] = ((GLint *) p)[1];
-   case TYPE_INT:
-   case TYPE_ENUM:
-      params[0] = ((GLint *) p)[0];
-      break;
-
-   case TYPE_INT_N:
-      for (i = 0; i < v.value_int_n.n; i++)
-	 params[i] = v.value_int_n.ints[i];
-      break;
-
-   case TYPE_INT64:
-      params[0] = (GLdouble) (((GLint64 *) p)[0]);
-      break;
-
-   case TYPE_BOOLEAN:
-      params[0] = *(GLboolean*) p;
-      break;		
-
-   case TYPE_MATRIX:
-      m = *(GLmatrix **) p;
-      for (i = 0; i < 16; i++)
-	 params[i] = m->m[i];
-      break;
-
-   case TYPE_MATRIX_T:
-      m = *(GLmatrix **) p;
-      for (i = 0; i < 16; i++)
-	 params[i] = m->m[transpose[i]];
-      break;
-
-   case TYPE_BIT_0:
-   case TYPE_BIT_1:
-   case TYPE_BIT_2:
-   case TYPE_BIT_3:
-   case TYPE_BIT_4:
-   case TYPE_BIT_5:
-   case TYPE_BIT_6:
-   case TYPE_BIT_7:
-      shift = d->type - TYPE_BIT_0;
-      params[0] = (*(GLbitfield *) p >> shift) & 1;
-      break;
-   }
+   GET_VALUE("glGetDoublev", pname, params, get_as_double_funcs);
 }
 
 static enum value_type
@@ -2238,87 +1971,5 @@ _mesa_GetDoublei_v(GLenum pname, GLuint index, GLdouble *params)
 void GLAPIENTRY
 _mesa_GetFixedv(GLenum pname, GLfixed *params)
 {
-   const struct value_desc *d;
-   union value v;
-   GLmatrix *m;
-   int shift, i;
-   void *p;
-
-   d = find_value("glGetDoublev", pname, &p, &v);
-   switch (d->type) {
-   case TYPE_INVALID:
-      break;
-   case TYPE_CONST:
-      params[0] = INT_TO_FIXED(d->offset);
-      break;
-
-   case TYPE_FLOAT_4:
-   case TYPE_FLOATN_4:
-      params[3] = FLOAT_TO_FIXED(((GLfloat *) p)[3]);
-   case TYPE_FLOAT_3:
-   case TYPE_FLOATN_3:
-      params[2] = FLOAT_TO_FIXED(((GLfloat *) p)[2]);
-   case TYPE_FLOAT_2:
-   case TYPE_FLOATN_2:
-      params[1] = FLOAT_TO_FIXED(((GLfloat *) p)[1]);
-   case TYPE_FLOAT:
-   case TYPE_FLOATN:
-      params[0] = FLOAT_TO_FIXED(((GLfloat *) p)[0]);
-      break;
-
-   case TYPE_DOUBLEN_2:
-      params[1] = FLOAT_TO_FIXED(((GLdouble *) p)[1]);
-   case TYPE_DOUBLEN:
-      params[0] = FLOAT_TO_FIXED(((GLdouble *) p)[0]);
-      break;
-
-   case TYPE_INT_4:
-      params[3] = INT_TO_FIXED(((GLint *) p)[3]);
-   case TYPE_INT_3:
-      params[2] = INT_TO_FIXED(((GLint *) p)[2]);
-   case TYPE_INT_2:
-   case TYPE_ENUM_2:
-      params[1] = INT_TO_FIXED(((GLint *) p)[1]);
-   case TYPE_INT:
-   case TYPE_ENUM:
-      params[0] = INT_TO_FIXED(((GLint *) p)[0]);
-      break;
-
-   case TYPE_INT_N:
-      for (i = 0; i < v.value_int_n.n; i++)
-	 params[i] = INT_TO_FIXED(v.value_int_n.ints[i]);
-      break;
-
-   case TYPE_INT64:
-      params[0] = ((GLint64 *) p)[0];
-      break;
-
-   case TYPE_BOOLEAN:
-      params[0] = BOOLEAN_TO_FIXED(((GLboolean*) p)[0]);
-      break;		
-
-   case TYPE_MATRIX:
-      m = *(GLmatrix **) p;
-      for (i = 0; i < 16; i++)
-	 params[i] = FLOAT_TO_FIXED(m->m[i]);
-      break;
-
-   case TYPE_MATRIX_T:
-      m = *(GLmatrix **) p;
-      for (i = 0; i < 16; i++)
-	 params[i] = FLOAT_TO_FIXED(m->m[transpose[i]]);
-      break;
-
-   case TYPE_BIT_0:
-   case TYPE_BIT_1:
-   case TYPE_BIT_2:
-   case TYPE_BIT_3:
-   case TYPE_BIT_4:
-   case TYPE_BIT_5:
-   case TYPE_BIT_6:
-   case TYPE_BIT_7:
-      shift = d->type - TYPE_BIT_0;
-      params[0] = BOOLEAN_TO_FIXED((*(GLbitfield *) p >> shift) & 1);
-      break;
-   }
+   GET_VALUE("glGetDoublev", pname, params, get_as_fixed_funcs);
 }
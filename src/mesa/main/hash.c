@@ -52,12 +52,31 @@
  */
 #define DELETED_KEY_VALUE 1
 
+/**
+ * Direct-indexed lookup for small keys.
+ *
+ * Object names from glGen*() are small, dense integers, so keys below
+ * DIRECT_MAX_KEY are also stored in a two-level array: a fixed directory of
+ * DIRECT_PAGES pointers to pages of DIRECT_PAGE_SIZE data pointers.  Pages
+ * are allocated while holding the table mutex and are only freed along with
+ * the table, so _mesa_HashLookup() can read them without taking the lock.
+ * struct hash_table remains the authoritative store, which is used for
+ * larger keys and for walking the table.
+ */
+#define DIRECT_PAGE_BITS 10
+#define DIRECT_PAGE_SIZE (1 << DIRECT_PAGE_BITS)
+#define DIRECT_PAGES 1024
+#define DIRECT_MAX_KEY (DIRECT_PAGES * DIRECT_PAGE_SIZE)
+
 /**
  * The hash table data structure.  
  */
 struct _mesa_HashTable {
    struct hash_table *ht;
+   void * volatile *volatile Direct[DIRECT_PAGES]; /**< lock-free lookups */
    GLuint MaxKey;                        /**< highest key inserted so far */
+   /** A page allocation failed, so ht may hold keys of unallocated pages */
+   GLboolean DirectIncomplete;
    mtx_t Mutex;                /**< mutual exclusion lock */
    mtx_t WalkMutex;            /**< for _mesa_HashWalk() */
    GLboolean InDeleteAll;                /**< Debug check */
@@ -103,6 +122,91 @@ uint_key(GLuint id)
 }
 /** @} */
 
+
+/**
+ * Make the stores done so far visible before any later store, so a reader
+ * which sees a newly published direct page also sees it cleared.  MSVC
+ * already gives volatile stores release semantics.
+ */
+static inline void
+write_barrier(void)
+{
+#if defined(__GNUC__)
+   __sync_synchronize();
+#endif
+}
+
+
+/**
+ * Return the direct-indexed page holding a key, or NULL if the key is out
+ * of range or its page hasn't been allocated.  Safe without the mutex.
+ */
+static inline void * volatile *
+direct_page(const struct _mesa_HashTable *table, GLuint key)
+{
+   if (key >= DIRECT_MAX_KEY)
+      return NULL;
+   return table->Direct[key >> DIRECT_PAGE_BITS];
+}
+
+
+/**
+ * Copy the entries of a new direct-indexed page's key range from the hash
+ * table.  Only needed after a page allocation failed, since otherwise
+ * every key of the range was inserted after the page existed.
+ */
+static void
+direct_fill_page(struct _mesa_HashTable *table, void * volatile *page,
+                 GLuint first_key)
+{
+   struct hash_entry *entry;
+   GLuint key;
+
+   if (first_key <= DELETED_KEY_VALUE &&
+       DELETED_KEY_VALUE < first_key + DIRECT_PAGE_SIZE)
+      page[DELETED_KEY_VALUE - first_key] = table->deleted_key_data;
+
+   hash_table_foreach(table->ht, entry) {
+      key = (GLuint)(uintptr_t) entry->key;
+      if (key >= first_key && key - first_key < DIRECT_PAGE_SIZE)
+         page[key - first_key] = entry->data;
+   }
+}
+
+
+/**
+ * Set the direct-indexed entry for a key, allocating its page if needed.
+ * The table mutex must be held.
+ */
+static void
+direct_set(struct _mesa_HashTable *table, GLuint key, void *data)
+{
+   void * volatile *page;
+
+   if (key >= DIRECT_MAX_KEY)
+      return;
+
+   page = table->Direct[key >> DIRECT_PAGE_BITS];
+   if (!page) {
+      if (!data)
+         return;
+      page = calloc(DIRECT_PAGE_SIZE, sizeof(void *));
+      if (!page) {
+         /* The key only goes in the hash table.  A later allocation of
+          * this page must pick it up from there.
+          */
+         table->DirectIncomplete = GL_TRUE;
+         return;
+      }
+      if (table->DirectIncomplete)
+         direct_fill_page(table, page, key & ~(DIRECT_PAGE_SIZE - 1));
+      write_barrier();
+      table->Direct[key >> DIRECT_PAGE_BITS] = page;
+   }
+
+   page[key & (DIRECT_PAGE_SIZE - 1)] = data;
+}
+
 /**
  * Create a new hash table.
  * 
@@ -145,6 +249,8 @@ _mesa_NewHashTable(void)
 void
 _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 {
+   GLuint i;
+
    assert(table);
 
    if (_mesa_hash_table_next_entry(table->ht, NULL) != NULL) {
@@ -153,6 +259,9 @@ _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 
    _mesa_hash_table_destroy(table->ht, NULL);
 
+   for (i = 0; i < DIRECT_PAGES; i++)
+      free((void *) table->Direct[i]);
+
    mtx_destroy(&table->Mutex);
    mtx_destroy(&table->WalkMutex);
    free(table);
@@ -168,10 +277,15 @@ static inline void *
 _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
 {
    const struct hash_entry *entry;
+   void * volatile *page;
 
    assert(table);
    assert(key);
 
+   page = direct_page(table, key);
+   if (page)
+      return page[key & (DIRECT_PAGE_SIZE - 1)];
+
    if (key == DELETED_KEY_VALUE)
       return table->deleted_key_data;
 
@@ -185,6 +299,9 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
 
 /**
  * Lookup an entry in the hash table.
+ *
+ * Keys whose direct-indexed page exists are looked up without taking the
+ * mutex.
  * 
  * \param table the hash table.
  * \param key the key.
@@ -194,8 +311,12 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
 void *
 _mesa_HashLookup(struct _mesa_HashTable *table, GLuint key)
 {
+   void * volatile *page;
    void *res;
    assert(table);
+   page = direct_page(table, key);
+   if (page)
+      return page[key & (DIRECT_PAGE_SIZE - 1)];
    mtx_lock(&table->Mutex);
    res = _mesa_HashLookup_unlocked(table, key);
    mtx_unlock(&table->Mutex);
@@ -263,6 +384,8 @@ _mesa_HashInsert_unlocked(struct _mesa_HashTable *table, GLuint key, void *data)
    if (key > table->MaxKey)
       table->MaxKey = key;
 
+   direct_set(table, key, data);
+
    if (key == DELETED_KEY_VALUE) {
       table->deleted_key_data = data;
    } else {
@@ -337,6 +460,7 @@ _mesa_HashRemove(struct _mesa_HashTable *table, GLuint key)
    }
 
    mtx_lock(&table->Mutex);
+   direct_set(table, key, NULL);
    if (key == DELETED_KEY_VALUE) {
       table->deleted_key_data = NULL;
    } else {
@@ -370,10 +494,12 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
    table->InDeleteAll = GL_TRUE;
    hash_table_foreach(table->ht, entry) {
       callback((uintptr_t)entry->key, entry->data, userData);
+      direct_set(table, (uintptr_t)entry->key, NULL);
       _mesa_hash_table_remove(table->ht, entry);
    }
    if (table->deleted_key_data) {
       callback(DELETED_KEY_VALUE, table->deleted_key_data, userData);
+      direct_set(table, DELETED_KEY_VALUE, NULL);
       table->deleted_key_data = NULL;
    }
    table->InDeleteAll = GL_FALSE;
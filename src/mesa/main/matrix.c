@@ -45,6 +45,22 @@
 #include "math/m_matrix.h"
 
 
+/**
+ * Flush vertices before the top of the current matrix stack is changed.
+ * Modelview changes are flagged so immediate mode vertices can be batched
+ * across them.
+ */
+static inline void
+flush_matrix_change(struct gl_context *ctx)
+{
+   if (ctx->CurrentStack == &ctx->ModelviewMatrixStack &&
+       (ctx->Driver.NeedFlush & FLUSH_STORED_VERTICES))
+      ctx->Driver.FlushVertices(ctx, FLUSH_STORED_VERTICES | FLUSH_MODELVIEW);
+   else
+      FLUSH_VERTICES(ctx, 0);
+}
+
+
 /**
  * Apply a perspective projection matrix.
  *
@@ -68,7 +84,7 @@ _mesa_Frustum( GLdouble left, GLdouble right,
 {
    GET_CURRENT_CONTEXT(ctx);
 
-   FLUSH_VERTICES(ctx, 0);
+   flush_matrix_change(ctx);
 
    if (nearval <= 0.0 ||
        farval <= 0.0 ||
@@ -111,7 +127,7 @@ _mesa_Ortho( GLdouble left, GLdouble right,
 {
    GET_CURRENT_CONTEXT(ctx);
 
-   FLUSH_VERTICES(ctx, 0);
+   flush_matrix_change(ctx);
 
    if (MESA_VERBOSE & VERBOSE_API)
       _mesa_debug(ctx, "glOrtho(%f, %f, %f, %f, %f, %f)\n",
@@ -266,7 +282,7 @@ _mesa_PopMatrix( void )
    GET_CURRENT_CONTEXT(ctx);
    struct gl_matrix_stack *stack = ctx->CurrentStack;
 
-   FLUSH_VERTICES(ctx, 0);
+   flush_matrix_change(ctx);
 
    if (MESA_VERBOSE&VERBOSE_API)
       _mesa_debug(ctx, "glPopMatrix %s\n",
@@ -304,7 +320,7 @@ _mesa_LoadIdentity( void )
 {
    GET_CURRENT_CONTEXT(ctx);
 
-   FLUSH_VERTICES(ctx, 0);
+   flush_matrix_change(ctx);
 
    if (MESA_VERBOSE & VERBOSE_API)
       _mesa_debug(ctx, "glLoadIdentity()\n");
@@ -338,7 +354,7 @@ _mesa_LoadMatrixf( const GLfloat *m )
           m[2], m[6], m[10], m[14],
           m[3], m[7], m[11], m[15]);
 
-   FLUSH_VERTICES(ctx, 0);
+   flush_matrix_change(ctx);
    _math_matrix_loadf( ctx->CurrentStack->Top, m );
    ctx->NewState |= ctx->CurrentStack->DirtyFlag;
 }
@@ -368,7 +384,7 @@ _mesa_MultMatrixf( const GLfloat *m )
           m[2], m[6], m[10], m[14],
           m[3], m[7], m[11], m[15]);
 
-   FLUSH_VERTICES(ctx, 0);
+   flush_matrix_change(ctx);
    _math_matrix_mul_floats( ctx->CurrentStack->Top, m );
    ctx->NewState |= ctx->CurrentStack->DirtyFlag;
 }
@@ -393,7 +409,7 @@ _mesa_Rotatef( GLfloat angle, GLfloat x, GLfloat y, GLfloat z )
 {
    GET_CURRENT_CONTEXT(ctx);
 
-   FLUSH_VERTICES(ctx, 0);
+   flush_matrix_change(ctx);
    if (angle != 0.0F) {
       _math_matrix_rotate( ctx->CurrentStack->Top, angle, x, y, z);
       ctx->NewState |= ctx->CurrentStack->DirtyFlag;
@@ -419,7 +435,7 @@ _mesa_Scalef( GLfloat x, GLfloat y, GLfloat z )
 {
    GET_CURRENT_CONTEXT(ctx);
 
-   FLUSH_VERTICES(ctx, 0);
+   flush_matrix_change(ctx);
    _math_matrix_scale( ctx->CurrentStack->Top, x, y, z);
    ctx->NewState |= ctx->CurrentStack->DirtyFlag;
 }
@@ -443,7 +459,7 @@ _mesa_Translatef( GLfloat x, GLfloat y, GLfloat z )
 {
    GET_CURRENT_CONTEXT(ctx);
 
-   FLUSH_VERTICES(ctx, 0);
+   flush_matrix_change(ctx);
    _math_matrix_translate( ctx->CurrentStack->Top, x, y, z);
    ctx->NewState |= ctx->CurrentStack->DirtyFlag;
 }
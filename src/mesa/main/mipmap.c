@@ -35,11 +35,16 @@
 #include "teximage.h"
 #include "texobj.h"
 #include "texstore.h"
+#include "threadpool.h"
 #include "image.h"
 #include "macros.h"
 #include "../../gallium/auxiliary/util/u_format_rgb9e5.h"
 #include "../../gallium/auxiliary/util/u_format_r11g11b10f.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 
 
 static GLint
@@ -137,6 +142,70 @@ bytes_per_pixel(GLenum datatype, GLuint comps)
 /*@}*/
 
 
+/**
+ * do_row() for GL_UNSIGNED_BYTE, 4 components.  This is by far the most
+ * common mipmap format (RGBA8/BGRA8 textures and atlases) so the texels
+ * are filtered as whole 32-bit words: the even and odd channels are split
+ * into 16-bit lanes, summed and shifted, which gives exactly the same
+ * result as averaging each channel separately.  The 2:1 case is done
+ * four dest texels at a time with SSE2 when available.
+ */
+static void
+do_row_ubyte4(const GLvoid *srcRowA, const GLvoid *srcRowB,
+              GLuint k0, GLuint colStride,
+              GLint dstWidth, GLvoid *dstRow)
+{
+   const GLubyte *rowA = (const GLubyte *) srcRowA;
+   const GLubyte *rowB = (const GLubyte *) srcRowB;
+   GLubyte *dst = (GLubyte *) dstRow;
+   GLuint i = 0, j, k;
+
+#ifdef __SSE2__
+   if (colStride == 2) {
+      const __m128i zero = _mm_setzero_si128();
+      for (; i + 4 <= (GLuint) dstWidth; i += 4) {
+         const __m128i a0 = _mm_loadu_si128((const __m128i *) (rowA + i * 8));
+         const __m128i a1 = _mm_loadu_si128((const __m128i *) (rowA + i * 8 + 16));
+         const __m128i b0 = _mm_loadu_si128((const __m128i *) (rowB + i * 8));
+         const __m128i b1 = _mm_loadu_si128((const __m128i *) (rowB + i * 8 + 16));
+         /* vertical sums, two source texels per register */
+         const __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero),
+                                          _mm_unpacklo_epi8(b0, zero));
+         const __m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero),
+                                          _mm_unpackhi_epi8(b0, zero));
+         const __m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero),
+                                          _mm_unpacklo_epi8(b1, zero));
+         const __m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero),
+                                          _mm_unpackhi_epi8(b1, zero));
+         /* horizontal sums of the even and odd source texels */
+         __m128i d0 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1),
+                                    _mm_unpackhi_epi64(s0, s1));
+         __m128i d1 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3),
+                                    _mm_unpackhi_epi64(s2, s3));
+         d0 = _mm_srli_epi16(d0, 2);
+         d1 = _mm_srli_epi16(d1, 2);
+         _mm_storeu_si128((__m128i *) (dst + i * 4), _mm_packus_epi16(d0, d1));
+      }
+   }
+#endif
+
+   for (j = i * colStride, k = j + k0; i < (GLuint) dstWidth;
+        i++, j += colStride, k += colStride) {
+      const GLuint mask = 0x00ff00ff;
+      GLuint a0, a1, b0, b1, lo, hi;
+      memcpy(&a0, rowA + j * 4, 4);
+      memcpy(&a1, rowA + k * 4, 4);
+      memcpy(&b0, rowB + j * 4, 4);
+      memcpy(&b1, rowB + k * 4, 4);
+      lo = (a0 & mask) + (a1 & mask) + (b0 & mask) + (b1 & mask);
+      hi = ((a0 >> 8) & mask) + ((a1 >> 8) & mask) +
+           ((b0 >> 8) & mask) + ((b1 >> 8) & mask);
+      lo = ((lo >> 2) & mask) | (((hi >> 2) & mask) << 8);
+      memcpy(dst + i * 4, &lo, 4);
+   }
+}
+
+
 /**
  * Average together two rows of a source image to produce a single new
  * row in the dest image.  It's legal for the two source rows to point
@@ -161,17 +230,7 @@ do_row(GLenum datatype, GLuint comps, GLint srcWidth,
    */
 
    if (datatype == GL_UNSIGNED_BYTE && comps == 4) {
-      GLuint i, j, k;
-      const GLubyte(*rowA)[4] = (const GLubyte(*)[4]) srcRowA;
-      const GLubyte(*rowB)[4] = (const GLubyte(*)[4]) srcRowB;
-      GLubyte(*dst)[4] = (GLubyte(*)[4]) dstRow;
-      for (i = j = 0, k = k0; i < (GLuint) dstWidth;
-           i++, j += colStride, k += colStride) {
-         dst[i][0] = (rowA[j][0] + rowA[k][0] + rowB[j][0] + rowB[k][0]) / 4;
-         dst[i][1] = (rowA[j][1] + rowA[k][1] + rowB[j][1] + rowB[k][1]) / 4;
-         dst[i][2] = (rowA[j][2] + rowA[k][2] + rowB[j][2] + rowB[k][2]) / 4;
-         dst[i][3] = (rowA[j][3] + rowA[k][3] + rowB[j][3] + rowB[k][3]) / 4;
-      }
+      do_row_ubyte4(srcRowA, srcRowB, k0, colStride, dstWidth, dstRow);
    }
    else if (datatype == GL_UNSIGNED_BYTE && comps == 3) {
       GLuint i, j, k;
@@ -1441,17 +1500,22 @@ make_1d_mipmap(GLenum datatype, GLuint comps, GLint border,
 }
 
 
+/**
+ * Generate the non-border dest rows [firstRow, lastRow) of a 2D mipmap
+ * image.  Each dest row only depends on its own source rows so disjoint
+ * row ranges may be filtered concurrently.
+ */
 static void
-make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
-               GLint srcWidth, GLint srcHeight,
-	       const GLubyte *srcPtr, GLint srcRowStride,
-               GLint dstWidth, GLint dstHeight,
-	       GLubyte *dstPtr, GLint dstRowStride)
+make_2d_mipmap_rows(GLenum datatype, GLuint comps, GLint border,
+                    GLint srcWidth, GLint srcHeight,
+                    const GLubyte *srcPtr, GLint srcRowStride,
+                    GLint dstWidth, GLint dstHeight,
+                    GLubyte *dstPtr, GLint dstRowStride,
+                    GLint firstRow, GLint lastRow)
 {
    const GLint bpt = bytes_per_pixel(datatype, comps);
    const GLint srcWidthNB = srcWidth - 2 * border;  /* sizes w/out border */
    const GLint dstWidthNB = dstWidth - 2 * border;
-   const GLint dstHeightNB = dstHeight - 2 * border;
    const GLubyte *srcA, *srcB;
    GLubyte *dst;
    GLint row, srcRowStep;
@@ -1471,13 +1535,32 @@ make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
 
    dst = dstPtr + border * ((dstWidth + 1) * bpt);
 
-   for (row = 0; row < dstHeightNB; row++) {
+   srcA += firstRow * srcRowStep * srcRowStride;
+   srcB += firstRow * srcRowStep * srcRowStride;
+   dst += firstRow * dstRowStride;
+
+   for (row = firstRow; row < lastRow; row++) {
       do_row(datatype, comps, srcWidthNB, srcA, srcB,
              dstWidthNB, dst);
       srcA += srcRowStep * srcRowStride;
       srcB += srcRowStep * srcRowStride;
       dst += dstRowStride;
    }
+}
+
+
+static void
+make_2d_mipmap_border(GLenum datatype, GLuint comps, GLint border,
+                      GLint srcWidth, GLint srcHeight,
+                      const GLubyte *srcPtr, GLint srcRowStride,
+                      GLint dstWidth, GLint dstHeight,
+                      GLubyte *dstPtr, GLint dstRowStride)
+{
+   const GLint bpt = bytes_per_pixel(datatype, comps);
+   const GLint srcWidthNB = srcWidth - 2 * border;  /* sizes w/out border */
+   const GLint dstWidthNB = dstWidth - 2 * border;
+   const GLint dstHeightNB = dstHeight - 2 * border;
+   GLint row;
 
    /* This is ugly but probably won't be used much */
    if (border > 0) {
@@ -1533,6 +1616,23 @@ make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
 }
 
 
+static void
+make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
+               GLint srcWidth, GLint srcHeight,
+	       const GLubyte *srcPtr, GLint srcRowStride,
+               GLint dstWidth, GLint dstHeight,
+	       GLubyte *dstPtr, GLint dstRowStride)
+{
+   make_2d_mipmap_rows(datatype, comps, border,
+                       srcWidth, srcHeight, srcPtr, srcRowStride,
+                       dstWidth, dstHeight, dstPtr, dstRowStride,
+                       0, dstHeight - 2 * border);
+   make_2d_mipmap_border(datatype, comps, border,
+                         srcWidth, srcHeight, srcPtr, srcRowStride,
+                         dstWidth, dstHeight, dstPtr, dstRowStride);
+}
+
+
 static void
 make_3d_mipmap(GLenum datatype, GLuint comps, GLint border,
                GLint srcWidth, GLint srcHeight, GLint srcDepth,
@@ -1686,6 +1786,63 @@ make_3d_mipmap(GLenum datatype, GLuint comps, GLint border,
 }
 
 
+/**
+ * The parameters of one mipmap level generation job, which is split into
+ * bands of dest rows (2D images) or dest slices (array textures).
+ */
+struct mipmap_job
+{
+   GLenum target;
+   GLenum datatype;
+   GLuint comps;
+   GLint border;
+   GLint srcWidth, srcHeight;
+   const GLubyte **srcData;
+   GLint srcRowStride;
+   GLint dstWidth, dstHeight;
+   GLubyte **dstData;
+   GLint dstRowStride;
+};
+
+
+static GLboolean
+mipmap_band(void *data, int first, int last)
+{
+   const struct mipmap_job *job = (const struct mipmap_job *) data;
+   GLint i;
+
+   switch (job->target) {
+   case GL_TEXTURE_1D_ARRAY_EXT:
+      for (i = first; i < last; i++) {
+         make_1d_mipmap(job->datatype, job->comps, job->border,
+                        job->srcWidth, job->srcData[i],
+                        job->dstWidth, job->dstData[i]);
+      }
+      break;
+   case GL_TEXTURE_2D_ARRAY_EXT:
+   case GL_TEXTURE_CUBE_MAP_ARRAY:
+      for (i = first; i < last; i++) {
+         make_2d_mipmap(job->datatype, job->comps, job->border,
+                        job->srcWidth, job->srcHeight,
+                        job->srcData[i], job->srcRowStride,
+                        job->dstWidth, job->dstHeight,
+                        job->dstData[i], job->dstRowStride);
+      }
+      break;
+   default:
+      make_2d_mipmap_rows(job->datatype, job->comps, job->border,
+                          job->srcWidth, job->srcHeight,
+                          job->srcData[0], job->srcRowStride,
+                          job->dstWidth, job->dstHeight,
+                          job->dstData[0], job->dstRowStride,
+                          first, last);
+      break;
+   }
+
+   return GL_TRUE;
+}
+
+
 /**
  * Down-sample a texture image to produce the next lower mipmap level.
  * \param comps  components per texel (1, 2, 3 or 4)
@@ -1705,7 +1862,22 @@ _mesa_generate_mipmap_level(GLenum target,
                             GLubyte **dstData,
                             GLint dstRowStride)
 {
-   int i;
+   const size_t dstImageBytes =
+      (size_t) dstWidth * dstHeight * bytes_per_pixel(datatype, comps);
+   struct mipmap_job job;
+
+   job.target = target;
+   job.datatype = datatype;
+   job.comps = comps;
+   job.border = border;
+   job.srcWidth = srcWidth;
+   job.srcHeight = srcHeight;
+   job.srcData = srcData;
+   job.srcRowStride = srcRowStride;
+   job.dstWidth = dstWidth;
+   job.dstHeight = dstHeight;
+   job.dstData = dstData;
+   job.dstRowStride = dstRowStride;
 
    switch (target) {
    case GL_TEXTURE_1D:
@@ -1720,9 +1892,12 @@ _mesa_generate_mipmap_level(GLenum target,
    case GL_TEXTURE_CUBE_MAP_NEGATIVE_Y_ARB:
    case GL_TEXTURE_CUBE_MAP_POSITIVE_Z_ARB:
    case GL_TEXTURE_CUBE_MAP_NEGATIVE_Z_ARB:
-      make_2d_mipmap(datatype, comps, border,
-                     srcWidth, srcHeight, srcData[0], srcRowStride,
-                     dstWidth, dstHeight, dstData[0], dstRowStride);
+      /* filter bands of rows in parallel, then the border (if any) */
+      _mesa_threadpool_run_bands(mipmap_band, &job, dstHeight - 2 * border,
+                                 dstImageBytes);
+      make_2d_mipmap_border(datatype, comps, border,
+                            srcWidth, srcHeight, srcData[0], srcRowStride,
+                            dstWidth, dstHeight, dstData[0], dstRowStride);
       break;
    case GL_TEXTURE_3D:
       make_3d_mipmap(datatype, comps, border,
@@ -1734,19 +1909,14 @@ _mesa_generate_mipmap_level(GLenum target,
    case GL_TEXTURE_1D_ARRAY_EXT:
       assert(srcHeight == 1);
       assert(dstHeight == 1);
-      for (i = 0; i < dstDepth; i++) {
-	 make_1d_mipmap(datatype, comps, border,
-			srcWidth, srcData[i],
-			dstWidth, dstData[i]);
-      }
+      /* filter bands of slices in parallel */
+      _mesa_threadpool_run_bands(mipmap_band, &job, dstDepth,
+                                 dstImageBytes * dstDepth);
       break;
    case GL_TEXTURE_2D_ARRAY_EXT:
    case GL_TEXTURE_CUBE_MAP_ARRAY:
-      for (i = 0; i < dstDepth; i++) {
-	 make_2d_mipmap(datatype, comps, border,
-			srcWidth, srcHeight, srcData[i], srcRowStride,
-			dstWidth, dstHeight, dstData[i], dstRowStride);
-      }
+      _mesa_threadpool_run_bands(mipmap_band, &job, dstDepth,
+                                 dstImageBytes * dstDepth);
       break;
    case GL_TEXTURE_RECTANGLE_NV:
    case GL_TEXTURE_EXTERNAL_OES:
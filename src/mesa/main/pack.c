@@ -1240,7 +1240,7 @@ _mesa_pack_rgba_span_from_ints(struct gl_context *ctx, GLuint n, GLint rgba[][4]
 
 /**
  * Used to pack an array [][4] of RGBA float colors as specified
- * by the dstFormat, dstType and dstPacking.  Used by glReadPixels.
+ * by the dstFormat, dstType and dstPacking.
  * Historically, the RGBA values were in [0,1] and rescaled to fit
  * into GLubytes, etc.  But with new integer formats, the RGBA values
  * may have any value and we don't always rescale when converting to
@@ -1248,13 +1248,18 @@ _mesa_pack_rgba_span_from_ints(struct gl_context *ctx, GLuint n, GLint rgba[][4]
  *
  * Note: the rgba values will be modified by this function when any pixel
  * transfer ops are enabled.
+ *
+ * This does not record GL errors, and only reads the context, so it may
+ * be called from the image thread pool.
+ * \return GL_FALSE if out of memory
  */
-void
-_mesa_pack_rgba_span_float(struct gl_context *ctx, GLuint n, GLfloat rgba[][4],
-                           GLenum dstFormat, GLenum dstType,
-                           GLvoid *dstAddr,
-                           const struct gl_pixelstore_attrib *dstPacking,
-                           GLbitfield transferOps)
+GLboolean
+_mesa_try_pack_rgba_span_float(struct gl_context *ctx, GLuint n,
+                               GLfloat rgba[][4],
+                               GLenum dstFormat, GLenum dstType,
+                               GLvoid *dstAddr,
+                               const struct gl_pixelstore_attrib *dstPacking,
+                               GLbitfield transferOps)
 {
    GLfloat *luminance;
    const GLint comps = _mesa_components_in_format(dstFormat);
@@ -1267,8 +1272,7 @@ _mesa_pack_rgba_span_float(struct gl_context *ctx, GLuint n, GLfloat rgba[][4],
        dstFormat == GL_LUMINANCE_ALPHA_INTEGER_EXT) {
       luminance = malloc(n * sizeof(GLfloat));
       if (!luminance) {
-         _mesa_error(ctx, GL_OUT_OF_MEMORY, "pixel packing");
-         return;
+         return GL_FALSE;
       }
    }
    else {
@@ -2670,7 +2674,7 @@ _mesa_pack_rgba_span_float(struct gl_context *ctx, GLuint n, GLfloat rgba[][4],
       default:
          _mesa_problem(ctx, "bad type in _mesa_pack_rgba_span_float");
          free(luminance);
-         return;
+         return GL_TRUE;
    }
 
    if (dstPacking->SwapBytes) {
@@ -2684,6 +2688,25 @@ _mesa_pack_rgba_span_float(struct gl_context *ctx, GLuint n, GLfloat rgba[][4],
    }
 
    free(luminance);
+   return GL_TRUE;
+}
+
+
+/**
+ * Used to pack an array [][4] of RGBA float colors as specified
+ * by the dstFormat, dstType and dstPacking.  Used by glReadPixels.
+ * See _mesa_try_pack_rgba_span_float().
+ */
+void
+_mesa_pack_rgba_span_float(struct gl_context *ctx, GLuint n, GLfloat rgba[][4],
+                           GLenum dstFormat, GLenum dstType,
+                           GLvoid *dstAddr,
+                           const struct gl_pixelstore_attrib *dstPacking,
+                           GLbitfield transferOps)
+{
+   if (!_mesa_try_pack_rgba_span_float(ctx, n, rgba, dstFormat, dstType,
+                                       dstAddr, dstPacking, transferOps))
+      _mesa_error(ctx, GL_OUT_OF_MEMORY, "pixel packing");
 }
 
 
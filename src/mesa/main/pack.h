@@ -57,6 +57,14 @@ _mesa_pack_rgba_span_float(struct gl_context *ctx, GLuint n,
                            const struct gl_pixelstore_attrib *dstPacking,
                            GLbitfield transferOps);
 
+extern GLboolean
+_mesa_try_pack_rgba_span_float(struct gl_context *ctx, GLuint n,
+                               GLfloat rgba[][4],
+                               GLenum dstFormat, GLenum dstType,
+                               GLvoid *dstAddr,
+                               const struct gl_pixelstore_attrib *dstPacking,
+                               GLbitfield transferOps);
+
 
 extern void
 _mesa_unpack_color_span_ubyte(struct gl_context *ctx,
@@ -32,10 +32,12 @@
 #include "framebuffer.h"
 #include "formats.h"
 #include "format_unpack.h"
+#include "format_utils.h"
 #include "image.h"
 #include "mtypes.h"
 #include "pack.h"
 #include "pbo.h"
+#include "threadpool.h"
 #include "state.h"
 #include "glformats.h"
 #include "fbobject.h"
@@ -483,22 +485,202 @@ read_rgba_pixels_swizzle(struct gl_context *ctx,
    return GL_TRUE;
 }
 
-static void
-slow_read_rgba_pixels( struct gl_context *ctx,
-		       GLint x, GLint y,
-		       GLsizei width, GLsizei height,
-		       GLenum format, GLenum type,
-		       GLvoid *pixels,
-		       const struct gl_pixelstore_attrib *packing,
-		       GLbitfield transferOps )
+/**
+ * A _mesa_swizzle_and_convert() over the rows of an image, split into
+ * bands of rows for the thread pool.
+ */
+struct convert_rows_job
+{
+   GLubyte *dst;
+   int dstStride;
+   GLenum dst_type;
+   int dst_components;
+   const GLubyte *src;
+   int srcStride;
+   GLenum src_type;
+   int src_components;
+   GLubyte swizzle[4];
+   bool normalized;
+   int width;
+};
+
+
+static GLboolean
+convert_rows_band(void *data, int first, int last)
 {
+   const struct convert_rows_job *job = (const struct convert_rows_job *) data;
+   GLubyte *dst = job->dst + first * job->dstStride;
+   const GLubyte *src = job->src + first * job->srcStride;
+   int j;
+
+   for (j = first; j < last; j++) {
+      _mesa_swizzle_and_convert(dst, job->dst_type, job->dst_components,
+                                src, job->src_type, job->src_components,
+                                job->swizzle, job->normalized, job->width);
+      dst += job->dstStride;
+      src += job->srcStride;
+   }
+
+   return GL_TRUE;
+}
+
+
+/**
+ * Try to do glReadPixels of RGBA data with a single per-channel conversion
+ * from the renderbuffer's array format to the requested format and type,
+ * instead of unpacking to float RGBA and repacking.
+ * \return GL_TRUE if successful, GL_FALSE otherwise (use the slow path)
+ */
+static GLboolean
+read_rgba_pixels_array(struct gl_context *ctx,
+                       GLint x, GLint y,
+                       GLsizei width, GLsizei height,
+                       GLenum format, GLenum type,
+                       GLvoid *pixels,
+                       const struct gl_pixelstore_attrib *packing,
+                       GLbitfield transferOps)
+{
+   static const GLubyte map_r[1] = { 0 };
+   static const GLubyte map_g[1] = { 1 };
+   static const GLubyte map_b[1] = { 2 };
+   static const GLubyte map_a[1] = { 3 };
+   static const GLubyte map_rgba[4] = { 0, 1, 2, 3 };
+   static const GLubyte map_bgra[4] = { 2, 1, 0, 3 };
+   static const GLubyte map_abgr[4] = { 3, 2, 1, 0 };
    struct gl_renderbuffer *rb = ctx->ReadBuffer->_ColorReadBuffer;
    const mesa_format rbFormat = _mesa_get_srgb_format_linear(rb->Format);
-   void *rgba;
+   const GLboolean dst_is_integer = _mesa_is_enum_format_integer(format);
+   const GLubyte *dst2rgba;
+   GLubyte rgba2rb[4], swizzle[4];
+   GLenum src_type, dst_type;
+   int src_components, dst_components;
+   bool normalized, need_swap = false;
+   struct convert_rows_job job;
    GLubyte *dst, *map;
-   int dstStride, stride, j;
-   GLboolean dst_is_integer = _mesa_is_enum_format_integer(format);
-   GLboolean dst_is_uint = _mesa_is_format_unsigned(rbFormat);
+   int dstStride, stride, i;
+
+   /* The only transfer op we can handle is clamping, which is implied by
+    * converting to an unsigned normalized type.
+    */
+   if (transferOps & ~IMAGE_CLAMP_BIT)
+      return GL_FALSE;
+
+   /* Components missing from the base format would need rebasing, and
+    * luminance/intensity buffers read back with G = B = 0.
+    */
+   if (rb->_BaseFormat != _mesa_get_format_base_format(rb->Format) ||
+       rb->_BaseFormat == GL_LUMINANCE ||
+       rb->_BaseFormat == GL_LUMINANCE_ALPHA ||
+       rb->_BaseFormat == GL_INTENSITY)
+      return GL_FALSE;
+
+   if (!_mesa_format_to_array(rbFormat, &src_type, &src_components,
+                              rgba2rb, &normalized))
+      return GL_FALSE;
+
+   if (dst_is_integer != _mesa_is_format_integer(rbFormat))
+      return GL_FALSE;
+
+   switch (format) {
+   case GL_RED:
+   case GL_RED_INTEGER:
+      dst2rgba = map_r;
+      dst_components = 1;
+      break;
+   case GL_GREEN:
+   case GL_GREEN_INTEGER:
+      dst2rgba = map_g;
+      dst_components = 1;
+      break;
+   case GL_BLUE:
+   case GL_BLUE_INTEGER:
+      dst2rgba = map_b;
+      dst_components = 1;
+      break;
+   case GL_ALPHA:
+   case GL_ALPHA_INTEGER:
+      dst2rgba = map_a;
+      dst_components = 1;
+      break;
+   case GL_RG:
+   case GL_RG_INTEGER:
+      dst2rgba = map_rgba;
+      dst_components = 2;
+      break;
+   case GL_RGB:
+   case GL_RGB_INTEGER:
+      dst2rgba = map_rgba;
+      dst_components = 3;
+      break;
+   case GL_BGR:
+   case GL_BGR_INTEGER:
+      dst2rgba = map_bgra;
+      dst_components = 3;
+      break;
+   case GL_RGBA:
+   case GL_RGBA_INTEGER:
+      dst2rgba = map_rgba;
+      dst_components = 4;
+      break;
+   case GL_BGRA:
+   case GL_BGRA_INTEGER:
+      dst2rgba = map_bgra;
+      dst_components = 4;
+      break;
+   case GL_ABGR_EXT:
+      dst2rgba = map_abgr;
+      dst_components = 4;
+      break;
+   default:
+      return GL_FALSE;
+   }
+
+   switch (type) {
+   case GL_FLOAT:
+   case GL_HALF_FLOAT:
+   case GL_UNSIGNED_BYTE:
+   case GL_BYTE:
+   case GL_UNSIGNED_SHORT:
+   case GL_SHORT:
+   case GL_UNSIGNED_INT:
+   case GL_INT:
+      if (packing->SwapBytes && _mesa_sizeof_type(type) > 1)
+         return GL_FALSE;
+      dst_type = type;
+      break;
+   case GL_UNSIGNED_INT_8_8_8_8:
+      need_swap = packing->SwapBytes;
+      if (_mesa_little_endian())
+         need_swap = !need_swap;
+      dst_type = GL_UNSIGNED_BYTE;
+      break;
+   case GL_UNSIGNED_INT_8_8_8_8_REV:
+      need_swap = packing->SwapBytes;
+      if (!_mesa_little_endian())
+         need_swap = !need_swap;
+      dst_type = GL_UNSIGNED_BYTE;
+      break;
+   default:
+      return GL_FALSE;
+   }
+
+   if (need_swap && dst_components != 4)
+      return GL_FALSE;
+
+   /* Integer values that don't fit the destination type would have to be
+    * clamped, which _mesa_swizzle_and_convert doesn't do.
+    */
+   if (dst_is_integer && dst_type != src_type)
+      return GL_FALSE;
+
+   /* Clamping to [0, 1] only comes for free with unsigned destinations. */
+   if (transferOps &&
+       (dst_type == GL_FLOAT || dst_type == GL_HALF_FLOAT ||
+        !_mesa_is_type_unsigned(dst_type)))
+      return GL_FALSE;
+
+   for (i = 0; i < dst_components; i++)
+      swizzle[i] = rgba2rb[dst2rgba[need_swap ? 3 - i : i]];
 
    dstStride = _mesa_image_row_stride(packing, width, format, type);
    dst = (GLubyte *) _mesa_image_address2d(packing, pixels, width, height,
@@ -508,39 +690,142 @@ slow_read_rgba_pixels( struct gl_context *ctx,
 			       &map, &stride);
    if (!map) {
       _mesa_error(ctx, GL_OUT_OF_MEMORY, "glReadPixels");
-      return;
+      return GL_TRUE;  /* don't bother trying the slow path */
    }
 
+   job.dst = dst;
+   job.dstStride = dstStride;
+   job.dst_type = dst_type;
+   job.dst_components = dst_components;
+   job.src = map;
+   job.srcStride = stride;
+   job.src_type = src_type;
+   job.src_components = src_components;
+   memcpy(job.swizzle, swizzle, sizeof(swizzle));
+   job.normalized = normalized;
+   job.width = width;
+
+   _mesa_threadpool_run_bands(convert_rows_band, &job, height,
+                              (size_t) height * abs(dstStride));
+
+   ctx->Driver.UnmapRenderbuffer(ctx, rb);
+
+   return GL_TRUE;
+}
+
+/**
+ * Parameters of slow_read_rgba_pixels(), split into bands of rows.
+ */
+struct slow_read_job
+{
+   struct gl_context *ctx;
+   struct gl_renderbuffer *rb;
+   mesa_format rbFormat;
+   GLenum format, type;
+   const struct gl_pixelstore_attrib *packing;
+   GLbitfield transferOps;
+   GLboolean dst_is_integer, dst_is_uint;
+   GLsizei width;
+   GLubyte *dst;
+   int dstStride;
+   const GLubyte *map;
+   int stride;
+};
+
+
+static GLboolean
+slow_read_rgba_band(void *data, int first, int last)
+{
+   const struct slow_read_job *job = (const struct slow_read_job *) data;
+   struct gl_context *ctx = job->ctx;
+   GLboolean ok = GL_TRUE;
+   const GLsizei width = job->width;
+   GLubyte *dst = job->dst + first * job->dstStride;
+   const GLubyte *map = job->map + first * job->stride;
+   void *rgba;
+   int j;
+
    rgba = malloc(width * MAX_PIXEL_BYTES);
    if (!rgba)
-      goto done;
+      return GL_FALSE;
 
-   for (j = 0; j < height; j++) {
-      if (dst_is_integer) {
-	 _mesa_unpack_uint_rgba_row(rbFormat, width, map, (GLuint (*)[4]) rgba);
+   for (j = first; ok && j < last; j++) {
+      if (job->dst_is_integer) {
+	 _mesa_unpack_uint_rgba_row(job->rbFormat, width, map,
+                                    (GLuint (*)[4]) rgba);
          _mesa_rebase_rgba_uint(width, (GLuint (*)[4]) rgba,
-                                rb->_BaseFormat);
-         if (dst_is_uint) {
-            _mesa_pack_rgba_span_from_uints(ctx, width, (GLuint (*)[4]) rgba, format,
-                                            type, dst);
+                                job->rb->_BaseFormat);
+         if (job->dst_is_uint) {
+            _mesa_pack_rgba_span_from_uints(ctx, width, (GLuint (*)[4]) rgba,
+                                            job->format, job->type, dst);
          } else {
-            _mesa_pack_rgba_span_from_ints(ctx, width, (GLint (*)[4]) rgba, format,
-                                           type, dst);
+            _mesa_pack_rgba_span_from_ints(ctx, width, (GLint (*)[4]) rgba,
+                                           job->format, job->type, dst);
          }
       } else {
-	 _mesa_unpack_rgba_row(rbFormat, width, map, (GLfloat (*)[4]) rgba);
+	 _mesa_unpack_rgba_row(job->rbFormat, width, map,
+                               (GLfloat (*)[4]) rgba);
          _mesa_rebase_rgba_float(width, (GLfloat (*)[4]) rgba,
-                                 rb->_BaseFormat);
-	 _mesa_pack_rgba_span_float(ctx, width, (GLfloat (*)[4]) rgba, format,
-                                    type, dst, packing, transferOps);
+                                 job->rb->_BaseFormat);
+         ok = _mesa_try_pack_rgba_span_float(ctx, width,
+                                             (GLfloat (*)[4]) rgba,
+                                             job->format, job->type, dst,
+                                             job->packing, job->transferOps);
       }
-      dst += dstStride;
-      map += stride;
+      dst += job->dstStride;
+      map += job->stride;
    }
 
    free(rgba);
 
-done:
+   return ok;
+}
+
+
+static void
+slow_read_rgba_pixels( struct gl_context *ctx,
+		       GLint x, GLint y,
+		       GLsizei width, GLsizei height,
+		       GLenum format, GLenum type,
+		       GLvoid *pixels,
+		       const struct gl_pixelstore_attrib *packing,
+		       GLbitfield transferOps )
+{
+   struct gl_renderbuffer *rb = ctx->ReadBuffer->_ColorReadBuffer;
+   struct slow_read_job job;
+   GLubyte *dst, *map;
+   int dstStride, stride;
+
+   dstStride = _mesa_image_row_stride(packing, width, format, type);
+   dst = (GLubyte *) _mesa_image_address2d(packing, pixels, width, height,
+					   format, type, 0, 0);
+
+   ctx->Driver.MapRenderbuffer(ctx, rb, x, y, width, height, GL_MAP_READ_BIT,
+			       &map, &stride);
+   if (!map) {
+      _mesa_error(ctx, GL_OUT_OF_MEMORY, "glReadPixels");
+      return;
+   }
+
+   job.ctx = ctx;
+   job.rb = rb;
+   job.rbFormat = _mesa_get_srgb_format_linear(rb->Format);
+   job.format = format;
+   job.type = type;
+   job.packing = packing;
+   job.transferOps = transferOps;
+   job.dst_is_integer = _mesa_is_enum_format_integer(format);
+   job.dst_is_uint = _mesa_is_format_unsigned(job.rbFormat);
+   job.width = width;
+   job.dst = dst;
+   job.dstStride = dstStride;
+   job.map = map;
+   job.stride = stride;
+
+   if (!_mesa_threadpool_run_bands(slow_read_rgba_band, &job, height,
+                                   (size_t) height * width * MAX_PIXEL_BYTES))
+      _mesa_error(ctx, GL_OUT_OF_MEMORY, "glReadPixels");
+
    ctx->Driver.UnmapRenderbuffer(ctx, rb);
 }
 
@@ -571,6 +856,11 @@ read_rgba_pixels( struct gl_context *ctx,
       return;
    }
 
+   if (read_rgba_pixels_array(ctx, x, y, width, height,
+                              format, type, pixels, packing, transferOps)) {
+      return;
+   }
+
    slow_read_rgba_pixels(ctx, x, y, width, height,
 			 format, type, pixels, packing, transferOps);
 }
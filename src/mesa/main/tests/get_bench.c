@@ -0,0 +1,154 @@
+/*
+ * Copyright 2014 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Measure the cost of the glGet*v entry points over every pname the
+ * context accepts, i.e. the hash lookup, the extra checks and the
+ * conversion to the destination type.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "main/glheader.h"
+#include "main/context.h"
+#include "main/extensions.h"
+#include "main/framebuffer.h"
+#include "main/get.h"
+#include "main/version.h"
+#include "drivers/common/driverfuncs.h"
+
+
+#define MAX_PNAMES 0x1000
+#define ITERATIONS 1000
+
+
+static struct gl_context ctx;
+static GLenum pnames[MAX_PNAMES];
+static unsigned num_pnames;
+
+
+static void
+update_state(struct gl_context *ctx, GLuint new_state)
+{
+}
+
+
+static double
+get_time(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+
+   return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+/**
+ * Collects the pnames that glGetIntegerv accepts in this context. Every
+ * value fits in the 16 bits of the enum space used by the getters.
+ */
+static void
+find_pnames(void)
+{
+   GLint values[512];
+   GLenum pname;
+
+   for (pname = 1; pname < 0x10000 && num_pnames < MAX_PNAMES; pname++) {
+      _mesa_GetIntegerv(pname, values);
+      if (_mesa_GetError() == GL_NO_ERROR)
+         pnames[num_pnames++] = pname;
+   }
+}
+
+
+#define BENCH_GET(func, type)                                           \
+   do {                                                                 \
+      type values[512];                                                 \
+      unsigned i, j;                                                    \
+      double start, end;                                                \
+                                                                        \
+      start = get_time();                                               \
+      for (i = 0; i < ITERATIONS; i++) {                                \
+         for (j = 0; j < num_pnames; j++)                               \
+            func(pnames[j], values);                                    \
+      }                                                                 \
+      end = get_time();                                                 \
+                                                                        \
+      printf("%-24s %10.1f\n", #func,                                   \
+             (end - start) / ((double) ITERATIONS * num_pnames));       \
+   } while (0)
+
+
+int main(int argc, char **argv)
+{
+   struct dd_function_table driver_functions;
+   struct gl_config visual;
+   struct gl_framebuffer *fb;
+
+   memset(&visual, 0, sizeof(visual));
+   visual.rgbMode = GL_TRUE;
+   visual.doubleBufferMode = GL_TRUE;
+   visual.redBits = visual.greenBits = visual.blueBits = 8;
+   visual.alphaBits = 8;
+   visual.rgbBits = 32;
+   visual.depthBits = 24;
+   visual.stencilBits = 8;
+
+   _mesa_init_driver_functions(&driver_functions);
+   driver_functions.UpdateState = update_state;
+
+   if (!_mesa_initialize_context(&ctx, API_OPENGL_COMPAT, &visual, NULL,
+                                 &driver_functions))
+      return 1;
+
+   _mesa_enable_sw_extensions(&ctx);
+   _mesa_compute_version(&ctx);
+
+   fb = _mesa_create_framebuffer(&visual);
+   if (!fb)
+      return 1;
+
+   _mesa_make_current(&ctx, fb, fb);
+
+   find_pnames();
+
+   printf("%u pnames, GL %u.%u\n", num_pnames,
+          ctx.Version / 10, ctx.Version % 10);
+   printf("%-24s %10s\n", "entry point", "ns/call");
+
+   BENCH_GET(_mesa_GetBooleanv, GLboolean);
+   BENCH_GET(_mesa_GetFloatv, GLfloat);
+   BENCH_GET(_mesa_GetIntegerv, GLint);
+   BENCH_GET(_mesa_GetInteger64v, GLint64);
+   BENCH_GET(_mesa_GetDoublev, GLdouble);
+   BENCH_GET(_mesa_GetFixedv, GLfixed);
+
+   _mesa_make_current(NULL, NULL, NULL);
+   _mesa_reference_framebuffer(&fb, NULL);
+   _mesa_free_context_data(&ctx);
+
+   return 0;
+}
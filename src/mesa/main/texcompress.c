@@ -43,6 +43,7 @@
 #include "texcompress_s3tc.h"
 #include "texcompress_etc.h"
 #include "texcompress_bptc.h"
+#include "threadpool.h"
 
 
 /**
@@ -622,8 +623,37 @@ _mesa_get_compressed_fetch_func(mesa_format format)
 }
 
 
+struct decompress_job
+{
+   compressed_fetch_func fetch;
+   const GLubyte *src;
+   GLint stride;
+   GLuint width;
+   GLfloat *dest;
+};
+
+/** Decompress texel rows [first, last) of an image */
+static GLboolean
+decompress_rows(void *data, int first, int last)
+{
+   const struct decompress_job *job = (const struct decompress_job *) data;
+   GLfloat *dest = job->dest + (size_t) first * job->width * 4;
+   GLint i, j;
+
+   for (j = first; j < last; j++) {
+      for (i = 0; i < (GLint) job->width; i++) {
+         job->fetch(job->src, job->stride, i, j, dest);
+         dest += 4;
+      }
+   }
+
+   return GL_TRUE;
+}
+
+
 /**
  * Decompress a compressed texture image, returning a GL_RGBA/GL_FLOAT image.
+ * Large images are decompressed in bands of rows on several threads.
  * \param srcRowStride  stride in bytes between rows of blocks in the
  *                      compressed source image.
  */
@@ -632,26 +662,23 @@ _mesa_decompress_image(mesa_format format, GLuint width, GLuint height,
                        const GLubyte *src, GLint srcRowStride,
                        GLfloat *dest)
 {
-   compressed_fetch_func fetch;
-   GLuint i, j;
+   struct decompress_job job;
    GLuint bytes, bw, bh;
-   GLint stride;
 
    bytes = _mesa_get_format_bytes(format);
    _mesa_get_format_block_size(format, &bw, &bh);
 
-   fetch = _mesa_get_compressed_fetch_func(format);
-   if (!fetch) {
+   job.fetch = _mesa_get_compressed_fetch_func(format);
+   if (!job.fetch) {
       _mesa_problem(NULL, "Unexpected format in _mesa_decompress_image()");
       return;
    }
- 
-   stride = srcRowStride * bh / bytes;
 
-   for (j = 0; j < height; j++) {
-      for (i = 0; i < width; i++) {
-         fetch(src, stride, i, j, dest);
-         dest += 4;
-      }
-   }
+   job.src = src;
+   job.stride = srcRowStride * bh / bytes;
+   job.width = width;
+   job.dest = dest;
+
+   _mesa_threadpool_run_bands(decompress_rows, &job, height,
+                              (size_t) width * height * 4 * sizeof(GLfloat));
 }
@@ -33,6 +33,13 @@
 #include "texstore.h"
 #include "macros.h"
 #include "image.h"
+#include "threadpool.h"
+
+#include <float.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #define BLOCK_SIZE 4
 #define N_PARTITIONS 64
@@ -498,18 +505,19 @@ count_anchors_before_texel(int n_subsets,
    return count;
 }
 
+static const uint8_t weights2[] = { 0, 21, 43, 64 };
+static const uint8_t weights3[] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const uint8_t weights4[] =
+   { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+static const uint8_t *weights[] = {
+   NULL, NULL, weights2, weights3, weights4
+};
+
 static int32_t
 interpolate(int32_t a, int32_t b,
             int index,
             int index_bits)
 {
-   static const uint8_t weights2[] = { 0, 21, 43, 64 };
-   static const uint8_t weights3[] = { 0, 9, 18, 27, 37, 46, 55, 64 };
-   static const uint8_t weights4[] =
-      { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
-   static const uint8_t *weights[] = {
-      NULL, NULL, weights2, weights3, weights4
-   };
    int weight;
 
    weight = weights[index_bits][index];
@@ -983,292 +991,1043 @@ write_bits(struct bit_writer *writer, int n_bits, int value)
    } while (n_bits > 0);
 }
 
+/* The encoders search for a good encoding of each block rather than using a
+ * fixed mode. How much of the search space is covered depends on the
+ * GL_TEXTURE_COMPRESSION_HINT so that applications compressing at runtime
+ * can trade quality for speed.
+ */
+enum bptc_quality {
+   BPTC_QUALITY_FASTEST,
+   BPTC_QUALITY_DEFAULT,
+   BPTC_QUALITY_NICEST
+};
+
+/* Encoding a block is much slower than the plain conversions the thread
+ * pool's band size is tuned for, so the size of an encoding job is scaled
+ * by this to get smaller images split across threads too.
+ */
+#define ENCODE_COST_FACTOR 64
+
+struct bptc_unorm_encoding {
+   int mode_num;
+   int partition_num;
+   int rotation;
+   int index_selection;
+   /* Quantized endpoints without the p-bits */
+   uint8_t endpoints[3 * 2][4];
+   uint8_t pbits[3 * 2];
+   /* The color indices (or the indices of all components when the mode
+    * doesn't have separate alpha indices) followed by the alpha indices */
+   uint8_t indices[2][BLOCK_SIZE * BLOCK_SIZE];
+   uint32_t error;
+};
+
+/* The colors selectable by the indices of a subset, stored as one array per
+ * component so that the distance to all of them can be computed at once.
+ * Components which aren't being compared are left as zero.
+ */
+struct bptc_palette {
+   int16_t values[4][16];
+   int n_entries;
+};
+
+static enum bptc_quality
+get_quality(const struct gl_context *ctx)
+{
+   switch (ctx->Hint.TextureCompression) {
+   case GL_FASTEST:
+      return BPTC_QUALITY_FASTEST;
+   case GL_NICEST:
+      return BPTC_QUALITY_NICEST;
+   default:
+      return BPTC_QUALITY_DEFAULT;
+   }
+}
+
+static uint32_t
+get_partition_subsets(int n_subsets, int partition_num)
+{
+   switch (n_subsets) {
+   case 2:
+      return partition_table1[partition_num];
+   case 3:
+      return partition_table2[partition_num];
+   default:
+      return 0;
+   }
+}
+
+static int
+get_anchor_texel(int n_subsets, int partition_num, int subset)
+{
+   if (subset == 0)
+      return 0;
+   else if (n_subsets == 2)
+      return anchor_indices[0][partition_num];
+   else
+      return anchor_indices[subset][partition_num];
+}
+
+/* Finds the direction of greatest variance for the given covariance matrix
+ * with a few steps of power iteration and returns the variance along it.
+ * The axis is left as zero if the texels are all the same.
+ */
+static float
+find_principal_axis(float covariance[4][4], int n_components,
+                    int n_iterations, float axis[4])
+{
+   float next[4];
+   float length = 0.0f, scale;
+   int largest = 0;
+   int i, j, iteration;
+
+   /* Start from the row of the component which varies the most, which is
+    * usually close to the answer already */
+   for (i = 1; i < n_components; i++) {
+      if (covariance[i][i] > covariance[largest][largest])
+         largest = i;
+   }
+
+   for (i = 0; i < n_components; i++)
+      axis[i] = covariance[largest][i];
+
+   for (iteration = 0; iteration < n_iterations; iteration++) {
+      length = 0.0f;
+
+      for (i = 0; i < n_components; i++) {
+         next[i] = 0.0f;
+         for (j = 0; j < n_components; j++)
+            next[i] += covariance[i][j] * axis[j];
+         length += next[i] * next[i];
+      }
+
+      if (length <= 0.0f) {
+         memset(axis, 0, sizeof axis[0] * 4);
+         return 0.0f;
+      }
+
+      length = sqrtf(length);
+      scale = 1.0f / length;
+
+      for (i = 0; i < n_components; i++)
+         axis[i] = next[i] * scale;
+   }
+
+   return length;
+}
+
 static void
-get_average_luminance_alpha_unorm(int width, int height,
-                                  const uint8_t *src, int src_rowstride,
-                                  int *average_luminance, int *average_alpha)
+get_covariance_unorm(const uint8_t texels[][4],
+                     const int *texel_nums, int n_texels,
+                     int first_component, int n_components,
+                     float mean[4], float covariance[4][4])
 {
-   int luminance_sum = 0, alpha_sum = 0;
-   int y, x;
+   float diff[4];
+   int i, j, k;
+
+   memset(mean, 0, sizeof mean[0] * 4);
+   memset(covariance, 0, sizeof covariance[0][0] * 4 * 4);
+
+   for (i = 0; i < n_texels; i++) {
+      for (j = 0; j < n_components; j++)
+         mean[j] += texels[texel_nums[i]][first_component + j];
+   }
+
+   for (j = 0; j < n_components; j++)
+      mean[j] /= n_texels;
+
+   for (i = 0; i < n_texels; i++) {
+      for (j = 0; j < n_components; j++)
+         diff[j] = texels[texel_nums[i]][first_component + j] - mean[j];
 
-   for (y = 0; y < height; y++) {
-      for (x = 0; x < width; x++) {
-         luminance_sum += src[0] + src[1] + src[2];
-         alpha_sum += src[3];
-         src += 4;
+      for (j = 0; j < n_components; j++) {
+         for (k = j; k < n_components; k++)
+            covariance[j][k] += diff[j] * diff[k];
       }
-      src += src_rowstride - width * 4;
    }
 
-   *average_luminance = luminance_sum / (width * height);
-   *average_alpha = alpha_sum / (width * height);
+   for (j = 0; j < n_components; j++) {
+      for (k = 0; k < j; k++)
+         covariance[j][k] = covariance[k][j];
+   }
 }
 
+/* Fits a line through the given components of the texels along their
+ * principal axis and sets the endpoints to the extent of the texels when
+ * projected onto it.
+ */
 static void
-get_rgba_endpoints_unorm(int width, int height,
-                         const uint8_t *src, int src_rowstride,
-                         int average_luminance, int average_alpha,
-                         uint8_t endpoints[][4])
+fit_endpoints_unorm(const uint8_t texels[][4],
+                    const int *texel_nums, int n_texels,
+                    int first_component, int n_components,
+                    float endpoints[2][4])
 {
-   int endpoint_luminances[2];
-   int midpoint;
-   int sums[2][4];
-   int endpoint;
-   int luminance;
-   uint8_t temp[3];
-   const uint8_t *p = src;
-   int rgb_left_endpoint_count = 0;
-   int alpha_left_endpoint_count = 0;
-   int y, x, i;
-
-   memset(sums, 0, sizeof sums);
-
-   for (y = 0; y < height; y++) {
-      for (x = 0; x < width; x++) {
-         luminance = p[0] + p[1] + p[2];
-         if (luminance < average_luminance) {
-            endpoint = 0;
-            rgb_left_endpoint_count++;
-         } else {
-            endpoint = 1;
-         }
-         for (i = 0; i < 3; i++)
-            sums[endpoint][i] += p[i];
+   float mean[4], covariance[4][4], axis[4];
+   float t, t_min = FLT_MAX, t_max = -FLT_MAX;
+   int i, j;
+
+   if (n_texels == 0) {
+      for (j = 0; j < n_components; j++)
+         endpoints[0][first_component + j] =
+            endpoints[1][first_component + j] = 0.0f;
+      return;
+   }
 
-         if (p[2] < average_alpha) {
-            endpoint = 0;
-            alpha_left_endpoint_count++;
-         } else {
-            endpoint = 1;
-         }
-         sums[endpoint][3] += p[3];
+   get_covariance_unorm(texels, texel_nums, n_texels,
+                        first_component, n_components,
+                        mean, covariance);
+
+   if (find_principal_axis(covariance, n_components, 4, axis) <= 0.0f) {
+      for (j = 0; j < n_components; j++)
+         endpoints[0][first_component + j] =
+            endpoints[1][first_component + j] = mean[j];
+      return;
+   }
 
-         p += 4;
+   for (i = 0; i < n_texels; i++) {
+      t = 0.0f;
+      for (j = 0; j < n_components; j++)
+         t += (texels[texel_nums[i]][first_component + j] - mean[j]) * axis[j];
+      t_min = MIN2(t_min, t);
+      t_max = MAX2(t_max, t);
+   }
+
+   for (j = 0; j < n_components; j++) {
+      endpoints[0][first_component + j] =
+         CLAMP(mean[j] + axis[j] * t_min, 0.0f, 255.0f);
+      endpoints[1][first_component + j] =
+         CLAMP(mean[j] + axis[j] * t_max, 0.0f, 255.0f);
+   }
+}
+
+/* Moves the endpoints to the least squares fit of the texels for the
+ * weights selected by their current indices.
+ */
+static void
+refit_endpoints_unorm(const uint8_t texels[][4],
+                      const int *texel_nums, int n_texels,
+                      int first_component, int n_components,
+                      const uint8_t *indices, int index_bits,
+                      float endpoints[2][4])
+{
+   float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+   float ax[4] = { 0.0f }, bx[4] = { 0.0f };
+   float a, b, value, det;
+   int i, j;
+
+   for (i = 0; i < n_texels; i++) {
+      b = weights[index_bits][indices[texel_nums[i]]] / 64.0f;
+      a = 1.0f - b;
+
+      aa += a * a;
+      ab += a * b;
+      bb += b * b;
+
+      for (j = 0; j < n_components; j++) {
+         value = texels[texel_nums[i]][first_component + j];
+         ax[j] += a * value;
+         bx[j] += b * value;
       }
+   }
+
+   det = aa * bb - ab * ab;
+
+   /* All of the texels use the same weight */
+   if (det < 1e-4f)
+      return;
 
-      p += src_rowstride - width * 4;
+   for (j = 0; j < n_components; j++) {
+      endpoints[0][first_component + j] =
+         CLAMP((ax[j] * bb - bx[j] * ab) / det, 0.0f, 255.0f);
+      endpoints[1][first_component + j] =
+         CLAMP((bx[j] * aa - ax[j] * ab) / det, 0.0f, 255.0f);
    }
+}
 
-   if (rgb_left_endpoint_count == 0 ||
-       rgb_left_endpoint_count == width * height) {
-      for (i = 0; i < 3; i++)
-         endpoints[0][i] = endpoints[1][i] =
-            (sums[0][i] + sums[1][i]) / (width * height);
-   } else {
-      for (i = 0; i < 3; i++) {
-         endpoints[0][i] = sums[0][i] / rgb_left_endpoint_count;
-         endpoints[1][i] = (sums[1][i] /
-                            (width * height - rgb_left_endpoint_count));
+/* Quantizes an endpoint to the precision of the mode with the given p-bit
+ * (or none if pbit is negative) and returns the squared error of the
+ * values the decoder will expand it to.
+ */
+static float
+quantize_endpoint_unorm(const struct bptc_unorm_mode *mode,
+                        const float endpoint[4],
+                        int pbit,
+                        uint8_t quantized[4],
+                        uint8_t expanded[4])
+{
+   int n_components = mode->n_alpha_bits > 0 ? 4 : 3;
+   int component, n_bits, total_bits;
+   int nearest, value, max, q;
+   float diff, error, best_error, total_error = 0.0f;
+
+   for (component = 0; component < n_components; component++) {
+      n_bits = component < 3 ? mode->n_color_bits : mode->n_alpha_bits;
+      total_bits = n_bits + (pbit >= 0);
+      max = (1 << n_bits) - 1;
+
+      /* Start from the nearest value at the full precision and try its
+       * neighbours because the expansion isn't exactly linear */
+      nearest = (int) (endpoint[component] * ((1 << total_bits) - 1) /
+                       255.0f + 0.5f);
+      if (pbit >= 0)
+         nearest >>= 1;
+
+      best_error = FLT_MAX;
+
+      for (q = MAX2(nearest - 1, 0); q <= MIN2(nearest + 1, max); q++) {
+         value = pbit >= 0 ? (q << 1) | pbit : q;
+         value = expand_component(value, total_bits);
+         diff = value - endpoint[component];
+         error = diff * diff;
+
+         if (error < best_error) {
+            best_error = error;
+            quantized[component] = q;
+            expanded[component] = value;
+         }
       }
+
+      total_error += best_error;
    }
 
-   if (alpha_left_endpoint_count == 0 ||
-       alpha_left_endpoint_count == width * height) {
-      endpoints[0][3] = endpoints[1][3] =
-         (sums[0][3] + sums[1][3]) / (width * height);
-   } else {
-         endpoints[0][3] = sums[0][3] / alpha_left_endpoint_count;
-         endpoints[1][3] = (sums[1][3] /
-                            (width * height - alpha_left_endpoint_count));
+   if (n_components == 3) {
+      quantized[3] = 0;
+      expanded[3] = 255;
    }
 
-   /* We may need to swap the endpoints to ensure the most-significant bit of
-    * the first index is zero */
+   return total_error;
+}
 
-   for (endpoint = 0; endpoint < 2; endpoint++) {
-      endpoint_luminances[endpoint] =
-         endpoints[endpoint][0] +
-         endpoints[endpoint][1] +
-         endpoints[endpoint][2];
+static void
+build_palette(const uint8_t endpoints[2][4],
+              int first_component, int n_components,
+              int index_bits,
+              struct bptc_palette *palette)
+{
+   int component, index;
+
+   memset(palette->values, 0, sizeof palette->values);
+   palette->n_entries = 1 << index_bits;
+
+   for (component = first_component;
+        component < first_component + n_components;
+        component++) {
+      for (index = 0; index < palette->n_entries; index++) {
+         palette->values[component][index] =
+            interpolate(endpoints[0][component],
+                        endpoints[1][component],
+                        index,
+                        index_bits);
+      }
    }
-   midpoint = (endpoint_luminances[0] + endpoint_luminances[1]) / 2;
+}
 
-   if ((src[0] + src[1] + src[2] <= midpoint) !=
-       (endpoint_luminances[0] <= midpoint)) {
-      memcpy(temp, endpoints[0], 3);
-      memcpy(endpoints[0], endpoints[1], 3);
-      memcpy(endpoints[1], temp, 3);
+/* Computes the squared distance from the texel to every palette entry */
+static void
+get_palette_errors(const struct bptc_palette *palette,
+                   const int16_t texel[4],
+                   int32_t errors[16])
+{
+#ifdef __SSE2__
+   const __m128i r = _mm_set1_epi16(texel[0]);
+   const __m128i g = _mm_set1_epi16(texel[1]);
+   const __m128i b = _mm_set1_epi16(texel[2]);
+   const __m128i a = _mm_set1_epi16(texel[3]);
+   __m128i dr, dg, db, da, rg, ba;
+   int i;
+
+   /* Eight entries at a time. The differences fit in 16 bits so the
+    * squares of each pair of components can be summed with one madd. */
+   for (i = 0; i < palette->n_entries; i += 8) {
+      dr = _mm_sub_epi16(_mm_loadu_si128((const __m128i *)
+                                         (palette->values[0] + i)), r);
+      dg = _mm_sub_epi16(_mm_loadu_si128((const __m128i *)
+                                         (palette->values[1] + i)), g);
+      db = _mm_sub_epi16(_mm_loadu_si128((const __m128i *)
+                                         (palette->values[2] + i)), b);
+      da = _mm_sub_epi16(_mm_loadu_si128((const __m128i *)
+                                         (palette->values[3] + i)), a);
+
+      rg = _mm_unpacklo_epi16(dr, dg);
+      ba = _mm_unpacklo_epi16(db, da);
+      _mm_storeu_si128((__m128i *) (errors + i),
+                       _mm_add_epi32(_mm_madd_epi16(rg, rg),
+                                     _mm_madd_epi16(ba, ba)));
+
+      rg = _mm_unpackhi_epi16(dr, dg);
+      ba = _mm_unpackhi_epi16(db, da);
+      _mm_storeu_si128((__m128i *) (errors + i + 4),
+                       _mm_add_epi32(_mm_madd_epi16(rg, rg),
+                                     _mm_madd_epi16(ba, ba)));
+   }
+#else
+   int32_t diff;
+   int i, component;
+
+   for (i = 0; i < palette->n_entries; i++) {
+      errors[i] = 0;
+      for (component = 0; component < 4; component++) {
+         diff = palette->values[component][i] - texel[component];
+         errors[i] += diff * diff;
+      }
    }
+#endif
+}
+
+/* Picks the closest palette entry for each texel, comparing only the given
+ * components, and returns the total squared error.
+ */
+static uint32_t
+select_indices_unorm(const struct bptc_palette *palette,
+                     const uint8_t texels[][4],
+                     const int *texel_nums, int n_texels,
+                     int first_component, int n_components,
+                     uint8_t *indices)
+{
+   int32_t errors[16];
+   int16_t texel[4];
+   uint32_t total_error = 0;
+   int i, component, index, best;
+
+   for (i = 0; i < n_texels; i++) {
+      for (component = 0; component < 4; component++) {
+         if (component >= first_component &&
+             component < first_component + n_components)
+            texel[component] = texels[texel_nums[i]][component];
+         else
+            texel[component] = 0;
+      }
 
-   /* Same for the alpha endpoints */
+      get_palette_errors(palette, texel, errors);
 
-   midpoint = (endpoints[0][3] + endpoints[1][3]) / 2;
+      best = 0;
+      for (index = 1; index < palette->n_entries; index++) {
+         if (errors[index] < errors[best])
+            best = index;
+      }
 
-   if ((src[3] <= midpoint) != (endpoints[0][3] <= midpoint)) {
-      temp[0] = endpoints[0][3];
-      endpoints[0][3] = endpoints[1][3];
-      endpoints[1][3] = temp[0];
+      indices[texel_nums[i]] = best;
+      total_error += errors[best];
    }
+
+   return total_error;
 }
 
-static void
-write_rgb_indices_unorm(struct bit_writer *writer,
-                        int src_width, int src_height,
-                        const uint8_t *src, int src_rowstride,
-                        uint8_t endpoints[][4])
+/* Encodes the texels of one subset into the encoding, alternating between
+ * choosing indices for the quantized endpoints and refitting the endpoints
+ * to the indices. Returns the squared error of the subset.
+ */
+static uint32_t
+encode_unorm_subset(const struct bptc_unorm_mode *mode,
+                    const uint8_t texels[][4],
+                    const int *texel_nums, int n_texels,
+                    int subset,
+                    int color_index_bits, int alpha_index_bits,
+                    int n_refinements,
+                    struct bptc_unorm_encoding *encoding)
 {
-   int luminance;
-   int endpoint_luminances[2];
-   int endpoint;
-   int index;
-   int y, x;
+   bool separate_alpha = mode->n_secondary_index_bits > 0;
+   int n_fit_components = (separate_alpha || mode->n_alpha_bits == 0) ? 3 : 4;
+   float endpoints[2][4];
+   uint8_t quantized[2][2][4], expanded[2][2][4];
+   uint8_t decoded[2][4];
+   float errors[2][2];
+   int pbits[2];
+   uint8_t indices[2][BLOCK_SIZE * BLOCK_SIZE];
+   struct bptc_palette palette;
+   uint32_t error, best_error = UINT32_MAX;
+   int iteration, endpoint, i;
+
+   fit_endpoints_unorm(texels, texel_nums, n_texels,
+                       0, n_fit_components, endpoints);
+   if (separate_alpha)
+      fit_endpoints_unorm(texels, texel_nums, n_texels, 3, 1, endpoints);
+
+   for (iteration = 0; ; iteration++) {
+      /* Quantize the endpoints, picking the p-bits which get them closest */
+      if (mode->has_endpoint_pbits || mode->has_shared_pbits) {
+         for (endpoint = 0; endpoint < 2; endpoint++) {
+            errors[endpoint][0] =
+               quantize_endpoint_unorm(mode, endpoints[endpoint], 0,
+                                       quantized[0][endpoint],
+                                       expanded[0][endpoint]);
+            errors[endpoint][1] =
+               quantize_endpoint_unorm(mode, endpoints[endpoint], 1,
+                                       quantized[1][endpoint],
+                                       expanded[1][endpoint]);
+         }
+
+         if (mode->has_endpoint_pbits) {
+            for (endpoint = 0; endpoint < 2; endpoint++)
+               pbits[endpoint] = errors[endpoint][1] < errors[endpoint][0];
+         } else {
+            pbits[0] = pbits[1] = (errors[0][1] + errors[1][1] <
+                                   errors[0][0] + errors[1][0]);
+         }
+      } else {
+         for (endpoint = 0; endpoint < 2; endpoint++) {
+            quantize_endpoint_unorm(mode, endpoints[endpoint], -1,
+                                    quantized[0][endpoint],
+                                    expanded[0][endpoint]);
+            pbits[endpoint] = 0;
+         }
+      }
+
+      for (endpoint = 0; endpoint < 2; endpoint++)
+         memcpy(decoded[endpoint], expanded[pbits[endpoint]][endpoint], 4);
+
+      if (separate_alpha) {
+         build_palette(decoded, 0, 3, color_index_bits, &palette);
+         error = select_indices_unorm(&palette, texels, texel_nums, n_texels,
+                                      0, 3, indices[0]);
+         build_palette(decoded, 3, 1, alpha_index_bits, &palette);
+         error += select_indices_unorm(&palette, texels, texel_nums, n_texels,
+                                       3, 1, indices[1]);
+      } else {
+         build_palette(decoded, 0, 4, color_index_bits, &palette);
+         error = select_indices_unorm(&palette, texels, texel_nums, n_texels,
+                                      0, 4, indices[0]);
+      }
 
-   for (endpoint = 0; endpoint < 2; endpoint++) {
-      endpoint_luminances[endpoint] =
-         endpoints[endpoint][0] +
-         endpoints[endpoint][1] +
-         endpoints[endpoint][2];
+      if (error < best_error) {
+         best_error = error;
+
+         for (endpoint = 0; endpoint < 2; endpoint++) {
+            memcpy(encoding->endpoints[subset * 2 + endpoint],
+                   quantized[pbits[endpoint]][endpoint], 4);
+            encoding->pbits[subset * 2 + endpoint] = pbits[endpoint];
+         }
+
+         for (i = 0; i < n_texels; i++) {
+            encoding->indices[0][texel_nums[i]] = indices[0][texel_nums[i]];
+            if (separate_alpha)
+               encoding->indices[1][texel_nums[i]] = indices[1][texel_nums[i]];
+         }
+      }
+
+      if (iteration >= n_refinements || best_error == 0)
+         break;
+
+      if (separate_alpha) {
+         refit_endpoints_unorm(texels, texel_nums, n_texels, 0, 3,
+                               indices[0], color_index_bits, endpoints);
+         refit_endpoints_unorm(texels, texel_nums, n_texels, 3, 1,
+                               indices[1], alpha_index_bits, endpoints);
+      } else {
+         refit_endpoints_unorm(texels, texel_nums, n_texels,
+                               0, n_fit_components,
+                               indices[0], color_index_bits, endpoints);
+      }
    }
 
-   /* If the endpoints have the same luminance then we'll just use index 0 for
-    * all of the texels */
-   if (endpoint_luminances[0] == endpoint_luminances[1]) {
-      write_bits(writer, BLOCK_SIZE * BLOCK_SIZE * 2 - 1, 0);
+   return best_error;
+}
+
+/* The most-significant bit of the index of each subset's anchor texel is
+ * implicitly zero, so if it is set the endpoints are swapped and the indices
+ * inverted.
+ */
+static void
+fix_anchor_index(struct bptc_unorm_encoding *encoding,
+                 int subset, int anchor,
+                 int index_set,
+                 int first_component, int n_components,
+                 int index_bits,
+                 const int *texel_nums, int n_texels)
+{
+   uint8_t *endpoints[2] = {
+      encoding->endpoints[subset * 2],
+      encoding->endpoints[subset * 2 + 1]
+   };
+   uint8_t *indices = encoding->indices[index_set];
+   uint8_t t;
+   int component, i;
+
+   if (indices[anchor] < (1 << (index_bits - 1)))
       return;
+
+   for (component = first_component;
+        component < first_component + n_components;
+        component++) {
+      t = endpoints[0][component];
+      endpoints[0][component] = endpoints[1][component];
+      endpoints[1][component] = t;
    }
 
-   for (y = 0; y < src_height; y++) {
-      for (x = 0; x < src_width; x++) {
-         luminance = src[0] + src[1] + src[2];
+   /* The p-bits only exist in modes without separate alpha indices */
+   if (index_set == 0) {
+      t = encoding->pbits[subset * 2];
+      encoding->pbits[subset * 2] = encoding->pbits[subset * 2 + 1];
+      encoding->pbits[subset * 2 + 1] = t;
+   }
 
-         index = ((luminance - endpoint_luminances[0]) * 3 /
-                  (endpoint_luminances[1] - endpoint_luminances[0]));
-         if (index < 0)
-            index = 0;
-         else if (index > 3)
-            index = 3;
+   for (i = 0; i < n_texels; i++)
+      indices[texel_nums[i]] = (1 << index_bits) - 1 - indices[texel_nums[i]];
+}
+
+static void
+encode_unorm_block(const uint8_t block_texels[][4], int valid_mask,
+                   int mode_num, int partition_num,
+                   int rotation, int index_selection,
+                   int n_refinements,
+                   struct bptc_unorm_encoding *encoding)
+{
+   const struct bptc_unorm_mode *mode = bptc_unorm_modes + mode_num;
+   uint8_t texels[BLOCK_SIZE * BLOCK_SIZE][4];
+   int texel_nums[3][BLOCK_SIZE * BLOCK_SIZE];
+   int n_texels[3] = { 0, 0, 0 };
+   int color_index_bits, alpha_index_bits;
+   uint32_t subsets;
+   int subset, texel, anchor;
+
+   memcpy(texels, block_texels, sizeof texels);
 
-         assert(x != 0 || y != 0 || index < 2);
+   /* The rotation is its own inverse so it can be applied to the source to
+    * get the components the way they are stored in the block */
+   if (rotation) {
+      for (texel = 0; texel < BLOCK_SIZE * BLOCK_SIZE; texel++)
+         apply_rotation(rotation, texels[texel]);
+   }
 
-         write_bits(writer, (x == 0 && y == 0) ? 1 : 2, index);
+   subsets = get_partition_subsets(mode->n_subsets, partition_num);
 
-         src += 4;
+   for (texel = 0; texel < BLOCK_SIZE * BLOCK_SIZE; texel++) {
+      if (valid_mask & (1 << texel)) {
+         subset = (subsets >> (texel * 2)) & 3;
+         texel_nums[subset][n_texels[subset]++] = texel;
       }
+   }
 
-      /* Pad the indices out to the block size */
-      if (src_width < BLOCK_SIZE)
-         write_bits(writer, 2 * (BLOCK_SIZE - src_width), 0);
-
-      src += src_rowstride - src_width * 4;
+   if (index_selection) {
+      color_index_bits = mode->n_secondary_index_bits;
+      alpha_index_bits = mode->n_index_bits;
+   } else {
+      color_index_bits = mode->n_index_bits;
+      alpha_index_bits = mode->n_secondary_index_bits;
    }
 
-   /* Pad the indices out to the block size */
-   if (src_height < BLOCK_SIZE)
-      write_bits(writer, 2 * BLOCK_SIZE * (BLOCK_SIZE - src_height), 0);
+   encoding->mode_num = mode_num;
+   encoding->partition_num = partition_num;
+   encoding->rotation = rotation;
+   encoding->index_selection = index_selection;
+   memset(encoding->indices, 0, sizeof encoding->indices);
+   encoding->error = 0;
+
+   for (subset = 0; subset < mode->n_subsets; subset++) {
+      encoding->error += encode_unorm_subset(mode, texels,
+                                             texel_nums[subset],
+                                             n_texels[subset],
+                                             subset,
+                                             color_index_bits,
+                                             alpha_index_bits,
+                                             n_refinements,
+                                             encoding);
+
+      anchor = get_anchor_texel(mode->n_subsets, partition_num, subset);
+
+      if (mode->n_secondary_index_bits) {
+         fix_anchor_index(encoding, subset, anchor, 0, 0, 3,
+                          color_index_bits,
+                          texel_nums[subset], n_texels[subset]);
+         fix_anchor_index(encoding, subset, anchor, 1, 3, 1,
+                          alpha_index_bits,
+                          texel_nums[subset], n_texels[subset]);
+      } else {
+         fix_anchor_index(encoding, subset, anchor, 0, 0, 4,
+                          color_index_bits,
+                          texel_nums[subset], n_texels[subset]);
+      }
+   }
 }
 
 static void
-write_alpha_indices_unorm(struct bit_writer *writer,
-                          int src_width, int src_height,
-                          const uint8_t *src, int src_rowstride,
-                          uint8_t endpoints[][4])
+try_unorm_encoding(const uint8_t texels[][4], int valid_mask,
+                   int mode_num, int partition_num,
+                   int rotation, int index_selection,
+                   int n_refinements,
+                   struct bptc_unorm_encoding *best)
 {
-   int index;
-   int y, x;
+   struct bptc_unorm_encoding encoding;
 
-   /* If the endpoints have the same alpha then we'll just use index 0 for
-    * all of the texels */
-   if (endpoints[0][3] == endpoints[1][3]) {
-      write_bits(writer, BLOCK_SIZE * BLOCK_SIZE * 3 - 1, 0);
+   if (best->error == 0)
       return;
+
+   encode_unorm_block(texels, valid_mask,
+                      mode_num, partition_num,
+                      rotation, index_selection,
+                      n_refinements,
+                      &encoding);
+
+   if (encoding.error < best->error)
+      *best = encoding;
+}
+
+/* Estimates how well each partition suits the block by how far the texels
+ * of its subsets lie from their best-fit lines, and returns the n_best most
+ * promising partitions, best first.
+ */
+static int
+rank_partitions(const uint8_t texels[][4], int valid_mask,
+                int n_subsets, int n_partitions, int n_components,
+                int *best, int n_best)
+{
+   /* The components followed by the product of each pair of them */
+   static const uint8_t product_index[4][4] = {
+      { 4, 5, 6, 7 },
+      { 5, 8, 9, 10 },
+      { 6, 9, 11, 12 },
+      { 7, 10, 12, 13 }
+   };
+   int32_t moments[BLOCK_SIZE * BLOCK_SIZE][14];
+   int32_t sums[3][14];
+   float scores[N_PARTITIONS];
+   float covariance[4][4], axis[4];
+   int n_texels[3];
+   float score, variance, residual;
+   uint32_t subsets;
+   int partition_num, subset, texel, i, j, k, n_ranked = 0;
+
+   n_best = MIN2(n_best, n_partitions);
+
+   /* The covariance of each subset is built from sums of the texels and
+    * their products, so these are calculated once for all partitions and
+    * the sums for the first subset are what's left from the whole block */
+   memset(moments, 0, sizeof moments);
+   memset(sums[0], 0, sizeof sums[0]);
+   n_texels[0] = 0;
+
+   for (texel = 0; texel < BLOCK_SIZE * BLOCK_SIZE; texel++) {
+      if (!(valid_mask & (1 << texel)))
+         continue;
+
+      for (j = 0; j < 4; j++) {
+         moments[texel][j] = texels[texel][j];
+         for (k = j; k < 4; k++)
+            moments[texel][product_index[j][k]] =
+               texels[texel][j] * texels[texel][k];
+      }
+
+      for (i = 0; i < 14; i++)
+         sums[0][i] += moments[texel][i];
+      n_texels[0]++;
    }
 
-   for (y = 0; y < src_height; y++) {
-      for (x = 0; x < src_width; x++) {
-         index = (((int) src[3] - (int) endpoints[0][3]) * 7 /
-                  ((int) endpoints[1][3] - endpoints[0][3]));
-         if (index < 0)
-            index = 0;
-         else if (index > 7)
-            index = 7;
+   for (partition_num = 0; partition_num < n_partitions; partition_num++) {
+      subsets = get_partition_subsets(n_subsets, partition_num);
 
-         assert(x != 0 || y != 0 || index < 4);
+      for (subset = 1; subset < n_subsets; subset++) {
+         memset(sums[subset], 0, sizeof sums[subset]);
+         n_texels[subset] = 0;
 
-         /* The first index has one less bit */
-         write_bits(writer, (x == 0 && y == 0) ? 2 : 3, index);
+         for (texel = 0; texel < BLOCK_SIZE * BLOCK_SIZE; texel++) {
+            if (((subsets >> (texel * 2)) & 3) != subset ||
+                !(valid_mask & (1 << texel)))
+               continue;
 
-         src += 4;
+            for (i = 0; i < 14; i++)
+               sums[subset][i] += moments[texel][i];
+            n_texels[subset]++;
+         }
+      }
+
+      /* The error of fitting a line is the variance not along the line */
+      score = 0.0f;
+      for (subset = 0; subset < n_subsets; subset++) {
+         const int32_t *subset_sums = sums[subset];
+         int32_t first_sums[14];
+         int n = n_texels[subset];
+
+         if (subset == 0) {
+            for (i = 0; i < 14; i++) {
+               first_sums[i] = sums[0][i];
+               for (j = 1; j < n_subsets; j++)
+                  first_sums[i] -= sums[j][i];
+            }
+            for (j = 1; j < n_subsets; j++)
+               n -= n_texels[j];
+            subset_sums = first_sums;
+         }
+
+         if (n == 0)
+            continue;
+
+         variance = 0.0f;
+         for (j = 0; j < n_components; j++) {
+            for (k = j; k < n_components; k++) {
+               covariance[j][k] = covariance[k][j] =
+                  subset_sums[product_index[j][k]] -
+                  (float) subset_sums[j] * subset_sums[k] / n;
+            }
+            variance += covariance[j][j];
+         }
+
+         residual = variance - find_principal_axis(covariance, n_components,
+                                                   2, axis);
+         score += MAX2(residual, 0.0f);
       }
 
-      /* Pad the indices out to the block size */
-      if (src_width < BLOCK_SIZE)
-         write_bits(writer, 3 * (BLOCK_SIZE - src_width), 0);
+      /* Insertion sort into the best ones so far */
+      if (n_ranked < n_best)
+         i = n_ranked++;
+      else if (score < scores[n_best - 1])
+         i = n_best - 1;
+      else
+         continue;
+
+      for (; i > 0 && scores[i - 1] > score; i--) {
+         scores[i] = scores[i - 1];
+         best[i] = best[i - 1];
+      }
 
-      src += src_rowstride - src_width * 4;
+      scores[i] = score;
+      best[i] = partition_num;
    }
 
-   /* Pad the indices out to the block size */
-   if (src_height < BLOCK_SIZE)
-      write_bits(writer, 3 * BLOCK_SIZE * (BLOCK_SIZE - src_height), 0);
+   return n_ranked;
 }
 
 static void
-compress_rgba_unorm_block(int src_width, int src_height,
-                          const uint8_t *src, int src_rowstride,
-                          uint8_t *dst)
+try_partitioned_unorm_encodings(const uint8_t texels[][4], int valid_mask,
+                                int mode_num,
+                                const int *partitions, int n_partitions,
+                                int n_refinements,
+                                struct bptc_unorm_encoding *best)
 {
-   int average_luminance, average_alpha;
-   uint8_t endpoints[2][4];
-   struct bit_writer writer;
-   int component, endpoint;
+   int i;
+
+   for (i = 0; i < n_partitions; i++) {
+      try_unorm_encoding(texels, valid_mask, mode_num, partitions[i], 0, 0,
+                         n_refinements, best);
+   }
+}
 
-   get_average_luminance_alpha_unorm(src_width, src_height, src, src_rowstride,
-                                     &average_luminance, &average_alpha);
-   get_rgba_endpoints_unorm(src_width, src_height, src, src_rowstride,
-                            average_luminance, average_alpha,
-                            endpoints);
+static void
+write_unorm_block(const struct bptc_unorm_encoding *encoding,
+                  uint8_t *dst)
+{
+   const struct bptc_unorm_mode *mode = bptc_unorm_modes + encoding->mode_num;
+   const uint8_t *primary_indices =
+      encoding->indices[encoding->index_selection];
+   const uint8_t *secondary_indices =
+      encoding->indices[!encoding->index_selection];
+   struct bit_writer writer;
+   int component, subset, endpoint, texel;
+   bool anchor;
 
    writer.dst = dst;
    writer.pos = 0;
    writer.buf = 0;
 
-   write_bits(&writer, 5, 0x10); /* mode 4 */
-   write_bits(&writer, 2, 0); /* rotation 0 */
-   write_bits(&writer, 1, 0); /* index selection bit */
+   write_bits(&writer, encoding->mode_num + 1, 1 << encoding->mode_num);
+   write_bits(&writer, mode->n_partition_bits, encoding->partition_num);
 
-   /* Write the color endpoints */
-   for (component = 0; component < 3; component++)
-      for (endpoint = 0; endpoint < 2; endpoint++)
-         write_bits(&writer, 5, endpoints[endpoint][component] >> 3);
-
-   /* Write the alpha endpoints */
-   for (endpoint = 0; endpoint < 2; endpoint++)
-      write_bits(&writer, 6, endpoints[endpoint][3] >> 2);
-
-   write_rgb_indices_unorm(&writer,
-                           src_width, src_height,
-                           src, src_rowstride,
-                           endpoints);
-   write_alpha_indices_unorm(&writer,
-                             src_width, src_height,
-                             src, src_rowstride,
-                             endpoints);
+   if (mode->has_rotation_bits)
+      write_bits(&writer, 2, encoding->rotation);
+   if (mode->has_index_selection_bit)
+      write_bits(&writer, 1, encoding->index_selection);
+
+   for (component = 0; component < 3; component++) {
+      for (subset = 0; subset < mode->n_subsets; subset++) {
+         for (endpoint = 0; endpoint < 2; endpoint++) {
+            write_bits(&writer, mode->n_color_bits,
+                       encoding->endpoints[subset * 2 + endpoint][component]);
+         }
+      }
+   }
+
+   if (mode->n_alpha_bits > 0) {
+      for (subset = 0; subset < mode->n_subsets; subset++) {
+         for (endpoint = 0; endpoint < 2; endpoint++) {
+            write_bits(&writer, mode->n_alpha_bits,
+                       encoding->endpoints[subset * 2 + endpoint][3]);
+         }
+      }
+   }
+
+   if (mode->has_endpoint_pbits) {
+      for (subset = 0; subset < mode->n_subsets; subset++) {
+         for (endpoint = 0; endpoint < 2; endpoint++)
+            write_bits(&writer, 1, encoding->pbits[subset * 2 + endpoint]);
+      }
+   } else if (mode->has_shared_pbits) {
+      for (subset = 0; subset < mode->n_subsets; subset++)
+         write_bits(&writer, 1, encoding->pbits[subset * 2]);
+   }
+
+   for (texel = 0; texel < BLOCK_SIZE * BLOCK_SIZE; texel++) {
+      anchor = is_anchor(mode->n_subsets, encoding->partition_num, texel);
+      write_bits(&writer, mode->n_index_bits - anchor,
+                 primary_indices[texel]);
+   }
+
+   if (mode->n_secondary_index_bits) {
+      for (texel = 0; texel < BLOCK_SIZE * BLOCK_SIZE; texel++) {
+         anchor = is_anchor(mode->n_subsets, encoding->partition_num, texel);
+         write_bits(&writer, mode->n_secondary_index_bits - anchor,
+                    secondary_indices[texel]);
+      }
+   }
 }
 
 static void
-compress_rgba_unorm(int width, int height,
-                    const uint8_t *src, int src_rowstride,
-                    uint8_t *dst, int dst_rowstride)
+compress_rgba_unorm_block(int src_width, int src_height,
+                          const uint8_t *src, int src_rowstride,
+                          uint8_t *dst,
+                          enum bptc_quality quality)
 {
-   int dst_row_diff;
+   uint8_t texels[BLOCK_SIZE * BLOCK_SIZE][4];
+   struct bptc_unorm_encoding best;
+   int partitions[N_PARTITIONS];
+   int n_partitions;
+   int valid_mask = 0;
+   bool opaque = true;
+   int rotation, index_selection;
    int y, x;
 
-   if (dst_rowstride >= width * 4)
-      dst_row_diff = dst_rowstride - ((width + 3) & ~3) * 4;
-   else
-      dst_row_diff = 0;
-
-   for (y = 0; y < height; y += BLOCK_SIZE) {
-      for (x = 0; x < width; x += BLOCK_SIZE) {
-         compress_rgba_unorm_block(MIN2(width - x, BLOCK_SIZE),
-                                   MIN2(height - y, BLOCK_SIZE),
-                                   src + x * 4 + y * src_rowstride,
-                                   src_rowstride,
-                                   dst);
+   /* Texels beyond the edge of the image are left out of the fit and get
+    * index zero */
+   memset(texels, 0, sizeof texels);
+
+   for (y = 0; y < src_height; y++) {
+      for (x = 0; x < src_width; x++) {
+         memcpy(texels[y * BLOCK_SIZE + x], src + x * 4, 4);
+         valid_mask |= 1 << (y * BLOCK_SIZE + x);
+         if (src[x * 4 + 3] != 255)
+            opaque = false;
+      }
+      src += src_rowstride;
+   }
+
+   /* Mode 6 handles most blocks well so it's encoded first. This is the
+    * fallback if nothing else does better, and often makes the rest of the
+    * search stop early. The partitioned modes only try the partitions which
+    * look most promising. */
+   encode_unorm_block(texels, valid_mask, 6, 0, 0, 0,
+                      quality == BPTC_QUALITY_NICEST ? 2 : 1,
+                      &best);
+
+   switch (quality) {
+   case BPTC_QUALITY_FASTEST:
+      break;
+
+   case BPTC_QUALITY_DEFAULT:
+      if (!opaque)
+         try_unorm_encoding(texels, valid_mask, 5, 0, 0, 0, 1, &best);
+      if (best.error == 0)
+         break;
+
+      n_partitions = rank_partitions(texels, valid_mask, 2, N_PARTITIONS,
+                                     opaque ? 3 : 4, partitions, 4);
+      if (opaque) {
+         try_partitioned_unorm_encodings(texels, valid_mask, 1,
+                                         partitions, n_partitions, 1, &best);
+         try_partitioned_unorm_encodings(texels, valid_mask, 3,
+                                         partitions, n_partitions, 1, &best);
+      } else {
+         try_partitioned_unorm_encodings(texels, valid_mask, 7,
+                                         partitions, n_partitions, 1, &best);
+      }
+      break;
+
+   case BPTC_QUALITY_NICEST:
+      for (rotation = 0; rotation < 4; rotation++) {
+         try_unorm_encoding(texels, valid_mask, 5, 0, rotation, 0, 2, &best);
+         for (index_selection = 0; index_selection < 2; index_selection++) {
+            try_unorm_encoding(texels, valid_mask, 4, 0,
+                               rotation, index_selection, 2, &best);
+         }
+      }
+      if (best.error == 0)
+         break;
+
+      n_partitions = rank_partitions(texels, valid_mask, 2, N_PARTITIONS,
+                                     opaque ? 3 : 4, partitions, 16);
+
+      /* The modes without alpha are no use for translucent blocks */
+      if (!opaque) {
+         try_partitioned_unorm_encodings(texels, valid_mask, 7,
+                                         partitions, n_partitions, 2, &best);
+         break;
+      }
+
+      try_partitioned_unorm_encodings(texels, valid_mask, 1,
+                                      partitions, n_partitions, 2, &best);
+      try_partitioned_unorm_encodings(texels, valid_mask, 3,
+                                      partitions, n_partitions, 2, &best);
+
+      /* Mode 0 can only use the first 16 three-subset partitions */
+      n_partitions = rank_partitions(texels, valid_mask, 3, 16,
+                                     3, partitions, 8);
+      try_partitioned_unorm_encodings(texels, valid_mask, 0,
+                                      partitions, n_partitions, 2, &best);
+      n_partitions = rank_partitions(texels, valid_mask, 3, N_PARTITIONS,
+                                     3, partitions, 16);
+      try_partitioned_unorm_encodings(texels, valid_mask, 2,
+                                      partitions, n_partitions, 2, &best);
+      break;
+   }
+
+   write_unorm_block(&best, dst);
+}
+
+struct compress_rgba_unorm_job {
+   int width, height;
+   const uint8_t *src;
+   int src_rowstride;
+   uint8_t *dst;
+   int dst_rowstride;
+   enum bptc_quality quality;
+};
+
+static GLboolean
+compress_rgba_unorm_rows(void *data, int first, int last)
+{
+   const struct compress_rgba_unorm_job *job = data;
+   uint8_t *dst;
+   int block_row, y, x;
+
+   for (block_row = first; block_row < last; block_row++) {
+      y = block_row * BLOCK_SIZE;
+      dst = job->dst + block_row * job->dst_rowstride;
+
+      for (x = 0; x < job->width; x += BLOCK_SIZE) {
+         compress_rgba_unorm_block(MIN2(job->width - x, BLOCK_SIZE),
+                                   MIN2(job->height - y, BLOCK_SIZE),
+                                   job->src + x * 4 + y * job->src_rowstride,
+                                   job->src_rowstride,
+                                   dst,
+                                   job->quality);
          dst += BLOCK_BYTES;
       }
-      dst += dst_row_diff;
    }
+
+   return GL_TRUE;
+}
+
+static void
+compress_rgba_unorm(int width, int height,
+                    const uint8_t *src, int src_rowstride,
+                    uint8_t *dst, int dst_rowstride,
+                    enum bptc_quality quality)
+{
+   struct compress_rgba_unorm_job job;
+
+   job.width = width;
+   job.height = height;
+   job.src = src;
+   job.src_rowstride = src_rowstride;
+   job.dst = dst;
+   if (dst_rowstride >= width * 4)
+      job.dst_rowstride = dst_rowstride;
+   else
+      job.dst_rowstride = ((width + 3) & ~3) * 4;
+   job.quality = quality;
+
+   /* Each row of blocks is encoded independently */
+   _mesa_threadpool_run_bands(compress_rgba_unorm_rows, &job,
+                              (height + BLOCK_SIZE - 1) / BLOCK_SIZE,
+                              (size_t) width * height * 4 *
+                              ENCODE_COST_FACTOR);
 }
 
 GLboolean
@@ -1305,31 +2064,14 @@ _mesa_texstore_bptc_rgba_unorm(TEXSTORE_PARAMS)
 
    compress_rgba_unorm(srcWidth, srcHeight,
                        pixels, rowstride,
-                       dstSlices[0], dstRowStride);
+                       dstSlices[0], dstRowStride,
+                       get_quality(ctx));
 
    free((void *) tempImage);
 
    return GL_TRUE;
 }
 
-static float
-get_average_luminance_float(int width, int height,
-                            const float *src, int src_rowstride)
-{
-   float luminance_sum = 0;
-   int y, x;
-
-   for (y = 0; y < height; y++) {
-      for (x = 0; x < width; x++) {
-         luminance_sum += src[0] + src[1] + src[2];
-         src += 3;
-      }
-      src += (src_rowstride - width * 3 * sizeof (float)) / sizeof (float);
-   }
-
-   return luminance_sum / (width * height);
-}
-
 static float
 clamp_value(float value, bool is_signed)
 {
@@ -1349,165 +2091,511 @@ clamp_value(float value, bool is_signed)
    return value;
 }
 
+/* Converts a component to the integer space the decoder interpolates in,
+ * i.e. the inverse of finish_(un)signed_unquantize(), so that the error of
+ * an encoding can be measured exactly. This space is linear in the bits of
+ * the half float which makes the error roughly relative to the magnitude.
+ */
+static int32_t
+float_to_unquantized(float value, bool is_signed)
+{
+   int half = _mesa_float_to_half(clamp_value(value, is_signed));
+   int32_t magnitude = half & 0x7fff;
+
+   if (is_signed) {
+      magnitude = (magnitude * 32 + 30) / 31;
+      return (half & 0x8000) ? -magnitude : magnitude;
+   } else {
+      return MIN2((magnitude * 64 + 30) / 31, 0xffff);
+   }
+}
+
+/* The unpartitioned and the two-subset BC6H modes, as indices into
+ * bptc_float_modes. The one-subset modes are ordered by increasing endpoint
+ * precision and decreasing delta range. The first few two-subset modes are
+ * the ones which get picked most often, so they are all that the default
+ * quality tries.
+ */
+static const uint8_t
+bptc_float_one_subset_modes[] = { 3, 5, 7, 9 };
+
+static const uint8_t
+bptc_float_two_subset_modes[] = { 0, 2, 8, 1, 4, 6, 10, 12, 14, 16 };
+
+#define N_DEFAULT_TWO_SUBSET_FLOAT_MODES 3
+
+/* BC6H only uses the first half of the two-subset partitions */
+#define N_FLOAT_PARTITIONS 32
+
+struct bptc_float_encoding {
+   int mode_num;
+   int partition_num;
+   /* Quantized endpoints. They are sign extended for the signed formats and
+    * are not yet converted to deltas for the transformed modes */
+   int32_t endpoints[2 * 2][3];
+   uint8_t indices[BLOCK_SIZE * BLOCK_SIZE];
+   int64_t error;
+};
+
+/* Finds the endpoint value of the given size which unquantizes closest to
+ * the given value. Returns it and sets *unquantized to what the decoder will
+ * get back from it.
+ */
+static int
+quantize_endpoint_float(float value, int n_bits, bool is_signed,
+                        int32_t *unquantized)
+{
+   int nearest, q, q_min, q_max, best_q = 0;
+   int32_t decoded;
+   float scale, diff, best_diff = FLT_MAX;
+
+   if (is_signed) {
+      q_min = -(1 << (n_bits - 1));
+      q_max = (1 << (n_bits - 1)) - 1;
+   } else {
+      q_min = 0;
+      q_max = (1 << n_bits) - 1;
+   }
+
+   /* The unquantized value of q is roughly q << (16 - n_bits), except that
+    * the widest endpoints are used as is */
+   if (n_bits >= (is_signed ? 16 : 15))
+      scale = 1.0f;
+   else
+      scale = 1 << (16 - n_bits);
+
+   nearest = (int) floorf(CLAMP(value / scale, q_min, q_max) + 0.5f);
+
+   for (q = MAX2(nearest - 1, q_min); q <= MIN2(nearest + 1, q_max); q++) {
+      if (is_signed)
+         decoded = signed_unquantize(q, n_bits);
+      else
+         decoded = unsigned_unquantize(q, n_bits);
+
+      diff = fabsf(decoded - value);
+      if (diff < best_diff) {
+         best_diff = diff;
+         best_q = q;
+         *unquantized = decoded;
+      }
+   }
+
+   /* Clamping the range above guarantees there's always a candidate */
+   assert(best_diff < FLT_MAX);
+
+   return best_q;
+}
+
 static void
-get_endpoints_float(int width, int height,
-                    const float *src, int src_rowstride,
-                    float average_luminance, float endpoints[][3],
-                    bool is_signed)
+fit_endpoints_float(const float texels[][3],
+                    const int *texel_nums, int n_texels,
+                    float endpoints[2][3])
 {
-   float endpoint_luminances[2];
-   float midpoint;
-   float sums[2][3];
-   int endpoint, component;
-   float luminance;
-   float temp[3];
-   const float *p = src;
-   int left_endpoint_count = 0;
-   int y, x, i;
-
-   memset(sums, 0, sizeof sums);
-
-   for (y = 0; y < height; y++) {
-      for (x = 0; x < width; x++) {
-         luminance = p[0] + p[1] + p[2];
-         if (luminance < average_luminance) {
-            endpoint = 0;
-            left_endpoint_count++;
-         } else {
-            endpoint = 1;
-         }
-         for (i = 0; i < 3; i++)
-            sums[endpoint][i] += p[i];
+   float mean[3] = { 0.0f }, covariance[4][4], axis[4], diff[3];
+   float t, t_min = FLT_MAX, t_max = -FLT_MAX;
+   int i, j, k;
+
+   for (i = 0; i < n_texels; i++) {
+      for (j = 0; j < 3; j++)
+         mean[j] += texels[texel_nums[i]][j];
+   }
+
+   for (j = 0; j < 3; j++)
+      mean[j] /= n_texels;
+
+   memset(covariance, 0, sizeof covariance);
 
-         p += 3;
+   for (i = 0; i < n_texels; i++) {
+      for (j = 0; j < 3; j++)
+         diff[j] = texels[texel_nums[i]][j] - mean[j];
+
+      for (j = 0; j < 3; j++) {
+         for (k = 0; k < 3; k++)
+            covariance[j][k] += diff[j] * diff[k];
       }
+   }
 
-      p += (src_rowstride - width * 3 * sizeof (float)) / sizeof (float);
+   if (find_principal_axis(covariance, 3, 4, axis) <= 0.0f) {
+      for (j = 0; j < 3; j++)
+         endpoints[0][j] = endpoints[1][j] = mean[j];
+      return;
    }
 
-   if (left_endpoint_count == 0 ||
-       left_endpoint_count == width * height) {
-      for (i = 0; i < 3; i++)
-         endpoints[0][i] = endpoints[1][i] =
-            (sums[0][i] + sums[1][i]) / (width * height);
-   } else {
-      for (i = 0; i < 3; i++) {
-         endpoints[0][i] = sums[0][i] / left_endpoint_count;
-         endpoints[1][i] = sums[1][i] / (width * height - left_endpoint_count);
+   for (i = 0; i < n_texels; i++) {
+      t = 0.0f;
+      for (j = 0; j < 3; j++)
+         t += (texels[texel_nums[i]][j] - mean[j]) * axis[j];
+      t_min = MIN2(t_min, t);
+      t_max = MAX2(t_max, t);
+   }
+
+   for (j = 0; j < 3; j++) {
+      endpoints[0][j] = mean[j] + axis[j] * t_min;
+      endpoints[1][j] = mean[j] + axis[j] * t_max;
+   }
+}
+
+static void
+refit_endpoints_float(const float texels[][3],
+                      const int *texel_nums, int n_texels,
+                      const uint8_t *indices, int n_index_bits,
+                      float endpoints[2][3])
+{
+   float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+   float ax[3] = { 0.0f }, bx[3] = { 0.0f };
+   float a, b, det;
+   int i, j;
+
+   for (i = 0; i < n_texels; i++) {
+      b = weights[n_index_bits][indices[texel_nums[i]]] / 64.0f;
+      a = 1.0f - b;
+
+      aa += a * a;
+      ab += a * b;
+      bb += b * b;
+
+      for (j = 0; j < 3; j++) {
+         ax[j] += a * texels[texel_nums[i]][j];
+         bx[j] += b * texels[texel_nums[i]][j];
       }
    }
 
-   /* Clamp the endpoints to the range of a half float and strip out
-    * infinities */
-   for (endpoint = 0; endpoint < 2; endpoint++) {
-      for (component = 0; component < 3; component++) {
-         endpoints[endpoint][component] =
-            clamp_value(endpoints[endpoint][component], is_signed);
+   det = aa * bb - ab * ab;
+
+   /* All of the texels use the same weight */
+   if (det < 1e-4f)
+      return;
+
+   for (j = 0; j < 3; j++) {
+      endpoints[0][j] = (ax[j] * bb - bx[j] * ab) / det;
+      endpoints[1][j] = (bx[j] * aa - ax[j] * ab) / det;
+   }
+}
+
+/* The most-significant bit of the anchor texel's index is implicitly zero,
+ * so the endpoints are ordered to put the anchor texel nearer the first.
+ */
+static void
+orient_endpoints_float(const float *anchor_texel, float endpoints[2][3])
+{
+   float d0 = 0.0f, d1 = 0.0f, diff, t;
+   int j;
+
+   for (j = 0; j < 3; j++) {
+      diff = anchor_texel[j] - endpoints[0][j];
+      d0 += diff * diff;
+      diff = anchor_texel[j] - endpoints[1][j];
+      d1 += diff * diff;
+   }
+
+   if (d1 < d0) {
+      for (j = 0; j < 3; j++) {
+         t = endpoints[0][j];
+         endpoints[0][j] = endpoints[1][j];
+         endpoints[1][j] = t;
       }
    }
+}
 
-   /* We may need to swap the endpoints to ensure the most-significant bit of
-    * the first index is zero */
+/* Picks the index decoding closest to each texel for the given unquantized
+ * endpoints and returns the total squared error. The anchor texel is
+ * limited to the indices that can be stored without their top bit.
+ */
+static int64_t
+select_indices_float(const float texels[][3],
+                     const int *texel_nums, int n_texels,
+                     const int32_t endpoints[2][3],
+                     int n_index_bits, int anchor_texel,
+                     uint8_t *indices)
+{
+   int32_t palette[16][3];
+   int64_t error, best_error, total_error = 0;
+   const int n_entries = 1 << n_index_bits;
+   float diff;
+   int i, index, n_candidates, component;
 
-   for (endpoint = 0; endpoint < 2; endpoint++) {
-      endpoint_luminances[endpoint] =
-         endpoints[endpoint][0] +
-         endpoints[endpoint][1] +
-         endpoints[endpoint][2];
+   for (index = 0; index < n_entries; index++) {
+      for (component = 0; component < 3; component++) {
+         palette[index][component] = interpolate(endpoints[0][component],
+                                                 endpoints[1][component],
+                                                 index,
+                                                 n_index_bits);
+      }
    }
-   midpoint = (endpoint_luminances[0] + endpoint_luminances[1]) / 2.0f;
 
-   if ((src[0] + src[1] + src[2] <= midpoint) !=
-       (endpoint_luminances[0] <= midpoint)) {
-      memcpy(temp, endpoints[0], sizeof temp);
-      memcpy(endpoints[0], endpoints[1], sizeof temp);
-      memcpy(endpoints[1], temp, sizeof temp);
+   for (i = 0; i < n_texels; i++) {
+      const float *texel = texels[texel_nums[i]];
+
+      if (texel_nums[i] == anchor_texel)
+         n_candidates = n_entries / 2;
+      else
+         n_candidates = n_entries;
+
+      best_error = INT64_MAX;
+
+      for (index = 0; index < n_candidates; index++) {
+         error = 0;
+         for (component = 0; component < 3; component++) {
+            diff = palette[index][component] - texel[component];
+            error += (int64_t) (diff * diff);
+         }
+
+         if (error < best_error) {
+            best_error = error;
+            indices[texel_nums[i]] = index;
+         }
+      }
+
+      total_error += best_error;
    }
+
+   return total_error;
 }
 
+/* Quantizes the endpoints of all subsets for the mode. When the mode stores
+ * the other endpoints as deltas from the first, they are pulled towards it
+ * until the deltas fit.
+ */
 static void
-write_rgb_indices_float(struct bit_writer *writer,
-                        int src_width, int src_height,
-                        const float *src, int src_rowstride,
-                        float endpoints[][3])
+quantize_endpoints_float(const struct bptc_float_mode *mode,
+                         int n_endpoints,
+                         const float endpoints[][3],
+                         bool is_signed,
+                         int32_t quantized[][3],
+                         int32_t unquantized[][3])
 {
-   float luminance;
-   float endpoint_luminances[2];
-   int endpoint;
-   int index;
-   int y, x;
+   int endpoint, component, max_delta, delta;
 
-   for (endpoint = 0; endpoint < 2; endpoint++) {
-      endpoint_luminances[endpoint] =
-         endpoints[endpoint][0] +
-         endpoints[endpoint][1] +
-         endpoints[endpoint][2];
+   for (endpoint = 0; endpoint < n_endpoints; endpoint++) {
+      for (component = 0; component < 3; component++) {
+         quantized[endpoint][component] =
+            quantize_endpoint_float(endpoints[endpoint][component],
+                                    mode->n_endpoint_bits,
+                                    is_signed,
+                                    &unquantized[endpoint][component]);
+      }
    }
 
-   /* If the endpoints have the same luminance then we'll just use index 0 for
-    * all of the texels */
-   if (endpoint_luminances[0] == endpoint_luminances[1]) {
-      write_bits(writer, BLOCK_SIZE * BLOCK_SIZE * 4 - 1, 0);
+   if (!mode->transformed_endpoints)
       return;
+
+   for (endpoint = 1; endpoint < n_endpoints; endpoint++) {
+      for (component = 0; component < 3; component++) {
+         max_delta = (1 << (mode->n_delta_bits[component] - 1)) - 1;
+         delta = quantized[endpoint][component] - quantized[0][component];
+
+         if (delta >= -max_delta - 1 && delta <= max_delta)
+            continue;
+
+         delta = CLAMP(delta, -max_delta - 1, max_delta);
+         quantized[endpoint][component] = quantized[0][component] + delta;
+
+         if (is_signed)
+            unquantized[endpoint][component] =
+               signed_unquantize(quantized[endpoint][component],
+                                 mode->n_endpoint_bits);
+         else
+            unquantized[endpoint][component] =
+               unsigned_unquantize(quantized[endpoint][component],
+                                   mode->n_endpoint_bits);
+      }
    }
+}
 
-   for (y = 0; y < src_height; y++) {
-      for (x = 0; x < src_width; x++) {
-         luminance = src[0] + src[1] + src[2];
+static void
+encode_float_block(const float texels[][3], int valid_mask,
+                   bool is_signed,
+                   int mode_num, int partition_num,
+                   int n_refinements,
+                   struct bptc_float_encoding *encoding)
+{
+   const struct bptc_float_mode *mode = bptc_float_modes + mode_num;
+   const int n_subsets = mode->n_partition_bits ? 2 : 1;
+   const int n_endpoints = n_subsets * 2;
+   uint32_t subsets = get_partition_subsets(n_subsets, partition_num);
+   int texel_nums[2][BLOCK_SIZE * BLOCK_SIZE];
+   int n_texels[2] = { 0, 0 };
+   int anchors[2];
+   float endpoints[2 * 2][3];
+   int32_t quantized[2 * 2][3], unquantized[2 * 2][3];
+   uint8_t indices[BLOCK_SIZE * BLOCK_SIZE];
+   int64_t error;
+   int iteration, subset, texel;
+
+   encoding->mode_num = mode_num;
+   encoding->partition_num = partition_num;
+   encoding->error = INT64_MAX;
+
+   for (texel = 0; texel < BLOCK_SIZE * BLOCK_SIZE; texel++) {
+      if (!(valid_mask & (1 << texel)))
+         continue;
+
+      subset = (subsets >> (texel * 2)) & 3;
+      texel_nums[subset][n_texels[subset]++] = texel;
+   }
+
+   /* Texel 0 is always valid and in the first subset. A second subset with
+    * no valid texels just gets the endpoints of the first so that the
+    * deltas to it are small. */
+   for (subset = 0; subset < n_subsets; subset++) {
+      anchors[subset] = get_anchor_texel(n_subsets, partition_num, subset);
+
+      if (n_texels[subset] == 0) {
+         memcpy(endpoints[subset * 2], endpoints[0], sizeof endpoints[0] * 2);
+         continue;
+      }
 
-         index = ((luminance - endpoint_luminances[0]) * 15 /
-                  (endpoint_luminances[1] - endpoint_luminances[0]));
-         if (index < 0)
-            index = 0;
-         else if (index > 15)
-            index = 15;
+      fit_endpoints_float(texels, texel_nums[subset], n_texels[subset],
+                          endpoints + subset * 2);
+      orient_endpoints_float(texels[anchors[subset]], endpoints + subset * 2);
+   }
 
-         assert(x != 0 || y != 0 || index < 8);
+   memset(indices, 0, sizeof indices);
 
-         write_bits(writer, (x == 0 && y == 0) ? 3 : 4, index);
+   for (iteration = 0; ; iteration++) {
+      quantize_endpoints_float(mode, n_endpoints, endpoints, is_signed,
+                               quantized, unquantized);
 
-         src += 3;
+      error = 0;
+      for (subset = 0; subset < n_subsets; subset++) {
+         error += select_indices_float(texels,
+                                       texel_nums[subset], n_texels[subset],
+                                       unquantized + subset * 2,
+                                       mode->n_index_bits, anchors[subset],
+                                       indices);
       }
 
-      /* Pad the indices out to the block size */
-      if (src_width < BLOCK_SIZE)
-         write_bits(writer, 4 * (BLOCK_SIZE - src_width), 0);
+      if (error < encoding->error) {
+         encoding->error = error;
+         memcpy(encoding->endpoints, quantized,
+                sizeof quantized[0] * n_endpoints);
+         memcpy(encoding->indices, indices, sizeof indices);
+      }
 
-      src += (src_rowstride - src_width * 3 * sizeof (float)) / sizeof (float);
+      if (iteration >= n_refinements || encoding->error == 0)
+         break;
+
+      for (subset = 0; subset < n_subsets; subset++) {
+         if (n_texels[subset] == 0)
+            continue;
+
+         refit_endpoints_float(texels, texel_nums[subset], n_texels[subset],
+                               indices, mode->n_index_bits,
+                               endpoints + subset * 2);
+         orient_endpoints_float(texels[anchors[subset]],
+                                endpoints + subset * 2);
+      }
    }
+}
+
+static void
+try_float_encoding(const float texels[][3], int valid_mask,
+                   bool is_signed,
+                   int mode_num, int partition_num,
+                   int n_refinements,
+                   struct bptc_float_encoding *best)
+{
+   struct bptc_float_encoding encoding;
 
-   /* Pad the indices out to the block size */
-   if (src_height < BLOCK_SIZE)
-      write_bits(writer, 4 * BLOCK_SIZE * (BLOCK_SIZE - src_height), 0);
+   if (best->error == 0)
+      return;
+
+   encode_float_block(texels, valid_mask, is_signed,
+                      mode_num, partition_num,
+                      n_refinements,
+                      &encoding);
+
+   if (encoding.error < best->error)
+      *best = encoding;
 }
 
-static int
-get_endpoint_value(float value, bool is_signed)
+static void
+write_float_block(const struct bptc_float_encoding *encoding,
+                  uint8_t *dst)
 {
-   bool sign = false;
-   int half;
+   const struct bptc_float_mode *mode =
+      bptc_float_modes + encoding->mode_num;
+   const struct bptc_float_bitfield *bitfield;
+   const int n_subsets = mode->n_partition_bits ? 2 : 1;
+   int32_t stored[2 * 2][3];
+   struct bit_writer writer;
+   int endpoint, component, n_bits, value, reversed, i, texel;
 
-   if (is_signed) {
-      half = _mesa_float_to_half(value);
+   /* The transformed modes store the other endpoints as deltas from the
+    * first. Everything is stored as two's complement of its field size. */
+   for (endpoint = 0; endpoint < n_subsets * 2; endpoint++) {
+      for (component = 0; component < 3; component++) {
+         value = encoding->endpoints[endpoint][component];
 
-      if (half & 0x8000) {
-         half &= 0x7fff;
-         sign = true;
-      }
+         if (mode->transformed_endpoints && endpoint > 0) {
+            value -= encoding->endpoints[0][component];
+            n_bits = mode->n_delta_bits[component];
+         } else {
+            n_bits = mode->n_endpoint_bits;
+         }
 
-      half = (32 * half / 31) >> 6;
+         stored[endpoint][component] = value & ((1 << n_bits) - 1);
+      }
+   }
 
-      if (sign)
-         half = -half & ((1 << 10) - 1);
+   writer.dst = dst;
+   writer.pos = 0;
+   writer.buf = 0;
 
-      return half;
+   /* This is the inverse of the mode number calculation in
+    * fetch_rgb_float_from_block() */
+   if (encoding->mode_num < 2) {
+      write_bits(&writer, 2, encoding->mode_num);
    } else {
-      if (value <= 0.0f)
-         return 0;
+      write_bits(&writer, 5,
+                 ((encoding->mode_num - 2) & 1) | 2 |
+                 (((encoding->mode_num - 2) >> 1) << 2));
+   }
+
+   for (bitfield = mode->bitfields; bitfield->endpoint != -1; bitfield++) {
+      value = ((stored[bitfield->endpoint][bitfield->component] >>
+                bitfield->offset) &
+               ((1 << bitfield->n_bits) - 1));
+
+      if (bitfield->reverse) {
+         reversed = 0;
+         for (i = 0; i < bitfield->n_bits; i++) {
+            if (value & (1 << i))
+               reversed |= 1 << (bitfield->n_bits - 1 - i);
+         }
+         value = reversed;
+      }
+
+      write_bits(&writer, bitfield->n_bits, value);
+   }
 
-      half = _mesa_float_to_half(value);
+   if (mode->n_partition_bits)
+      write_bits(&writer, mode->n_partition_bits, encoding->partition_num);
 
-      return (64 * half / 31) >> 6;
+   for (texel = 0; texel < BLOCK_SIZE * BLOCK_SIZE; texel++) {
+      write_bits(&writer,
+                 mode->n_index_bits -
+                 is_anchor(n_subsets, encoding->partition_num, texel),
+                 encoding->indices[texel]);
+   }
+}
+
+static void
+try_float_modes(const float texels[][3], int valid_mask,
+                bool is_signed,
+                const uint8_t *modes, int n_modes,
+                const int *partitions, int n_partitions,
+                int n_refinements,
+                struct bptc_float_encoding *best)
+{
+   int i, j;
+
+   for (i = 0; i < n_modes; i++) {
+      for (j = 0; j < n_partitions; j++) {
+         try_float_encoding(texels, valid_mask, is_signed,
+                            modes[i], partitions[j],
+                            n_refinements, best);
+      }
    }
 }
 
@@ -1515,67 +2603,147 @@ static void
 compress_rgb_float_block(int src_width, int src_height,
                          const float *src, int src_rowstride,
                          uint8_t *dst,
-                         bool is_signed)
+                         bool is_signed,
+                         enum bptc_quality quality)
 {
-   float average_luminance;
-   float endpoints[2][3];
-   struct bit_writer writer;
-   int component, endpoint;
-   int endpoint_value;
+   float texels[BLOCK_SIZE * BLOCK_SIZE][3];
+   uint8_t ranking_texels[BLOCK_SIZE * BLOCK_SIZE][4];
+   struct bptc_float_encoding best;
+   int partitions[N_FLOAT_PARTITIONS];
+   int n_partitions, n_refinements, n_modes;
+   int valid_mask = 0;
+   int32_t value;
+   int component, texel;
+   int y, x;
 
-   average_luminance =
-      get_average_luminance_float(src_width, src_height, src, src_rowstride);
-   get_endpoints_float(src_width, src_height, src, src_rowstride,
-                       average_luminance, endpoints, is_signed);
+   /* Texels beyond the edge of the image are left out of the fit and get
+    * index zero */
+   memset(texels, 0, sizeof texels);
+   memset(ranking_texels, 0, sizeof ranking_texels);
 
-   writer.dst = dst;
-   writer.pos = 0;
-   writer.buf = 0;
+   for (y = 0; y < src_height; y++) {
+      for (x = 0; x < src_width; x++) {
+         texel = y * BLOCK_SIZE + x;
+         for (component = 0; component < 3; component++) {
+            value = float_to_unquantized(src[x * 3 + component], is_signed);
+            texels[texel][component] = value;
 
-   write_bits(&writer, 5, 3); /* mode 3 */
+            /* The partitions are ranked on the top 8 bits */
+            if (is_signed)
+               value += 0x8000;
+            ranking_texels[texel][component] = CLAMP(value >> 8, 0, 255);
+         }
+         valid_mask |= 1 << texel;
+      }
+      src += src_rowstride / sizeof (float);
+   }
 
-   /* Write the endpoints */
-   for (endpoint = 0; endpoint < 2; endpoint++) {
-      for (component = 0; component < 3; component++) {
-         endpoint_value =
-            get_endpoint_value(endpoints[endpoint][component], is_signed);
-         write_bits(&writer, 10, endpoint_value);
+   /* Mode 3 is the only one with full precision endpoints and no deltas,
+    * so it's always possible and is encoded first as the fallback. The
+    * two-subset modes only try the partitions which look most promising. */
+   encode_float_block(texels, valid_mask, is_signed, 3, 0, 0, &best);
+
+   switch (quality) {
+   case BPTC_QUALITY_FASTEST:
+      break;
+
+   case BPTC_QUALITY_DEFAULT:
+   case BPTC_QUALITY_NICEST:
+      if (quality == BPTC_QUALITY_NICEST) {
+         n_refinements = 3;
+         n_partitions = 8;
+         n_modes = Elements(bptc_float_two_subset_modes);
+      } else {
+         n_refinements = 1;
+         n_partitions = 2;
+         n_modes = N_DEFAULT_TWO_SUBSET_FLOAT_MODES;
+      }
+
+      partitions[0] = 0;
+      try_float_modes(texels, valid_mask, is_signed,
+                      bptc_float_one_subset_modes,
+                      Elements(bptc_float_one_subset_modes),
+                      partitions, 1,
+                      n_refinements, &best);
+      if (best.error == 0)
+         break;
+
+      n_partitions = rank_partitions(ranking_texels, valid_mask,
+                                     2, N_FLOAT_PARTITIONS, 3,
+                                     partitions, n_partitions);
+      try_float_modes(texels, valid_mask, is_signed,
+                      bptc_float_two_subset_modes, n_modes,
+                      partitions, n_partitions,
+                      n_refinements, &best);
+      break;
+   }
+
+   write_float_block(&best, dst);
+}
+
+struct compress_rgb_float_job {
+   int width, height;
+   const float *src;
+   int src_rowstride;
+   uint8_t *dst;
+   int dst_rowstride;
+   bool is_signed;
+   enum bptc_quality quality;
+};
+
+static GLboolean
+compress_rgb_float_rows(void *data, int first, int last)
+{
+   const struct compress_rgb_float_job *job = data;
+   uint8_t *dst;
+   int block_row, y, x;
+
+   for (block_row = first; block_row < last; block_row++) {
+      y = block_row * BLOCK_SIZE;
+      dst = job->dst + block_row * job->dst_rowstride;
+
+      for (x = 0; x < job->width; x += BLOCK_SIZE) {
+         compress_rgb_float_block(MIN2(job->width - x, BLOCK_SIZE),
+                                  MIN2(job->height - y, BLOCK_SIZE),
+                                  job->src + x * 3 +
+                                  y * job->src_rowstride / sizeof (float),
+                                  job->src_rowstride,
+                                  dst,
+                                  job->is_signed,
+                                  job->quality);
+         dst += BLOCK_BYTES;
       }
    }
 
-   write_rgb_indices_float(&writer,
-                           src_width, src_height,
-                           src, src_rowstride,
-                           endpoints);
+   return GL_TRUE;
 }
 
 static void
 compress_rgb_float(int width, int height,
                    const float *src, int src_rowstride,
                    uint8_t *dst, int dst_rowstride,
-                   bool is_signed)
+                   bool is_signed,
+                   enum bptc_quality quality)
 {
-   int dst_row_diff;
-   int y, x;
+   struct compress_rgb_float_job job;
 
+   job.width = width;
+   job.height = height;
+   job.src = src;
+   job.src_rowstride = src_rowstride;
+   job.dst = dst;
    if (dst_rowstride >= width * 4)
-      dst_row_diff = dst_rowstride - ((width + 3) & ~3) * 4;
+      job.dst_rowstride = dst_rowstride;
    else
-      dst_row_diff = 0;
-
-   for (y = 0; y < height; y += BLOCK_SIZE) {
-      for (x = 0; x < width; x += BLOCK_SIZE) {
-         compress_rgb_float_block(MIN2(width - x, BLOCK_SIZE),
-                                  MIN2(height - y, BLOCK_SIZE),
-                                  src + x * 3 +
-                                  y * src_rowstride / sizeof (float),
-                                  src_rowstride,
-                                  dst,
-                                  is_signed);
-         dst += BLOCK_BYTES;
-      }
-      dst += dst_row_diff;
-   }
+      job.dst_rowstride = ((width + 3) & ~3) * 4;
+   job.is_signed = is_signed;
+   job.quality = quality;
+
+   /* Each row of blocks is encoded independently */
+   _mesa_threadpool_run_bands(compress_rgb_float_rows, &job,
+                              (height + BLOCK_SIZE - 1) / BLOCK_SIZE,
+                              (size_t) width * height * 3 * sizeof (float) *
+                              ENCODE_COST_FACTOR);
 }
 
 static GLboolean
@@ -1615,7 +2783,8 @@ texstore_bptc_rgb_float(TEXSTORE_PARAMS,
    compress_rgb_float(srcWidth, srcHeight,
                       pixels, rowstride,
                       dstSlices[0], dstRowStride,
-                      is_signed);
+                      is_signed,
+                      get_quality(ctx));
 
    free((void *) tempImage);
 
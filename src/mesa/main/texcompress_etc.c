@@ -37,12 +37,15 @@
  * MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1
  */
 
+#include <limits.h>
 #include <stdbool.h>
 #include "texcompress.h"
 #include "texcompress_etc.h"
 #include "texstore.h"
 #include "macros.h"
 #include "format_unpack.h"
+#include "glformats.h"
+#include "threadpool.h"
 #include "util/format_srgb.h"
 
 
@@ -114,38 +117,6 @@ _mesa_texstore_etc1_rgb8(TEXSTORE_PARAMS)
 }
 
 
-/**
- * Decode texture data in format `MESA_FORMAT_ETC1_RGB8` to
- * `MESA_FORMAT_ABGR8888`.
- *
- * The size of the source data must be a multiple of the ETC1 block size,
- * which is 8, even if the texture image's dimensions are not aligned to 4.
- * From the GL_OES_compressed_ETC1_RGB8_texture spec:
- *   The texture is described as a number of 4x4 pixel blocks. If the
- *   texture (or a particular mip-level) is smaller than 4 pixels in
- *   any dimension (such as a 2x2 or a 8x1 texture), the texture is
- *   found in the upper left part of the block(s), and the rest of the
- *   pixels are not used. For instance, a texture of size 4x2 will be
- *   placed in the upper half of a 4x4 block, and the lower half of the
- *   pixels in the block will not be accessed.
- *
- * \param src_width in pixels
- * \param src_height in pixels
- * \param dst_stride in bytes
- */
-void
-_mesa_etc1_unpack_rgba8888(uint8_t *dst_row,
-                           unsigned dst_stride,
-                           const uint8_t *src_row,
-                           unsigned src_stride,
-                           unsigned src_width,
-                           unsigned src_height)
-{
-   etc1_unpack_rgba8888(dst_row, dst_stride,
-                        src_row, src_stride,
-                        src_width, src_height);
-}
-
 static uint8_t
 etc2_base_color1_t_mode(const uint8_t *in, GLuint index)
 {
@@ -549,26 +520,119 @@ etc2_rgb8_fetch_texel(const struct etc2_block *block,
    }
 }
 
+/**
+ * Decode all 16 texels of an ETC2 RGB block into texels[y][x].  Apart from
+ * planar mode, a block has at most eight distinct colors (four per subblock
+ * in individual/differential mode, four paint colors in T/H mode), so those
+ * are computed once and the texels become table lookups.  Alpha is 255
+ * except for punchthrough-transparent texels.
+ */
+static void
+etc2_rgb8_decode_block(const struct etc2_block *block,
+                       uint8_t texels[4][4][4],
+                       GLboolean punchthrough_alpha)
+{
+   uint8_t palette[2][4][4];
+   int x, y, i, blk, idx;
+
+   if (block->is_planar_mode) {
+      for (y = 0; y < 4; y++) {
+         for (x = 0; x < 4; x++) {
+            for (i = 0; i < 3; i++) {
+               int color = (x * (block->base_colors[1][i] -
+                                 block->base_colors[0][i]) +
+                            y * (block->base_colors[2][i] -
+                                 block->base_colors[0][i]) +
+                            4 * block->base_colors[0][i] + 2) >> 2;
+               texels[y][x][i] = etc2_clamp(color);
+            }
+            texels[y][x][3] = 255;
+         }
+      }
+      return;
+   }
+
+   if (block->is_ind_mode || block->is_diff_mode) {
+      for (blk = 0; blk < 2; blk++) {
+         for (idx = 0; idx < 4; idx++) {
+            const int modifier = block->modifier_tables[blk][idx];
+
+            for (i = 0; i < 3; i++)
+               palette[blk][idx][i] =
+                  etc2_clamp(block->base_colors[blk][i] + modifier);
+            palette[blk][idx][3] = 255;
+         }
+      }
+   }
+   else {
+      /* T and H modes don't have subblocks */
+      for (idx = 0; idx < 4; idx++) {
+         for (i = 0; i < 3; i++)
+            palette[0][idx][i] = block->paint_colors[idx][i];
+         palette[0][idx][3] = 255;
+      }
+      memcpy(palette[1], palette[0], sizeof(palette[0]));
+   }
+
+   if (punchthrough_alpha && !block->opaque) {
+      memset(palette[0][2], 0, 4);
+      memset(palette[1][2], 0, 4);
+   }
+
+   for (y = 0; y < 4; y++) {
+      for (x = 0; x < 4; x++) {
+         const int bit = y + x * 4;
+
+         idx = ((block->pixel_indices[0] >> (15 + bit)) & 0x2) |
+               ((block->pixel_indices[0] >>      (bit)) & 0x1);
+         blk = (block->is_ind_mode || block->is_diff_mode) &&
+               ((block->flipped) ? (y >= 2) : (x >= 2));
+
+         memcpy(texels[y][x], palette[blk][idx], 4);
+      }
+   }
+}
+
+static uint8_t
+etc2_alpha8_value(const struct etc2_block *block, int idx)
+{
+   int modifier = etc2_modifier_tables[block->table_index][idx];
+   return etc2_clamp(block->base_codeword + modifier * block->multiplier);
+}
+
 static void
 etc2_alpha8_fetch_texel(const struct etc2_block *block,
       int x, int y, uint8_t *dst)
 {
-   int modifier, alpha, idx;
-   /* get pixel index */
-   idx = etc2_get_pixel_index(block, x, y);
-   modifier = etc2_modifier_tables[block->table_index][idx];
-   alpha = block->base_codeword + modifier * block->multiplier;
-   dst[3] = etc2_clamp(alpha);
+   dst[3] = etc2_alpha8_value(block, etc2_get_pixel_index(block, x, y));
 }
 
+/**
+ * Decode the alpha channel of all 16 texels of an EAC block into
+ * texels[y][x][3], looking the values up from the block's 8 possible
+ * alphas.
+ */
 static void
-etc2_r11_fetch_texel(const struct etc2_block *block,
-                     int x, int y, uint8_t *dst)
+etc2_alpha8_decode_block(const struct etc2_block *block,
+                         uint8_t texels[4][4][4])
 {
-   GLint modifier, idx;
+   uint8_t palette[8];
+   int x, y, idx;
+
+   for (idx = 0; idx < 8; idx++)
+      palette[idx] = etc2_alpha8_value(block, idx);
+
+   for (y = 0; y < 4; y++)
+      for (x = 0; x < 4; x++)
+         texels[y][x][3] = palette[etc2_get_pixel_index(block, x, y)];
+}
+
+static GLushort
+etc2_r11_value(const struct etc2_block *block, int idx)
+{
+   GLint modifier;
    GLshort color;
-   /* Get pixel index */
-   idx = etc2_get_pixel_index(block, x, y);
+
    modifier = etc2_modifier_tables[block->table_index][idx];
 
    if (block->multiplier != 0)
@@ -584,22 +648,27 @@ etc2_r11_fetch_texel(const struct etc2_block *block,
     * 11 bits."
     */
    color = (color << 5) | (color >> 6);
-   ((GLushort *)dst)[0] = color;
+   return color;
 }
 
 static void
-etc2_signed_r11_fetch_texel(const struct etc2_block *block,
-                            int x, int y, uint8_t *dst)
+etc2_r11_fetch_texel(const struct etc2_block *block,
+                     int x, int y, uint8_t *dst)
+{
+   ((GLushort *)dst)[0] =
+      etc2_r11_value(block, etc2_get_pixel_index(block, x, y));
+}
+
+static GLshort
+etc2_signed_r11_value(const struct etc2_block *block, int idx)
 {
-   GLint modifier, idx;
+   GLint modifier;
    GLshort color;
    GLbyte base_codeword = (GLbyte) block->base_codeword;
 
    if (base_codeword == -128)
       base_codeword = -127;
 
-   /* Get pixel index */
-   idx = etc2_get_pixel_index(block, x, y);
    modifier = etc2_modifier_tables[block->table_index][idx];
 
    if (block->multiplier != 0)
@@ -622,7 +691,36 @@ etc2_signed_r11_fetch_texel(const struct etc2_block *block,
       color = (color << 5) | (color >> 5);
       color = -color;
    }
-   ((GLshort *)dst)[0] = color;
+   return color;
+}
+
+static void
+etc2_signed_r11_fetch_texel(const struct etc2_block *block,
+                            int x, int y, uint8_t *dst)
+{
+   ((GLshort *)dst)[0] =
+      etc2_signed_r11_value(block, etc2_get_pixel_index(block, x, y));
+}
+
+/**
+ * Decode all 16 texels of an (optionally signed) R11 EAC block into
+ * texels[y][x], looking the values up from the block's 8 possible colors.
+ */
+static void
+etc2_r11_decode_block(const struct etc2_block *block,
+                      GLushort texels[4][4], GLboolean is_signed)
+{
+   GLushort palette[8];
+   int x, y, idx;
+
+   for (idx = 0; idx < 8; idx++) {
+      palette[idx] = is_signed ? (GLushort) etc2_signed_r11_value(block, idx)
+                               : etc2_r11_value(block, idx);
+   }
+
+   for (y = 0; y < 4; y++)
+      for (x = 0; x < 4; x++)
+         texels[y][x] = palette[etc2_get_pixel_index(block, x, y)];
 }
 
 static void
@@ -665,17 +763,58 @@ etc2_rgba8_fetch_texel(const struct etc2_block *block,
    etc2_alpha8_fetch_texel(block, x, y, dst);
 }
 
+/**
+ * Write the visible w x h texels of a decoded block, swapping R and B for
+ * the formats that unpack to MESA_FORMAT_B8G8R8A8_SRGB.
+ */
+static void
+etc2_store_rgba_block(uint8_t *dst_row, unsigned dst_stride,
+                      uint8_t texels[4][4][4],
+                      unsigned w, unsigned h, GLboolean bgra)
+{
+   unsigned i, j;
+
+   for (j = 0; j < h; j++) {
+      uint8_t *dst = dst_row + j * dst_stride;
+
+      if (bgra) {
+         for (i = 0; i < w; i++) {
+            dst[0] = texels[j][i][2];
+            dst[1] = texels[j][i][1];
+            dst[2] = texels[j][i][0];
+            dst[3] = texels[j][i][3];
+            dst += 4;
+         }
+      }
+      else {
+         memcpy(dst, texels[j], w * 4);
+      }
+   }
+}
+
+/**
+ * Unpack the RGB8, RGBA8 EAC and punchthrough formats (and their sRGB
+ * variants) to 8-bit RGBA/BGRA.
+ */
 static void
-etc2_unpack_rgb8(uint8_t *dst_row,
-                 unsigned dst_stride,
-                 const uint8_t *src_row,
-                 unsigned src_stride,
-                 unsigned width,
-                 unsigned height)
-{
-   const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
+etc2_unpack_rgba_blocks(uint8_t *dst_row,
+                        unsigned dst_stride,
+                        const uint8_t *src_row,
+                        unsigned src_stride,
+                        unsigned width,
+                        unsigned height,
+                        GLboolean has_alpha,
+                        GLboolean punchthrough_alpha,
+                        GLboolean bgra)
+{
+   /* If internalformat is COMPRESSED_RGBA8_ETC2_EAC, each 4 × 4 block of
+    * RGBA8888 information is compressed to 128 bits: the alpha block
+    * followed by an RGB8 block.
+    */
+   const unsigned bw = 4, bh = 4, bs = has_alpha ? 16 : 8, comps = 4;
    struct etc2_block block;
-   unsigned x, y, i, j;
+   uint8_t texels[4][4][4];
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
@@ -692,19 +831,20 @@ etc2_unpack_rgb8(uint8_t *dst_row,
           */
          const unsigned w = MIN2(bw, width - x);
 
-         etc2_rgb8_parse_block(&block, src,
-                               false /* punchthrough_alpha */);
-
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     false /* punchthrough_alpha */);
-               dst[3] = 255;
-               dst += comps;
-            }
+         if (has_alpha) {
+            etc2_rgba8_parse_block(&block, src);
+            etc2_rgb8_decode_block(&block, texels,
+                                   false /* punchthrough_alpha */);
+            etc2_alpha8_decode_block(&block, texels);
+         }
+         else {
+            etc2_rgb8_parse_block(&block, src, punchthrough_alpha);
+            etc2_rgb8_decode_block(&block, texels, punchthrough_alpha);
          }
 
+         etc2_store_rgba_block(dst_row + y * dst_stride + x * comps,
+                               dst_stride, texels, w, h, bgra);
+
          src += bs;
       }
 
@@ -712,41 +852,41 @@ etc2_unpack_rgb8(uint8_t *dst_row,
    }
 }
 
+/**
+ * Unpack the one and two channel (signed) R11/RG11 EAC formats to 16 bits
+ * per channel.  Each channel is stored as its own 64-bit block.
+ */
 static void
-etc2_unpack_srgb8(uint8_t *dst_row,
-                  unsigned dst_stride,
-                  const uint8_t *src_row,
-                  unsigned src_stride,
-                  unsigned width,
-                  unsigned height)
-{
-   const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
+etc2_unpack_r11_blocks(uint8_t *dst_row,
+                       unsigned dst_stride,
+                       const uint8_t *src_row,
+                       unsigned src_stride,
+                       unsigned width,
+                       unsigned height,
+                       unsigned comps,
+                       GLboolean is_signed)
+{
+   const unsigned bw = 4, bh = 4, bs = 8 * comps;
    struct etc2_block block;
-   unsigned x, y, i, j;
-   uint8_t tmp;
+   GLushort texels[4][4];
+   unsigned x, y, i, j, c;
 
    for (y = 0; y < height; y += bh) {
-      const uint8_t *src = src_row;
       const unsigned h = MIN2(bh, height - y);
+      const uint8_t *src = src_row;
 
       for (x = 0; x < width; x+= bw) {
          const unsigned w = MIN2(bw, width - x);
-         etc2_rgb8_parse_block(&block, src,
-                               false /* punchthrough_alpha */);
-
-
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     false /* punchthrough_alpha */);
-               /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
-               tmp = dst[0];
-               dst[0] = dst[2];
-               dst[2] = tmp;
-               dst[3] = 255;
-
-               dst += comps;
+
+         for (c = 0; c < comps; c++) {
+            etc2_r11_parse_block(&block, src + 8 * c);
+            etc2_r11_decode_block(&block, texels, is_signed);
+
+            for (j = 0; j < h; j++) {
+               GLushort *dst = (GLushort *) (dst_row + (y + j) * dst_stride) +
+                               x * comps + c;
+               for (i = 0; i < w; i++)
+                  dst[i * comps] = texels[j][i];
             }
          }
          src += bs;
@@ -756,424 +896,1252 @@ etc2_unpack_srgb8(uint8_t *dst_row,
    }
 }
 
-static void
-etc2_unpack_rgba8(uint8_t *dst_row,
-                  unsigned dst_stride,
-                  const uint8_t *src_row,
-                  unsigned src_stride,
-                  unsigned width,
-                  unsigned height)
+/*
+ * Encoding
+ *
+ * The encoders take the texels of a block as texels[y][x] and pick the
+ * encoding with the least squared error.  A fast search only tries the
+ * individual, differential and planar modes with colors rounded from the
+ * subblock averages; a thorough search also tries neighbouring base colors
+ * and the T and H modes.
+ */
+
+static int
+etc2_rgb_error(const uint8_t *texel, const uint8_t *color)
 {
-   /* If internalformat is COMPRESSED_RGBA8_ETC2_EAC, each 4 × 4 block of
-    * RGBA8888 information is compressed to 128 bits. To decode a block, the
-    * two 64-bit integers int64bitAlpha and int64bitColor are calculated.
-   */
-   const unsigned bw = 4, bh = 4, bs = 16, comps = 4;
-   struct etc2_block block;
-   unsigned x, y, i, j;
+   const int dr = texel[0] - color[0];
+   const int dg = texel[1] - color[1];
+   const int db = texel[2] - color[2];
 
-   for (y = 0; y < height; y += bh) {
-      const uint8_t *src = src_row;
-      const unsigned h = MIN2(bh, height - y);
+   return dr * dr + dg * dg + db * db;
+}
 
-      for (x = 0; x < width; x+= bw) {
-         const unsigned w = MIN2(bw, width - x);
-         etc2_rgba8_parse_block(&block, src);
+static bool
+etc2_is_transparent(const uint8_t *texel)
+{
+   return texel[3] < 128;
+}
 
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgba8_fetch_texel(&block, i, j, dst);
-               dst += comps;
-            }
-         }
-         src += bs;
-      }
+/**
+ * Set the 2-bit index of texel (x, y) in the pixel index word of an
+ * individual, differential, T or H mode block.
+ */
+static uint32_t
+etc2_rgb_index_bits(int x, int y, int idx)
+{
+   const int bit = y + x * 4;
 
-      src_row += src_stride;
-   }
+   return ((uint32_t) (idx >> 1) << (bit + 16)) | ((uint32_t) (idx & 1) << bit);
 }
 
-static void
-etc2_unpack_srgb8_alpha8(uint8_t *dst_row,
-                         unsigned dst_stride,
-                         const uint8_t *src_row,
-                         unsigned src_stride,
-                         unsigned width,
-                         unsigned height)
+/**
+ * Pick the closest of four palette colors for each texel in the mask,
+ * returning the total error and setting the index bits.  Transparent
+ * texels of a non-opaque punchthrough block must use index 2, which
+ * opaque texels then can't use.
+ */
+static int
+etc2_select_rgb_indices(const uint8_t texels[4][4][4], unsigned mask,
+                        uint8_t palette[4][3], bool non_opaque,
+                        int max_error, uint32_t *indices)
 {
-   /* If internalformat is COMPRESSED_SRGB8_ALPHA8_ETC2_EAC, each 4 × 4 block
-    * of RGBA8888 information is compressed to 128 bits. To decode a block, the
-    * two 64-bit integers int64bitAlpha and int64bitColor are calculated.
-    */
-   const unsigned bw = 4, bh = 4, bs = 16, comps = 4;
-   struct etc2_block block;
-   unsigned x, y, i, j;
-   uint8_t tmp;
+   int x, y, idx, error, best_idx, best_error, total = 0;
 
-   for (y = 0; y < height; y += bh) {
-      const unsigned h = MIN2(bh, height - y);
-      const uint8_t *src = src_row;
+   *indices = 0;
 
-      for (x = 0; x < width; x+= bw) {
-         const unsigned w = MIN2(bw, width - x);
-         etc2_rgba8_parse_block(&block, src);
+   for (y = 0; y < 4; y++) {
+      for (x = 0; x < 4; x++) {
+         if (!(mask & (1 << (y * 4 + x))))
+            continue;
+
+         if (non_opaque && etc2_is_transparent(texels[y][x])) {
+            *indices |= etc2_rgb_index_bits(x, y, 2);
+            continue;
+         }
 
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgba8_fetch_texel(&block, i, j, dst);
+         best_idx = 0;
+         best_error = INT_MAX;
 
-               /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
-               tmp = dst[0];
-               dst[0] = dst[2];
-               dst[2] = tmp;
-               dst[3] = dst[3];
+         for (idx = 0; idx < 4; idx++) {
+            if (non_opaque && idx == 2)
+               continue;
 
-               dst += comps;
+            error = etc2_rgb_error(texels[y][x], palette[idx]);
+            if (error < best_error) {
+               best_error = error;
+               best_idx = idx;
             }
          }
-         src += bs;
-      }
 
-      src_row += src_stride;
+         *indices |= etc2_rgb_index_bits(x, y, best_idx);
+         total += best_error;
+
+         /* This can't beat what the caller already has */
+         if (total >= max_error)
+            return total;
+      }
    }
+
+   return total;
 }
 
-static void
-etc2_unpack_r11(uint8_t *dst_row,
-                unsigned dst_stride,
-                const uint8_t *src_row,
-                unsigned src_stride,
-                unsigned width,
-                unsigned height)
-{
-   /* If internalformat is COMPRESSED_R11_EAC, each 4 × 4 block of
-      color information is compressed to 64 bits.
-   */
-   const unsigned bw = 4, bh = 4, bs = 8, comps = 1, comp_size = 2;
-   struct etc2_block block;
-   unsigned x, y, i, j;
+static unsigned
+etc2_subblock_mask(bool flipped, int subblock)
+{
+   if (flipped)
+      return subblock ? 0xff00 : 0x00ff;
+   else
+      return subblock ? 0xcccc : 0x3333;
+}
 
-   for (y = 0; y < height; y += bh) {
-      const unsigned h = MIN2(bh, height - y);
-      const uint8_t *src = src_row;
+/**
+ * Find the modifier table giving the least error for one subblock around
+ * the given base color.  Returns the error and sets the table and indices.
+ */
+static int
+etc2_fit_subblock(const uint8_t texels[4][4][4], unsigned mask,
+                  const uint8_t base[3], bool non_opaque,
+                  int *table, uint32_t *indices)
+{
+   uint8_t palette[4][3];
+   uint32_t table_indices;
+   int t, idx, i, error, best_error = INT_MAX;
 
-      for (x = 0; x < width; x+= bw) {
-         const unsigned w = MIN2(bw, width - x);
-         etc2_r11_parse_block(&block, src);
+   for (t = 0; t < 8; t++) {
+      const int *modifiers = non_opaque ? etc2_modifier_tables_non_opaque[t]
+                                        : etc1_modifier_tables[t];
 
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps * comp_size;
-            for (i = 0; i < w; i++) {
-               etc2_r11_fetch_texel(&block, i, j, dst);
-               dst += comps * comp_size;
-            }
-         }
-         src += bs;
+      for (idx = 0; idx < 4; idx++) {
+         for (i = 0; i < 3; i++)
+            palette[idx][i] = etc2_clamp(base[i] + modifiers[idx]);
       }
 
-      src_row += src_stride;
+      error = etc2_select_rgb_indices(texels, mask, palette, non_opaque,
+                                      best_error, &table_indices);
+      if (error < best_error) {
+         best_error = error;
+         *table = t;
+         *indices = table_indices;
+      }
    }
+
+   return best_error;
 }
 
 static void
-etc2_unpack_rg11(uint8_t *dst_row,
-                 unsigned dst_stride,
-                 const uint8_t *src_row,
-                 unsigned src_stride,
-                 unsigned width,
-                 unsigned height)
-{
-   /* If internalformat is COMPRESSED_RG11_EAC, each 4 × 4 block of
-      RG color information is compressed to 128 bits.
-   */
-   const unsigned bw = 4, bh = 4, bs = 16, comps = 2, comp_size = 2;
-   struct etc2_block block;
-   unsigned x, y, i, j;
+etc2_subblock_average(const uint8_t texels[4][4][4], unsigned mask,
+                      bool non_opaque, float average[3])
+{
+   int x, y, i, count = 0;
 
-   for (y = 0; y < height; y += bh) {
-      const unsigned h = MIN2(bh, height - y);
-      const uint8_t *src = src_row;
+   average[0] = average[1] = average[2] = 0.0f;
 
-      for (x = 0; x < width; x+= bw) {
-         const unsigned w = MIN2(bw, width - x);
-         /* red component */
-         etc2_r11_parse_block(&block, src);
-
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride +
-                           x * comps * comp_size;
-            for (i = 0; i < w; i++) {
-               etc2_r11_fetch_texel(&block, i, j, dst);
-               dst += comps * comp_size;
-            }
-         }
-         /* green component */
-         etc2_r11_parse_block(&block, src + 8);
-
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride +
-                           x * comps * comp_size;
-            for (i = 0; i < w; i++) {
-               etc2_r11_fetch_texel(&block, i, j, dst + comp_size);
-               dst += comps * comp_size;
-            }
-         }
-         src += bs;
+   for (y = 0; y < 4; y++) {
+      for (x = 0; x < 4; x++) {
+         if (!(mask & (1 << (y * 4 + x))) ||
+             (non_opaque && etc2_is_transparent(texels[y][x])))
+            continue;
+
+         for (i = 0; i < 3; i++)
+            average[i] += texels[y][x][i];
+         count++;
       }
+   }
 
-      src_row += src_stride;
+   if (count) {
+      for (i = 0; i < 3; i++)
+         average[i] /= count;
    }
 }
 
 static void
-etc2_unpack_signed_r11(uint8_t *dst_row,
-                       unsigned dst_stride,
-                       const uint8_t *src_row,
-                       unsigned src_stride,
-                       unsigned width,
-                       unsigned height)
+etc2_write_rgb_indices(uint8_t *dst, uint32_t indices)
 {
-   /* If internalformat is COMPRESSED_SIGNED_R11_EAC, each 4 × 4 block of
-      red color information is compressed to 64 bits.
-   */
-   const unsigned bw = 4, bh = 4, bs = 8, comps = 1, comp_size = 2;
-   struct etc2_block block;
-   unsigned x, y, i, j;
-
-   for (y = 0; y < height; y += bh) {
-      const unsigned h = MIN2(bh, height - y);
-      const uint8_t *src = src_row;
+   dst[4] = indices >> 24;
+   dst[5] = indices >> 16;
+   dst[6] = indices >> 8;
+   dst[7] = indices;
+}
 
-      for (x = 0; x < width; x+= bw) {
-         const unsigned w = MIN2(bw, width - x);
-         etc2_r11_parse_block(&block, src);
-
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride +
-                           x * comps * comp_size;
-            for (i = 0; i < w; i++) {
-               etc2_signed_r11_fetch_texel(&block, i, j, dst);
-               dst += comps * comp_size;
+/**
+ * Try the individual and differential modes, which are shared with ETC1.
+ * Punchthrough blocks only have the differential mode, where the bit that
+ * would select it says whether the block is opaque instead.
+ */
+static int
+etc2_encode_etc1_modes(const uint8_t texels[4][4][4],
+                       bool punchthrough, bool non_opaque, bool thorough,
+                       int best_error, uint8_t *dst)
+{
+   static const int offsets[] = { 0, -1, 1, -2, 2 };
+   const int n_offsets = thorough ? 5 : 1;
+   float average[2][3];
+   uint8_t base[3], best_base[2][3];
+   int quantized[2][3], q[3], best_q[2][3];
+   int tables[2], best_tables[2];
+   uint32_t indices, subblock_indices[2];
+   int flipped, s, o, i, error, subblock_error[2];
+
+   for (flipped = 0; flipped < 2; flipped++) {
+      for (s = 0; s < 2; s++)
+         etc2_subblock_average(texels, etc2_subblock_mask(flipped, s),
+                               non_opaque, average[s]);
+
+      /* Individual mode: each subblock has its own 4-bit color */
+      if (!punchthrough) {
+         for (s = 0; s < 2; s++) {
+            const unsigned mask = etc2_subblock_mask(flipped, s);
+
+            for (i = 0; i < 3; i++)
+               quantized[s][i] = (int) (average[s][i] * 15.0f / 255.0f + 0.5f);
+
+            subblock_error[s] = INT_MAX;
+
+            for (o = 0; o < n_offsets; o++) {
+               for (i = 0; i < 3; i++) {
+                  q[i] = CLAMP(quantized[s][i] + offsets[o], 0, 15);
+                  base[i] = q[i] * 17;
+               }
+
+               error = etc2_fit_subblock(texels, mask, base, false,
+                                         &tables[s], &indices);
+               if (error < subblock_error[s]) {
+                  subblock_error[s] = error;
+                  memcpy(best_q[s], q, sizeof q);
+                  best_tables[s] = tables[s];
+                  subblock_indices[s] = indices;
+               }
             }
          }
-         src += bs;
+
+         if (subblock_error[0] + subblock_error[1] < best_error) {
+            best_error = subblock_error[0] + subblock_error[1];
+
+            for (i = 0; i < 3; i++)
+               dst[i] = (best_q[0][i] << 4) | best_q[1][i];
+            dst[3] = (best_tables[0] << 5) | (best_tables[1] << 2) | flipped;
+            etc2_write_rgb_indices(dst, subblock_indices[0] |
+                                        subblock_indices[1]);
+         }
       }
 
-      src_row += src_stride;
-   }
-}
+      /* Differential mode: a 5-bit color and a 3-bit signed delta */
+      for (s = 0; s < 2; s++) {
+         for (i = 0; i < 3; i++)
+            quantized[s][i] = (int) (average[s][i] * 31.0f / 255.0f + 0.5f);
+      }
 
-static void
-etc2_unpack_signed_rg11(uint8_t *dst_row,
-                        unsigned dst_stride,
-                        const uint8_t *src_row,
-                        unsigned src_stride,
-                        unsigned width,
-                        unsigned height)
-{
-   /* If internalformat is COMPRESSED_SIGNED_RG11_EAC, each 4 × 4 block of
-      RG color information is compressed to 128 bits.
-   */
-   const unsigned bw = 4, bh = 4, bs = 16, comps = 2, comp_size = 2;
-   struct etc2_block block;
-   unsigned x, y, i, j;
+      for (s = 0; s < 2; s++) {
+         const unsigned mask = etc2_subblock_mask(flipped, s);
 
-   for (y = 0; y < height; y += bh) {
-      const unsigned h = MIN2(bh, height - y);
-      const uint8_t *src = src_row;
+         subblock_error[s] = INT_MAX;
 
-      for (x = 0; x < width; x+= bw) {
-         const unsigned w = MIN2(bw, width - x);
-         /* red component */
-         etc2_r11_parse_block(&block, src);
-
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride +
-                          x * comps * comp_size;
-            for (i = 0; i < w; i++) {
-               etc2_signed_r11_fetch_texel(&block, i, j, dst);
-               dst += comps * comp_size;
+         for (o = 0; o < n_offsets; o++) {
+            for (i = 0; i < 3; i++) {
+               q[i] = CLAMP(quantized[s][i] + offsets[o], 0, 31);
+
+               /* The second color must be within reach of the first */
+               if (s == 1)
+                  q[i] = CLAMP(q[i], best_q[0][i] - 4, best_q[0][i] + 3);
+
+               base[i] = (q[i] << 3) | (q[i] >> 2);
             }
-         }
-         /* green component */
-         etc2_r11_parse_block(&block, src + 8);
-
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride +
-                           x * comps * comp_size;
-            for (i = 0; i < w; i++) {
-               etc2_signed_r11_fetch_texel(&block, i, j, dst + comp_size);
-               dst += comps * comp_size;
+
+            error = etc2_fit_subblock(texels, mask, base, non_opaque,
+                                      &tables[s], &indices);
+            if (error < subblock_error[s]) {
+               subblock_error[s] = error;
+               memcpy(best_q[s], q, sizeof q);
+               memcpy(best_base[s], base, sizeof base);
+               best_tables[s] = tables[s];
+               subblock_indices[s] = indices;
             }
          }
-         src += bs;
       }
 
-      src_row += src_stride;
+      if (subblock_error[0] + subblock_error[1] < best_error) {
+         best_error = subblock_error[0] + subblock_error[1];
+
+         for (i = 0; i < 3; i++)
+            dst[i] = (best_q[0][i] << 3) | ((best_q[1][i] - best_q[0][i]) & 7);
+         dst[3] = (best_tables[0] << 5) | (best_tables[1] << 2) |
+                  ((!non_opaque) << 1) | flipped;
+         etc2_write_rgb_indices(dst, subblock_indices[0] |
+                                     subblock_indices[1]);
+      }
    }
-}
 
-static void
-etc2_unpack_rgb8_punchthrough_alpha1(uint8_t *dst_row,
-                                     unsigned dst_stride,
-                                     const uint8_t *src_row,
-                                     unsigned src_stride,
-                                     unsigned width,
-                                     unsigned height)
-{
-   const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
-   struct etc2_block block;
-   unsigned x, y, i, j;
+   return best_error;
+}
 
-   for (y = 0; y < height; y += bh) {
-      const unsigned h = MIN2(bh, height - y);
-      const uint8_t *src = src_row;
+/**
+ * The T, H and planar modes are selected by making the differential mode's
+ * red, green or blue sum overflow.  The 5-bit part of the sum is made of
+ * the three unused high bits plus two color bits hi, and the 3-bit delta of
+ * the unused bit 2 plus two color bits lo.  Returns the unused bits which
+ * make the sum go out of range.
+ */
+static uint8_t
+etc2_overflow_bits(int hi, int lo)
+{
+   /* Either hi + (lo - 4) < 0 or 28 + hi + lo > 31 */
+   return (hi + lo < 4) ? 0x04 : 0xe0;
+}
 
-      for (x = 0; x < width; x+= bw) {
-         const unsigned w = MIN2(bw, width - x);
-         etc2_rgb8_parse_block(&block, src,
-                               true /* punchthrough_alpha */);
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     true /* punchthrough_alpha */);
-               dst += comps;
+/**
+ * The bit above a 4-bit (T/H) or 6-bit (planar) red or green value which
+ * keeps the sum from overflowing when it must not.
+ */
+static uint8_t
+etc2_no_overflow_bit(uint8_t byte)
+{
+   static const int lookup[8] = { 0, 1, 2, 3, -4, -3, -2, -1 };
+
+   return ((byte >> 3) + lookup[byte & 0x7] < 0) ? 0x80 : 0;
+}
+
+/**
+ * Split the opaque texels into two clusters of similar colors with a few
+ * rounds of k-means, for the T and H modes.
+ */
+static void
+etc2_find_clusters(const uint8_t texels[4][4][4], bool non_opaque,
+                   float centers[2][3])
+{
+   const uint8_t *texel;
+   float sums[2][3], error[2];
+   int counts[2], luminance, min_lum = INT_MAX, max_lum = -1;
+   int x, y, i, c, iteration;
+
+   for (y = 0; y < 4; y++) {
+      for (x = 0; x < 4; x++) {
+         texel = texels[y][x];
+         if (non_opaque && etc2_is_transparent(texel))
+            continue;
+
+         luminance = texel[0] + texel[1] + texel[2];
+         if (luminance < min_lum) {
+            min_lum = luminance;
+            for (i = 0; i < 3; i++)
+               centers[0][i] = texel[i];
+         }
+         if (luminance > max_lum) {
+            max_lum = luminance;
+            for (i = 0; i < 3; i++)
+               centers[1][i] = texel[i];
+         }
+      }
+   }
+
+   if (max_lum < 0) {
+      memset(centers, 0, sizeof(float) * 2 * 3);
+      return;
+   }
+
+   for (iteration = 0; iteration < 3; iteration++) {
+      memset(sums, 0, sizeof sums);
+      memset(counts, 0, sizeof counts);
+
+      for (y = 0; y < 4; y++) {
+         for (x = 0; x < 4; x++) {
+            texel = texels[y][x];
+            if (non_opaque && etc2_is_transparent(texel))
+               continue;
+
+            for (c = 0; c < 2; c++) {
+               error[c] = 0.0f;
+               for (i = 0; i < 3; i++)
+                  error[c] += (texel[i] - centers[c][i]) *
+                              (texel[i] - centers[c][i]);
             }
+
+            c = error[1] < error[0];
+            for (i = 0; i < 3; i++)
+               sums[c][i] += texel[i];
+            counts[c]++;
          }
+      }
 
-         src += bs;
+      for (c = 0; c < 2; c++) {
+         if (counts[c]) {
+            for (i = 0; i < 3; i++)
+               centers[c][i] = sums[c][i] / counts[c];
+         }
       }
+   }
+}
 
-      src_row += src_stride;
+static int
+etc2_encode_t_mode(const uint8_t texels[4][4][4], const float centers[2][3],
+                   bool non_opaque, int best_error, uint8_t *dst)
+{
+   uint8_t palette[4][3];
+   int colors[2][3];
+   uint32_t indices;
+   int order, d, i, error;
+
+   for (order = 0; order < 2; order++) {
+      /* The first color is on its own, the second has the distance added
+       * and subtracted */
+      for (i = 0; i < 3; i++) {
+         colors[0][i] = (int) (centers[order][i] * 15.0f / 255.0f + 0.5f);
+         colors[1][i] = (int) (centers[!order][i] * 15.0f / 255.0f + 0.5f);
+      }
+
+      for (d = 0; d < 8; d++) {
+         const int distance = etc2_distance_table[d];
+
+         for (i = 0; i < 3; i++) {
+            palette[0][i] = colors[0][i] * 17;
+            palette[1][i] = etc2_clamp(colors[1][i] * 17 + distance);
+            palette[2][i] = colors[1][i] * 17;
+            palette[3][i] = etc2_clamp(colors[1][i] * 17 - distance);
+         }
+
+         error = etc2_select_rgb_indices(texels, 0xffff, palette, non_opaque,
+                                         best_error, &indices);
+         if (error >= best_error)
+            continue;
+
+         best_error = error;
+
+         dst[0] = ((colors[0][0] >> 2) << 3) | (colors[0][0] & 3);
+         dst[0] |= etc2_overflow_bits(colors[0][0] >> 2, colors[0][0] & 3);
+         dst[1] = (colors[0][1] << 4) | colors[0][2];
+         dst[2] = (colors[1][0] << 4) | colors[1][1];
+         dst[3] = (colors[1][2] << 4) | ((d >> 1) << 2) |
+                  ((!non_opaque) << 1) | (d & 1);
+         etc2_write_rgb_indices(dst, indices);
+      }
+   }
+
+   return best_error;
+}
+
+static int
+etc2_encode_h_mode(const uint8_t texels[4][4][4], const float centers[2][3],
+                   bool non_opaque, int best_error, uint8_t *dst)
+{
+   uint8_t palette[4][3];
+   int colors[2][3], c[2][3], values[2];
+   uint32_t indices;
+   int d, i, error, a, b;
+
+   for (i = 0; i < 3; i++) {
+      colors[0][i] = (int) (centers[0][i] * 15.0f / 255.0f + 0.5f);
+      colors[1][i] = (int) (centers[1][i] * 15.0f / 255.0f + 0.5f);
+   }
+
+   values[0] = (colors[0][0] << 8) | (colors[0][1] << 4) | colors[0][2];
+   values[1] = (colors[1][0] << 8) | (colors[1][1] << 4) | colors[1][2];
+
+   for (d = 0; d < 8; d++) {
+      const int distance = etc2_distance_table[d];
+
+      /* The lowest bit of the distance is whether the first color is
+       * greater than or equal to the second, so order them to match */
+      if (values[0] == values[1] && !(d & 1))
+         continue;
+
+      if ((values[0] >= values[1]) == (d & 1)) {
+         memcpy(c, colors, sizeof c);
+      } else {
+         memcpy(c[0], colors[1], sizeof c[0]);
+         memcpy(c[1], colors[0], sizeof c[1]);
+      }
+
+      for (i = 0; i < 3; i++) {
+         palette[0][i] = etc2_clamp(c[0][i] * 17 + distance);
+         palette[1][i] = etc2_clamp(c[0][i] * 17 - distance);
+         palette[2][i] = etc2_clamp(c[1][i] * 17 + distance);
+         palette[3][i] = etc2_clamp(c[1][i] * 17 - distance);
+      }
+
+      error = etc2_select_rgb_indices(texels, 0xffff, palette, non_opaque,
+                                      best_error, &indices);
+      if (error >= best_error)
+         continue;
+
+      best_error = error;
+
+      dst[0] = (c[0][0] << 3) | (c[0][1] >> 1);
+      dst[0] |= etc2_no_overflow_bit(dst[0]);
+
+      a = ((c[0][1] & 1) << 1) | (c[0][2] >> 3);
+      b = (c[0][2] >> 1) & 3;
+      dst[1] = ((c[0][1] & 1) << 4) | (c[0][2] & 8) | b;
+      dst[1] |= etc2_overflow_bits(a, b);
+
+      dst[2] = ((c[0][2] & 1) << 7) | (c[1][0] << 3) | (c[1][1] >> 1);
+      dst[3] = ((c[1][1] & 1) << 7) | (c[1][2] << 3) | (d & 4) |
+               ((!non_opaque) << 1) | ((d >> 1) & 1);
+      etc2_write_rgb_indices(dst, indices);
+   }
+
+   return best_error;
+}
+
+/** Expand an n-bit planar mode value to 8 bits */
+static int
+etc2_expand_bits(int value, int n_bits)
+{
+   return (value << (8 - n_bits)) | (value >> (2 * n_bits - 8));
+}
+
+static int
+etc2_planar_error(const uint8_t texels[4][4][4], int component,
+                  int o, int h, int v)
+{
+   int x, y, color, diff, error = 0;
+
+   for (y = 0; y < 4; y++) {
+      for (x = 0; x < 4; x++) {
+         color = etc2_clamp((x * (h - o) + y * (v - o) + 4 * o + 2) >> 2);
+         diff = color - texels[y][x][component];
+         error += diff * diff;
+      }
+   }
+
+   return error;
+}
+
+/**
+ * Planar mode fits a gradient through the block from three colors at the
+ * origin and one block to the right and below.  The components are
+ * independent so each one is fitted on its own.
+ */
+static int
+etc2_encode_planar_mode(const uint8_t texels[4][4][4], bool thorough,
+                        int best_error, uint8_t *dst)
+{
+   static const int bits[3] = { 6, 7, 6 };
+   int quantized[3][3], best[3][3];
+   int i, x, y, n_bits, max, range, error, component_error, total = 0;
+   int o, h, v;
+   float sum, sum_x, sum_y, slope_x, slope_y, origin;
+
+   for (i = 0; i < 3; i++) {
+      /* Least squares fit of origin + slope_x * x + slope_y * y */
+      sum = sum_x = sum_y = 0.0f;
+      for (y = 0; y < 4; y++) {
+         for (x = 0; x < 4; x++) {
+            sum += texels[y][x][i];
+            sum_x += (x - 1.5f) * texels[y][x][i];
+            sum_y += (y - 1.5f) * texels[y][x][i];
+         }
+      }
+      slope_x = sum_x / 20.0f;
+      slope_y = sum_y / 20.0f;
+      origin = sum / 16.0f - 1.5f * (slope_x + slope_y);
+
+      n_bits = bits[i];
+      max = (1 << n_bits) - 1;
+      quantized[i][0] = (int) CLAMP(origin * max / 255.0f + 0.5f, 0, max);
+      quantized[i][1] = (int) CLAMP((origin + 4 * slope_x) * max / 255.0f +
+                                    0.5f, 0, max);
+      quantized[i][2] = (int) CLAMP((origin + 4 * slope_y) * max / 255.0f +
+                                    0.5f, 0, max);
+
+      component_error = INT_MAX;
+
+      /* Rounding to the nearest value isn't always best once the values
+       * are expanded and the result clamped, so try the neighbours too */
+      range = thorough ? 1 : 0;
+
+      for (o = MAX2(quantized[i][0] - range, 0);
+           o <= MIN2(quantized[i][0] + range, max); o++) {
+         for (h = MAX2(quantized[i][1] - range, 0);
+              h <= MIN2(quantized[i][1] + range, max); h++) {
+            for (v = MAX2(quantized[i][2] - range, 0);
+                 v <= MIN2(quantized[i][2] + range, max); v++) {
+               error = etc2_planar_error(texels, i,
+                                         etc2_expand_bits(o, n_bits),
+                                         etc2_expand_bits(h, n_bits),
+                                         etc2_expand_bits(v, n_bits));
+               if (error < component_error) {
+                  component_error = error;
+                  best[i][0] = o;
+                  best[i][1] = h;
+                  best[i][2] = v;
+               }
+            }
+         }
+      }
+
+      total += component_error;
+      if (total >= best_error)
+         return total;
    }
+
+   /* Unused bits are set so that red and green don't overflow but blue
+    * does */
+   dst[0] = (best[0][0] << 1) | (best[1][0] >> 6);
+   dst[0] |= etc2_no_overflow_bit(dst[0]);
+   dst[1] = ((best[1][0] & 0x3f) << 1) | (best[2][0] >> 5);
+   dst[1] |= etc2_no_overflow_bit(dst[1]);
+   dst[2] = (((best[2][0] >> 3) & 3) << 3) | ((best[2][0] >> 1) & 3);
+   dst[2] |= etc2_overflow_bits((best[2][0] >> 3) & 3, (best[2][0] >> 1) & 3);
+   dst[3] = ((best[2][0] & 1) << 7) | ((best[0][1] >> 1) << 2) | 0x2 |
+            (best[0][1] & 1);
+   dst[4] = (best[1][1] << 1) | (best[2][1] >> 5);
+   dst[5] = ((best[2][1] & 0x1f) << 3) | (best[0][2] >> 3);
+   dst[6] = ((best[0][2] & 7) << 5) | (best[1][2] >> 2);
+   dst[7] = ((best[1][2] & 3) << 6) | best[2][2];
+
+   return total;
 }
 
+/**
+ * Encode an ETC2 RGB block, or the RGB part of an RGBA8 EAC block.  For
+ * the punchthrough formats, texels with alpha below 128 become transparent.
+ */
 static void
-etc2_unpack_srgb8_punchthrough_alpha1(uint8_t *dst_row,
-                                     unsigned dst_stride,
-                                     const uint8_t *src_row,
-                                     unsigned src_stride,
-                                     unsigned width,
-                                     unsigned height)
-{
-   const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
-   struct etc2_block block;
-   unsigned x, y, i, j;
-   uint8_t tmp;
+etc2_encode_rgb_block(const uint8_t texels[4][4][4],
+                      bool punchthrough, bool thorough, uint8_t *dst)
+{
+   uint8_t candidate[8];
+   float centers[2][3];
+   bool non_opaque = false;
+   int x, y, error, best_error;
+
+   if (punchthrough) {
+      for (y = 0; y < 4; y++) {
+         for (x = 0; x < 4; x++) {
+            if (etc2_is_transparent(texels[y][x]))
+               non_opaque = true;
+         }
+      }
+   }
 
-   for (y = 0; y < height; y += bh) {
-      const unsigned h = MIN2(bh, height - y);
-      const uint8_t *src = src_row;
+   best_error = etc2_encode_etc1_modes(texels, punchthrough, non_opaque,
+                                       thorough, INT_MAX, dst);
 
-      for (x = 0; x < width; x+= bw) {
-         const unsigned w = MIN2(bw, width - x);
-         etc2_rgb8_parse_block(&block, src,
-                               true /* punchthrough_alpha */);
-         for (j = 0; j < h; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < w; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     true /* punchthrough_alpha */);
-               /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
-               tmp = dst[0];
-               dst[0] = dst[2];
-               dst[2] = tmp;
-               dst[3] = dst[3];
-
-               dst += comps;
+   /* Planar mode is always opaque */
+   if (best_error > 0 && !non_opaque) {
+      error = etc2_encode_planar_mode(texels, thorough, best_error,
+                                      candidate);
+      if (error < best_error) {
+         best_error = error;
+         memcpy(dst, candidate, 8);
+      }
+   }
+
+   if (best_error > 0 && thorough) {
+      etc2_find_clusters(texels, non_opaque, centers);
+      best_error = etc2_encode_t_mode(texels, centers, non_opaque,
+                                      best_error, dst);
+      best_error = etc2_encode_h_mode(texels, centers, non_opaque,
+                                      best_error, dst);
+   }
+}
+
+enum etc2_eac_kind {
+   ETC2_EAC_ALPHA8,
+   ETC2_EAC_R11,
+   ETC2_EAC_SIGNED_R11
+};
+
+/**
+ * Decode one value of an EAC block, as 8 bits for alpha and 11 bits for
+ * the R11 formats.
+ */
+static int
+etc2_eac_value(enum etc2_eac_kind kind, int base, int multiplier,
+               int modifier)
+{
+   switch (kind) {
+   case ETC2_EAC_ALPHA8:
+      return etc2_clamp(base + modifier * multiplier);
+   case ETC2_EAC_R11:
+      if (multiplier != 0)
+         modifier *= multiplier * 8;
+      return etc2_clamp2(base * 8 + 4 + modifier);
+   default:
+      if (multiplier != 0)
+         modifier *= multiplier * 8;
+      return etc2_clamp3(base * 8 + modifier);
+   }
+}
+
+/**
+ * Encode 16 alpha or R11 values given as values[y][x] as an EAC block.
+ */
+static void
+etc2_encode_eac_block(const int values[4][4], enum etc2_eac_kind kind,
+                      bool thorough, uint8_t *dst)
+{
+   const int scale = kind == ETC2_EAC_ALPHA8 ? 1 : 8;
+   const int offset = kind == ETC2_EAC_R11 ? 4 : 0;
+   const int min_base = kind == ETC2_EAC_SIGNED_R11 ? -127 : 0;
+   const int max_base = kind == ETC2_EAC_SIGNED_R11 ? 127 : 255;
+   /* A multiplier of 0 uses the modifiers unscaled in the R11 formats */
+   const int min_multiplier = kind == ETC2_EAC_ALPHA8 ? 1 : 0;
+   int palette[8];
+   uint8_t indices[4][4], best_indices[4][4];
+   int min_value = INT_MAX, max_value = INT_MIN;
+   int best_base = 0, best_multiplier = 1, best_table = 0;
+   int best_error = INT_MAX;
+   int table, m, m0, b, b0, mult_range, base_range, x, y, idx;
+   int error, diff, texel_error, best_texel_error;
+   uint64_t bits;
+
+   for (y = 0; y < 4; y++) {
+      for (x = 0; x < 4; x++) {
+         min_value = MIN2(min_value, values[y][x]);
+         max_value = MAX2(max_value, values[y][x]);
+      }
+   }
+
+   mult_range = thorough ? 1 : 0;
+   base_range = thorough ? 2 : 0;
+
+   for (table = 0; table < 16; table++) {
+      const int *modifiers = etc2_modifier_tables[table];
+      const int span = modifiers[7] - modifiers[3];
+
+      /* Stretch the table over the range of values */
+      m0 = ((max_value - min_value) + span * scale / 2) / (span * scale);
+      m0 = CLAMP(m0, min_multiplier, 15);
+
+      for (m = m0 - mult_range; m <= m0 + mult_range; m++) {
+         if (m < min_multiplier || m > 15)
+            continue;
+
+         /* Center the table on the range */
+         b0 = (min_value + max_value) / 2 - offset -
+              (modifiers[3] + modifiers[7]) * (m ? m * scale : 1) / 2;
+         b0 = CLAMP(IROUND((float) b0 / scale), min_base, max_base);
+
+         for (b = b0 - base_range; b <= b0 + base_range; b++) {
+            if (b < min_base || b > max_base)
+               continue;
+
+            for (idx = 0; idx < 8; idx++)
+               palette[idx] = etc2_eac_value(kind, b, m, modifiers[idx]);
+
+            error = 0;
+            for (y = 0; y < 4 && error < best_error; y++) {
+               for (x = 0; x < 4; x++) {
+                  best_texel_error = INT_MAX;
+                  for (idx = 0; idx < 8; idx++) {
+                     diff = palette[idx] - values[y][x];
+                     texel_error = diff * diff;
+                     if (texel_error < best_texel_error) {
+                        best_texel_error = texel_error;
+                        indices[y][x] = idx;
+                     }
+                  }
+                  error += best_texel_error;
+               }
+            }
+
+            if (error < best_error) {
+               best_error = error;
+               best_base = b;
+               best_multiplier = m;
+               best_table = table;
+               memcpy(best_indices, indices, sizeof indices);
+
+               if (error == 0)
+                  goto done;
             }
          }
+      }
+   }
 
-         src += bs;
+done:
+   dst[0] = (uint8_t) best_base;
+   dst[1] = (best_multiplier << 4) | best_table;
+
+   /* The indices are stored column by column from the top bits down */
+   bits = 0;
+   for (x = 0; x < 4; x++) {
+      for (y = 0; y < 4; y++)
+         bits = (bits << 3) | best_indices[y][x];
+   }
+
+   for (idx = 0; idx < 6; idx++)
+      dst[2 + idx] = (uint8_t) (bits >> (40 - 8 * idx));
+}
+
+/**
+ * Copy the texels of the block at (x, y) out of an image, repeating the
+ * last row and column of the image for blocks hanging off its edges.
+ */
+static void
+etc2_load_rgba_block(const uint8_t *src, unsigned src_stride,
+                     unsigned width, unsigned height,
+                     unsigned x, unsigned y,
+                     uint8_t texels[4][4][4])
+{
+   unsigned i, j;
+
+   for (j = 0; j < 4; j++) {
+      const uint8_t *row = src + MIN2(y + j, height - 1) * src_stride;
+
+      for (i = 0; i < 4; i++)
+         memcpy(texels[j][i], row + MIN2(x + i, width - 1) * 4, 4);
+   }
+}
+
+/**
+ * Encode RGBA8 texels to the RGB8, RGBA8 EAC or punchthrough formats.
+ */
+static void
+etc2_encode_rgba_blocks(uint8_t *dst_row, unsigned dst_stride,
+                        const uint8_t *src, unsigned src_stride,
+                        unsigned width, unsigned height,
+                        unsigned first_block_row, unsigned last_block_row,
+                        GLboolean has_alpha, GLboolean punchthrough_alpha,
+                        bool thorough)
+{
+   const unsigned bs = has_alpha ? 16 : 8;
+   uint8_t texels[4][4][4];
+   int alpha[4][4];
+   uint8_t *dst;
+   unsigned block_row, x, i, j;
+
+   for (block_row = first_block_row; block_row < last_block_row; block_row++) {
+      dst = dst_row + block_row * dst_stride;
+
+      for (x = 0; x < width; x += 4) {
+         etc2_load_rgba_block(src, src_stride, width, height,
+                              x, block_row * 4, texels);
+
+         if (has_alpha) {
+            for (j = 0; j < 4; j++)
+               for (i = 0; i < 4; i++)
+                  alpha[j][i] = texels[j][i][3];
+
+            etc2_encode_eac_block(alpha, ETC2_EAC_ALPHA8, thorough, dst);
+            etc2_encode_rgb_block(texels, false, thorough, dst + 8);
+         }
+         else {
+            etc2_encode_rgb_block(texels, punchthrough_alpha, thorough, dst);
+         }
+
+         dst += bs;
       }
+   }
+}
 
-      src_row += src_stride;
+/**
+ * Encode float texels in [0, 1] (or [-1, 1] if signed) to the one and two
+ * channel R11/RG11 EAC formats.
+ */
+static void
+etc2_encode_r11_blocks(uint8_t *dst_row, unsigned dst_stride,
+                       const float *src, unsigned src_stride,
+                       unsigned width, unsigned height,
+                       unsigned first_block_row, unsigned last_block_row,
+                       unsigned comps, GLboolean is_signed,
+                       bool thorough)
+{
+   int values[4][4];
+   uint8_t *dst;
+   unsigned block_row, x, y, i, j, c;
+
+   for (block_row = first_block_row; block_row < last_block_row; block_row++) {
+      dst = dst_row + block_row * dst_stride;
+      y = block_row * 4;
+
+      for (x = 0; x < width; x += 4) {
+         for (c = 0; c < comps; c++) {
+            for (j = 0; j < 4; j++) {
+               const float *row = src + MIN2(y + j, height - 1) * src_stride;
+
+               for (i = 0; i < 4; i++) {
+                  const float value = row[MIN2(x + i, width - 1) * comps + c];
+
+                  if (is_signed)
+                     values[j][i] = IROUND(CLAMP(value, -1.0f, 1.0f) * 1023.0f);
+                  else
+                     values[j][i] = IROUND(CLAMP(value, 0.0f, 1.0f) * 2047.0f);
+               }
+            }
+
+            etc2_encode_eac_block(values,
+                                  is_signed ? ETC2_EAC_SIGNED_R11
+                                            : ETC2_EAC_R11,
+                                  thorough, dst + 8 * c);
+         }
+
+         dst += 8 * comps;
+      }
+   }
+}
+
+
+struct etc2_encode_job
+{
+   uint8_t *dst_row;
+   unsigned dst_stride;
+   const void *src;
+   unsigned src_stride;
+   unsigned width, height;
+   mesa_format format;
+   bool thorough;
+};
+
+/** Encode block rows [first, last) of an image */
+static GLboolean
+etc2_encode_band(void *data, int first, int last)
+{
+   const struct etc2_encode_job *job = (const struct etc2_encode_job *) data;
+
+   switch (job->format) {
+   case MESA_FORMAT_ETC2_RGB8:
+   case MESA_FORMAT_ETC2_SRGB8:
+      etc2_encode_rgba_blocks(job->dst_row, job->dst_stride,
+                              job->src, job->src_stride,
+                              job->width, job->height, first, last,
+                              false, false, job->thorough);
+      break;
+   case MESA_FORMAT_ETC2_RGBA8_EAC:
+   case MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC:
+      etc2_encode_rgba_blocks(job->dst_row, job->dst_stride,
+                              job->src, job->src_stride,
+                              job->width, job->height, first, last,
+                              true, false, job->thorough);
+      break;
+   case MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1:
+   case MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1:
+      etc2_encode_rgba_blocks(job->dst_row, job->dst_stride,
+                              job->src, job->src_stride,
+                              job->width, job->height, first, last,
+                              false, true, job->thorough);
+      break;
+   case MESA_FORMAT_ETC2_R11_EAC:
+   case MESA_FORMAT_ETC2_SIGNED_R11_EAC:
+      etc2_encode_r11_blocks(job->dst_row, job->dst_stride,
+                             job->src, job->src_stride,
+                             job->width, job->height, first, last, 1,
+                             job->format == MESA_FORMAT_ETC2_SIGNED_R11_EAC,
+                             job->thorough);
+      break;
+   case MESA_FORMAT_ETC2_RG11_EAC:
+   case MESA_FORMAT_ETC2_SIGNED_RG11_EAC:
+      etc2_encode_r11_blocks(job->dst_row, job->dst_stride,
+                             job->src, job->src_stride,
+                             job->width, job->height, first, last, 2,
+                             job->format == MESA_FORMAT_ETC2_SIGNED_RG11_EAC,
+                             job->thorough);
+      break;
+   default:
+      break;
    }
+
+   return GL_TRUE;
+}
+
+/**
+ * Compress an image to any of the ETC2 formats.  The image is converted to
+ * RGBA ubyte (or float for the R11/RG11 formats) first, then rows of blocks
+ * are encoded concurrently.  GL_FASTEST as the texture compression hint
+ * picks the fast search.
+ */
+static GLboolean
+etc2_texstore(TEXSTORE_PARAMS)
+{
+   const GLenum baseFormat = _mesa_get_format_base_format(dstFormat);
+   const bool is_r11 = (baseFormat == GL_RED || baseFormat == GL_RG);
+   struct etc2_encode_job job;
+   const void *tempImage;
+   size_t image_size;
+   GLint img;
+
+   if (is_r11) {
+      tempImage = _mesa_make_temp_float_image(ctx, dims,
+                                              baseInternalFormat, baseFormat,
+                                              srcWidth, srcHeight, srcDepth,
+                                              srcFormat, srcType, srcAddr,
+                                              srcPacking,
+                                              ctx->_ImageTransferState);
+      job.src_stride = srcWidth * _mesa_components_in_format(baseFormat);
+      image_size = job.src_stride * srcHeight * sizeof(GLfloat);
+   }
+   else {
+      /* Always expand to RGBA; RGB8 just ignores the alpha */
+      tempImage = _mesa_make_temp_ubyte_image(ctx, dims,
+                                              baseInternalFormat, GL_RGBA,
+                                              srcWidth, srcHeight, srcDepth,
+                                              srcFormat, srcType, srcAddr,
+                                              srcPacking);
+      job.src_stride = srcWidth * 4;
+      image_size = job.src_stride * srcHeight;
+   }
+
+   if (!tempImage)
+      return GL_FALSE; /* out of memory */
+
+   job.dst_stride = dstRowStride;
+   job.width = srcWidth;
+   job.height = srcHeight;
+   job.format = dstFormat;
+   job.thorough = ctx->Hint.TextureCompression != GL_FASTEST;
+
+   for (img = 0; img < srcDepth; img++) {
+      job.dst_row = dstSlices[img];
+      job.src = (const GLubyte *) tempImage + img * image_size;
+
+      /* Encoding costs far more per byte than the conversions the thread
+       * pool's band size is tuned for */
+      _mesa_threadpool_run_bands(etc2_encode_band, &job,
+                                 (srcHeight + 3) / 4, image_size * 64);
+   }
+
+   free((void *) tempImage);
+
+   return GL_TRUE;
 }
 
-/* ETC2 texture formats are valid in glCompressedTexImage2D and
- * glCompressedTexSubImage2D functions */
 GLboolean
 _mesa_texstore_etc2_rgb8(TEXSTORE_PARAMS)
 {
-   ASSERT(0);
+   ASSERT(dstFormat == MESA_FORMAT_ETC2_RGB8);
 
-   return GL_FALSE;
+   return etc2_texstore(ctx, dims, baseInternalFormat,
+                        dstFormat, dstRowStride, dstSlices,
+                        srcWidth, srcHeight, srcDepth,
+                        srcFormat, srcType, srcAddr, srcPacking);
 }
 
 GLboolean
 _mesa_texstore_etc2_srgb8(TEXSTORE_PARAMS)
 {
-   ASSERT(0);
+   ASSERT(dstFormat == MESA_FORMAT_ETC2_SRGB8);
 
-   return GL_FALSE;
+   return etc2_texstore(ctx, dims, baseInternalFormat,
+                        dstFormat, dstRowStride, dstSlices,
+                        srcWidth, srcHeight, srcDepth,
+                        srcFormat, srcType, srcAddr, srcPacking);
 }
 
 GLboolean
 _mesa_texstore_etc2_rgba8_eac(TEXSTORE_PARAMS)
 {
-   ASSERT(0);
+   ASSERT(dstFormat == MESA_FORMAT_ETC2_RGBA8_EAC);
 
-   return GL_FALSE;
+   return etc2_texstore(ctx, dims, baseInternalFormat,
+                        dstFormat, dstRowStride, dstSlices,
+                        srcWidth, srcHeight, srcDepth,
+                        srcFormat, srcType, srcAddr, srcPacking);
 }
 
 GLboolean
 _mesa_texstore_etc2_srgb8_alpha8_eac(TEXSTORE_PARAMS)
 {
-   ASSERT(0);
+   ASSERT(dstFormat == MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC);
 
-   return GL_FALSE;
+   return etc2_texstore(ctx, dims, baseInternalFormat,
+                        dstFormat, dstRowStride, dstSlices,
+                        srcWidth, srcHeight, srcDepth,
+                        srcFormat, srcType, srcAddr, srcPacking);
 }
 
 GLboolean
 _mesa_texstore_etc2_r11_eac(TEXSTORE_PARAMS)
 {
-   ASSERT(0);
+   ASSERT(dstFormat == MESA_FORMAT_ETC2_R11_EAC);
 
-   return GL_FALSE;
+   return etc2_texstore(ctx, dims, baseInternalFormat,
+                        dstFormat, dstRowStride, dstSlices,
+                        srcWidth, srcHeight, srcDepth,
+                        srcFormat, srcType, srcAddr, srcPacking);
 }
 
 GLboolean
 _mesa_texstore_etc2_signed_r11_eac(TEXSTORE_PARAMS)
 {
-   ASSERT(0);
+   ASSERT(dstFormat == MESA_FORMAT_ETC2_SIGNED_R11_EAC);
 
-   return GL_FALSE;
+   return etc2_texstore(ctx, dims, baseInternalFormat,
+                        dstFormat, dstRowStride, dstSlices,
+                        srcWidth, srcHeight, srcDepth,
+                        srcFormat, srcType, srcAddr, srcPacking);
 }
 
 GLboolean
 _mesa_texstore_etc2_rg11_eac(TEXSTORE_PARAMS)
 {
-   ASSERT(0);
+   ASSERT(dstFormat == MESA_FORMAT_ETC2_RG11_EAC);
 
-   return GL_FALSE;
+   return etc2_texstore(ctx, dims, baseInternalFormat,
+                        dstFormat, dstRowStride, dstSlices,
+                        srcWidth, srcHeight, srcDepth,
+                        srcFormat, srcType, srcAddr, srcPacking);
 }
 
 GLboolean
 _mesa_texstore_etc2_signed_rg11_eac(TEXSTORE_PARAMS)
 {
-   ASSERT(0);
+   ASSERT(dstFormat == MESA_FORMAT_ETC2_SIGNED_RG11_EAC);
 
-   return GL_FALSE;
+   return etc2_texstore(ctx, dims, baseInternalFormat,
+                        dstFormat, dstRowStride, dstSlices,
+                        srcWidth, srcHeight, srcDepth,
+                        srcFormat, srcType, srcAddr, srcPacking);
 }
 
 GLboolean
 _mesa_texstore_etc2_rgb8_punchthrough_alpha1(TEXSTORE_PARAMS)
 {
-   ASSERT(0);
+   ASSERT(dstFormat == MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1);
 
-   return GL_FALSE;
+   return etc2_texstore(ctx, dims, baseInternalFormat,
+                        dstFormat, dstRowStride, dstSlices,
+                        srcWidth, srcHeight, srcDepth,
+                        srcFormat, srcType, srcAddr, srcPacking);
 }
 
 GLboolean
 _mesa_texstore_etc2_srgb8_punchthrough_alpha1(TEXSTORE_PARAMS)
 {
-   ASSERT(0);
+   ASSERT(dstFormat == MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1);
 
-   return GL_FALSE;
+   return etc2_texstore(ctx, dims, baseInternalFormat,
+                        dstFormat, dstRowStride, dstSlices,
+                        srcWidth, srcHeight, srcDepth,
+                        srcFormat, srcType, srcAddr, srcPacking);
+}
+
+
+static void
+etc2_unpack_format(uint8_t *dst_row,
+                   unsigned dst_stride,
+                   const uint8_t *src_row,
+                   unsigned src_stride,
+                   unsigned src_width,
+                   unsigned src_height,
+                   mesa_format format)
+{
+   switch (format) {
+   case MESA_FORMAT_ETC1_RGB8:
+      etc1_unpack_rgba8888(dst_row, dst_stride, src_row, src_stride,
+                           src_width, src_height);
+      break;
+   case MESA_FORMAT_ETC2_RGB8:
+   case MESA_FORMAT_ETC2_SRGB8:
+      etc2_unpack_rgba_blocks(dst_row, dst_stride, src_row, src_stride,
+                              src_width, src_height, false, false,
+                              format == MESA_FORMAT_ETC2_SRGB8);
+      break;
+   case MESA_FORMAT_ETC2_RGBA8_EAC:
+   case MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC:
+      etc2_unpack_rgba_blocks(dst_row, dst_stride, src_row, src_stride,
+                              src_width, src_height, true, false,
+                              format == MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC);
+      break;
+   case MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1:
+   case MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1:
+      etc2_unpack_rgba_blocks(dst_row, dst_stride, src_row, src_stride,
+                              src_width, src_height, false, true,
+                              format == MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1);
+      break;
+   case MESA_FORMAT_ETC2_R11_EAC:
+      etc2_unpack_r11_blocks(dst_row, dst_stride, src_row, src_stride,
+                             src_width, src_height, 1, false);
+      break;
+   case MESA_FORMAT_ETC2_RG11_EAC:
+      etc2_unpack_r11_blocks(dst_row, dst_stride, src_row, src_stride,
+                             src_width, src_height, 2, false);
+      break;
+   case MESA_FORMAT_ETC2_SIGNED_R11_EAC:
+      etc2_unpack_r11_blocks(dst_row, dst_stride, src_row, src_stride,
+                             src_width, src_height, 1, true);
+      break;
+   case MESA_FORMAT_ETC2_SIGNED_RG11_EAC:
+      etc2_unpack_r11_blocks(dst_row, dst_stride, src_row, src_stride,
+                             src_width, src_height, 2, true);
+      break;
+   default:
+      break;
+   }
+}
+
+
+struct etc_unpack_job
+{
+   uint8_t *dst_row;
+   unsigned dst_stride;
+   const uint8_t *src_row;
+   unsigned src_stride;
+   unsigned width, height;
+   mesa_format format;
+};
+
+/** Unpack block rows [first, last) of an image */
+static GLboolean
+etc_unpack_band(void *data, int first, int last)
+{
+   const struct etc_unpack_job *job = (const struct etc_unpack_job *) data;
+   const unsigned y0 = first * 4;
+   const unsigned y1 = MIN2((unsigned) last * 4, job->height);
+
+   etc2_unpack_format(job->dst_row + y0 * job->dst_stride, job->dst_stride,
+                      job->src_row + first * job->src_stride, job->src_stride,
+                      job->width, y1 - y0, job->format);
+
+   return GL_TRUE;
+}
+
+/**
+ * Decode a whole image, splitting large ones into bands of block rows
+ * which are decoded concurrently.
+ */
+static void
+etc_unpack_threaded(uint8_t *dst_row,
+                    unsigned dst_stride,
+                    const uint8_t *src_row,
+                    unsigned src_stride,
+                    unsigned src_width,
+                    unsigned src_height,
+                    mesa_format format)
+{
+   struct etc_unpack_job job;
+
+   job.dst_row = dst_row;
+   job.dst_stride = dst_stride;
+   job.src_row = src_row;
+   job.src_stride = src_stride;
+   job.width = src_width;
+   job.height = src_height;
+   job.format = format;
+
+   _mesa_threadpool_run_bands(etc_unpack_band, &job, (src_height + 3) / 4,
+                              (size_t) dst_stride * src_height);
+}
+
+
+/**
+ * Decode texture data in format `MESA_FORMAT_ETC1_RGB8` to
+ * `MESA_FORMAT_ABGR8888`.
+ *
+ * The size of the source data must be a multiple of the ETC1 block size,
+ * which is 8, even if the texture image's dimensions are not aligned to 4.
+ * From the GL_OES_compressed_ETC1_RGB8_texture spec:
+ *   The texture is described as a number of 4x4 pixel blocks. If the
+ *   texture (or a particular mip-level) is smaller than 4 pixels in
+ *   any dimension (such as a 2x2 or a 8x1 texture), the texture is
+ *   found in the upper left part of the block(s), and the rest of the
+ *   pixels are not used. For instance, a texture of size 4x2 will be
+ *   placed in the upper half of a 4x4 block, and the lower half of the
+ *   pixels in the block will not be accessed.
+ *
+ * \param src_width in pixels
+ * \param src_height in pixels
+ * \param dst_stride in bytes
+ */
+void
+_mesa_etc1_unpack_rgba8888(uint8_t *dst_row,
+                           unsigned dst_stride,
+                           const uint8_t *src_row,
+                           unsigned src_stride,
+                           unsigned src_width,
+                           unsigned src_height)
+{
+   etc_unpack_threaded(dst_row, dst_stride, src_row, src_stride,
+                       src_width, src_height, MESA_FORMAT_ETC1_RGB8);
 }
 
 
@@ -1207,46 +2175,8 @@ _mesa_unpack_etc2_format(uint8_t *dst_row,
                          unsigned src_height,
                          mesa_format format)
 {
-   if (format == MESA_FORMAT_ETC2_RGB8)
-      etc2_unpack_rgb8(dst_row, dst_stride,
-                       src_row, src_stride,
-                       src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_SRGB8)
-      etc2_unpack_srgb8(dst_row, dst_stride,
-                        src_row, src_stride,
-                        src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_RGBA8_EAC)
-      etc2_unpack_rgba8(dst_row, dst_stride,
-                        src_row, src_stride,
-                        src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC)
-      etc2_unpack_srgb8_alpha8(dst_row, dst_stride,
-                               src_row, src_stride,
-                               src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_R11_EAC)
-      etc2_unpack_r11(dst_row, dst_stride,
-                      src_row, src_stride,
-                      src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_RG11_EAC)
-      etc2_unpack_rg11(dst_row, dst_stride,
-                       src_row, src_stride,
-                       src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_SIGNED_R11_EAC)
-      etc2_unpack_signed_r11(dst_row, dst_stride,
-                             src_row, src_stride,
-                             src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_SIGNED_RG11_EAC)
-      etc2_unpack_signed_rg11(dst_row, dst_stride,
-                              src_row, src_stride,
-                              src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1)
-      etc2_unpack_rgb8_punchthrough_alpha1(dst_row, dst_stride,
-                                           src_row, src_stride,
-                                           src_width, src_height);
-   else if (format == MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1)
-      etc2_unpack_srgb8_punchthrough_alpha1(dst_row, dst_stride,
-                                            src_row, src_stride,
-                                            src_width, src_height);
+   etc_unpack_threaded(dst_row, dst_stride, src_row, src_stride,
+                       src_width, src_height, format);
 }
 
 
@@ -45,6 +45,7 @@
 #include "texgetimage.h"
 #include "teximage.h"
 #include "texstore.h"
+#include "threadpool.h"
 
 
 
@@ -358,6 +359,81 @@ _mesa_base_pack_format(GLenum format)
 }
 
 
+/**
+ * State for unpacking one mapped image of get_tex_rgba_uncompressed(),
+ * split into bands of rows.
+ */
+struct get_tex_rgba_job
+{
+   struct gl_context *ctx;
+   GLuint dimensions;
+   GLenum format, type;
+   GLvoid *pixels;
+   mesa_format texFormat;
+   GLenum rebaseFormat;
+   GLbitfield transferOps;
+   GLboolean tex_is_integer, tex_is_uint;
+   GLuint width, height;
+   GLuint img;
+   GLubyte *srcMap;
+   GLint rowstride;
+};
+
+
+static GLboolean
+get_tex_rgba_band(void *data, int first, int last)
+{
+   const struct get_tex_rgba_job *job = (const struct get_tex_rgba_job *) data;
+   struct gl_context *ctx = job->ctx;
+   const GLuint width = job->width;
+   GLboolean ok = GL_TRUE;
+   GLfloat (*rgba)[4];
+   GLuint (*rgba_uint)[4];
+   int row;
+
+   /* Allocate buffer for one row of texels */
+   rgba = malloc(4 * width * sizeof(GLfloat));
+   rgba_uint = (GLuint (*)[4]) rgba;
+   if (!rgba)
+      return GL_FALSE;
+
+   for (row = first; ok && row < last; row++) {
+      const GLubyte *src = job->srcMap + row * job->rowstride;
+      void *dest = _mesa_image_address(job->dimensions, &ctx->Pack,
+                                       job->pixels, width, job->height,
+                                       job->format, job->type,
+                                       job->img, row, 0);
+
+      if (job->tex_is_integer) {
+         _mesa_unpack_uint_rgba_row(job->texFormat, width, src, rgba_uint);
+         if (job->rebaseFormat)
+            _mesa_rebase_rgba_uint(width, rgba_uint, job->rebaseFormat);
+         if (job->tex_is_uint) {
+            _mesa_pack_rgba_span_from_uints(ctx, width,
+                                            (GLuint (*)[4]) rgba_uint,
+                                            job->format, job->type, dest);
+         } else {
+            _mesa_pack_rgba_span_from_ints(ctx, width,
+                                           (GLint (*)[4]) rgba_uint,
+                                           job->format, job->type, dest);
+         }
+      } else {
+         _mesa_unpack_rgba_row(job->texFormat, width, src, rgba);
+         if (job->rebaseFormat)
+            _mesa_rebase_rgba_float(width, rgba, job->rebaseFormat);
+         ok = _mesa_try_pack_rgba_span_float(ctx, width,
+                                             (GLfloat (*)[4]) rgba,
+                                             job->format, job->type, dest,
+                                             &ctx->Pack, job->transferOps);
+      }
+   }
+
+   free(rgba);
+
+   return ok;
+}
+
+
 /**
  * Get an uncompressed color texture image.
  */
@@ -375,20 +451,11 @@ get_tex_rgba_uncompressed(struct gl_context *ctx, GLuint dimensions,
    GLenum rebaseFormat = GL_NONE;
    GLuint height = texImage->Height;
    GLuint depth = texImage->Depth;
-   GLuint img, row;
-   GLfloat (*rgba)[4];
-   GLuint (*rgba_uint)[4];
+   GLuint img;
    GLboolean tex_is_integer = _mesa_is_format_integer_color(texImage->TexFormat);
    GLboolean tex_is_uint = _mesa_is_format_unsigned(texImage->TexFormat);
    GLenum texBaseFormat = _mesa_get_format_base_format(texImage->TexFormat);
-
-   /* Allocate buffer for one row of texels */
-   rgba = malloc(4 * width * sizeof(GLfloat));
-   rgba_uint = (GLuint (*)[4]) rgba;
-   if (!rgba) {
-      _mesa_error(ctx, GL_OUT_OF_MEMORY, "glGetTexImage()");
-      return;
-   }
+   struct get_tex_rgba_job job;
 
    if (texImage->TexObject->Target == GL_TEXTURE_1D_ARRAY) {
       depth = height;
@@ -462,54 +529,45 @@ get_tex_rgba_uncompressed(struct gl_context *ctx, GLuint dimensions,
       }
    }
 
-   for (img = 0; img < depth; img++) {
-      GLubyte *srcMap;
-      GLint rowstride;
+   job.ctx = ctx;
+   job.dimensions = dimensions;
+   job.format = format;
+   job.type = type;
+   job.pixels = pixels;
+   job.texFormat = texFormat;
+   job.rebaseFormat = rebaseFormat;
+   job.transferOps = transferOps;
+   job.tex_is_integer = tex_is_integer;
+   job.tex_is_uint = tex_is_uint;
+   job.width = width;
+   job.height = height;
 
+   for (img = 0; img < depth; img++) {
       /* map src texture buffer */
       ctx->Driver.MapTextureImage(ctx, texImage, img,
                                   0, 0, width, height, GL_MAP_READ_BIT,
-                                  &srcMap, &rowstride);
-      if (srcMap) {
-         for (row = 0; row < height; row++) {
-            const GLubyte *src = srcMap + row * rowstride;
-            void *dest = _mesa_image_address(dimensions, &ctx->Pack, pixels,
-                                             width, height, format, type,
-                                             img, row, 0);
+                                  &job.srcMap, &job.rowstride);
+      if (job.srcMap) {
+         GLboolean ok;
 
-	    if (tex_is_integer) {
-	       _mesa_unpack_uint_rgba_row(texFormat, width, src, rgba_uint);
-               if (rebaseFormat)
-                  _mesa_rebase_rgba_uint(width, rgba_uint, rebaseFormat);
-               if (tex_is_uint) {
-                  _mesa_pack_rgba_span_from_uints(ctx, width,
-                                                  (GLuint (*)[4]) rgba_uint,
-                                                  format, type, dest);
-               } else {
-                  _mesa_pack_rgba_span_from_ints(ctx, width,
-                                                 (GLint (*)[4]) rgba_uint,
-                                                 format, type, dest);
-               }
-	    } else {
-	       _mesa_unpack_rgba_row(texFormat, width, src, rgba);
-               if (rebaseFormat)
-                  _mesa_rebase_rgba_float(width, rgba, rebaseFormat);
-	       _mesa_pack_rgba_span_float(ctx, width, (GLfloat (*)[4]) rgba,
-					  format, type, dest,
-					  &ctx->Pack, transferOps);
-	    }
-	 }
+         job.img = img;
+         ok = _mesa_threadpool_run_bands(get_tex_rgba_band, &job, height,
+                                         (size_t) width * height *
+                                         4 * sizeof(GLfloat));
 
          /* Unmap the src texture buffer */
          ctx->Driver.UnmapTextureImage(ctx, texImage, img);
+
+         if (!ok) {
+            _mesa_error(ctx, GL_OUT_OF_MEMORY, "glGetTexImage()");
+            break;
+         }
       }
       else {
          _mesa_error(ctx, GL_OUT_OF_MEMORY, "glGetTexImage");
          break;
       }
    }
-
-   free(rgba);
 }
 
 
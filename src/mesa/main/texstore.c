@@ -51,6 +51,7 @@
  */
 
 
+#include "c11/threads.h"
 #include "glheader.h"
 #include "bufferobj.h"
 #include "colormac.h"
@@ -71,6 +72,7 @@
 #include "texcompress_bptc.h"
 #include "teximage.h"
 #include "texstore.h"
+#include "threadpool.h"
 #include "enums.h"
 #include "glformats.h"
 #include "../../gallium/auxiliary/util/u_format_rgb9e5.h"
@@ -1503,6 +1505,7 @@ texstore_swizzle(TEXSTORE_PARAMS)
 
    switch (srcType) {
    case GL_FLOAT:
+   case GL_HALF_FLOAT:
    case GL_UNSIGNED_BYTE:
    case GL_BYTE:
    case GL_UNSIGNED_SHORT:
@@ -1709,31 +1712,39 @@ texstore_rgba_integer(TEXSTORE_PARAMS)
    return GL_TRUE;
 }
 
-static GLboolean
-texstore_rgba(TEXSTORE_PARAMS)
-{
-   static StoreTexImageFunc table[MESA_FORMAT_COUNT];
-   static GLboolean initialized = GL_FALSE;
+static StoreTexImageFunc texstore_rgba_table[MESA_FORMAT_COUNT];
 
-   if (!initialized) {
-      memset(table, 0, sizeof table);
 
-      table[MESA_FORMAT_B5G6R5_UNORM] = _mesa_texstore_rgb565;
-      table[MESA_FORMAT_R5G6B5_UNORM] = _mesa_texstore_rgb565;
-      table[MESA_FORMAT_YCBCR] = _mesa_texstore_ycbcr;
-      table[MESA_FORMAT_YCBCR_REV] = _mesa_texstore_ycbcr;
+static void
+init_texstore_rgba_table(void)
+{
+   StoreTexImageFunc *table = texstore_rgba_table;
 
-      table[MESA_FORMAT_B10G10R10A2_UINT] = _mesa_texstore_argb2101010_uint;
-      table[MESA_FORMAT_R10G10B10A2_UINT] = _mesa_texstore_abgr2101010_uint;
+   table[MESA_FORMAT_B5G6R5_UNORM] = _mesa_texstore_rgb565;
+   table[MESA_FORMAT_R5G6B5_UNORM] = _mesa_texstore_rgb565;
+   table[MESA_FORMAT_YCBCR] = _mesa_texstore_ycbcr;
+   table[MESA_FORMAT_YCBCR_REV] = _mesa_texstore_ycbcr;
+
+   table[MESA_FORMAT_B10G10R10A2_UINT] = _mesa_texstore_argb2101010_uint;
+   table[MESA_FORMAT_R10G10B10A2_UINT] = _mesa_texstore_abgr2101010_uint;
+}
 
-      initialized = GL_TRUE;
-   }
 
-   if (table[dstFormat] && table[dstFormat](ctx, dims, baseInternalFormat,
-                                            dstFormat, dstRowStride, dstSlices,
-                                            srcWidth, srcHeight, srcDepth,
-                                            srcFormat, srcType, srcAddr,
-                                            srcPacking)) {
+static GLboolean
+texstore_rgba(TEXSTORE_PARAMS)
+{
+   static once_flag flag = ONCE_FLAG_INIT;
+   StoreTexImageFunc store;
+
+   /* texstore bands may get here concurrently */
+   call_once(&flag, init_texstore_rgba_table);
+   store = texstore_rgba_table[dstFormat];
+
+   if (store && store(ctx, dims, baseInternalFormat,
+                      dstFormat, dstRowStride, dstSlices,
+                      srcWidth, srcHeight, srcDepth,
+                      srcFormat, srcType, srcAddr,
+                      srcPacking)) {
       return GL_TRUE;
    }
 
@@ -1851,6 +1862,91 @@ _mesa_texstore_memcpy(TEXSTORE_PARAMS)
                   srcAddr, srcPacking);
    return GL_TRUE;
 }
+
+
+/**
+ * Parameters of a texstore_rgba() call that is split into bands of rows
+ * (or of images, for 3D stores).
+ */
+struct texstore_job
+{
+   struct gl_context *ctx;
+   GLuint dims;
+   GLenum baseInternalFormat;
+   mesa_format dstFormat;
+   GLint dstRowStride;
+   GLubyte **dstSlices;
+   GLint srcWidth, srcHeight, srcDepth;
+   GLenum srcFormat, srcType;
+   const GLvoid *srcAddr;
+   const struct gl_pixelstore_attrib *srcPacking;
+};
+
+
+static GLboolean
+texstore_rgba_band(void *data, int first, int last)
+{
+   const struct texstore_job *job = (const struct texstore_job *) data;
+   struct gl_pixelstore_attrib packing = *job->srcPacking;
+   GLubyte *bandStart;
+   GLubyte **dstSlices = &bandStart;
+   GLint height = job->srcHeight, depth = job->srcDepth;
+
+   /* Address the band through the unpack skip parameters, keeping the
+    * image stride of the whole source image.
+    */
+   if (packing.ImageHeight == 0)
+      packing.ImageHeight = job->srcHeight;
+
+   if (job->srcDepth > 1) {
+      packing.SkipImages += first;
+      dstSlices = job->dstSlices + first;
+      depth = last - first;
+   }
+   else {
+      packing.SkipRows += first;
+      bandStart = job->dstSlices[0] + first * job->dstRowStride;
+      height = last - first;
+   }
+
+   return texstore_rgba(job->ctx, job->dims, job->baseInternalFormat,
+                        job->dstFormat, job->dstRowStride, dstSlices,
+                        job->srcWidth, height, depth,
+                        job->srcFormat, job->srcType, job->srcAddr,
+                        &packing);
+}
+
+
+/**
+ * texstore_rgba(), with large images split into bands of rows (or 3D
+ * images) that are converted concurrently.
+ */
+static GLboolean
+texstore_rgba_threaded(TEXSTORE_PARAMS)
+{
+   struct texstore_job job;
+
+   job.ctx = ctx;
+   job.dims = dims;
+   job.baseInternalFormat = baseInternalFormat;
+   job.dstFormat = dstFormat;
+   job.dstRowStride = dstRowStride;
+   job.dstSlices = dstSlices;
+   job.srcWidth = srcWidth;
+   job.srcHeight = srcHeight;
+   job.srcDepth = srcDepth;
+   job.srcFormat = srcFormat;
+   job.srcType = srcType;
+   job.srcAddr = srcAddr;
+   job.srcPacking = srcPacking;
+
+   return _mesa_threadpool_run_bands(texstore_rgba_band, &job,
+                                     srcDepth > 1 ? srcDepth : srcHeight,
+                                     (size_t) srcWidth * srcHeight * srcDepth *
+                                     _mesa_get_format_bytes(dstFormat));
+}
+
+
 /**
  * Store user data into texture memory.
  * Called via glTex[Sub]Image1/2/3D()
@@ -1878,10 +1974,10 @@ _mesa_texstore(TEXSTORE_PARAMS)
                                  srcWidth, srcHeight, srcDepth,
                                  srcFormat, srcType, srcAddr, srcPacking);
    } else {
-      return texstore_rgba(ctx, dims, baseInternalFormat,
-                           dstFormat, dstRowStride, dstSlices,
-                           srcWidth, srcHeight, srcDepth,
-                           srcFormat, srcType, srcAddr, srcPacking);
+      return texstore_rgba_threaded(ctx, dims, baseInternalFormat,
+                                    dstFormat, dstRowStride, dstSlices,
+                                    srcWidth, srcHeight, srcDepth,
+                                    srcFormat, srcType, srcAddr, srcPacking);
    }
 }
 
@@ -0,0 +1,305 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2014  The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/**
+ * \file threadpool.c
+ *
+ * Worker threads for splitting large image operations into bands.
+ *
+ * Every context holds a reference on the pool.  The worker threads are
+ * started the first time a job is big enough to be worth splitting and
+ * are shut down with the last context, so none are left running when a
+ * driver is unloaded.  Only one job runs on the pool at
+ * a time; if another thread (another context) submits a job while the
+ * pool is busy, that job simply runs on the calling thread.
+ */
+
+
+#include "c11/threads.h"
+#include "imports.h"
+#include "macros.h"
+#include "threadpool.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+
+/** Max number of worker threads, not counting the submitting thread */
+#define MAX_WORKERS 7
+
+/**
+ * Jobs are only split into bands of at least this many bytes; below that
+ * the hand-off costs more than the work.
+ */
+#define MIN_BAND_BYTES (256 * 1024)
+
+
+struct threadpool
+{
+   mtx_t submit_mutex;  /**< held while a job is on the pool */
+   mtx_t mutex;         /**< protects everything below */
+   cnd_t work_cond;     /**< signalled when a job is submitted */
+   cnd_t done_cond;     /**< signalled when the last band finishes */
+
+   thrd_t workers[MAX_WORKERS];
+   int num_workers;
+   GLboolean created;
+   GLboolean shutdown;
+
+   /* The current job */
+   mesa_band_func func;
+   void *data;
+   int count;
+   int num_bands;
+   int next_band;
+   int bands_done;
+   GLboolean failed;
+};
+
+static struct threadpool pool;
+
+/** Non-NULL on the pool's worker threads */
+static tss_t worker_key;
+static once_flag worker_key_once = ONCE_FLAG_INIT;
+
+/** Protects pool_refcount and creating/destroying the pool */
+static mtx_t pool_ref_mutex = _MTX_INITIALIZER_NP;
+static int pool_refcount;
+
+
+/**
+ * Claim and run bands of the current job until there are none left.
+ * Called with pool.mutex held, returns with it held.
+ */
+static void
+run_pending_bands(void)
+{
+   while (pool.next_band < pool.num_bands) {
+      const int band = pool.next_band++;
+      const int first = pool.count * band / pool.num_bands;
+      const int last = pool.count * (band + 1) / pool.num_bands;
+      mesa_band_func func = pool.func;
+      void *data = pool.data;
+      GLboolean ok;
+
+      mtx_unlock(&pool.mutex);
+      ok = func(data, first, last);
+      mtx_lock(&pool.mutex);
+
+      if (!ok)
+         pool.failed = GL_TRUE;
+      if (++pool.bands_done == pool.num_bands)
+         cnd_broadcast(&pool.done_cond);
+   }
+}
+
+
+static void
+create_worker_key(void)
+{
+   tss_create(&worker_key, NULL);
+}
+
+
+static int
+worker_main(void *arg)
+{
+   (void) arg;
+
+   tss_set(worker_key, &pool);
+
+   mtx_lock(&pool.mutex);
+   while (!pool.shutdown) {
+      if (pool.next_band < pool.num_bands)
+         run_pending_bands();
+      else
+         cnd_wait(&pool.work_cond, &pool.mutex);
+   }
+   mtx_unlock(&pool.mutex);
+
+   return 0;
+}
+
+
+static void
+destroy_pool(void)
+{
+   int i;
+
+   mtx_lock(&pool.mutex);
+   pool.shutdown = GL_TRUE;
+   cnd_broadcast(&pool.work_cond);
+   mtx_unlock(&pool.mutex);
+
+   for (i = 0; i < pool.num_workers; i++)
+      thrd_join(pool.workers[i], NULL);
+   pool.num_workers = 0;
+
+   cnd_destroy(&pool.done_cond);
+   cnd_destroy(&pool.work_cond);
+   mtx_destroy(&pool.mutex);
+   mtx_destroy(&pool.submit_mutex);
+
+   pool.shutdown = GL_FALSE;
+   pool.created = GL_FALSE;
+}
+
+
+static void
+create_pool(void)
+{
+   int num_cpus = 1, i;
+
+#if defined(_SC_NPROCESSORS_ONLN)
+   num_cpus = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+   pool.created = GL_TRUE;
+
+   call_once(&worker_key_once, create_worker_key);
+   mtx_init(&pool.submit_mutex, mtx_plain);
+   mtx_init(&pool.mutex, mtx_plain);
+   cnd_init(&pool.work_cond);
+   cnd_init(&pool.done_cond);
+
+   for (i = 0; i < MIN2(num_cpus - 1, MAX_WORKERS); i++) {
+      if (thrd_create(&pool.workers[pool.num_workers], worker_main,
+                      NULL) != thrd_success)
+         break;
+      pool.num_workers++;
+   }
+}
+
+
+/**
+ * Called for each new context.  The workers are only started once there
+ * is a job to split.
+ */
+void
+_mesa_threadpool_reference(void)
+{
+   mtx_lock(&pool_ref_mutex);
+   pool_refcount++;
+   mtx_unlock(&pool_ref_mutex);
+}
+
+
+/**
+ * Called when a context is destroyed.  Joins the workers when the last
+ * context goes away.
+ */
+void
+_mesa_threadpool_release(void)
+{
+   mtx_lock(&pool_ref_mutex);
+   assert(pool_refcount > 0);
+   if (--pool_refcount == 0 && pool.created)
+      destroy_pool();
+   mtx_unlock(&pool_ref_mutex);
+}
+
+
+/**
+ * Run func over items [0, count) of a job, splitting it into contiguous
+ * bands processed concurrently by the calling thread and the pool's
+ * workers.  Returns once all bands are done.
+ *
+ * \param bytes  approximate amount of data the whole job touches, used to
+ *               decide how many bands (if more than one) are worthwhile
+ * \return GL_FALSE if any band failed
+ */
+GLboolean
+_mesa_threadpool_run_bands(mesa_band_func func, void *data,
+                           int count, size_t bytes)
+{
+   GLboolean ok;
+   int num_bands;
+
+   if (count <= 0)
+      return GL_TRUE;
+
+   num_bands = (int) MIN2(bytes / MIN_BAND_BYTES, (size_t) count);
+   if (num_bands <= 1)
+      return func(data, 0, count);
+
+   /* The caller's context holds a reference, so the pool can't be
+    * destroyed once it's been created here.
+    */
+   mtx_lock(&pool_ref_mutex);
+   if (!pool.created && pool_refcount > 0)
+      create_pool();
+   mtx_unlock(&pool_ref_mutex);
+
+   if (pool.num_workers == 0 ||
+       mtx_trylock(&pool.submit_mutex) != thrd_success)
+      return func(data, 0, count);
+
+   mtx_lock(&pool.mutex);
+   pool.func = func;
+   pool.data = data;
+   pool.count = count;
+   pool.num_bands = MIN2(num_bands, pool.num_workers + 1);
+   pool.next_band = 0;
+   pool.bands_done = 0;
+   pool.failed = GL_FALSE;
+   cnd_broadcast(&pool.work_cond);
+
+   run_pending_bands();
+   while (pool.bands_done < pool.num_bands)
+      cnd_wait(&pool.done_cond, &pool.mutex);
+
+   ok = !pool.failed;
+   pool.num_bands = 0;
+   pool.next_band = 0;
+   mtx_unlock(&pool.mutex);
+
+   mtx_unlock(&pool.submit_mutex);
+
+   return ok;
+}
+
+
+/**
+ * Called by _mesa_error().  The workers don't own the context, so they
+ * can't record GL errors; the ones they raise are all out of memory
+ * errors from helpers deep in the conversions.  Instead the band's job is
+ * marked as failed, and _mesa_threadpool_run_bands() returns GL_FALSE on
+ * the submitting thread.
+ *
+ * \return GL_TRUE if the error was deferred this way
+ */
+GLboolean
+_mesa_threadpool_defer_error(void)
+{
+   call_once(&worker_key_once, create_worker_key);
+   if (!tss_get(worker_key))
+      return GL_FALSE;
+
+   mtx_lock(&pool.mutex);
+   pool.failed = GL_TRUE;
+   mtx_unlock(&pool.mutex);
+   return GL_TRUE;
+}
@@ -0,0 +1,65 @@
+/**
+ * \file threadpool.h
+ * A small pool of worker threads for splitting large image operations
+ * (texture stores, pixel packing, mipmap generation) into bands.
+ */
+
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (C) 2014  The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+
+#include <stddef.h>
+#include "glheader.h"
+
+
+/**
+ * Work callback: process items [first, last) of a job, e.g. a range of
+ * image rows or slices.  Bands of the same job may run concurrently and
+ * must not write to shared state.  GL errors raised on a worker fail the
+ * job instead, see _mesa_threadpool_defer_error().
+ *
+ * \return GL_FALSE on failure (out of memory)
+ */
+typedef GLboolean (*mesa_band_func)(void *data, int first, int last);
+
+
+extern void
+_mesa_threadpool_reference(void);
+
+extern void
+_mesa_threadpool_release(void);
+
+extern GLboolean
+_mesa_threadpool_run_bands(mesa_band_func func, void *data,
+                           int count, size_t bytes);
+
+extern GLboolean
+_mesa_threadpool_defer_error(void);
+
+
+#endif /* THREADPOOL_H */
@@ -77,7 +77,31 @@ static const struct st_tracked_state *atoms[] =
 
 void st_init_atoms( struct st_context *st )
 {
-   /* no-op */
+   GLuint i, bit;
+
+   STATIC_ASSERT(Elements(atoms) <= 32);
+
+   memset(st->atoms_for_mesa, 0, sizeof(st->atoms_for_mesa));
+   memset(st->atoms_for_st, 0, sizeof(st->atoms_for_st));
+
+   for (i = 0; i < Elements(atoms); i++) {
+      const struct st_tracked_state *atom = atoms[i];
+
+      if (!(atom->dirty.mesa || atom->dirty.st) ||
+          !atom->update) {
+         printf("malformed atom %s\n", atom->name);
+         assert(0);
+      }
+
+      for (bit = 0; bit < 32; bit++) {
+         if (atom->dirty.mesa & (1u << bit))
+            st->atoms_for_mesa[bit] |= 1u << i;
+      }
+      for (bit = 0; bit < 64; bit++) {
+         if (atom->dirty.st & (1ull << bit))
+            st->atoms_for_st[bit] |= 1u << i;
+      }
+   }
 }
 
 
@@ -90,27 +114,31 @@ void st_destroy_atoms( struct st_context *st )
 /***********************************************************************
  */
 
-static GLboolean check_state( const struct st_state_flags *a,
-			      const struct st_state_flags *b )
-{
-   return ((a->mesa & b->mesa) ||
-	   (a->st & b->st));
-}
-
-static void accumulate_state( struct st_state_flags *a,
-			      const struct st_state_flags *b )
+/**
+ * Return the mask of atoms which need to run for the given dirty flags.
+ * Only the set bits are visited.
+ */
+static INLINE GLbitfield
+atoms_for_state( const struct st_context *st,
+                 const struct st_state_flags *flags )
 {
-   a->mesa |= b->mesa;
-   a->st |= b->st;
-}
+   GLbitfield mask = 0;
+   GLbitfield mesa = flags->mesa;
+   uint64_t bits = flags->st;
+
+   while (mesa) {
+      const int bit = ffs(mesa) - 1;
+      mask |= st->atoms_for_mesa[bit];
+      mesa &= mesa - 1;
+   }
 
+   while (bits) {
+      const int bit = ffsll(bits) - 1;
+      mask |= st->atoms_for_st[bit];
+      bits &= bits - 1;
+   }
 
-static void xor_states( struct st_state_flags *result,
-			     const struct st_state_flags *a,
-			      const struct st_state_flags *b )
-{
-   result->mesa = a->mesa ^ b->mesa;
-   result->st = a->st ^ b->st;
+   return mask;
 }
 
 
@@ -164,7 +192,7 @@ static void check_attrib_edgeflag(struct st_context *st)
 void st_validate_state( struct st_context *st )
 {
    struct st_state_flags *state = &st->dirty;
-   GLuint i;
+   GLbitfield pending;
 
    /* Get Mesa driver state. */
    st->dirty.st |= st->ctx->NewDriverState;
@@ -184,53 +212,30 @@ void st_validate_state( struct st_context *st )
 
    /*printf("%s %x/%x\n", __FUNCTION__, state->mesa, state->st);*/
 
-#ifdef DEBUG
-   if (1) {
-#else
-   if (0) {
-#endif
-      /* Debug version which enforces various sanity checks on the
-       * state flags which are generated and checked to help ensure
-       * state atoms are ordered correctly in the list.
+   pending = atoms_for_state(st, state);
+
+   while (pending) {
+      const int i = ffs(pending) - 1;
+      struct st_state_flags prev = *state;
+
+      pending &= pending - 1;
+
+      atoms[i]->update( st );
+
+      /* Atoms may flag more state; pick up the later atoms which depend
+       * on it. Flagging state examined by this or an earlier atom means
+       * the atoms are ordered incorrectly in the list.
        */
-      struct st_state_flags examined, prev;      
-      memset(&examined, 0, sizeof(examined));
-      prev = *state;
-
-      for (i = 0; i < Elements(atoms); i++) {	 
-	 const struct st_tracked_state *atom = atoms[i];
-	 struct st_state_flags generated;
-	 
-	 /*printf("atom %s %x/%x\n", atom->name, atom->dirty.mesa, atom->dirty.st);*/
-
-	 if (!(atom->dirty.mesa || atom->dirty.st) ||
-	     !atom->update) {
-	    printf("malformed atom %s\n", atom->name);
-	    assert(0);
-	 }
-
-	 if (check_state(state, &atom->dirty)) {
-	    atoms[i]->update( st );
-	    /*printf("after: %x\n", atom->dirty.mesa);*/
-	 }
-
-	 accumulate_state(&examined, &atom->dirty);
-
-	 /* generated = (prev ^ state)
-	  * if (examined & generated)
-	  *     fail;
-	  */
-	 xor_states(&generated, &prev, state);
-	 assert(!check_state(&examined, &generated));
-	 prev = *state;
-      }
-      /*printf("\n");*/
+      if (state->mesa != prev.mesa || state->st != prev.st) {
+         struct st_state_flags generated;
+         GLbitfield generated_atoms;
 
-   }
-   else {
-      for (i = 0; i < Elements(atoms); i++) {	 
-	 if (check_state(state, &atoms[i]->dirty))
-	    atoms[i]->update( st );
+         generated.mesa = state->mesa ^ prev.mesa;
+         generated.st = state->st ^ prev.st;
+         generated_atoms = atoms_for_state(st, &generated);
+
+         assert(!(generated_atoms & ((2u << i) - 1)));
+         pending |= generated_atoms & ~((2u << i) - 1);
       }
    }
 
@@ -537,6 +537,39 @@ setup_non_interleaved_attribs(struct st_context *st,
    return TRUE;
 }
 
+/**
+ * Fill in the st_vertex_array_key for each vertex program input.
+ */
+static void
+get_array_keys(const struct st_vertex_program *vp,
+               const struct st_vp_variant *vpv,
+               const struct gl_client_array **arrays,
+               struct st_vertex_array_key keys[])
+{
+   GLuint attr;
+
+   memset(keys, 0, sizeof(keys[0]) * vpv->num_inputs);
+
+   for (attr = 0; attr < vpv->num_inputs; attr++) {
+      const GLuint mesaAttr = vp->index_to_input[attr];
+      const struct gl_client_array *array = arrays[mesaAttr];
+      struct st_vertex_array_key *key = &keys[attr];
+
+      key->ptr = array->Ptr;
+      key->bufobj = array->BufferObj;
+      if (_mesa_is_bufferobj(array->BufferObj))
+         key->buffer = st_buffer_object(array->BufferObj)->buffer;
+      key->stride = array->StrideB;
+      key->instance_divisor = array->InstanceDivisor;
+      key->type = array->Type;
+      key->format = array->Format;
+      key->size = array->Size;
+      key->normalized = array->Normalized;
+      key->integer = array->Integer;
+      key->attr = mesaAttr;
+   }
+}
+
 static void update_array(struct st_context *st)
 {
    struct gl_context *ctx = st->ctx;
@@ -545,6 +578,7 @@ static void update_array(struct st_context *st)
    const struct st_vp_variant *vpv;
    struct pipe_vertex_buffer vbuffer[PIPE_MAX_SHADER_INPUTS];
    struct pipe_vertex_element velements[PIPE_MAX_ATTRIBS];
+   struct st_vertex_array_key keys[PIPE_MAX_ATTRIBS];
    unsigned num_vbuffers, num_velements;
 
    st->vertex_array_out_of_memory = FALSE;
@@ -557,6 +591,18 @@ static void update_array(struct st_context *st)
    vp = st->vp;
    vpv = st->vp_variant;
 
+   /* The vbo module flags the arrays as changed on every flush, even when
+    * they are the same as for the previous draw.
+    */
+   get_array_keys(vp, vpv, arrays, keys);
+   if (st->last_arrays_valid &&
+       st->last_num_array_keys == vpv->num_inputs &&
+       memcmp(st->last_array_keys, keys,
+              sizeof(keys[0]) * vpv->num_inputs) == 0)
+      return;
+
+   st->last_arrays_valid = FALSE;
+
    memset(velements, 0, sizeof(struct pipe_vertex_element) * vpv->num_inputs);
 
    /*
@@ -591,7 +637,22 @@ static void update_array(struct st_context *st)
                              st->last_num_vbuffers - num_vbuffers, NULL);
    }
    st->last_num_vbuffers = num_vbuffers;
-   cso_set_vertex_elements(st->cso_context, num_velements, velements);
+
+   /* Interleaved arrays streamed into a VBO only move the buffer offset
+    * from one draw to the next; keep the bound vertex elements then.
+    */
+   if (num_velements != st->last_num_velements ||
+       memcmp(st->last_velements, velements,
+              sizeof(velements[0]) * num_velements) != 0) {
+      cso_set_vertex_elements(st->cso_context, num_velements, velements);
+      memcpy(st->last_velements, velements,
+             sizeof(velements[0]) * num_velements);
+      st->last_num_velements = num_velements;
+   }
+
+   memcpy(st->last_array_keys, keys, sizeof(keys[0]) * vpv->num_inputs);
+   st->last_num_array_keys = vpv->num_inputs;
+   st->last_arrays_valid = TRUE;
 }
 
 
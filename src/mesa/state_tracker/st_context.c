@@ -184,6 +184,9 @@ st_create_context_priv( struct gl_context *ctx, struct pipe_context *pipe,
 
    st->cso_context = cso_create_context(pipe);
 
+   /* No vertex elements are bound yet, not even an empty set. */
+   st->last_num_velements = ~0;
+
    st_init_atoms( st );
    st_init_bitmap(st);
    st_init_clear(st);
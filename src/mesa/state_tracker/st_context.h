@@ -59,6 +59,25 @@ struct st_state_flags {
    uint64_t st;
 };
 
+/**
+ * The parts of a vertex array that st_update_array() looks at, for one
+ * vertex program input. Used to tell when nothing changed since the
+ * previous update.
+ */
+struct st_vertex_array_key {
+   const GLubyte *ptr;
+   const struct gl_buffer_object *bufobj;
+   struct pipe_resource *buffer;   /**< NULL for user-space arrays */
+   GLsizei stride;
+   GLuint instance_divisor;
+   GLenum type;
+   GLenum format;
+   GLubyte size;
+   GLubyte normalized;
+   GLubyte integer;
+   GLubyte attr;                   /**< VERT_ATTRIB_x */
+};
+
 struct st_tracked_state {
    const char *name;
    struct st_state_flags dirty;
@@ -130,6 +149,12 @@ struct st_context
 
    struct st_state_flags dirty;
 
+   /** Mask of st_atom.c atoms (by index) to run for each dirty bit,
+    * filled in by st_init_atoms().
+    */
+   GLbitfield atoms_for_mesa[32];
+   GLbitfield atoms_for_st[64];
+
    GLboolean missing_textures;
    GLboolean vertdata_edgeflags;
    GLboolean edgeflag_culls_prims;
@@ -197,6 +222,15 @@ struct st_context
    /* The number of vertex buffers from the last call of validate_arrays. */
    unsigned last_num_vbuffers;
 
+   /* The arrays and vertex elements from the last successful call of
+    * validate_arrays, so that redundant updates can be skipped.
+    */
+   struct st_vertex_array_key last_array_keys[PIPE_MAX_ATTRIBS];
+   unsigned last_num_array_keys;
+   boolean last_arrays_valid;
+   struct pipe_vertex_element last_velements[PIPE_MAX_ATTRIBS];
+   unsigned last_num_velements;
+
    int32_t draw_stamp;
    int32_t read_stamp;
 
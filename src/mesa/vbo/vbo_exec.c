@@ -87,6 +87,23 @@ void vbo_exec_invalidate_state( struct gl_context *ctx, GLuint new_state )
    if (new_state & _NEW_EVAL)
       exec->eval.recalculate_maps = GL_TRUE;
 
+   /* Batching across modelview changes moves positions by a few ulps.
+    * Depth tests which only pass for (nearly) coplanar fragments show
+    * that the app redraws geometry against its own depth values, as in
+    * multipass rendering, decals or hidden line removal.  The earlier
+    * passes looked like any other rendering, so stop batching for good.
+    */
+   if ((new_state & (_NEW_DEPTH | _NEW_POLYGON)) && ctx->Depth.Test) {
+      const GLenum func = ctx->Depth.Func;
+
+      if (func == GL_EQUAL ||
+          (!ctx->Depth.Mask && (func == GL_LEQUAL || func == GL_GEQUAL)) ||
+          ctx->Polygon.OffsetFill ||
+          ctx->Polygon.OffsetLine ||
+          ctx->Polygon.OffsetPoint)
+         exec->vtx.xform_exact_depth = GL_TRUE;
+   }
+
    _ae_invalidate_state(ctx, new_state);
 }
 
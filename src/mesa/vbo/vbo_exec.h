@@ -112,6 +112,20 @@ struct vbo_exec_context
        * vertex program below:
        */
       const struct gl_client_array *inputs[VERT_ATTRIB_MAX];
+
+      /* Batching across modelview changes.  While xform_active, the
+       * stored vertices are drawn with xform_modelview instead of the
+       * current modelview matrix, and new positions and normals are
+       * transformed into its object space when needed (xform_vertices).
+       */
+      GLboolean xform_active;
+      GLboolean xform_dirty;    /**< modelview changed since last glBegin */
+      GLboolean xform_vertices;
+      GLmatrix xform_modelview;
+      GLfloat xform_pos[16];    /**< current object space -> batch's */
+      GLfloat xform_normal[16]; /**< transposed for normals */
+      /** The app relies on exact depth values, so never batch again */
+      GLboolean xform_exact_depth;
    } vtx;
 
    
@@ -42,6 +42,7 @@ USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "main/api_arrayelt.h"
 #include "main/api_validate.h"
 #include "main/dispatch.h"
+#include "math/m_matrix.h"
 
 #include "vbo_context.h"
 #include "vbo_noop.h"
@@ -57,6 +58,7 @@ USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
 static void reset_attrfv( struct vbo_exec_context *exec );
+static void vbo_exec_end_xform( struct vbo_exec_context *exec );
 
 
 /**
@@ -226,6 +228,48 @@ vbo_exec_copy_from_current(struct vbo_exec_context *exec)
 }
 
 
+/**
+ * Transform a normal from the current modelview's object space into the
+ * batch's, see vbo_exec_update_xform().
+ */
+static inline void
+vbo_exec_xform_normal(const struct vbo_exec_context *exec, GLfloat *n)
+{
+   const GLfloat *m = exec->vtx.xform_normal;
+   const GLfloat x = n[0], y = n[1], z = n[2];
+
+   n[0] = m[0] * x + m[1] * y + m[2] * z;
+   n[1] = m[4] * x + m[5] * y + m[6] * z;
+   n[2] = m[8] * x + m[9] * y + m[10] * z;
+}
+
+
+/**
+ * Transform the position and normal of a just stored vertex into the
+ * object space of the modelview matrix the batch is drawn with.
+ */
+static void
+vbo_exec_xform_vertex(const struct vbo_exec_context *exec, GLfloat *v)
+{
+   const GLfloat *m = exec->vtx.xform_pos;
+   GLfloat *pos = v + (exec->vtx.attrptr[VBO_ATTRIB_POS] - exec->vtx.vertex);
+   const GLfloat x = pos[0], y = pos[1], z = pos[2];
+   const GLfloat w = exec->vtx.attrsz[VBO_ATTRIB_POS] == 4 ? pos[3] : 1.0f;
+
+   assert(exec->vtx.attrsz[VBO_ATTRIB_POS] >= 3);
+
+   /* The transformation is affine, so w is unchanged. */
+   pos[0] = m[0] * x + m[4] * y + m[8] * z + m[12] * w;
+   pos[1] = m[1] * x + m[5] * y + m[9] * z + m[13] * w;
+   pos[2] = m[2] * x + m[6] * y + m[10] * z + m[14] * w;
+
+   if (exec->vtx.attrsz[VBO_ATTRIB_NORMAL] == 3)
+      vbo_exec_xform_normal(exec,
+                            v + (exec->vtx.attrptr[VBO_ATTRIB_NORMAL] -
+                                 exec->vtx.vertex));
+}
+
+
 /**
  * Flush existing data, set new attrib size, replay copied vertices.
  * This is called when we transition from a small vertex attribute size
@@ -273,6 +317,7 @@ vbo_exec_wrap_upgrade_vertex(struct vbo_exec_context *exec,
        !oldSize && lastcount > 8 && exec->vtx.vertex_size) {
       vbo_exec_copy_to_current( exec );
       reset_attrfv( exec );
+      vbo_exec_end_xform( exec );
    }
 
    /* Fix up sizes:
@@ -339,6 +384,8 @@ vbo_exec_wrap_upgrade_vertex(struct vbo_exec_context *exec,
 		  } else {
 		     GLfloat *current = (GLfloat *)vbo->currval[j].Ptr;
 		     COPY_SZ_4V(dest + new_offset, sz, current);
+                     if (j == VBO_ATTRIB_NORMAL && exec->vtx.xform_vertices)
+                        vbo_exec_xform_normal(exec, dest + new_offset);
 		  }
 	       }
 	       else {
@@ -427,6 +474,9 @@ do {									\
       for (i = 0; i < exec->vtx.vertex_size; i++)			\
 	 exec->vtx.buffer_ptr[i] = exec->vtx.vertex[i];			\
 									\
+      if (unlikely(exec->vtx.xform_vertices))				\
+	 vbo_exec_xform_vertex(exec, exec->vtx.buffer_ptr);		\
+									\
       exec->vtx.buffer_ptr += exec->vtx.vertex_size;			\
 									\
       /* Set FLUSH_STORED_VERTICES to indicate that there's now */	\
@@ -559,6 +609,148 @@ vbo_exec_FlushVertices_internal(struct vbo_exec_context *exec, GLboolean unmap)
       vbo_exec_copy_to_current( exec );
       reset_attrfv( exec );
    }
+
+   vbo_exec_end_xform( exec );
+}
+
+
+/**
+ * Stop batching across modelview changes.  Only valid once every stored
+ * vertex has been drawn.
+ */
+static void
+vbo_exec_end_xform(struct vbo_exec_context *exec)
+{
+   exec->vtx.xform_active = GL_FALSE;
+   exec->vtx.xform_dirty = GL_FALSE;
+   exec->vtx.xform_vertices = GL_FALSE;
+}
+
+
+/**
+ * Does a 4x4 matrix have (0, 0, 0, 1) as its last row and an invertible
+ * upper 3x3?
+ */
+static GLboolean
+is_affine_invertible(const GLfloat *m)
+{
+   GLfloat det;
+
+   if (m[3] != 0.0f || m[7] != 0.0f || m[11] != 0.0f || m[15] != 1.0f)
+      return GL_FALSE;
+
+   det = m[0] * (m[5] * m[10] - m[9] * m[6]) -
+         m[4] * (m[1] * m[10] - m[9] * m[2]) +
+         m[8] * (m[1] * m[6] - m[5] * m[2]);
+
+   return det != 0.0f && !IS_INF_OR_NAN(det);
+}
+
+
+/**
+ * Called instead of flushing when the modelview matrix is about to change
+ * while vertices are stored.
+ *
+ * With fixed function vertex processing, the only per-vertex use of the
+ * modelview matrix is transforming positions and normals to eye space, so
+ * later vertices can be transformed into the object space of the stored
+ * ones and everything drawn with the old matrix.  That keeps apps which
+ * draw lots of tiny glBegin/glEnd objects between matrix changes from
+ * turning every object into a separate draw.
+ *
+ * Transformed positions can differ from the untransformed ones in the last
+ * bits.  That's harmless for ordinary depth testing, but not once the app
+ * has shown that it redraws geometry against its own depth values, see
+ * vbo_exec_invalidate_state().
+ *
+ * A normal which isn't part of the vertex is the same for every stored
+ * vertex, so it can't follow the matrix change.  Don't batch if lighting
+ * needs it.  Texgen, which could need it too, is never batched.
+ *
+ * \return GL_TRUE if the vertices were kept.
+ */
+static GLboolean
+vbo_exec_defer_modelview(struct vbo_exec_context *exec)
+{
+   struct gl_context *ctx = exec->ctx;
+
+   if (!exec->vtx.xform_active) {
+      if (!exec->vtx.vert_count ||
+          exec->vtx.attrsz[VBO_ATTRIB_POS] < 3 ||
+          exec->vtx.attrtype[VBO_ATTRIB_POS] != GL_FLOAT ||
+          ctx->RenderMode != GL_RENDER ||
+          exec->vtx.xform_exact_depth ||
+          (ctx->Light.Enabled && !exec->vtx.attrsz[VBO_ATTRIB_NORMAL]) ||
+          ctx->VertexProgram._Enabled ||
+          ctx->_Shader->CurrentProgram[MESA_SHADER_VERTEX] ||
+          ctx->Texture._TexGenEnabled ||
+          ctx->Transform.RescaleNormals ||
+          !is_affine_invertible(ctx->ModelviewMatrixStack.Top->m))
+         return GL_FALSE;
+
+      _math_matrix_copy(&exec->vtx.xform_modelview,
+                        ctx->ModelviewMatrixStack.Top);
+      exec->vtx.xform_active = GL_TRUE;
+   }
+
+   exec->vtx.xform_dirty = GL_TRUE;
+   return GL_TRUE;
+}
+
+
+/**
+ * c = a * b for column-major 4x4 matrices.
+ */
+static void
+matmul4(GLfloat *c, const GLfloat *a, const GLfloat *b)
+{
+   GLuint i, j;
+
+   for (i = 0; i < 4; i++) {
+      for (j = 0; j < 4; j++) {
+         c[j * 4 + i] = a[i] * b[j * 4] +
+                        a[4 + i] * b[j * 4 + 1] +
+                        a[8 + i] * b[j * 4 + 2] +
+                        a[12 + i] * b[j * 4 + 3];
+      }
+   }
+}
+
+
+/**
+ * Called from glBegin when the modelview matrix changed since the stored
+ * vertices were kept.  Work out how to transform new vertices into the
+ * batch's object space, or flush if that isn't possible.
+ */
+static void
+vbo_exec_update_xform(struct vbo_exec_context *exec)
+{
+   struct gl_context *ctx = exec->ctx;
+   GLmatrix *mv = ctx->ModelviewMatrixStack.Top;
+   GLmatrix *batch = &exec->vtx.xform_modelview;
+
+   exec->vtx.xform_dirty = GL_FALSE;
+
+   if (memcmp(mv->m, batch->m, 16 * sizeof(GLfloat)) == 0) {
+      /* e.g. glPushMatrix, glTranslate, ..., glPopMatrix */
+      exec->vtx.xform_vertices = GL_FALSE;
+      return;
+   }
+
+   if (!is_affine_invertible(mv->m)) {
+      vbo_exec_FlushVertices_internal(exec, GL_FALSE);
+      return;
+   }
+
+   _math_matrix_analyse(batch);
+   _math_matrix_analyse(mv);
+
+   /* Positions: batch^-1 * mv.  Normals go to eye space with the inverse
+    * transpose, so they need transpose(mv^-1 * batch).
+    */
+   matmul4(exec->vtx.xform_pos, batch->inv, mv->m);
+   matmul4(exec->vtx.xform_normal, mv->inv, batch->m);
+   exec->vtx.xform_vertices = GL_TRUE;
 }
 
 
@@ -691,6 +883,9 @@ static void GLAPIENTRY vbo_exec_Begin( GLenum mode )
    if (exec->vtx.vertex_size && !exec->vtx.attrsz[0])
       vbo_exec_FlushVertices_internal(exec, GL_FALSE);
 
+   if (unlikely(exec->vtx.xform_dirty))
+      vbo_exec_update_xform(exec);
+
    i = exec->vtx.prim_count++;
    exec->vtx.prim[i].mode = mode;
    exec->vtx.prim[i].begin = 1;
@@ -1040,6 +1235,8 @@ void vbo_exec_vtx_init( struct vbo_exec_context *exec )
    exec->vtx.buffer_map = _mesa_align_malloc(VBO_VERT_BUFFER_SIZE, 64);
    exec->vtx.buffer_ptr = exec->vtx.buffer_map;
 
+   _math_matrix_ctr(&exec->vtx.xform_modelview);
+
    vbo_exec_vtxfmt_init( exec );
    _mesa_noop_vtxfmt_init(&exec->vtxfmt_noop);
 
@@ -1122,6 +1319,8 @@ void vbo_exec_vtx_destroy( struct vbo_exec_context *exec )
       ctx->Driver.UnmapBuffer(ctx, exec->vtx.bufferobj, MAP_INTERNAL);
    }
    _mesa_reference_buffer_object(ctx, &exec->vtx.bufferobj, NULL);
+
+   _math_matrix_dtr(&exec->vtx.xform_modelview);
 }
 
 
@@ -1164,6 +1363,15 @@ void vbo_exec_FlushVertices( struct gl_context *ctx, GLuint flags )
       return;
    }
 
+   /* Keep batching if only the modelview matrix is changing */
+   if ((flags & FLUSH_MODELVIEW) && vbo_exec_defer_modelview(exec)) {
+#ifdef DEBUG
+      exec->flush_call_depth--;
+      assert(exec->flush_call_depth == 0);
+#endif
+      return;
+   }
+
    /* Flush (draw), and make sure VBO is left unmapped when done */
    vbo_exec_FlushVertices_internal(exec, GL_TRUE);
 
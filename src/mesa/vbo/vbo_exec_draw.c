@@ -389,12 +389,24 @@ vbo_exec_vtx_flush(struct vbo_exec_context *exec, GLboolean keepUnmapped)
 
       if (exec->vtx.copied.nr != exec->vtx.vert_count) {
 	 struct gl_context *ctx = exec->ctx;
+         GLmatrix *modelview = NULL;
 	 
 	 /* Before the update_state() as this may raise _NEW_VARYING_VP_INPUTS
           * from _mesa_set_varying_vp_inputs().
 	  */
 	 vbo_exec_bind_arrays( ctx );
 
+         /* Vertices kept across modelview changes are drawn with the
+          * modelview matrix they were stored for.
+          */
+         if (exec->vtx.xform_active &&
+             memcmp(ctx->ModelviewMatrixStack.Top->m,
+                    exec->vtx.xform_modelview.m, 16 * sizeof(GLfloat))) {
+            modelview = ctx->ModelviewMatrixStack.Top;
+            ctx->ModelviewMatrixStack.Top = &exec->vtx.xform_modelview;
+            ctx->NewState |= _NEW_MODELVIEW;
+         }
+
          if (ctx->NewState)
             _mesa_update_state( ctx );
 
@@ -415,6 +427,11 @@ vbo_exec_vtx_flush(struct vbo_exec_context *exec, GLboolean keepUnmapped)
 				       exec->vtx.vert_count - 1,
 				       NULL, NULL);
 
+         if (modelview) {
+            ctx->ModelviewMatrixStack.Top = modelview;
+            ctx->NewState |= _NEW_MODELVIEW;
+         }
+
 	 /* If using a real VBO, get new storage -- unless asked not to.
           */
          if (_mesa_is_bufferobj(exec->vtx.bufferobj) && !keepUnmapped) {
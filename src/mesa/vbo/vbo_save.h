@@ -81,6 +81,16 @@ struct vbo_save_vertex_list {
    struct _mesa_prim *prim;
    GLuint prim_count;
 
+   /* The same primitives rewritten as indexed GL_POINTS, GL_LINES and
+    * GL_TRIANGLES, with runs of primitives of the same kind merged into
+    * one.  Used on playback when the state allows it, see
+    * vbo_save_playback_vertex_list().  merged_prim_count is zero if the
+    * list couldn't be (or didn't need to be) merged.
+    */
+   struct _mesa_prim *merged_prim;
+   GLuint merged_prim_count;
+   struct _mesa_index_buffer merged_ib;
+
    struct vbo_save_vertex_store *vertex_store;
    struct vbo_save_primitive_store *prim_store;
 };
@@ -88,15 +98,17 @@ struct vbo_save_vertex_list {
 /* These buffers should be a reasonable size to support upload to
  * hardware.  Current vbo implementation will re-upload on any
  * changes, so don't make too big or apps which dynamically create
- * dlists and use only a few times will suffer.
+ * dlists and use only a few times will suffer.  On the other hand a
+ * vertex list is split whenever either store fills up, and every
+ * split costs a draw call on playback.
  *
  * Consider stategy of uploading regions from the VBO on demand in the
  * case of dynamic vbos.  Then make the dlist code signal that
  * likelyhood as it occurs.  No reason we couldn't change usage
  * internally even though this probably isn't allowed for client VBOs?
  */
-#define VBO_SAVE_BUFFER_SIZE (8*1024) /* dwords */
-#define VBO_SAVE_PRIM_SIZE   128
+#define VBO_SAVE_BUFFER_SIZE (64*1024) /* dwords */
+#define VBO_SAVE_PRIM_SIZE   1024
 #define VBO_SAVE_PRIM_MODE_MASK         0x3f
 #define VBO_SAVE_PRIM_WEAK              0x40
 #define VBO_SAVE_PRIM_NO_CURRENT_UPDATE 0x80
@@ -363,6 +363,227 @@ merge_prims(struct gl_context *ctx,
    *prim_count = prev_prim - prim_list + 1;
 }
 
+
+/**
+ * Return the mode a primitive is drawn as in a merged vertex list, or
+ * GL_NONE if it can't be expressed as indexed points, lines or triangles
+ * without changing the result.  Quads and polygons are left alone since
+ * the diagonal the driver splits them along isn't known here.
+ */
+static GLenum
+merged_prim_mode(const struct _mesa_prim *prim)
+{
+   switch (prim->mode) {
+   case GL_POINTS:
+      return GL_POINTS;
+   case GL_LINES:
+   case GL_LINE_STRIP:
+      return GL_LINES;
+   case GL_LINE_LOOP:
+      /* a loop split across vertex lists isn't closed in this one */
+      return prim->begin && prim->end ? GL_LINES : GL_NONE;
+   case GL_TRIANGLES:
+   case GL_TRIANGLE_STRIP:
+   case GL_TRIANGLE_FAN:
+      return GL_TRIANGLES;
+   default:
+      return GL_NONE;
+   }
+}
+
+
+/**
+ * Number of indices needed to draw a primitive in its merged mode.
+ */
+static GLuint
+merged_prim_index_count(const struct _mesa_prim *prim)
+{
+   const GLuint count = prim->count;
+
+   switch (prim->mode) {
+   case GL_POINTS:
+      return count;
+   case GL_LINES:
+      return count & ~1;
+   case GL_LINE_STRIP:
+      return count >= 2 ? (count - 1) * 2 : 0;
+   case GL_LINE_LOOP:
+      return count >= 2 ? count * 2 : 0;
+   case GL_TRIANGLES:
+      return count - count % 3;
+   case GL_TRIANGLE_STRIP:
+   case GL_TRIANGLE_FAN:
+      return count >= 3 ? (count - 2) * 3 : 0;
+   default:
+      assert(0);
+      return 0;
+   }
+}
+
+
+/**
+ * Write the indices for one primitive in its merged mode.  Triangles keep
+ * the winding and last vertex of the original primitive, so culling,
+ * two-sided lighting and last-vertex flat shading are unchanged.
+ */
+static GLuint *
+merged_prim_indices(const struct _mesa_prim *prim, GLuint *dst)
+{
+   const GLuint start = prim->start;
+   const GLuint n = merged_prim_index_count(prim);
+   GLuint i;
+
+   switch (prim->mode) {
+   case GL_POINTS:
+   case GL_LINES:
+   case GL_TRIANGLES:
+      for (i = 0; i < n; i++)
+         *dst++ = start + i;
+      break;
+   case GL_LINE_STRIP:
+   case GL_LINE_LOOP:
+      for (i = 0; i + 1 < prim->count; i++) {
+         *dst++ = start + i;
+         *dst++ = start + i + 1;
+      }
+      if (prim->mode == GL_LINE_LOOP && n) {
+         *dst++ = start + prim->count - 1;
+         *dst++ = start;
+      }
+      break;
+   case GL_TRIANGLE_STRIP:
+      for (i = 0; i + 2 < prim->count; i++) {
+         *dst++ = start + i + (i & 1);
+         *dst++ = start + i + 1 - (i & 1);
+         *dst++ = start + i + 2;
+      }
+      break;
+   case GL_TRIANGLE_FAN:
+      for (i = 0; i + 2 < prim->count; i++) {
+         *dst++ = start;
+         *dst++ = start + i + 1;
+         *dst++ = start + i + 2;
+      }
+      break;
+   default:
+      assert(0);
+   }
+
+   return dst;
+}
+
+
+/**
+ * Build node->merged_prim: consecutive primitives which are drawn as the
+ * same kind of indexed primitive are merged into one draw, so a list made
+ * of many small strips and fans is replayed with a handful of draws.
+ * Order between runs is kept.  Nothing is built unless it saves draws.
+ */
+static void
+compile_merged_prims(struct gl_context *ctx,
+                     struct vbo_save_vertex_list *node)
+{
+   struct gl_buffer_object *obj;
+   struct _mesa_prim *merged;
+   GLuint *indices, *dst;
+   GLuint i, nr_merged = 0, nr_indices = 0;
+   GLenum prev_mode = GL_NONE;
+   GLboolean ok;
+
+   node->merged_prim = NULL;
+   node->merged_prim_count = 0;
+   memset(&node->merged_ib, 0, sizeof(node->merged_ib));
+
+   if (node->prim_count < 2 || node->count == 0)
+      return;
+
+   for (i = 0; i < node->prim_count; i++) {
+      const GLenum mode = merged_prim_mode(&node->prim[i]);
+
+      if (mode == GL_NONE)
+         return;
+      if (mode != prev_mode)
+         nr_merged++;
+      prev_mode = mode;
+      nr_indices += merged_prim_index_count(&node->prim[i]);
+   }
+
+   if (nr_merged >= node->prim_count || nr_indices == 0)
+      return;
+
+   merged = malloc(nr_merged * sizeof(*merged));
+   indices = malloc(nr_indices * sizeof(GLuint));
+   if (!merged || !indices)
+      goto fail;
+
+   dst = indices;
+   prev_mode = GL_NONE;
+   nr_merged = 0;
+   for (i = 0; i < node->prim_count; i++) {
+      const GLenum mode = merged_prim_mode(&node->prim[i]);
+      struct _mesa_prim *p;
+
+      if (mode != prev_mode) {
+         p = &merged[nr_merged++];
+         memset(p, 0, sizeof(*p));
+         p->mode = mode;
+         p->indexed = 1;
+         p->begin = 1;
+         p->end = 1;
+         p->start = dst - indices;
+         p->num_instances = 1;
+         prev_mode = mode;
+      }
+      dst = merged_prim_indices(&node->prim[i], dst);
+      p = &merged[nr_merged - 1];
+      p->count = (dst - indices) - p->start;
+   }
+   assert(dst == indices + nr_indices);
+
+   /* Vertex lists are limited to VBO_SAVE_BUFFER_SIZE floats, so the
+    * indices nearly always fit in shorts.
+    */
+   if (node->count <= 0x10000) {
+      GLushort *dst16 = (GLushort *) indices;
+      for (i = 0; i < nr_indices; i++)
+         dst16[i] = (GLushort) indices[i];
+      node->merged_ib.type = GL_UNSIGNED_SHORT;
+   }
+   else {
+      node->merged_ib.type = GL_UNSIGNED_INT;
+   }
+   node->merged_ib.count = nr_indices;
+
+   obj = ctx->Driver.NewBufferObject(ctx, VBO_BUF_ID,
+                                     GL_ELEMENT_ARRAY_BUFFER_ARB);
+   if (!obj)
+      goto fail;
+
+   ok = ctx->Driver.BufferData(ctx, GL_ELEMENT_ARRAY_BUFFER_ARB,
+                               nr_indices *
+                               vbo_sizeof_ib_type(node->merged_ib.type),
+                               indices, GL_STATIC_DRAW_ARB,
+                               GL_MAP_READ_BIT | GL_DYNAMIC_STORAGE_BIT,
+                               obj);
+   if (!ok) {
+      _mesa_reference_buffer_object(ctx, &obj, NULL);
+      goto fail;
+   }
+
+   free(indices);
+   node->merged_ib.obj = obj;
+   node->merged_ib.ptr = NULL;
+   node->merged_prim = merged;
+   node->merged_prim_count = nr_merged;
+   return;
+
+fail:
+   /* Not an error, the list is just drawn unmerged. */
+   free(indices);
+   free(merged);
+   memset(&node->merged_ib, 0, sizeof(node->merged_ib));
+}
+
 /**
  * Insert the active immediate struct onto the display list currently
  * being built.
@@ -443,6 +664,8 @@ _save_compile_vertex_list(struct gl_context *ctx)
 
    merge_prims(ctx, node->prim, &node->prim_count);
 
+   compile_merged_prims(ctx, node);
+
    /* Deal with GL_COMPILE_AND_EXECUTE:
     */
    if (ctx->ExecuteFlag) {
@@ -1521,6 +1744,10 @@ vbo_destroy_vertex_list(struct gl_context *ctx, void *data)
 
    free(node->current_data);
    node->current_data = NULL;
+
+   free(node->merged_prim);
+   node->merged_prim = NULL;
+   _mesa_reference_buffer_object(ctx, &node->merged_ib.obj, NULL);
 }
 
 
@@ -1531,8 +1758,10 @@ vbo_print_vertex_list(struct gl_context *ctx, void *data)
    GLuint i;
    (void) ctx;
 
-   printf("VBO-VERTEX-LIST, %u vertices %d primitives, %d vertsize\n",
-          node->count, node->prim_count, node->vertex_size);
+   printf("VBO-VERTEX-LIST, %u vertices %d primitives, %d vertsize, "
+          "%d merged primitives\n",
+          node->count, node->prim_count, node->vertex_size,
+          node->merged_prim_count);
 
    for (i = 0; i < node->prim_count; i++) {
       struct _mesa_prim *prim = &node->prim[i];
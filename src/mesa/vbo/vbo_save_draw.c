@@ -34,6 +34,7 @@
 #include "main/macros.h"
 #include "main/light.h"
 #include "main/state.h"
+#include "main/transformfeedback.h"
 
 #include "vbo_context.h"
 
@@ -217,6 +218,48 @@ static void vbo_bind_vertex_list(struct gl_context *ctx,
 }
 
 
+/**
+ * Can the merged, indexed form of the vertex list be drawn instead of its
+ * original primitives without changing the result?
+ */
+static GLboolean
+can_draw_merged_prims(struct gl_context *ctx,
+                      const struct vbo_save_vertex_list *node)
+{
+   const struct gl_fragment_program *fp = ctx->FragmentProgram._Current;
+
+   if (!node->merged_prim_count)
+      return GL_FALSE;
+
+   /* Feedback reports every independent line with GL_LINE_RESET_TOKEN
+    * where strips only reset the first one.
+    */
+   if (ctx->RenderMode != GL_RENDER)
+      return GL_FALSE;
+
+   /* Merged strips and fans only keep the last vertex of each triangle,
+    * independent lines restart the stipple pattern and unfilled triangles
+    * honour edge flags where strips and fans don't.
+    */
+   if (ctx->Light.ProvokingVertex != GL_LAST_VERTEX_CONVENTION_EXT ||
+       ctx->Line.StippleFlag ||
+       ctx->Polygon.FrontMode != GL_FILL ||
+       ctx->Polygon.BackMode != GL_FILL)
+      return GL_FALSE;
+
+   /* Indices may match the restart index, and the primitive ID would keep
+    * counting across merged primitives.
+    */
+   if (ctx->Array._PrimitiveRestart ||
+       _mesa_is_xfb_active_and_unpaused(ctx) ||
+       ctx->GeometryProgram._Current ||
+       (fp && (fp->Base.InputsRead & VARYING_BIT_PRIMITIVE_ID)))
+      return GL_FALSE;
+
+   return GL_TRUE;
+}
+
+
 static void
 vbo_save_loopback_vertex_list(struct gl_context *ctx,
                               const struct vbo_save_vertex_list *list)
@@ -308,14 +351,26 @@ vbo_save_playback_vertex_list(struct gl_context *ctx, void *data)
 	 _mesa_update_state( ctx );
 
       if (node->count > 0) {
-         vbo_context(ctx)->draw_prims(ctx, 
-                                      node->prim,
-                                      node->prim_count,
-                                      NULL,
-                                      GL_TRUE,
-                                      0,    /* Node is a VBO, so this is ok */
-                                      node->count - 1,
-                                      NULL, NULL);
+         if (can_draw_merged_prims(ctx, node)) {
+            vbo_context(ctx)->draw_prims(ctx,
+                                         node->merged_prim,
+                                         node->merged_prim_count,
+                                         &node->merged_ib,
+                                         GL_TRUE,
+                                         0,
+                                         node->count - 1,
+                                         NULL, NULL);
+         }
+         else {
+            vbo_context(ctx)->draw_prims(ctx, 
+                                         node->prim,
+                                         node->prim_count,
+                                         NULL,
+                                         GL_TRUE,
+                                         0,    /* Node is a VBO, so this is ok */
+                                         node->count - 1,
+                                         NULL, NULL);
+         }
       }
    }
 
@@ -31,6 +31,10 @@ void util_format_unsigned_fetch_texel_rgtc(unsigned srcRowStride, const unsigned
 void util_format_signed_fetch_texel_rgtc(unsigned srcRowStride, const signed char *pixdata,
                                            unsigned i, unsigned j, signed char *value, unsigned comps);
 
+void util_format_unsigned_decode_rgtc_block(const unsigned char *blksrc, unsigned char value[16]);
+
+void util_format_signed_decode_rgtc_block(const signed char *blksrc, signed char value[16]);
+
 void util_format_unsigned_encode_rgtc_ubyte(unsigned char *blkaddr, unsigned char srccolors[4][4],
                                             int numxpixels, int numypixels);
 
@@ -58,6 +58,37 @@ void TAG(fetch_texel_rgtc)(unsigned srcRowStride, const TYPE *pixdata,
    *value = decode;
 }
 
+void TAG(decode_rgtc_block)(const TYPE *blksrc, TYPE value[16])
+{
+   const TYPE alpha0 = blksrc[0];
+   const TYPE alpha1 = blksrc[1];
+   TYPE palette[8];
+   uint64_t codes = 0;
+   int code, k;
+
+   palette[0] = alpha0;
+   palette[1] = alpha1;
+   for (code = 2; code < 8; code++) {
+      if (alpha0 > alpha1)
+         palette[code] = ((alpha0 * (8 - code) + (alpha1 * (code - 1))) / 7);
+      else if (code < 6)
+         palette[code] = ((alpha0 * (6 - code) + (alpha1 * (code - 1))) / 5);
+      else if (code == 6)
+         palette[code] = T_MIN;
+      else
+         palette[code] = T_MAX;
+   }
+
+   /* 16 3-bit codes, little endian, in row major texel order */
+   for (k = 7; k >= 2; k--)
+      codes = (codes << 8) | (unsigned char) blksrc[k];
+
+   for (k = 0; k < 16; k++) {
+      value[k] = palette[codes & 0x7];
+      codes >>= 3;
+   }
+}
+
 static void TAG(write_rgtc_encoded_channel)(TYPE *blkaddr,
                                             TYPE alphabase1,
                                             TYPE alphabase2,